@@ -0,0 +1,283 @@
+/**
+ * Helpers shared by the benchmark programs: timing, a deterministic random
+ * number generator, synthetic corpora and (on Linux) hardware counters.
+ */
+#ifndef bench_h
+#define bench_h
+
+#include "../src/natcmp.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static inline uint64_t bench_rand(uint64_t *state)
+{
+    // xorshift64*
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * UINT64_C(0x2545F4914F6CDD1D);
+}
+
+/**
+ * bench_corpus_t
+ *
+ * Array of generated strings. All strings live in one allocation.
+ */
+typedef struct {
+    const char *name;
+    unsigned char **strs;
+    size_t n;
+    unsigned char *buf;
+} bench_corpus_t;
+
+static inline void bench_corpus_free(bench_corpus_t *c)
+{
+    free(c->strs);
+    free(c->buf);
+    c->strs = NULL;
+    c->buf  = NULL;
+    c->n    = 0;
+}
+
+/**
+ * bench_corpus_gen
+ *
+ * Generates n strings of the named shape:
+ *   "files"    - "IMG_0042_v3.JPG" style names with mixed case
+ *   "versions" - dotted version numbers such as "1.12.3"
+ *   "numeric"  - long digit runs with leading zeros
+ *   "prefix"   - long shared text prefix followed by a number
+ *   "text"     - words without digits
+ */
+static inline int bench_corpus_gen(bench_corpus_t *c, const char *name,
+                                   size_t n, uint64_t seed)
+{
+    static const char *words[] = {"img",    "IMG",   "file",  "File", "photo",
+                                  "report", "log",   "shard", "part", "chunk",
+                                  "frame",  "Frame", "data",  "v",    "rc"};
+    const size_t nword         = sizeof(words) / sizeof(words[0]);
+    const size_t maxlen        = 96;
+    uint64_t st                = seed ? seed : 1;
+
+    c->name = name;
+    c->n    = n;
+    c->strs = malloc(sizeof(*c->strs) * (n ? n : 1));
+    c->buf  = malloc(maxlen * (n ? n : 1));
+    if (!c->strs || !c->buf) {
+        bench_corpus_free(c);
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        char *p    = (char *)c->buf + i * maxlen;
+        size_t len = 0;
+        c->strs[i] = (unsigned char *)p;
+        if (strcmp(name, "files") == 0) {
+            len = (size_t)snprintf(
+                p, maxlen, "%s_%0*u_%s%u.%s",
+                words[bench_rand(&st) % nword],
+                (int)(bench_rand(&st) % 6),
+                (unsigned)(bench_rand(&st) % 100000),
+                words[bench_rand(&st) % nword],
+                (unsigned)(bench_rand(&st) % 20),
+                (bench_rand(&st) & 1) ? "JPG" : "txt");
+        } else if (strcmp(name, "versions") == 0) {
+            len = (size_t)snprintf(p, maxlen, "%u.%u.%u",
+                                   (unsigned)(bench_rand(&st) % 5),
+                                   (unsigned)(bench_rand(&st) % 30),
+                                   (unsigned)(bench_rand(&st) % 200));
+        } else if (strcmp(name, "numeric") == 0) {
+            size_t nd = 1 + bench_rand(&st) % 40;
+            size_t nz = bench_rand(&st) % 4;
+            for (; len < nz; len++) {
+                p[len] = '0';
+            }
+            for (size_t k = 0; k < nd; k++) {
+                p[len++] = (char)('0' + bench_rand(&st) % 10);
+            }
+            p[len] = 0;
+        } else if (strcmp(name, "prefix") == 0) {
+            len = (size_t)snprintf(
+                p, maxlen,
+                "/var/lib/service/storage/volume/objects/segment_%u/%u",
+                (unsigned)(bench_rand(&st) % 64),
+                (unsigned)(bench_rand(&st) % 1000000));
+        } else {
+            size_t nw = 1 + bench_rand(&st) % 4;
+            for (size_t k = 0; k < nw; k++) {
+                len += (size_t)snprintf(p + len, maxlen - len, "%s%s",
+                                        k ? " " : "",
+                                        words[bench_rand(&st) % nword]);
+            }
+        }
+        (void)len;
+    }
+    return 0;
+}
+
+/**
+ * bench_corpus_load
+ *
+ * Loads the lines of a file (such as a corpus rewritten by tools/natanon) as
+ * a corpus named after the file. If n is not 0 the corpus has exactly n
+ * strings, the lines being repeated as needed; otherwise it has one string
+ * per line.
+ */
+static inline int bench_corpus_load(bench_corpus_t *c, const char *path,
+                                    size_t n)
+{
+    FILE *fp     = fopen(path, "rb");
+    size_t len   = 0;
+    size_t cap   = 1 << 16;
+    size_t nline = 0;
+
+    c->name = path;
+    c->n    = 0;
+    c->strs = NULL;
+    c->buf  = malloc(cap);
+    if (!fp || !c->buf) {
+        goto FAIL;
+    }
+    for (;;) {
+        if (len + 1 == cap) {
+            unsigned char *p = realloc(c->buf, cap * 2);
+            if (!p) {
+                goto FAIL;
+            }
+            c->buf = p;
+            cap *= 2;
+        }
+        size_t r = fread(c->buf + len, 1, cap - 1 - len, fp);
+        if (r == 0) {
+            break;
+        }
+        len += r;
+    }
+    if (ferror(fp)) {
+        goto FAIL;
+    }
+    fclose(fp);
+    fp = NULL;
+    if (len && c->buf[len - 1] != '\n') {
+        c->buf[len++] = '\n';
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (c->buf[i] == '\n') {
+            c->buf[i] = 0;
+            nline++;
+        }
+    }
+    if (!nline) {
+        goto FAIL;
+    }
+
+    c->n    = n ? n : nline;
+    c->strs = malloc(sizeof(*c->strs) * c->n);
+    if (!c->strs) {
+        goto FAIL;
+    }
+    unsigned char *p = c->buf;
+    for (size_t i = 0; i < c->n; i++) {
+        if (i && i % nline == 0) {
+            p = c->buf;
+        }
+        c->strs[i] = p;
+        p += strlen((char *)p) + 1;
+    }
+    return 0;
+
+FAIL:
+    if (fp) {
+        fclose(fp);
+    }
+    bench_corpus_free(c);
+    return -1;
+}
+
+/**
+ * bench_counter_t
+ *
+ * Hardware event counter. The counter is unavailable (fd < 0) on non-Linux
+ * systems or when perf events are not permitted.
+ */
+typedef struct {
+    int fd;
+} bench_counter_t;
+
+static inline void bench_counter_open(bench_counter_t *cnt, unsigned long type)
+{
+    cnt->fd = -1;
+#if defined(__linux__)
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = type;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    cnt->fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)type;
+#endif
+}
+
+static inline void bench_counter_start(bench_counter_t *cnt)
+{
+#if defined(__linux__)
+    if (cnt->fd >= 0) {
+        ioctl(cnt->fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(cnt->fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)cnt;
+#endif
+}
+
+// returns the counted events, or -1 if the counter is unavailable
+static inline long long bench_counter_stop(bench_counter_t *cnt)
+{
+#if defined(__linux__)
+    long long val = -1;
+    if (cnt->fd >= 0) {
+        ioctl(cnt->fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(cnt->fd, &val, sizeof(val)) != (ssize_t)sizeof(val)) {
+            val = -1;
+        }
+    }
+    return val;
+#else
+    (void)cnt;
+    return -1;
+#endif
+}
+
+static inline void bench_counter_close(bench_counter_t *cnt)
+{
+#if defined(__linux__)
+    if (cnt->fd >= 0) {
+        close(cnt->fd);
+    }
+#endif
+    cnt->fd = -1;
+}
+
+#endif /* bench_h */
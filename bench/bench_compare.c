@@ -0,0 +1,501 @@
+/**
+ * Head-to-head comparison of natcmp() with other natural order
+ * implementations:
+ *
+ *   strnatcasecmp - reimplementation of Martin Pool's strnatcmp.c
+ *   strverscmp    - glibc
+ *   filevercmp    - reimplementation of the gnulib/coreutils algorithm
+ *   regex-key     - split with regcomp("[0-9]+|[^0-9]+") into a key of
+ *                   (lower-cased text, unsigned long long) tokens, like the
+ *                   usual scripting language recipe
+ *
+ * For each corpus it reports the time to sort the corpus with qsort() and
+ * lists the inputs on which each implementation disagrees with natcmp().
+ * Case-insensitive implementations are checked against natcmp(a, b, NULL),
+ * case-sensitive ones against natcmp_bytes(). natcmp_dfa() is included as a
+ * sanity check and should never disagree. The lines of the file named by the
+ * NATCMP_BENCH_CORPUS environment variable are used as an additional corpus.
+ */
+#define _GNU_SOURCE
+#include "bench.h"
+#include <limits.h>
+#include <regex.h>
+
+#define NSTR     50000
+#define NPAIR    200000
+#define NEXAMPLE 5
+
+/* strnatcmp */
+
+static int strnat_compare_right(const unsigned char *a, const unsigned char *b)
+{
+    int bias = 0;
+    // the longest run of digits wins, if equal the first difference wins
+    for (;; a++, b++) {
+        if (!isdigit(*a) && !isdigit(*b)) {
+            return bias;
+        } else if (!isdigit(*a)) {
+            return -1;
+        } else if (!isdigit(*b)) {
+            return 1;
+        } else if (*a < *b) {
+            if (!bias) {
+                bias = -1;
+            }
+        } else if (*a > *b) {
+            if (!bias) {
+                bias = 1;
+            }
+        }
+    }
+}
+
+static int strnat_compare_left(const unsigned char *a, const unsigned char *b)
+{
+    // leading zeros: compare as fractional parts, the first difference wins
+    for (;; a++, b++) {
+        if (!isdigit(*a) && !isdigit(*b)) {
+            return 0;
+        } else if (!isdigit(*a)) {
+            return -1;
+        } else if (!isdigit(*b)) {
+            return 1;
+        } else if (*a != *b) {
+            return (*a < *b) ? -1 : 1;
+        }
+    }
+}
+
+static int strnatcasecmp(const unsigned char *a, const unsigned char *b)
+{
+    size_t ai = 0;
+    size_t bi = 0;
+    for (;;) {
+        int ca = a[ai];
+        int cb = b[bi];
+        while (isspace(ca)) {
+            ca = a[++ai];
+        }
+        while (isspace(cb)) {
+            cb = b[++bi];
+        }
+        if (isdigit(ca) && isdigit(cb)) {
+            int res = (ca == '0' || cb == '0') ?
+                          strnat_compare_left(a + ai, b + bi) :
+                          strnat_compare_right(a + ai, b + bi);
+            if (res != 0) {
+                return res;
+            }
+        }
+        if (!ca && !cb) {
+            return 0;
+        }
+        ca = toupper(ca);
+        cb = toupper(cb);
+        if (ca != cb) {
+            return (ca < cb) ? -1 : 1;
+        }
+        ai++;
+        bi++;
+    }
+}
+
+/* filevercmp */
+
+static int fv_order(unsigned char c)
+{
+    if (isdigit(c)) {
+        return 0;
+    } else if (isalpha(c)) {
+        return c;
+    } else if (c == '~') {
+        return -1;
+    }
+    return (int)c + UCHAR_MAX + 1;
+}
+
+static int fv_verrevcmp(const unsigned char *s1, size_t len1,
+                        const unsigned char *s2, size_t len2)
+{
+    size_t p1 = 0;
+    size_t p2 = 0;
+    while (p1 < len1 || p2 < len2) {
+        int first_diff = 0;
+        while ((p1 < len1 && !isdigit(s1[p1])) ||
+               (p2 < len2 && !isdigit(s2[p2]))) {
+            int c1 = (p1 == len1) ? 0 : fv_order(s1[p1]);
+            int c2 = (p2 == len2) ? 0 : fv_order(s2[p2]);
+            if (c1 != c2) {
+                return c1 - c2;
+            }
+            p1++;
+            p2++;
+        }
+        while (p1 < len1 && s1[p1] == '0') {
+            p1++;
+        }
+        while (p2 < len2 && s2[p2] == '0') {
+            p2++;
+        }
+        while (p1 < len1 && p2 < len2 && isdigit(s1[p1]) && isdigit(s2[p2])) {
+            if (!first_diff) {
+                first_diff = s1[p1] - s2[p2];
+            }
+            p1++;
+            p2++;
+        }
+        if (p1 < len1 && isdigit(s1[p1])) {
+            return 1;
+        } else if (p2 < len2 && isdigit(s2[p2])) {
+            return -1;
+        } else if (first_diff) {
+            return first_diff;
+        }
+    }
+    return 0;
+}
+
+// returns the length of s without its file suffix (\.[A-Za-z~][A-Za-z0-9~]*)*
+static size_t fv_prefix_len(const unsigned char *s)
+{
+    const unsigned char *p     = s;
+    const unsigned char *match = NULL;
+    int read_alpha             = 0;
+    while (*p) {
+        if (read_alpha) {
+            read_alpha = 0;
+            if (!isalpha(*p) && *p != '~') {
+                match = NULL;
+            }
+        } else if (*p == '.') {
+            read_alpha = 1;
+            if (!match) {
+                match = p;
+            }
+        } else if (!isalnum(*p) && *p != '~') {
+            match = NULL;
+        }
+        p++;
+    }
+    return (size_t)((match ? match : p) - s);
+}
+
+static int filevercmp(const unsigned char *a, const unsigned char *b)
+{
+    int res = strcmp((const char *)a, (const char *)b);
+    if (res == 0) {
+        return 0;
+    }
+    // special files: "", ".", ".." and hidden files come first
+    if (!*a) {
+        return -1;
+    } else if (!*b) {
+        return 1;
+    } else if (strcmp((const char *)a, ".") == 0) {
+        return -1;
+    } else if (strcmp((const char *)b, ".") == 0) {
+        return 1;
+    } else if (strcmp((const char *)a, "..") == 0) {
+        return -1;
+    } else if (strcmp((const char *)b, "..") == 0) {
+        return 1;
+    } else if (*a == '.' && *b != '.') {
+        return -1;
+    } else if (*a != '.' && *b == '.') {
+        return 1;
+    } else if (*a == '.' && *b == '.') {
+        a++;
+        b++;
+    }
+
+    size_t len_a = fv_prefix_len(a);
+    size_t len_b = fv_prefix_len(b);
+    int ver      = fv_verrevcmp(a, len_a, b, len_b);
+    if (ver == 0) {
+        ver = fv_verrevcmp(a, strlen((const char *)a), b,
+                           strlen((const char *)b));
+    }
+    return ver ? ver : res;
+}
+
+/* regex-split key */
+
+typedef struct {
+    unsigned char *text;       // lower-cased text token (NULL for numbers)
+    unsigned long long number; // saturated numeric value
+} rx_token_t;
+
+typedef struct {
+    rx_token_t *tokens;
+    size_t ntoken;
+} rx_key_t;
+
+static regex_t rx_split;
+
+static int rx_key_build(rx_key_t *key, const unsigned char *s)
+{
+    regmatch_t m;
+    const char *p = (const char *)s;
+    size_t cap    = 4;
+
+    key->ntoken = 0;
+    key->tokens = malloc(sizeof(*key->tokens) * cap);
+    if (!key->tokens) {
+        return -1;
+    }
+    // scripting-language style keys always start with a (maybe empty) text
+    if (isdigit((unsigned char)*p)) {
+        key->tokens[key->ntoken].text = (unsigned char *)strdup("");
+        key->tokens[key->ntoken++].number = 0;
+    }
+    while (*p && regexec(&rx_split, p, 1, &m, 0) == 0) {
+        size_t len = (size_t)(m.rm_eo - m.rm_so);
+        rx_token_t *tok;
+        if (key->ntoken == cap) {
+            cap *= 2;
+            void *tokens = realloc(key->tokens, sizeof(*key->tokens) * cap);
+            if (!tokens) {
+                return -1;
+            }
+            key->tokens = tokens;
+        }
+        tok         = key->tokens + key->ntoken++;
+        tok->text   = NULL;
+        tok->number = 0;
+        if (isdigit((unsigned char)p[m.rm_so])) {
+            for (size_t i = 0; i < len; i++) {
+                unsigned long long d =
+                    (unsigned long long)(p[m.rm_so + (regoff_t)i] - '0');
+                tok->number = (tok->number > (ULLONG_MAX - d) / 10) ?
+                                  ULLONG_MAX :
+                                  tok->number * 10 + d;
+            }
+        } else {
+            tok->text = malloc(len + 1);
+            if (!tok->text) {
+                return -1;
+            }
+            for (size_t i = 0; i < len; i++) {
+                tok->text[i] =
+                    (unsigned char)tolower((unsigned char)p[m.rm_so +
+                                                            (regoff_t)i]);
+            }
+            tok->text[len] = 0;
+        }
+        p += m.rm_eo;
+    }
+    return 0;
+}
+
+static void rx_key_free(rx_key_t *key)
+{
+    for (size_t i = 0; i < key->ntoken; i++) {
+        free(key->tokens[i].text);
+    }
+    free(key->tokens);
+}
+
+static int rx_key_cmp(const rx_key_t *a, const rx_key_t *b)
+{
+    size_t n = (a->ntoken < b->ntoken) ? a->ntoken : b->ntoken;
+    for (size_t i = 0; i < n; i++) {
+        const rx_token_t *ta = a->tokens + i;
+        const rx_token_t *tb = b->tokens + i;
+        int res              = 0;
+        if (ta->text && tb->text) {
+            res = strcmp((const char *)ta->text, (const char *)tb->text);
+        } else if (!ta->text && !tb->text) {
+            res = (ta->number < tb->number) ? -1 : (ta->number > tb->number);
+        } else {
+            // only reachable if one key starts with an empty text
+            res = ta->text ? 1 : -1;
+        }
+        if (res != 0) {
+            return (res < 0) ? -1 : 1;
+        }
+    }
+    return (a->ntoken < b->ntoken) ? -1 : (a->ntoken > b->ntoken);
+}
+
+/* drivers */
+
+typedef struct {
+    const unsigned char *str;
+    const rx_key_t *key;
+} item_t;
+
+typedef struct {
+    const char *name;
+    int case_sensitive;
+    int (*cmp)(const item_t *a, const item_t *b);
+} impl_t;
+
+static int impl_natcmp(const item_t *a, const item_t *b)
+{
+    return natcmp(a->str, b->str, NULL);
+}
+
+static int impl_natcmp_bytes(const item_t *a, const item_t *b)
+{
+    return natcmp_bytes(a->str, b->str);
+}
+
+static int impl_natcmp_dfa(const item_t *a, const item_t *b)
+{
+    return natcmp_dfa(a->str, b->str);
+}
+
+static int impl_strnatcasecmp(const item_t *a, const item_t *b)
+{
+    return strnatcasecmp(a->str, b->str);
+}
+
+static int impl_strverscmp(const item_t *a, const item_t *b)
+{
+    return strverscmp((const char *)a->str, (const char *)b->str);
+}
+
+static int impl_filevercmp(const item_t *a, const item_t *b)
+{
+    return filevercmp(a->str, b->str);
+}
+
+static int impl_regex_key(const item_t *a, const item_t *b)
+{
+    return rx_key_cmp(a->key, b->key);
+}
+
+static const impl_t impls[] = {
+    {"natcmp",        0, impl_natcmp       },
+    {"natcmp_bytes",  1, impl_natcmp_bytes },
+    {"natcmp_dfa",    0, impl_natcmp_dfa   },
+    {"strnatcasecmp", 0, impl_strnatcasecmp},
+    {"strverscmp",    1, impl_strverscmp   },
+    {"filevercmp",    1, impl_filevercmp   },
+    {"regex-key",     0, impl_regex_key    },
+};
+#define NIMPL (sizeof(impls) / sizeof(impls[0]))
+
+static const impl_t *sort_impl;
+
+static int qsort_cb(const void *a, const void *b)
+{
+    return sort_impl->cmp(a, b);
+}
+
+static int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static void report_differences(const item_t *items, size_t n, int exhaustive)
+{
+    uint64_t st  = 7;
+    size_t npair = exhaustive ? n * n : NPAIR;
+
+    for (size_t k = 2; k < NIMPL; k++) {
+        const impl_t *ref = impls[k].case_sensitive ? impls + 1 : impls;
+        size_t ndiff      = 0;
+        for (size_t p = 0; p < npair; p++) {
+            size_t i = exhaustive ? p / n : (size_t)(bench_rand(&st) % n);
+            size_t j = exhaustive ? p % n : (size_t)(bench_rand(&st) % n);
+            int exp  = ref->cmp(items + i, items + j);
+            int act  = sign(impls[k].cmp(items + i, items + j));
+            if (exp == act) {
+                continue;
+            }
+            if (ndiff++ < NEXAMPLE) {
+                printf("      %-13s \"%s\" vs \"%s\": %s=%d, %s=%d\n",
+                       impls[k].name, items[i].str, items[j].str, ref->name,
+                       exp, impls[k].name, act);
+            }
+        }
+        printf("    %-13s disagrees with %s on %zu of %zu pairs\n",
+               impls[k].name, ref->name, ndiff, npair);
+    }
+}
+
+static int run_corpus(const char *name, unsigned char **strs, size_t n,
+                      int exhaustive)
+{
+    rx_key_t *keys = calloc(n, sizeof(*keys));
+    item_t *items  = malloc(sizeof(*items) * n);
+    item_t *work   = malloc(sizeof(*items) * n);
+    if (!keys || !items || !work) {
+        return -1;
+    }
+
+    double t = bench_now();
+    for (size_t i = 0; i < n; i++) {
+        if (rx_key_build(keys + i, strs[i]) != 0) {
+            return -1;
+        }
+        items[i].str = strs[i];
+        items[i].key = keys + i;
+    }
+    t = bench_now() - t;
+
+    printf("\n  corpus: %s (%zu strings)\n", name, n);
+    printf("    %-13s key build %10.3f ms\n", "regex-key", t * 1e3);
+    for (size_t k = 0; k < NIMPL; k++) {
+        memcpy(work, items, sizeof(*items) * n);
+        sort_impl = impls + k;
+        t         = bench_now();
+        qsort(work, n, sizeof(*work), qsort_cb);
+        t = bench_now() - t;
+        printf("    %-13s qsort     %10.3f ms\n", impls[k].name, t * 1e3);
+    }
+
+    printf("    ordering differences:\n");
+    report_differences(items, n, exhaustive);
+
+    for (size_t i = 0; i < n; i++) {
+        rx_key_free(keys + i);
+    }
+    free(work);
+    free(items);
+    free(keys);
+    return 0;
+}
+
+int main(void)
+{
+    static const char *corpora[] = {"files", "versions", "numeric", "prefix",
+                                    "text"};
+    static const char *edge[]    = {
+        "file1.txt", "file01.txt", "file001.txt", "File1.txt", "file 1.txt",
+        "file1 .txt", "x1.5", "x1.10", "x1.05", "1.0~rc1", "1.0", "1.0a",
+        "1.0.1", "a0", "a00", "a0b", "a00b", ".hidden", "visible", "~tilde",
+        "18446744073709551616", "18446744073709551617", "a_b", "a-b", "aB",
+        "ab",
+    };
+    const size_t nedge = sizeof(edge) / sizeof(edge[0]);
+
+    if (regcomp(&rx_split, "[0-9]+|[^0-9]+", REG_EXTENDED) != 0) {
+        return 1;
+    }
+
+    printf("=== natcmp vs other natural order implementations ===\n");
+    if (run_corpus("edge cases", (unsigned char **)edge, nedge, 1) != 0) {
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        bench_corpus_t c;
+        if (bench_corpus_gen(&c, corpora[i], NSTR, 1 + i) != 0 ||
+            run_corpus(corpora[i], c.strs, c.n, 0) != 0) {
+            return 1;
+        }
+        bench_corpus_free(&c);
+    }
+    if (getenv("NATCMP_BENCH_CORPUS")) {
+        bench_corpus_t c;
+        if (bench_corpus_load(&c, getenv("NATCMP_BENCH_CORPUS"), 0) != 0 ||
+            run_corpus(c.name, c.strs, c.n, 0) != 0) {
+            return 1;
+        }
+        bench_corpus_free(&c);
+    }
+
+    regfree(&rx_split);
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * Compares natcmp() and the table-driven natcmp_dfa() on several corpora,
+ * reporting time per comparison and, where perf events are available, branch
+ * and branch-miss counts per comparison. The lines of the file named by the
+ * NATCMP_BENCH_CORPUS environment variable are used as an additional corpus.
+ */
+#define _GNU_SOURCE
+#include "bench.h"
+
+#define NSTR  100000
+#define NPAIR 2000000
+
+typedef int (*cmp_func_t)(const unsigned char *a, const unsigned char *b);
+
+static int cmp_natcmp(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp(a, b, NULL);
+}
+
+static int cmp_dfa(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp_dfa(a, b);
+}
+
+static void run(const bench_corpus_t *c, const uint32_t *pairs,
+                const char *label, cmp_func_t cmp)
+{
+    bench_counter_t branches;
+    bench_counter_t misses;
+    bench_counter_open(&branches, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+    bench_counter_open(&misses, PERF_COUNT_HW_BRANCH_MISSES);
+
+    long sum = 0;
+    bench_counter_start(&branches);
+    bench_counter_start(&misses);
+    double t = bench_now();
+    for (size_t i = 0; i < NPAIR; i++) {
+        sum += cmp(c->strs[pairs[i * 2]], c->strs[pairs[i * 2 + 1]]);
+    }
+    t                 = bench_now() - t;
+    long long nmiss   = bench_counter_stop(&misses);
+    long long nbranch = bench_counter_stop(&branches);
+
+    printf("  %-10s %-8s %8.2f ns/cmp", c->name, label, t * 1e9 / NPAIR);
+    if (nbranch >= 0 && nmiss >= 0) {
+        printf("  %8.2f branches/cmp  %6.3f misses/cmp  (%.2f%%)",
+               (double)nbranch / NPAIR, (double)nmiss / NPAIR,
+               nbranch ? 100.0 * (double)nmiss / (double)nbranch : 0.0);
+    } else {
+        printf("  (perf counters unavailable)");
+    }
+    printf("  [sum=%ld]\n", sum);
+
+    bench_counter_close(&misses);
+    bench_counter_close(&branches);
+}
+
+int main(void)
+{
+    static const char *corpora[] = {"files", "versions", "numeric", "prefix",
+                                    "text"};
+    const char *file = getenv("NATCMP_BENCH_CORPUS");
+    uint32_t *pairs  = malloc(sizeof(*pairs) * NPAIR * 2);
+    uint64_t st      = 42;
+    if (!pairs) {
+        return 1;
+    }
+    for (size_t i = 0; i < NPAIR * 2; i++) {
+        pairs[i] = (uint32_t)(bench_rand(&st) % NSTR);
+    }
+
+    printf("=== natcmp vs natcmp_dfa (%d random pairs) ===\n", NPAIR);
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        bench_corpus_t c;
+        if (bench_corpus_gen(&c, corpora[i], NSTR, 1 + i) != 0) {
+            return 1;
+        }
+        run(&c, pairs, "natcmp", cmp_natcmp);
+        run(&c, pairs, "dfa", cmp_dfa);
+        bench_corpus_free(&c);
+    }
+    if (file) {
+        bench_corpus_t c;
+        if (bench_corpus_load(&c, file, NSTR) != 0) {
+            perror(file);
+            return 1;
+        }
+        run(&c, pairs, "natcmp", cmp_natcmp);
+        run(&c, pairs, "dfa", cmp_dfa);
+        bench_corpus_free(&c);
+    }
+
+    free(pairs);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * Measures the digit-run hook of natcmp_ex() per corpus: natcmp() against
+ * natcmp_ex() with natcmp_digit_cmp() passed directly (inlined into the
+ * scanning loop) and through a pointer the compiler cannot see (an indirect
+ * call per digit run), and the alternate built-in digit comparisons.
+ */
+#define _GNU_SOURCE
+#include "bench.h"
+
+#define NSTR  100000
+#define NPAIR 2000000
+
+typedef int (*cmp_func_t)(const unsigned char *a, const unsigned char *b);
+
+static natcmp_digit_cmp_func_t volatile digit_ptr = natcmp_digit_cmp;
+
+static int cmp_natcmp(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp(a, b, NULL);
+}
+
+static int cmp_inline(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp_ex(a, b, NULL, natcmp_digit_cmp);
+}
+
+static int cmp_pointer(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp_ex(a, b, NULL, digit_ptr);
+}
+
+static int cmp_value(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp_ex(a, b, NULL, natcmp_digit_cmp_value);
+}
+
+static int cmp_zeros_first(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp_ex(a, b, NULL, natcmp_digit_cmp_zeros_first);
+}
+
+static int cmp_hex(const unsigned char *a, const unsigned char *b)
+{
+    return natcmp_ex(a, b, NULL, natcmp_digit_cmp_hex);
+}
+
+static void run(const bench_corpus_t *c, const uint32_t *pairs,
+                const char *label, cmp_func_t cmp)
+{
+    long sum = 0;
+    double t = bench_now();
+    for (size_t i = 0; i < NPAIR; i++) {
+        sum += cmp(c->strs[pairs[i * 2]], c->strs[pairs[i * 2 + 1]]);
+    }
+    t = bench_now() - t;
+    printf("  %-10s %-12s %8.2f ns/cmp  [sum=%ld]\n", c->name, label,
+           t * 1e9 / NPAIR, sum);
+}
+
+int main(void)
+{
+    static const char *corpora[] = {"files", "versions", "numeric", "prefix",
+                                    "text"};
+    uint32_t *pairs = malloc(sizeof(*pairs) * NPAIR * 2);
+    uint64_t st     = 42;
+    if (!pairs) {
+        return 1;
+    }
+    for (size_t i = 0; i < NPAIR * 2; i++) {
+        pairs[i] = (uint32_t)(bench_rand(&st) % NSTR);
+    }
+
+    printf("=== natcmp_ex digit-run callbacks (%d random pairs) ===\n", NPAIR);
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        bench_corpus_t c;
+        if (bench_corpus_gen(&c, corpora[i], NSTR, 1 + i) != 0) {
+            return 1;
+        }
+        run(&c, pairs, "natcmp", cmp_natcmp);
+        run(&c, pairs, "ex inline", cmp_inline);
+        run(&c, pairs, "ex pointer", cmp_pointer);
+        run(&c, pairs, "value", cmp_value);
+        run(&c, pairs, "zeros_first", cmp_zeros_first);
+        run(&c, pairs, "hex", cmp_hex);
+        bench_corpus_free(&c);
+    }
+
+    free(pairs);
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * Reports time and memory use of the sort engines of natcmp_sort.h per
+ * corpus size: bytes allocated, number of allocations, peak scratch memory
+ * (through the accounting allocator of natcmp_alloc.h), size of the fixed
+ * buffer given to natcmp_sort_inplace() and the growth of the peak RSS while
+ * sorting. Each run is done in a child process so that the RSS of one run
+ * does not hide the next.
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_sort.h"
+#include "bench.h"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FIXED_BUF       512
+#define FIXED_BUF_BYTES (sizeof(const unsigned char *) * FIXED_BUF)
+
+typedef struct {
+    const char *name;
+    int (*sort)(const unsigned char **strs, size_t n,
+                const natcmp_allocator_t *alloc);
+    size_t fixed; // bytes of fixed (stack) scratch buffer
+} engine_t;
+
+static int qsort_cb(const void *a, const void *b)
+{
+    return natcmp(*(const unsigned char *const *)a,
+                  *(const unsigned char *const *)b, NULL);
+}
+
+// qsort() allocates internally, so its allocations cannot be accounted
+static int sort_qsort(const unsigned char **strs, size_t n,
+                      const natcmp_allocator_t *alloc)
+{
+    (void)alloc;
+    qsort(strs, n, sizeof(*strs), qsort_cb);
+    return 0;
+}
+
+static int sort_merge(const unsigned char **strs, size_t n,
+                      const natcmp_allocator_t *alloc)
+{
+    return natcmp_sort_merge(strs, n, NULL, alloc);
+}
+
+static int sort_keys(const unsigned char **strs, size_t n,
+                     const natcmp_allocator_t *alloc)
+{
+    return natcmp_sort_keys(strs, n, alloc);
+}
+
+static int sort_inplace(const unsigned char **strs, size_t n,
+                        const natcmp_allocator_t *alloc)
+{
+    (void)alloc;
+    natcmp_sort_inplace(strs, n, NULL, NULL, 0);
+    return 0;
+}
+
+static int sort_inplace_buf(const unsigned char **strs, size_t n,
+                            const natcmp_allocator_t *alloc)
+{
+    const unsigned char *buf[FIXED_BUF];
+    (void)alloc;
+    natcmp_sort_inplace(strs, n, NULL, buf, FIXED_BUF);
+    return 0;
+}
+
+static const engine_t engines[] = {
+    {"qsort",      sort_qsort,       0              },
+    {"merge",      sort_merge,       0              },
+    {"keys",       sort_keys,        0              },
+    {"inplace",    sort_inplace,     0              },
+    {"inplace512", sort_inplace_buf, FIXED_BUF_BYTES},
+};
+
+static long max_rss_kb(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static int run(const engine_t *e, size_t n)
+{
+    bench_corpus_t c;
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a = natcmp_allocator_stats(&st, NULL);
+
+    if (bench_corpus_gen(&c, "files", n, 1) != 0) {
+        return -1;
+    }
+    long rss = max_rss_kb();
+    double t = bench_now();
+    if (e->sort((const unsigned char **)c.strs, n, &a) != 0) {
+        return -1;
+    }
+    t   = bench_now() - t;
+    rss = max_rss_kb() - rss;
+
+    printf("  %-10s %9zu %10.2f ms", e->name, n, t * 1e3);
+    if (e->sort == sort_qsort) {
+        printf(" %12s %8s %12s", "n/a", "n/a", "n/a");
+    } else {
+        printf(" %12zu %8zu %12zu", st.allocated, st.nalloc, st.peak);
+    }
+    printf(" %8zu %10ld\n", e->fixed, rss);
+    bench_corpus_free(&c);
+    return 0;
+}
+
+int main(void)
+{
+    static const size_t sizes[] = {10000, 100000, 1000000};
+
+    printf("=== sort engine memory profile (corpus: files) ===\n");
+    printf("  %-10s %9s %13s %12s %8s %12s %8s %10s\n", "engine", "n", "time",
+           "bytes", "allocs", "peak", "fixed", "+rss(KB)");
+    fflush(stdout);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (size_t k = 0; k < sizeof(engines) / sizeof(engines[0]); k++) {
+            int status;
+            pid_t pid = fork();
+            if (pid == 0) {
+                int rv = run(engines + k, sizes[i]);
+                fflush(stdout);
+                _exit(rv ? 1 : 0);
+            } else if (pid < 0 || waitpid(pid, &status, 0) < 0 ||
+                       !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * Compares the base cases of natcmp_sort.h on small partitions: insertion
+ * sort with natcmp() against natcmp_sort_network() (a sorting network on
+ * 64-bit key prefixes with ties fixed by natcmp()), per corpus and partition
+ * size, then natcmp_sort_merge() with either base case on a whole corpus.
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_sort.h"
+#include "bench.h"
+
+#define NSTR   (1 << 16)
+#define NROUND 8
+
+// same comparison as the default one, but not recognized as such, so the
+// sort engines fall back to insertion sort
+static int cmp_ascii(const unsigned char *a, const unsigned char *b,
+                     unsigned char **end_a, unsigned char **end_b)
+{
+    return natcmp_nondigit_cmp_ascii(a, b, end_a, end_b);
+}
+
+static double run_blocks(const bench_corpus_t *c, const unsigned char **strs,
+                         size_t size, int network)
+{
+    double t = 0;
+    for (int r = 0; r < NROUND; r++) {
+        memcpy(strs, c->strs, sizeof(*strs) * c->n);
+        double t0 = bench_now();
+        for (size_t i = 0; i + size <= c->n; i += size) {
+            if (network) {
+                natcmp_sort_network(strs + i, size);
+            } else {
+                natcmp_sort_insertion(strs + i, size, NULL);
+            }
+        }
+        t += bench_now() - t0;
+    }
+    return t * 1e9 / (double)(c->n / size * size) / NROUND;
+}
+
+static double run_merge(const bench_corpus_t *c, const unsigned char **strs,
+                        natcmp_nondigit_cmp_func_t compare)
+{
+    double t = 0;
+    for (int r = 0; r < NROUND; r++) {
+        memcpy(strs, c->strs, sizeof(*strs) * c->n);
+        double t0 = bench_now();
+        if (natcmp_sort_merge(strs, c->n, compare, NULL) != 0) {
+            return -1;
+        }
+        t += bench_now() - t0;
+    }
+    return t * 1e3 / NROUND;
+}
+
+int main(void)
+{
+    static const char *corpora[] = {"files", "versions", "numeric", "prefix",
+                                    "text"};
+    static const size_t sizes[]  = {8, 16, 32, 64};
+    const unsigned char **strs   = malloc(sizeof(*strs) * NSTR);
+    if (!strs) {
+        return 1;
+    }
+
+    printf("=== base case: insertion sort vs sorting network (ns/string) "
+           "===\n");
+    printf("  %-10s %5s %10s %10s %8s\n", "corpus", "size", "insertion",
+           "network", "speedup");
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        bench_corpus_t c;
+        if (bench_corpus_gen(&c, corpora[i], NSTR, 1 + i) != 0) {
+            return 1;
+        }
+        for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+            double ti = run_blocks(&c, strs, sizes[k], 0);
+            double tn = run_blocks(&c, strs, sizes[k], 1);
+            printf("  %-10s %5zu %10.1f %10.1f %7.2fx\n", corpora[i],
+                   sizes[k], ti, tn, ti / tn);
+        }
+        bench_corpus_free(&c);
+    }
+
+    printf("\n=== natcmp_sort_merge() of %d strings (ms) ===\n", NSTR);
+    printf("  %-10s %10s %10s %8s\n", "corpus", "insertion", "network",
+           "speedup");
+    for (size_t i = 0; i < sizeof(corpora) / sizeof(corpora[0]); i++) {
+        bench_corpus_t c;
+        if (bench_corpus_gen(&c, corpora[i], NSTR, 1 + i) != 0) {
+            return 1;
+        }
+        double ti = run_merge(&c, strs, cmp_ascii);
+        double tn = run_merge(&c, strs, NULL);
+        printf("  %-10s %10.2f %10.2f %7.2fx\n", corpora[i], ti, tn, ti / tn);
+        bench_corpus_free(&c);
+    }
+
+    free(strs);
+    return 0;
+}
@@ -25,9 +25,53 @@
 
 #include <ctype.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <strings.h>
 
+/**
+ * natcmp_swar_between
+ *
+ * Returns a word in which the high bit of each byte is set if the
+ * corresponding byte of x is strictly between m and n (0 <= m, n <= 128).
+ */
+static inline uint64_t natcmp_swar_between(uint64_t x, uint64_t m, uint64_t n)
+{
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    const uint64_t low7 = x & (ones * 127);
+    return ((ones * (127 + n) - low7) & ~x & (low7 + ones * (127 - m))) &
+           (ones * 128);
+}
+
+static inline uint64_t natcmp_swar_load(const unsigned char *s)
+{
+    uint64_t w;
+    memcpy(&w, s, sizeof(w));
+    return w;
+}
+
+// mask of bytes that are '0'-'9'
+#define natcmp_swar_digits(w) natcmp_swar_between((w), '0' - 1, '9' + 1)
+
+/**
+ * natcmp_mismatch
+ *
+ * Returns the index of the first byte that differs between a[0..n) and
+ * b[0..n), or n if they are equal. Compares 8 bytes at a time.
+ */
+static inline size_t natcmp_mismatch(const unsigned char *a,
+                                     const unsigned char *b, size_t n)
+{
+    size_t i = 0;
+    while (i + 8 <= n && natcmp_swar_load(a + i) == natcmp_swar_load(b + i)) {
+        i += 8;
+    }
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
 /**
  * natcmp_nondigit_cmp_func_t
  *
@@ -105,29 +149,344 @@ static inline int natcmp_nondigit_cmp_ascii(const unsigned char *a,
 }
 
 /**
- * natcmp
+ * natcmp_nondigit_cmp_bytes
  *
- * Compares two strings using natural order comparison.
- * Unlike standard string comparison, this treats numeric portions as numbers.
- * Example: "file2.txt" comes before "file10.txt"
+ * Compares the non-digit portions of two strings byte by byte
+ * (case-sensitive). This function is designed to be used as a callback for the
+ * natcmp function.
+ *
+ * The digit boundaries are found with strcspn() and the runs are compared with
+ * memcmp(), so the scan runs at the speed of the C library's word-wide string
+ * functions instead of a byte loop.
+ *
+ * @param a      First string to compare
+ * @param b      Second string to compare
+ * @param end_a  Output parameter to store position of first digit or end in
+ * string A
+ * @param end_b  Output parameter to store position of first digit or end in
+ * string B
+ * @return int   Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
+ */
+static inline int natcmp_nondigit_cmp_bytes(const unsigned char *a,
+                                            const unsigned char *b,
+                                            unsigned char **end_a,
+                                            unsigned char **end_b)
+{
+    // calculate length of non-digit part
+    size_t len_a = strcspn((const char *)a, "0123456789");
+    size_t len_b = strcspn((const char *)b, "0123456789");
+    // compare non-digit part byte by byte
+    int cmp      = memcmp(a, b, (len_a < len_b) ? len_a : len_b);
+    if (cmp != 0) {
+        // non-digit part is different
+        return (cmp < 0) ? -1 : 1;
+    } else if (len_a != len_b) {
+        // length of non-digit part is different
+        return (len_a < len_b) ? -1 : 1;
+    }
+
+    // skip non-digit part
+    *end_a = (unsigned char *)a + len_a;
+    *end_b = (unsigned char *)b + len_b;
+
+    return 0;
+}
+
+/**
+ * natcmp_digit_cmp_func_t
+ *
+ * Callback function type definition for comparing the digit runs at the head
+ * of two strings. Both strings start with a digit. The callback decides where
+ * each run ends, and must set end_a and end_b when it returns 0.
+ *
+ * @param a     First string to compare
+ * @param b     Second string to compare
+ * @param end_a Pointer to store the end position of the run in string A
+ * @param end_b Pointer to store the end position of the run in string B
+ * @return int  result (negative if a < b, positive if a > b, 0 if equal)
+ */
+typedef int (*natcmp_digit_cmp_func_t)(const unsigned char *a,
+                                       const unsigned char *b,
+                                       unsigned char **end_a,
+                                       unsigned char **end_b);
+
+/**
+ * natcmp_digit_cmp
+ *
+ * Compares the digit runs at the head of two strings. This is the digit
+ * comparison used by natcmp().
  *
  * Algorithm:
- * 1. Non-digit portions are compared using the provided callback function
- * 2. Digit portions are compared as numeric values
- * 3. If numeric values are equal, the one with fewer digits comes first
+ * 1. Leading zeros are skipped (the last digit of a run of zeros is kept)
+ * 2. The run with more significant digits is greater
+ * 3. Runs of the same length are compared digit by digit
+ * 4. If the numeric values are equal, the run with more leading zeros is
+ *    greater
+ * 5. Update end_a and end_b to point to the end of each digit run
  *
- * @param a         First string to compare
- * @param b         Second string to compare
- * @param compare   Callback function for comparing non-digit portions
- * @return int      Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ * @param a      First string to compare (must start with a digit)
+ * @param b      Second string to compare (must start with a digit)
+ * @param end_a  Output parameter to store position of end of digit run in
+ * string A
+ * @param end_b  Output parameter to store position of end of digit run in
+ * string B
+ * @return int   Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
  */
-static inline int natcmp(const unsigned char *a, const unsigned char *b,
-                         natcmp_nondigit_cmp_func_t compare)
+static inline int natcmp_digit_cmp(const unsigned char *a,
+                                   const unsigned char *b,
+                                   unsigned char **end_a, unsigned char **end_b)
+{
+    struct {
+        const unsigned char *head; // head of number part with leading zeros
+        const unsigned char
+            *digits; // head of number part without leading zeros
+        size_t len;  // length of number part
+        const unsigned char *tail; // tail of number part
+    } an, bn;
+    an.head = an.tail = a;
+    bn.head = bn.tail = b;
+
+#define natcmp_skip_leading_zeros(s)                                           \
+    while (*(s) == '0' && (s)[1] && isdigit((s)[1])) {                         \
+        (s)++;                                                                 \
+    }
+    natcmp_skip_leading_zeros(an.tail);
+    natcmp_skip_leading_zeros(bn.tail);
+#undef natcmp_skip_leading_zeros
+
+    an.digits = an.tail;
+    bn.digits = bn.tail;
+
+#define natcmp_skip_digits(s)                                                  \
+    while (*(s) && isdigit(*(s))) {                                            \
+        (s)++;                                                                 \
+    }
+    natcmp_skip_digits(an.tail);
+    natcmp_skip_digits(bn.tail);
+#undef natcmp_skip_digits
+
+    // calculate length of number part without leading zeros
+    an.len = (size_t)(an.tail - an.digits);
+    bn.len = (size_t)(bn.tail - bn.digits);
+
+    // compare number part
+    if (an.len != bn.len) {
+        // number part is different
+        return (an.len < bn.len) ? -1 : 1;
+    }
+
+    // compare digits
+    int cmp =
+        strncmp((const char *)an.digits, (const char *)bn.digits, an.len);
+    if (cmp != 0) {
+        // number part is different
+        return (cmp < 0) ? -1 : 1;
+    }
+
+    // compare length of number part with leading zeros
+    an.len = (size_t)(an.tail - an.head);
+    bn.len = (size_t)(bn.tail - bn.head);
+    if (an.len != bn.len) {
+        // longest number part is greater
+        return (an.len < bn.len) ? -1 : 1;
+    }
+
+    // whole number part is same
+    *end_a = (unsigned char *)an.tail;
+    *end_b = (unsigned char *)bn.tail;
+    return 0;
+}
+
+/**
+ * natcmp_digit_cmp_value
+ *
+ * Compares the digit runs at the head of two strings by their numeric value
+ * only: unlike natcmp_digit_cmp(), runs that differ only in their leading
+ * zeros are equal ("007" == "7"). This function is designed to be used as a
+ * callback for the natcmp_ex function.
+ *
+ * @param a      First string to compare (must start with a digit)
+ * @param b      Second string to compare (must start with a digit)
+ * @param end_a  Output parameter to store position of end of digit run in
+ * string A
+ * @param end_b  Output parameter to store position of end of digit run in
+ * string B
+ * @return int   Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
+ */
+static inline int natcmp_digit_cmp_value(const unsigned char *a,
+                                         const unsigned char *b,
+                                         unsigned char **end_a,
+                                         unsigned char **end_b)
+{
+    const unsigned char *da = a;
+    const unsigned char *db = b;
+    while (*da == '0') {
+        da++;
+    }
+    while (*db == '0') {
+        db++;
+    }
+
+    const unsigned char *ta = da;
+    const unsigned char *tb = db;
+    while (isdigit(*ta)) {
+        ta++;
+    }
+    while (isdigit(*tb)) {
+        tb++;
+    }
+
+    // the run with more significant digits is greater
+    size_t len_a = (size_t)(ta - da);
+    size_t len_b = (size_t)(tb - db);
+    if (len_a != len_b) {
+        return (len_a < len_b) ? -1 : 1;
+    }
+    int cmp = memcmp(da, db, len_a);
+    if (cmp != 0) {
+        return (cmp < 0) ? -1 : 1;
+    }
+
+    *end_a = (unsigned char *)ta;
+    *end_b = (unsigned char *)tb;
+    return 0;
+}
+
+/**
+ * natcmp_digit_cmp_zeros_first
+ *
+ * Compares the digit runs at the head of two strings by their numeric value,
+ * and puts the run with more leading zeros first when the values are equal
+ * ("007" < "07" < "7"), the reverse of natcmp_digit_cmp(). This is the order
+ * of gnulib's filevercmp(). This function is designed to be used as a
+ * callback for the natcmp_ex function.
+ *
+ * @param a      First string to compare (must start with a digit)
+ * @param b      Second string to compare (must start with a digit)
+ * @param end_a  Output parameter to store position of end of digit run in
+ * string A
+ * @param end_b  Output parameter to store position of end of digit run in
+ * string B
+ * @return int   Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
+ */
+static inline int natcmp_digit_cmp_zeros_first(const unsigned char *a,
+                                               const unsigned char *b,
+                                               unsigned char **end_a,
+                                               unsigned char **end_b)
+{
+    int res = natcmp_digit_cmp_value(a, b, end_a, end_b);
+    if (res == 0) {
+        // equal values: the longer run has more leading zeros
+        size_t len_a = (size_t)(*end_a - a);
+        size_t len_b = (size_t)(*end_b - b);
+        if (len_a != len_b) {
+            return (len_a < len_b) ? 1 : -1;
+        }
+    }
+    return res;
+}
+
+/**
+ * natcmp_digit_cmp_hex
+ *
+ * Compares the runs of hexadecimal digits at the head of two strings by
+ * their value, for names that embed hexadecimal numbers such as hashes and
+ * addresses. A run starts with a decimal digit and continues over
+ * '0'-'9', 'a'-'f' and 'A'-'F'; a run that starts with a letter ("ff") is
+ * still compared as text. As with natcmp_digit_cmp(), the run with more
+ * leading zeros is greater when the values are equal. This function is
+ * designed to be used as a callback for the natcmp_ex function.
+ *
+ * @param a      First string to compare (must start with a digit)
+ * @param b      Second string to compare (must start with a digit)
+ * @param end_a  Output parameter to store position of end of digit run in
+ * string A
+ * @param end_b  Output parameter to store position of end of digit run in
+ * string B
+ * @return int   Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
+ */
+static inline int natcmp_digit_cmp_hex(const unsigned char *a,
+                                       const unsigned char *b,
+                                       unsigned char **end_a,
+                                       unsigned char **end_b)
+{
+    const unsigned char *da = a;
+    const unsigned char *db = b;
+    while (*da == '0') {
+        da++;
+    }
+    while (*db == '0') {
+        db++;
+    }
+
+    const unsigned char *ta = da;
+    const unsigned char *tb = db;
+    while (isxdigit(*ta)) {
+        ta++;
+    }
+    while (isxdigit(*tb)) {
+        tb++;
+    }
+
+    // the run with more significant digits is greater
+    size_t len_a = (size_t)(ta - da);
+    size_t len_b = (size_t)(tb - db);
+    if (len_a != len_b) {
+        return (len_a < len_b) ? -1 : 1;
+    }
+    for (size_t i = 0; i < len_a; i++) {
+        // '0'-'9' are below 'a'-'f' once lower-cased
+        int ca = tolower(da[i]);
+        int cb = tolower(db[i]);
+        if (ca != cb) {
+            return (ca < cb) ? -1 : 1;
+        }
+    }
+
+    // equal values: the longer run has more leading zeros
+    len_a = (size_t)(ta - a);
+    len_b = (size_t)(tb - b);
+    if (len_a != len_b) {
+        return (len_a < len_b) ? -1 : 1;
+    }
+
+    *end_a = (unsigned char *)ta;
+    *end_b = (unsigned char *)tb;
+    return 0;
+}
+
+/**
+ * natcmp_ex
+ *
+ * Compares two strings using natural order comparison, with callbacks for
+ * both kinds of runs: `compare` for the non-digit portions and
+ * `digit_compare` for the runs that start with a digit. natcmp() is
+ * natcmp_ex() with natcmp_digit_cmp().
+ *
+ * Like natcmp(), this function is inline: when the callbacks are known at the
+ * call site (a built-in passed directly), the compiler can inline them into
+ * the scanning loop instead of calling them through pointers.
+ *
+ * @param a              First string to compare
+ * @param b              Second string to compare
+ * @param compare        Callback function for comparing non-digit portions
+ *                       (NULL selects natcmp_nondigit_cmp_ascii)
+ * @param digit_compare  Callback function for comparing digit runs (NULL
+ *                       selects natcmp_digit_cmp)
+ * @return int           Comparison result (-1=a is less, 0=equal, 1=a is
+ *                       greater)
+ */
+static inline int natcmp_ex(const unsigned char *a, const unsigned char *b,
+                            natcmp_nondigit_cmp_func_t compare,
+                            natcmp_digit_cmp_func_t digit_compare)
 {
     if (!compare) {
         // default to ASCII comparison if no callback is provided
         compare = natcmp_nondigit_cmp_ascii;
     }
+    if (!digit_compare) {
+        digit_compare = natcmp_digit_cmp;
+    }
 
     while (*a && *b) {
         int isdigit_a = isdigit(*a);
@@ -159,64 +518,17 @@ static inline int natcmp(const unsigned char *a, const unsigned char *b,
             return isdigit_a ? -1 : 1;
         }
 
-        struct {
-            const unsigned char *head; // head of number part with leading zeros
-            const unsigned char
-                *digits; // head of number part without leading zeros
-            size_t len;  // length of number part
-            const unsigned char *tail; // tail of number part
-        } an, bn;
-        an.head = an.tail = a;
-        bn.head = bn.tail = b;
-
-#define natcmp_skip_leading_zeros(s)                                           \
-    while (*(s) == '0' && (s)[1] && isdigit((s)[1])) {                         \
-        (s)++;                                                                 \
-    }
-        natcmp_skip_leading_zeros(an.tail);
-        natcmp_skip_leading_zeros(bn.tail);
-#undef natcmp_skip_leading_zeros
-
-        an.digits = an.tail;
-        bn.digits = bn.tail;
-
-#define natcmp_skip_digits(s)                                                  \
-    while (*(s) && isdigit(*(s))) {                                            \
-        (s)++;                                                                 \
-    }
-        natcmp_skip_digits(an.tail);
-        natcmp_skip_digits(bn.tail);
-#undef natcmp_skip_digits
-
-        // calculate length of number part without leading zeros
-        an.len = (size_t)(an.tail - an.digits);
-        bn.len = (size_t)(bn.tail - bn.digits);
-
         // compare number part
-        if (an.len != bn.len) {
-            // number part is different
-            return (an.len < bn.len) ? -1 : 1;
-        }
-
-        // compare digits
-        int cmp =
-            strncmp((const char *)an.digits, (const char *)bn.digits, an.len);
-        if (cmp != 0) {
-            // number part is different
-            return (cmp < 0) ? -1 : 1;
-        }
-
-        // compare length of number part with leading zeros
-        an.len = (size_t)(an.tail - an.head);
-        bn.len = (size_t)(bn.tail - bn.head);
-        if (an.len != bn.len) {
-            // longest number part is greater
-            return (an.len < bn.len) ? -1 : 1;
+        unsigned char *end_a = NULL;
+        unsigned char *end_b = NULL;
+        int res              = digit_compare(a, b, &end_a, &end_b);
+        if (res != 0) {
+            return (res < 0) ? -1 : 1;
         }
 
         // whole number part is same
-        a = an.tail;
-        b = bn.tail;
+        a = end_a;
+        b = end_b;
 
         // continue to next character
     }
@@ -232,4 +544,225 @@ static inline int natcmp(const unsigned char *a, const unsigned char *b,
     return 0;
 }
 
+/**
+ * natcmp
+ *
+ * Compares two strings using natural order comparison.
+ * Unlike standard string comparison, this treats numeric portions as numbers.
+ * Example: "file2.txt" comes before "file10.txt"
+ *
+ * Algorithm:
+ * 1. Non-digit portions are compared using the provided callback function
+ * 2. Digit portions are compared as numeric values
+ * 3. If numeric values are equal, the one with fewer digits comes first
+ *
+ * @param a         First string to compare
+ * @param b         Second string to compare
+ * @param compare   Callback function for comparing non-digit portions
+ * @return int      Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ */
+static inline int natcmp(const unsigned char *a, const unsigned char *b,
+                         natcmp_nondigit_cmp_func_t compare)
+{
+    return natcmp_ex(a, b, compare, natcmp_digit_cmp);
+}
+
+/**
+ * natcmp_total
+ *
+ * Compares two strings using natural order comparison, and breaks ties
+ * between strings that natcmp() considers equal by comparing their raw bytes.
+ * The result is a total order: it returns 0 only for identical strings, so
+ * unstable sorts produce the same output on every run.
+ * Example: "File2" comes before "file2" ('F' < 'f'), and both come before
+ * "file10"
+ *
+ * @param a         First string to compare
+ * @param b         Second string to compare
+ * @param compare   Callback function for comparing non-digit portions
+ * @return int      Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ */
+static inline int natcmp_total(const unsigned char *a, const unsigned char *b,
+                               natcmp_nondigit_cmp_func_t compare)
+{
+    int res = natcmp(a, b, compare);
+    if (res == 0) {
+        // tie-break by byte order
+        res = strcmp((const char *)a, (const char *)b);
+        if (res != 0) {
+            return (res < 0) ? -1 : 1;
+        }
+    }
+    return res;
+}
+
+/**
+ * natcmp_bytes
+ *
+ * Compares two strings using case-sensitive natural order comparison.
+ * The result is the same as natcmp(a, b, natcmp_nondigit_cmp_bytes), but the
+ * common prefix of the two strings is skipped 8 bytes at a time first, and
+ * the natural comparison only starts at the beginning of the run in which the
+ * strings differ.
+ *
+ * @param a         First string to compare
+ * @param b         Second string to compare
+ * @return int      Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ */
+static inline int natcmp_bytes(const unsigned char *a, const unsigned char *b)
+{
+    size_t len_a = strlen((const char *)a);
+    size_t len_b = strlen((const char *)b);
+    // the terminating NUL is compared too, so pos < len + 1 for both
+    size_t pos   = natcmp_mismatch(a, b, ((len_a < len_b) ? len_a : len_b) + 1);
+    if (pos > len_a) {
+        // a and b are same
+        return 0;
+    }
+
+    // a digit run must be compared from its head
+    while (pos && isdigit(a[pos - 1])) {
+        pos--;
+    }
+    return natcmp(a + pos, b + pos, natcmp_nondigit_cmp_bytes);
+}
+
+/**
+ * natcmp_dfa
+ *
+ * Table-driven implementation of natcmp(a, b, NULL). Both strings are scanned
+ * in lockstep, and each step looks up the next action in a transition table
+ * indexed by the current state and the pair of byte classes (end of string,
+ * digit, other). The leading zero counts and the first digit difference of
+ * the current digit runs are kept in local variables, so each byte pair costs
+ * one table lookup and one dispatch instead of the nested class checks of
+ * natcmp(). It gives the same results as natcmp() with the built-in
+ * natcmp_nondigit_cmp_ascii callback.
+ *
+ * @param a         First string to compare
+ * @param b         Second string to compare
+ * @return int      Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ */
+static inline int natcmp_dfa(const unsigned char *a, const unsigned char *b)
+{
+// byte classes
+#define NATCMP_DFA_END   0
+#define NATCMP_DFA_DIGIT 1
+#define NATCMP_DFA_OTHER 2
+// actions
+#define NATCMP_DFA_LT          0 // return -1
+#define NATCMP_DFA_GT          1 // return 1
+#define NATCMP_DFA_EQ          2 // return 0
+#define NATCMP_DFA_TEXT        3 // compare case-insensitively and advance
+#define NATCMP_DFA_DIGIT_START 4 // skip leading zeros and enter digit state
+#define NATCMP_DFA_DIGIT_NEXT  5 // record first difference and advance
+#define NATCMP_DFA_DIGIT_END   6 // resolve digit runs and enter text state
+#define NATCMP_DFA_R16(c) c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c
+    static const unsigned char cls[256] = {
+        NATCMP_DFA_END,   NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER,
+        NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER,
+        NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER,
+        NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER,
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_DIGIT, NATCMP_DFA_DIGIT, NATCMP_DFA_DIGIT, NATCMP_DFA_DIGIT,
+        NATCMP_DFA_DIGIT, NATCMP_DFA_DIGIT, NATCMP_DFA_DIGIT, NATCMP_DFA_DIGIT,
+        NATCMP_DFA_DIGIT, NATCMP_DFA_DIGIT, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER,
+        NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER, NATCMP_DFA_OTHER,
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+        NATCMP_DFA_R16(NATCMP_DFA_OTHER),
+    };
+#undef NATCMP_DFA_R16
+    // transition table: [state][class of a * 3 + class of b]
+    static const unsigned char trans[2][9] = {
+        // text state
+        {NATCMP_DFA_EQ, NATCMP_DFA_LT, NATCMP_DFA_LT, //
+         NATCMP_DFA_GT, NATCMP_DFA_DIGIT_START, NATCMP_DFA_LT, //
+         NATCMP_DFA_GT, NATCMP_DFA_GT, NATCMP_DFA_TEXT},
+        // digit state
+        {NATCMP_DFA_DIGIT_END, NATCMP_DFA_LT, NATCMP_DFA_DIGIT_END, //
+         NATCMP_DFA_GT, NATCMP_DFA_DIGIT_NEXT, NATCMP_DFA_GT, //
+         NATCMP_DFA_DIGIT_END, NATCMP_DFA_LT, NATCMP_DFA_DIGIT_END},
+    };
+    int state     = 0;
+    int diff      = 0; // first difference of significant digits
+    size_t zero_a = 0; // number of leading zeros of digit run in a
+    size_t zero_b = 0; // number of leading zeros of digit run in b
+
+    for (;;) {
+        unsigned int ca = *a;
+        unsigned int cb = *b;
+        switch (trans[state][cls[ca] * 3 + cls[cb]]) {
+        case NATCMP_DFA_LT:
+            return -1;
+        case NATCMP_DFA_GT:
+            return 1;
+        case NATCMP_DFA_EQ:
+            return 0;
+
+        case NATCMP_DFA_TEXT:
+            // lower-case A-Z without branches
+            ca |= (unsigned int)(ca - 'A' < 26) << 5;
+            cb |= (unsigned int)(cb - 'A' < 26) << 5;
+            if (ca != cb) {
+                return (ca < cb) ? -1 : 1;
+            }
+            a++;
+            b++;
+            break;
+
+        case NATCMP_DFA_DIGIT_START:
+            zero_a = zero_b = 0;
+            while (*a == '0' && cls[a[1]] == NATCMP_DFA_DIGIT) {
+                a++;
+                zero_a++;
+            }
+            while (*b == '0' && cls[b[1]] == NATCMP_DFA_DIGIT) {
+                b++;
+                zero_b++;
+            }
+            diff  = 0;
+            state = 1;
+            break;
+
+        case NATCMP_DFA_DIGIT_NEXT:
+            // keep the first difference only
+            diff += (diff == 0) * ((int)ca - (int)cb);
+            a++;
+            b++;
+            break;
+
+        case NATCMP_DFA_DIGIT_END:
+            if (diff != 0) {
+                return (diff < 0) ? -1 : 1;
+            } else if (zero_a != zero_b) {
+                // longest number part is greater
+                return (zero_a < zero_b) ? -1 : 1;
+            }
+            state = 0;
+            break;
+        }
+    }
+#undef NATCMP_DFA_END
+#undef NATCMP_DFA_DIGIT
+#undef NATCMP_DFA_OTHER
+#undef NATCMP_DFA_LT
+#undef NATCMP_DFA_GT
+#undef NATCMP_DFA_EQ
+#undef NATCMP_DFA_TEXT
+#undef NATCMP_DFA_DIGIT_START
+#undef NATCMP_DFA_DIGIT_NEXT
+#undef NATCMP_DFA_DIGIT_END
+}
+
 #endif /* natcmp_h */
@@ -0,0 +1,213 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_alloc_h
+#define natcmp_alloc_h
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/**
+ * natcmp_allocator_t
+ *
+ * Allocator hooks used by every function of the companion headers that needs
+ * scratch memory. Passing NULL wherever an allocator is accepted selects
+ * malloc() and free().
+ *
+ * alloc  Returns a block of at least `size` bytes, or NULL on failure
+ * free   Releases a block returned by alloc; `size` is the size that was
+ *        requested for it
+ * ctx    Opaque pointer passed to both hooks
+ */
+typedef struct {
+    void *(*alloc)(void *ctx, size_t size);
+    void (*free)(void *ctx, void *ptr, size_t size);
+    void *ctx;
+} natcmp_allocator_t;
+
+/**
+ * natcmp_alloc
+ *
+ * Allocates `size` bytes with the allocator (or malloc() if it is NULL).
+ * Sets errno to ENOMEM on failure.
+ *
+ * @param a     Allocator or NULL
+ * @param size  Number of bytes to allocate
+ * @return void*  Allocated block or NULL
+ */
+static inline void *natcmp_alloc(const natcmp_allocator_t *a, size_t size)
+{
+    void *ptr = a ? a->alloc(a->ctx, size ? size : 1) : malloc(size ? size : 1);
+    if (!ptr) {
+        errno = ENOMEM;
+    }
+    return ptr;
+}
+
+/**
+ * natcmp_alloc_array
+ *
+ * Allocates an array of n elements of `size` bytes, failing with ENOMEM if
+ * the total size overflows.
+ */
+static inline void *natcmp_alloc_array(const natcmp_allocator_t *a, size_t n,
+                                       size_t size)
+{
+    if (size && n > (size_t)-1 / size) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return natcmp_alloc(a, n * size);
+}
+
+/**
+ * natcmp_free
+ *
+ * Releases a block allocated by natcmp_alloc() or natcmp_alloc_array().
+ * `size` must be the size that was requested.
+ */
+static inline void natcmp_free(const natcmp_allocator_t *a, void *ptr,
+                               size_t size)
+{
+    if (!ptr) {
+        return;
+    } else if (a) {
+        a->free(a->ctx, ptr, size ? size : 1);
+    } else {
+        free(ptr);
+    }
+}
+
+/**
+ * natcmp_alloc_stats_t
+ *
+ * Counters maintained by the accounting allocator.
+ */
+typedef struct {
+    const natcmp_allocator_t *parent; // allocator to forward to (NULL=malloc)
+    size_t nalloc;    // number of allocations
+    size_t nfree;     // number of releases
+    size_t allocated; // total number of bytes allocated
+    size_t current;   // number of bytes currently allocated
+    size_t peak;      // largest value of `current`
+} natcmp_alloc_stats_t;
+
+static inline void *natcmp_alloc_stats_alloc(void *ctx, size_t size)
+{
+    natcmp_alloc_stats_t *st = (natcmp_alloc_stats_t *)ctx;
+    void *ptr                = natcmp_alloc(st->parent, size);
+    if (ptr) {
+        st->nalloc++;
+        st->allocated += size;
+        st->current += size;
+        if (st->current > st->peak) {
+            st->peak = st->current;
+        }
+    }
+    return ptr;
+}
+
+static inline void natcmp_alloc_stats_free(void *ctx, void *ptr, size_t size)
+{
+    natcmp_alloc_stats_t *st = (natcmp_alloc_stats_t *)ctx;
+    st->nfree++;
+    st->current -= size;
+    natcmp_free(st->parent, ptr, size);
+}
+
+/**
+ * natcmp_allocator_stats
+ *
+ * Initializes `st` and returns an allocator that forwards to `parent` and
+ * records the number of allocations, the bytes allocated and the peak number
+ * of bytes live at the same time in `st`.
+ *
+ * @param st      Counters to update
+ * @param parent  Allocator to forward to, or NULL for malloc()
+ * @return natcmp_allocator_t  Accounting allocator
+ */
+static inline natcmp_allocator_t
+natcmp_allocator_stats(natcmp_alloc_stats_t *st,
+                       const natcmp_allocator_t *parent)
+{
+    natcmp_allocator_t a = {natcmp_alloc_stats_alloc, natcmp_alloc_stats_free,
+                            st};
+    st->parent           = parent;
+    st->nalloc           = 0;
+    st->nfree            = 0;
+    st->allocated        = 0;
+    st->current          = 0;
+    st->peak             = 0;
+    return a;
+}
+
+/**
+ * natcmp_alloc_fail_t
+ *
+ * State of the failing allocator.
+ */
+typedef struct {
+    const natcmp_allocator_t *parent; // allocator to forward to (NULL=malloc)
+    size_t left;                      // allocations left before failing
+} natcmp_alloc_fail_t;
+
+static inline void *natcmp_alloc_fail_alloc(void *ctx, size_t size)
+{
+    natcmp_alloc_fail_t *f = (natcmp_alloc_fail_t *)ctx;
+    if (!f->left) {
+        return NULL;
+    }
+    f->left--;
+    return natcmp_alloc(f->parent, size);
+}
+
+static inline void natcmp_alloc_fail_free(void *ctx, void *ptr, size_t size)
+{
+    natcmp_alloc_fail_t *f = (natcmp_alloc_fail_t *)ctx;
+    natcmp_free(f->parent, ptr, size);
+}
+
+/**
+ * natcmp_allocator_failing
+ *
+ * Initializes `f` and returns an allocator that forwards the first `left`
+ * allocations to `parent` and fails every later one, to test the handling of
+ * allocation failures. Blocks are released through `parent`.
+ *
+ * @param f       State to update
+ * @param left    Number of allocations that succeed (0 fails every one)
+ * @param parent  Allocator to forward to, or NULL for malloc()
+ * @return natcmp_allocator_t  Failing allocator
+ */
+static inline natcmp_allocator_t
+natcmp_allocator_failing(natcmp_alloc_fail_t *f, size_t left,
+                         const natcmp_allocator_t *parent)
+{
+    natcmp_allocator_t a = {natcmp_alloc_fail_alloc, natcmp_alloc_fail_free,
+                            f};
+    f->parent            = parent;
+    f->left              = left;
+    return a;
+}
+
+#endif /* natcmp_alloc_h */
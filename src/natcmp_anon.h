@@ -0,0 +1,426 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_anon_h
+#define natcmp_anon_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_sort.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Corpus anonymization
+ *
+ * natcmp_anon_t rewrites names so that they can be published as benchmark
+ * corpora without revealing them, while keeping what the cost of natcmp()
+ * depends on: every name keeps its length and the position and length of its
+ * text and digit runs.
+ *
+ * - ASCII letters are replaced by letters of the same case. The replacement
+ *   of a letter is a permutation of the alphabet chosen by the seed and by
+ *   the letters and punctuation before it (case-insensitively, with each
+ *   digit run standing for a single symbol). Names that share a prefix share
+ *   the replaced prefix, and the first letter where they differ still
+ *   differs, so natcmp() walks the same distance into them. Names equal
+ *   under the default case-insensitive comparison stay equal.
+ * - Digit runs keep their leading zeros and number of significant digits.
+ *   The numbers of each length are replaced by random numbers of that length
+ *   kept in the same order, so the numeric order of all the numbers of the
+ *   corpus is kept, and equal numbers stay equal.
+ * - Other bytes (punctuation, spaces, non-ASCII bytes) are kept.
+ *
+ * The numbers must be known in advance: add every name with
+ * natcmp_anon_add(), call natcmp_anon_build(), then rewrite the names with
+ * natcmp_anon_apply(). The result only depends on the seed and the set of
+ * names.
+ */
+
+/**
+ * natcmp_anon_t
+ *
+ * Anonymizer. Initialize it with natcmp_anon_init() and release it with
+ * natcmp_anon_free().
+ */
+typedef struct {
+    uint64_t seed;
+    unsigned char *digits;       // numbers added, NUL-terminated
+    size_t dlen;                 // number of bytes used in digits
+    size_t dcap;                 // size of digits
+    size_t *offs;                // offset in digits of each number added
+    size_t noff;                 // number of numbers added
+    size_t offcap;               // number of allocated offsets
+    const unsigned char **nums;  // distinct numbers in order (after build)
+    const unsigned char **repl;  // replacement of each of nums
+    size_t nnum;                 // number of distinct numbers
+    unsigned char *rbuf;         // replacement digits, each NUL-terminated
+    size_t rsize;                // size of rbuf
+    const natcmp_allocator_t *alloc;
+} natcmp_anon_t;
+
+// splitmix64
+static inline uint64_t natcmp_anon_rand(uint64_t *state)
+{
+    uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z          = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z          = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+// returns the length of the digit run at s and the number of its leading
+// zeros in *nz
+static inline size_t natcmp_anon_run(const unsigned char *s, size_t *nz)
+{
+    size_t len = 0;
+    while (s[len] == '0') {
+        len++;
+    }
+    *nz = len;
+    while (isdigit(s[len])) {
+        len++;
+    }
+    return len;
+}
+
+/**
+ * natcmp_anon_init
+ *
+ * Initializes an anonymizer.
+ *
+ * @param an     Anonymizer to initialize
+ * @param seed   Secret seed of the replacements
+ * @param alloc  Allocator or NULL
+ */
+static inline void natcmp_anon_init(natcmp_anon_t *an, uint64_t seed,
+                                    const natcmp_allocator_t *alloc)
+{
+    memset(an, 0, sizeof(*an));
+    an->seed  = seed;
+    an->alloc = alloc;
+}
+
+/**
+ * natcmp_anon_free
+ *
+ * Releases the memory of an anonymizer.
+ */
+static inline void natcmp_anon_free(natcmp_anon_t *an)
+{
+    natcmp_free(an->alloc, an->digits, an->dcap);
+    natcmp_free(an->alloc, an->offs, sizeof(*an->offs) * an->offcap);
+    natcmp_free(an->alloc, (void *)an->nums, sizeof(*an->nums) * an->noff);
+    natcmp_free(an->alloc, (void *)an->repl, sizeof(*an->repl) * an->noff);
+    natcmp_free(an->alloc, an->rbuf, an->rsize);
+    natcmp_anon_init(an, an->seed, an->alloc);
+}
+
+/**
+ * natcmp_anon_add
+ *
+ * Records the numbers of a name.
+ *
+ * @return int  0 on success, -1 on failure with errno set to ENOMEM
+ */
+static inline int natcmp_anon_add(natcmp_anon_t *an, const unsigned char *str)
+{
+    while (*str) {
+        if (!isdigit(*str)) {
+            str++;
+            continue;
+        }
+        size_t nz;
+        size_t len = natcmp_anon_run(str, &nz);
+        size_t sig = len - nz;
+        if (sig) {
+            if (an->dlen + sig + 1 > an->dcap) {
+                size_t cap = an->dcap ? an->dcap : 4096;
+                while (cap < an->dlen + sig + 1) {
+                    cap *= 2;
+                }
+                unsigned char *p = (unsigned char *)natcmp_alloc(an->alloc,
+                                                                 cap);
+                if (!p) {
+                    return -1;
+                }
+                if (an->dlen) {
+                    memcpy(p, an->digits, an->dlen);
+                }
+                natcmp_free(an->alloc, an->digits, an->dcap);
+                an->digits = p;
+                an->dcap   = cap;
+            }
+            if (an->noff == an->offcap) {
+                size_t cap = an->offcap ? an->offcap * 2 : 256;
+                size_t *p  = (size_t *)natcmp_alloc_array(an->alloc, cap,
+                                                          sizeof(*p));
+                if (!p) {
+                    return -1;
+                }
+                if (an->noff) {
+                    memcpy(p, an->offs, sizeof(*p) * an->noff);
+                }
+                natcmp_free(an->alloc, an->offs, sizeof(*p) * an->offcap);
+                an->offs   = p;
+                an->offcap = cap;
+            }
+            an->offs[an->noff++] = an->dlen;
+            memcpy(an->digits + an->dlen, str + nz, sig);
+            an->digits[an->dlen + sig] = '\0';
+            an->dlen += sig + 1;
+        }
+        str += len;
+    }
+    return 0;
+}
+
+// writes `len` digits of the number first + i, where first is the smallest
+// number of `len` significant digits
+static inline void natcmp_anon_digits(unsigned char *p, size_t len, uint64_t i)
+{
+    for (size_t k = len; k-- > 0;) {
+        p[k] = (unsigned char)('0' + i % 10);
+        i /= 10;
+    }
+    p[0] = (unsigned char)(p[0] + 1);
+}
+
+// chooses m distinct numbers of `len` significant digits into p in order
+static inline int natcmp_anon_choose(natcmp_anon_t *an, uint64_t *rnd,
+                                     unsigned char *p, size_t len, size_t m)
+{
+    if (len <= 7) {
+        // selection sampling over the 9 * 10^(len - 1) numbers
+        uint64_t total = 9;
+        for (size_t k = 1; k < len; k++) {
+            total *= 10;
+        }
+        size_t left = m;
+        for (uint64_t i = 0; left; i++) {
+            if (natcmp_anon_rand(rnd) % (total - i) < left) {
+                natcmp_anon_digits(p, len, i);
+                p[len] = '\0';
+                p += len + 1;
+                left--;
+            }
+        }
+        return 0;
+    }
+
+    // draw random numbers, sort them and draw again the duplicates
+    const unsigned char **v = (const unsigned char **)natcmp_alloc_array(
+        an->alloc, m, sizeof(*v));
+    if (!v) {
+        return -1;
+    }
+    for (size_t i = 0; i < m; i++) {
+        unsigned char *q = p + i * (len + 1);
+        q[0]             = (unsigned char)('1' + natcmp_anon_rand(rnd) % 9);
+        for (size_t k = 1; k < len; k++) {
+            q[k] = (unsigned char)('0' + natcmp_anon_rand(rnd) % 10);
+        }
+        q[len] = '\0';
+        v[i]   = q;
+    }
+    int rv = 0;
+    for (int dup = 1; dup && rv == 0;) {
+        rv  = natcmp_sort_merge(v, m, NULL, an->alloc);
+        dup = 0;
+        for (size_t i = 1; i < m; i++) {
+            if (memcmp(v[i - 1], v[i], len) == 0) {
+                unsigned char *q = (unsigned char *)(uintptr_t)v[i];
+                for (size_t k = 1; k < len; k++) {
+                    q[k] = (unsigned char)('0' + natcmp_anon_rand(rnd) % 10);
+                }
+                dup = 1;
+            }
+        }
+    }
+    // copy the numbers in order through the pointers, from a scratch copy
+    if (rv == 0) {
+        size_t size        = m * (len + 1);
+        unsigned char *tmp = (unsigned char *)natcmp_alloc(an->alloc, size);
+        if (!tmp) {
+            rv = -1;
+        } else {
+            for (size_t i = 0; i < m; i++) {
+                memcpy(tmp + i * (len + 1), v[i], len + 1);
+            }
+            memcpy(p, tmp, size);
+            natcmp_free(an->alloc, tmp, size);
+        }
+    }
+    natcmp_free(an->alloc, (void *)v, sizeof(*v) * m);
+    return rv;
+}
+
+/**
+ * natcmp_anon_build
+ *
+ * Chooses the replacements of the numbers added so far. More names cannot be
+ * added afterwards.
+ *
+ * @return int  0 on success, -1 on failure with errno set to ENOMEM
+ */
+static inline int natcmp_anon_build(natcmp_anon_t *an)
+{
+    size_t n = an->noff;
+    an->nums = (const unsigned char **)natcmp_alloc_array(an->alloc, n,
+                                                          sizeof(*an->nums));
+    an->repl = (const unsigned char **)natcmp_alloc_array(an->alloc, n,
+                                                          sizeof(*an->repl));
+    if (!an->nums || !an->repl) {
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        an->nums[i] = an->digits + an->offs[i];
+    }
+    // numbers without leading zeros are in numeric order under natcmp()
+    if (natcmp_sort_merge(an->nums, n, NULL, an->alloc) != 0) {
+        return -1;
+    }
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!m || strcmp((const char *)an->nums[m - 1],
+                         (const char *)an->nums[i]) != 0) {
+            an->nums[m++] = an->nums[i];
+        }
+    }
+    an->nnum = m;
+
+    an->rsize = 0;
+    for (size_t i = 0; i < m; i++) {
+        an->rsize += strlen((const char *)an->nums[i]) + 1;
+    }
+    an->rbuf = (unsigned char *)natcmp_alloc(an->alloc, an->rsize);
+    if (!an->rbuf) {
+        return -1;
+    }
+
+    // replace the numbers of each length by as many in the same order
+    uint64_t rnd     = an->seed;
+    unsigned char *p = an->rbuf;
+    for (size_t i = 0; i < m;) {
+        size_t len = strlen((const char *)an->nums[i]);
+        size_t j   = i;
+        while (j < m && strlen((const char *)an->nums[j]) == len) {
+            an->repl[j] = p + (j - i) * (len + 1);
+            j++;
+        }
+        if (natcmp_anon_choose(an, &rnd, p, len, j - i) != 0) {
+            return -1;
+        }
+        p += (j - i) * (len + 1);
+        i = j;
+    }
+    return 0;
+}
+
+// returns the replacement of the `len` significant digits at s
+static inline const unsigned char *
+natcmp_anon_find(const natcmp_anon_t *an, const unsigned char *s, size_t len)
+{
+    size_t lo = 0;
+    size_t hi = an->nnum;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t l   = strlen((const char *)an->nums[mid]);
+        int rv     = (l != len) ? (l < len ? -1 : 1)
+                                : memcmp(an->nums[mid], s, len);
+        if (rv == 0) {
+            return an->repl[mid];
+        } else if (rv < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * natcmp_anon_apply
+ *
+ * Rewrites a name that was added before natcmp_anon_build().
+ *
+ * @param an   Built anonymizer
+ * @param str  Name to rewrite
+ * @param out  Buffer of at least strlen(str) + 1 bytes for the result
+ * @return int  0 on success, -1 with errno set to EINVAL if the name has a
+ *              number that was not added
+ */
+static inline int natcmp_anon_apply(const natcmp_anon_t *an,
+                                    const unsigned char *str,
+                                    unsigned char *out)
+{
+    // FNV-1a hash of the context of the next letter
+    uint64_t h = UINT64_C(0xCBF29CE484222325) ^ an->seed;
+
+    while (*str) {
+        unsigned char c = *str;
+        if (isdigit(c)) {
+            size_t nz;
+            size_t len = natcmp_anon_run(str, &nz);
+            memcpy(out, str, nz);
+            if (len > nz) {
+                const unsigned char *r = natcmp_anon_find(an, str + nz,
+                                                          len - nz);
+                if (!r) {
+                    errno = EINVAL;
+                    return -1;
+                }
+                memcpy(out + nz, r, len - nz);
+            }
+            str += len;
+            out += len;
+            c = '0';
+        } else {
+            int upper = (c >= 'A' && c <= 'Z');
+            if (upper || (c >= 'a' && c <= 'z')) {
+                // partial Fisher-Yates shuffle up to the letter's position
+                unsigned char perm[26];
+                uint64_t rnd = h;
+                size_t k     = (size_t)(c - (upper ? 'A' : 'a'));
+                for (size_t i = 0; i < 26; i++) {
+                    perm[i] = (unsigned char)i;
+                }
+                for (size_t i = 0; i <= k; i++) {
+                    size_t j        = i + natcmp_anon_rand(&rnd) % (26 - i);
+                    unsigned char t = perm[i];
+                    perm[i]         = perm[j];
+                    perm[j]         = t;
+                }
+                *out = (unsigned char)((upper ? 'A' : 'a') + perm[k]);
+                c    = (unsigned char)(c | 0x20);
+            } else {
+                *out = c;
+            }
+            str++;
+            out++;
+        }
+        h = (h ^ c) * UINT64_C(0x100000001B3);
+    }
+    *out = '\0';
+    return 0;
+}
+
+#endif /* natcmp_anon_h */
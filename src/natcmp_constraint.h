@@ -0,0 +1,532 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_constraint_h
+#define natcmp_constraint_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_sort.h"
+
+/**
+ * Version constraints
+ *
+ * A constraint is a comma-separated list of clauses that must all hold, such
+ * as ">=1.2.10,<2.0". A clause is an operator (">=", ">", "<=", "<", "=",
+ * "==" or "!=") followed by a version; a clause without an operator means
+ * "=". Spaces around clauses and operators are ignored. Versions are compared
+ * with natcmp().
+ *
+ * natcmp_constraint_compile() reduces the clauses to the tightest lower and
+ * upper bound and a sorted list of excluded versions, so matching a version
+ * costs one comparison with the bounds plus a binary search of the
+ * exclusions, whatever the number of clauses.
+ *
+ * With the default natcmp_nondigit_cmp_ascii callback, the bounds are also
+ * split into prepared runs (text runs with their lengths, digit runs with
+ * their significant digits and widths), and natcmp_constraint_match() checks
+ * the version against both bounds in a single pass: every run of the version
+ * is delimited and skipped once and compared with the run of each bound that
+ * is still undecided. A custom callback decides where its runs end, so it is
+ * called once per bound as by natcmp().
+ */
+
+/**
+ * natcmp_constraint_run_t
+ *
+ * Run of a prepared bound.
+ */
+typedef struct {
+    const unsigned char *s; // text, or digits without leading zeros
+    size_t len;             // length of the text or of the digits at s
+    size_t width;           // length of the digit run with zeros (0 for text)
+} natcmp_constraint_run_t;
+
+/**
+ * natcmp_constraint_t
+ *
+ * A compiled constraint. Bound strings point into `buf`.
+ */
+typedef struct {
+    const unsigned char *lo;    // lower bound or NULL
+    const unsigned char *hi;    // upper bound or NULL
+    int lo_incl;                // lower bound is inclusive
+    int hi_incl;                // upper bound is inclusive
+    int empty;                  // no version can match
+    const unsigned char **excl; // excluded versions in natural order
+    size_t nexcl;               // number of excluded versions
+    natcmp_nondigit_cmp_func_t compare;
+    void *buf;   // storage of the bound strings and exclusions
+    size_t size; // size of buf
+    natcmp_constraint_run_t *runs; // runs of lo then of hi, or NULL
+    size_t lo_nrun;                // number of runs of lo
+    size_t hi_nrun;                // number of runs of hi
+    const natcmp_allocator_t *alloc;
+} natcmp_constraint_t;
+
+/**
+ * natcmp_range_t
+ *
+ * Half-open range [begin, end) of array indices.
+ */
+typedef struct {
+    size_t begin;
+    size_t end;
+} natcmp_range_t;
+
+/**
+ * natcmp_lower_bound
+ *
+ * Returns the index of the first string of the sorted array `strs` that is not
+ * less than `key`, or n if there is none.
+ */
+static inline size_t natcmp_lower_bound(const unsigned char *const *strs,
+                                        size_t n, const unsigned char *key,
+                                        natcmp_nondigit_cmp_func_t compare)
+{
+    size_t lo = 0;
+    while (n > 0) {
+        size_t half = n / 2;
+        if (natcmp(strs[lo + half], key, compare) < 0) {
+            lo += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return lo;
+}
+
+/**
+ * natcmp_upper_bound
+ *
+ * Returns the index of the first string of the sorted array `strs` that is
+ * greater than `key`, or n if there is none.
+ */
+static inline size_t natcmp_upper_bound(const unsigned char *const *strs,
+                                        size_t n, const unsigned char *key,
+                                        natcmp_nondigit_cmp_func_t compare)
+{
+    size_t lo = 0;
+    while (n > 0) {
+        size_t half = n / 2;
+        if (natcmp(strs[lo + half], key, compare) <= 0) {
+            lo += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return lo;
+}
+
+// tightens the bound `*cur` with `v`; `dir` is -1 for lower and 1 for upper
+static inline void natcmp_constraint_bound(const unsigned char **cur,
+                                           int *incl, const unsigned char *v,
+                                           int vincl, int dir,
+                                           natcmp_nondigit_cmp_func_t compare)
+{
+    int cmp = *cur ? natcmp(v, *cur, compare) : -dir;
+    if (cmp == dir) {
+        // v is looser than the current bound
+        return;
+    } else if (cmp == 0) {
+        *incl = *incl && vincl;
+        return;
+    }
+    *cur  = v;
+    *incl = vincl;
+}
+
+/**
+ * natcmp_constraint_run
+ *
+ * Delimits the run at the head of `s` (which must not be at its end) as
+ * natcmp() with natcmp_nondigit_cmp_ascii does, and returns its end.
+ */
+static inline const unsigned char *
+natcmp_constraint_run(const unsigned char *s, natcmp_constraint_run_t *r)
+{
+    const unsigned char *p = s;
+    if (isdigit(*p)) {
+        // natcmp_digit_cmp() keeps the last digit of an all-zero run
+        while (*p == '0' && isdigit(p[1])) {
+            p++;
+        }
+        r->s = p;
+        while (isdigit(*p)) {
+            p++;
+        }
+        r->len   = (size_t)(p - r->s);
+        r->width = (size_t)(p - s);
+    } else {
+        while (*p && !isdigit(*p)) {
+            p++;
+        }
+        r->s     = s;
+        r->len   = (size_t)(p - s);
+        r->width = 0;
+    }
+    return p;
+}
+
+/**
+ * natcmp_constraint_run_cmp
+ *
+ * Compares two runs like natcmp_nondigit_cmp_ascii() and natcmp_digit_cmp().
+ *
+ * @return int  Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
+ */
+static inline int natcmp_constraint_run_cmp(const natcmp_constraint_run_t *a,
+                                            const natcmp_constraint_run_t *b)
+{
+    if (!a->width != !b->width) {
+        // number is less than non-digit character
+        return a->width ? -1 : 1;
+    } else if (a->width && a->len != b->len) {
+        // the number with more significant digits is greater
+        return (a->len < b->len) ? -1 : 1;
+    }
+
+    size_t n = (a->len < b->len) ? a->len : b->len;
+    int cmp  = a->width ? memcmp(a->s, b->s, n)
+                        : strncasecmp((const char *)a->s,
+                                      (const char *)b->s, n);
+    if (cmp != 0) {
+        return (cmp < 0) ? -1 : 1;
+    } else if (a->len != b->len) {
+        // shorter text is less
+        return (a->len < b->len) ? -1 : 1;
+    } else if (a->width != b->width) {
+        // longest number with leading zeros is greater
+        return (a->width < b->width) ? -1 : 1;
+    }
+    return 0;
+}
+
+// counts the runs of `s`, storing them into `runs` if it is not NULL
+static inline size_t natcmp_constraint_split(const unsigned char *s,
+                                             natcmp_constraint_run_t *runs)
+{
+    natcmp_constraint_run_t r;
+    size_t n = 0;
+    while (*s) {
+        s = natcmp_constraint_run(s, runs ? &runs[n] : &r);
+        n++;
+    }
+    return n;
+}
+
+/**
+ * natcmp_constraint_prepare
+ *
+ * Splits the bounds of `c` into runs.
+ *
+ * @return int  0 on success, -1 on failure with errno set to ENOMEM
+ */
+static inline int natcmp_constraint_prepare(natcmp_constraint_t *c)
+{
+    c->lo_nrun = c->lo ? natcmp_constraint_split(c->lo, NULL) : 0;
+    c->hi_nrun = c->hi ? natcmp_constraint_split(c->hi, NULL) : 0;
+    if (!c->lo_nrun && !c->hi_nrun) {
+        return 0;
+    }
+    c->runs = (natcmp_constraint_run_t *)natcmp_alloc_array(
+        c->alloc, c->lo_nrun + c->hi_nrun, sizeof(*c->runs));
+    if (!c->runs) {
+        return -1;
+    }
+    if (c->lo) {
+        natcmp_constraint_split(c->lo, c->runs);
+    }
+    if (c->hi) {
+        natcmp_constraint_split(c->hi, c->runs + c->lo_nrun);
+    }
+    return 0;
+}
+
+/**
+ * natcmp_constraint_compile
+ *
+ * Parses `str` into a compiled constraint.
+ *
+ * @param c        Constraint to initialize
+ * @param str      Constraint string
+ * @param compare  Callback function for comparing non-digit portions
+ * @param alloc    Allocator or NULL
+ * @return int     0 on success, -1 on failure with errno set to EINVAL (syntax
+ *                 error) or ENOMEM
+ */
+static inline int natcmp_constraint_compile(natcmp_constraint_t *c,
+                                            const char *str,
+                                            natcmp_nondigit_cmp_func_t compare,
+                                            const natcmp_allocator_t *alloc)
+{
+    size_t len     = strlen(str);
+    size_t nclause = 1;
+    for (size_t i = 0; i < len; i++) {
+        nclause += (str[i] == ',');
+    }
+
+    memset(c, 0, sizeof(*c));
+    c->compare = compare;
+    c->alloc   = alloc;
+    c->lo_incl = 1;
+    c->hi_incl = 1;
+    c->size    = sizeof(*c->excl) * nclause + len + 1;
+    c->buf     = natcmp_alloc(alloc, c->size);
+    if (!c->buf) {
+        return -1;
+    }
+    c->excl          = (const unsigned char **)c->buf;
+    unsigned char *p = (unsigned char *)(c->excl + nclause);
+    memcpy(p, str, len + 1);
+
+#define natcmp_constraint_skip_spaces(s)                                       \
+    while (*(s) == ' ' || *(s) == '\t') {                                      \
+        (s)++;                                                                 \
+    }
+    for (;;) {
+        int lower = 0;
+        int upper = 0;
+        int incl  = 1;
+        int ne    = 0;
+
+        natcmp_constraint_skip_spaces(p);
+        if (p[0] == '>' || p[0] == '<') {
+            lower = (p[0] == '>');
+            upper = !lower;
+            incl  = (p[1] == '=');
+            p += incl ? 2 : 1;
+        } else if (p[0] == '!' && p[1] == '=') {
+            ne = 1;
+            p += 2;
+        } else if (p[0] == '=') {
+            p += (p[1] == '=') ? 2 : 1;
+        }
+        natcmp_constraint_skip_spaces(p);
+
+        unsigned char *v = p;
+        while (*p && *p != ',' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        unsigned char *end = p;
+        natcmp_constraint_skip_spaces(p);
+        if (end == v || (*p && *p != ',') || strchr("<>=!", *v)) {
+            // missing version or garbage after it
+            natcmp_free(alloc, c->buf, c->size);
+            c->buf = NULL;
+            errno  = EINVAL;
+            return -1;
+        }
+        int last = !*p;
+        *end     = 0;
+        p++;
+
+        if (ne) {
+            c->excl[c->nexcl++] = v;
+        } else {
+            if (!upper) {
+                natcmp_constraint_bound(&c->lo, &c->lo_incl, v, incl, -1,
+                                        compare);
+            }
+            if (!lower) {
+                natcmp_constraint_bound(&c->hi, &c->hi_incl, v, incl, 1,
+                                        compare);
+            }
+        }
+        if (last) {
+            break;
+        }
+    }
+#undef natcmp_constraint_skip_spaces
+
+    if (c->lo && c->hi) {
+        int cmp  = natcmp(c->lo, c->hi, compare);
+        c->empty = cmp > 0 || (cmp == 0 && !(c->lo_incl && c->hi_incl));
+    }
+    natcmp_sort_insertion(c->excl, c->nexcl, compare);
+
+    if ((!compare || compare == natcmp_nondigit_cmp_ascii) &&
+        natcmp_constraint_prepare(c) != 0) {
+        natcmp_free(alloc, c->buf, c->size);
+        c->buf = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * natcmp_constraint_free
+ *
+ * Releases the memory of a compiled constraint.
+ */
+static inline void natcmp_constraint_free(natcmp_constraint_t *c)
+{
+    natcmp_free(c->alloc, c->runs,
+                (c->lo_nrun + c->hi_nrun) * sizeof(*c->runs));
+    natcmp_free(c->alloc, c->buf, c->size);
+    c->runs = NULL;
+    c->buf  = NULL;
+}
+
+/**
+ * natcmp_constraint_cmp_bounds
+ *
+ * Compares `version` with both prepared bounds in one pass over `version`.
+ * res[0] and res[1] receive the natcmp() results against lo and hi (0 for a
+ * bound that is not set).
+ */
+static inline void natcmp_constraint_cmp_bounds(const natcmp_constraint_t *c,
+                                                const unsigned char *version,
+                                                int res[2])
+{
+    const natcmp_constraint_run_t *runs[2] = {c->runs,
+                                              c->runs + c->lo_nrun};
+    size_t nrun[2]                         = {c->lo_nrun, c->hi_nrun};
+    int open[2]                            = {c->lo != NULL, c->hi != NULL};
+
+    res[0] = 0;
+    res[1] = 0;
+    for (size_t i = 0; open[0] || open[1]; i++) {
+        natcmp_constraint_run_t r = {NULL, 0, 0};
+        int end                   = !*version;
+        if (!end) {
+            version = natcmp_constraint_run(version, &r);
+        }
+        for (int k = 0; k < 2; k++) {
+            if (!open[k]) {
+                continue;
+            } else if (i == nrun[k] || end) {
+                // the shorter string is less
+                res[k] = (i == nrun[k]) ? !end : -1;
+            } else {
+                res[k] = natcmp_constraint_run_cmp(&r, &runs[k][i]);
+            }
+            open[k] = (res[k] == 0 && !end);
+        }
+    }
+}
+
+/**
+ * natcmp_constraint_match
+ *
+ * Returns 1 if `version` satisfies the constraint, 0 otherwise.
+ */
+static inline int natcmp_constraint_match(const natcmp_constraint_t *c,
+                                          const unsigned char *version)
+{
+    if (c->empty) {
+        return 0;
+    }
+    if (c->runs) {
+        int cmp[2];
+        natcmp_constraint_cmp_bounds(c, version, cmp);
+        if ((c->lo && (cmp[0] < 0 || (cmp[0] == 0 && !c->lo_incl))) ||
+            (c->hi && (cmp[1] > 0 || (cmp[1] == 0 && !c->hi_incl)))) {
+            return 0;
+        }
+    } else if (c->lo) {
+        int cmp = natcmp(version, c->lo, c->compare);
+        if (cmp < 0 || (cmp == 0 && !c->lo_incl)) {
+            return 0;
+        }
+    }
+    if (!c->runs && c->hi) {
+        int cmp = natcmp(version, c->hi, c->compare);
+        if (cmp > 0 || (cmp == 0 && !c->hi_incl)) {
+            return 0;
+        }
+    }
+    if (c->nexcl) {
+        size_t i = natcmp_lower_bound(c->excl, c->nexcl, version, c->compare);
+        if (i < c->nexcl && natcmp(c->excl[i], version, c->compare) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * natcmp_constraint_filter
+ *
+ * Finds the versions of the naturally sorted array `strs` that satisfy the
+ * constraint, as ranges of indices in ascending order. The bounds are found
+ * by binary search and every exclusion splits the range it falls into.
+ *
+ * @param c        Compiled constraint
+ * @param strs     Array of versions sorted with the same callback
+ * @param n        Number of versions
+ * @param out      Output array of ranges
+ * @param max      Number of elements of `out`
+ * @return size_t  Number of ranges (at most nexcl + 1). Like snprintf(), the
+ *                 full number is returned even if it exceeds `max`, and only
+ *                 the first `max` ranges are written.
+ */
+static inline size_t natcmp_constraint_filter(const natcmp_constraint_t *c,
+                                              const unsigned char *const *strs,
+                                              size_t n, natcmp_range_t *out,
+                                              size_t max)
+{
+    size_t begin = 0;
+    size_t end   = n;
+    size_t count = 0;
+
+    if (c->empty) {
+        return 0;
+    }
+    if (c->lo) {
+        begin = c->lo_incl ? natcmp_lower_bound(strs, n, c->lo, c->compare)
+                           : natcmp_upper_bound(strs, n, c->lo, c->compare);
+    }
+    if (c->hi) {
+        end = c->hi_incl ? natcmp_upper_bound(strs, n, c->hi, c->compare)
+                         : natcmp_lower_bound(strs, n, c->hi, c->compare);
+    }
+
+#define natcmp_constraint_emit(b, e)                                           \
+    do {                                                                       \
+        if (count < max) {                                                     \
+            out[count].begin = (b);                                            \
+            out[count].end   = (e);                                            \
+        }                                                                      \
+        count++;                                                               \
+    } while (0)
+    for (size_t i = 0; i < c->nexcl && begin < end; i++) {
+        size_t lb = begin + natcmp_lower_bound(strs + begin, end - begin,
+                                               c->excl[i], c->compare);
+        size_t ub = lb + natcmp_upper_bound(strs + lb, end - lb, c->excl[i],
+                                            c->compare);
+        if (lb > begin) {
+            natcmp_constraint_emit(begin, lb);
+        }
+        begin = ub;
+    }
+    if (begin < end) {
+        natcmp_constraint_emit(begin, end);
+    }
+#undef natcmp_constraint_emit
+
+    return count;
+}
+
+#endif /* natcmp_constraint_h */
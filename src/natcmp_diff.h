@@ -0,0 +1,449 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+
+#ifndef natcmp_diff_h
+#define natcmp_diff_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Streaming diff of sorted inputs
+ *
+ * natcmp_diff_t merges N inputs whose lines are sorted in natural order and
+ * reports every distinct line once, with the set of inputs that contain it:
+ * with two inputs, lines only in the first were removed, lines only in the
+ * second were added and lines in both are unchanged. Each input is read
+ * through a buffer of NATCMP_DIFF_BLOCK bytes (larger only for a longer
+ * line or run of equal lines), so memory does not depend on the size of the
+ * inputs.
+ *
+ * Inventories compared from one day to the next are mostly the same, so
+ * whenever the last line was found in every input, the buffered bytes of all
+ * inputs are compared 8 bytes at a time first: the whole lines they have in
+ * common are returned as one unchanged stretch without splitting them into
+ * lines or calling natcmp(). The line-by-line merge only runs from the first
+ * differing byte until the inputs line up again.
+ *
+ * Lines end with '\n'; a missing newline is added to the last line. Lines
+ * must not contain NUL bytes. Lines that natcmp() considers equal but that
+ * differ in their bytes ("File2" and "file2") are distinct lines, in any
+ * order within an input: when several inputs have such a run of lines, the
+ * run is read whole from each of them (the buffer grows to hold it) and its
+ * lines are matched by their bytes and returned in the order of
+ * natcmp_total().
+ */
+
+#define NATCMP_DIFF_MAX   64                 // largest number of inputs
+#define NATCMP_DIFF_BLOCK ((size_t)64 << 10) // bytes read per input
+
+typedef struct {
+    int fd;
+    unsigned char *buf; // buffered bytes, buf[pos..len)
+    size_t cap;         // size of buf
+    size_t pos;         // start of the current line
+    size_t len;         // end of the buffered bytes
+    size_t hlen;        // length of the head line with its newline, or 0
+    size_t glen;        // length of the lines equal to the head, or 0
+    int eof;            // 1 once read() returned 0
+} natcmp_diff_input_t;
+
+/**
+ * natcmp_diff_chunk_t
+ *
+ * Lines returned by natcmp_diff_next(), valid until the next call.
+ */
+typedef struct {
+    const unsigned char *ptr; // the lines, each ending with '\n'
+    size_t len;               // number of bytes
+    size_t count;             // number of lines (1 unless mask is every input)
+    uint64_t mask;            // bit i is set if the lines are in input i
+} natcmp_diff_chunk_t;
+
+/**
+ * natcmp_diff_t
+ *
+ * State of a diff.
+ */
+typedef struct {
+    natcmp_diff_input_t in[NATCMP_DIFF_MAX];
+    size_t n;      // number of inputs
+    uint64_t all;  // mask of every input
+    int aligned;   // 1 if the last line was in every input
+    size_t merged; // lines compared with natcmp() so far
+    size_t ffwd;   // lines skipped as common to every input so far
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+} natcmp_diff_t;
+
+/**
+ * natcmp_diff_free
+ *
+ * Releases the buffers. The file descriptors are not closed.
+ */
+static inline void natcmp_diff_free(natcmp_diff_t *d)
+{
+    for (size_t i = 0; i < d->n; i++) {
+        natcmp_free(d->alloc, d->in[i].buf, d->in[i].cap);
+        d->in[i].buf = NULL;
+    }
+    d->n = 0;
+}
+
+/**
+ * natcmp_diff_init
+ *
+ * Prepares to diff the sorted lines read from `n` file descriptors.
+ *
+ * @param d        Diff to initialize
+ * @param fds      Inputs, in the order of the bits of the masks
+ * @param n        Number of inputs (1 to NATCMP_DIFF_MAX)
+ * @param compare  Comparison for non-digit parts, or NULL for the default
+ * @param alloc    Allocator or NULL
+ * @return int     0 on success, -1 with errno set to EINVAL or ENOMEM
+ */
+static inline int natcmp_diff_init(natcmp_diff_t *d, const int *fds, size_t n,
+                                   natcmp_nondigit_cmp_func_t compare,
+                                   const natcmp_allocator_t *alloc)
+{
+    memset(d, 0, sizeof(*d));
+    d->compare = compare;
+    d->alloc   = alloc;
+    d->aligned = 1;
+    if (n == 0 || n > NATCMP_DIFF_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        natcmp_diff_input_t *in = d->in + i;
+        in->fd                  = fds[i];
+        in->buf = (unsigned char *)natcmp_alloc(alloc, NATCMP_DIFF_BLOCK);
+        if (!in->buf) {
+            natcmp_diff_free(d);
+            return -1;
+        }
+        in->cap = NATCMP_DIFF_BLOCK;
+        d->n    = i + 1;
+    }
+    d->all = (n == 64) ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+    return 0;
+}
+
+/**
+ * natcmp_diff_read
+ *
+ * Moves the unread bytes of an input to the start of its buffer and reads
+ * until the buffer is full or the input ends. A missing newline is added at
+ * the end of the input.
+ */
+static inline int natcmp_diff_read(natcmp_diff_input_t *in)
+{
+    memmove(in->buf, in->buf + in->pos, in->len - in->pos);
+    in->len -= in->pos;
+    in->pos = 0;
+    while (!in->eof && in->len < in->cap) {
+        ssize_t r = read(in->fd, in->buf + in->len, in->cap - in->len);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        } else if (r == 0) {
+            // len < cap, so there is room for the newline
+            in->eof = 1;
+            if (in->len > 0 && in->buf[in->len - 1] != '\n') {
+                in->buf[in->len++] = '\n';
+            }
+        }
+        in->len += (size_t)r;
+    }
+    return 0;
+}
+
+/**
+ * natcmp_diff_line
+ *
+ * Makes the line `off` bytes past the start of the current line of an input
+ * whole in the buffer, NUL-terminated in place of its newline for natcmp().
+ * Returns 1 and its length with the newline in `len`, 0 at the end of the
+ * input or -1 with errno set on failure.
+ */
+static inline int natcmp_diff_line(natcmp_diff_t *d, natcmp_diff_input_t *in,
+                                   size_t off, size_t *len)
+{
+    for (;;) {
+        unsigned char *s  = in->buf + in->pos + off;
+        unsigned char *nl =
+            (unsigned char *)memchr(s, '\n', in->len - in->pos - off);
+        if (nl) {
+            *nl  = 0;
+            *len = (size_t)(nl - s) + 1;
+            return 1;
+        } else if (in->eof) {
+            return 0;
+        } else if (in->pos == 0 && in->len == in->cap) {
+            // a line longer than the buffer
+            size_t cap = in->cap * 2;
+            unsigned char *buf = (unsigned char *)natcmp_alloc(d->alloc, cap);
+            if (!buf) {
+                return -1;
+            }
+            memcpy(buf, in->buf, in->len);
+            natcmp_free(d->alloc, in->buf, in->cap);
+            in->buf = buf;
+            in->cap = cap;
+        }
+        if (natcmp_diff_read(in) != 0) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * natcmp_diff_head
+ *
+ * Makes the next line of an input its head. Returns 1, 0 at the end of the
+ * input or -1 with errno set on failure.
+ */
+static inline int natcmp_diff_head(natcmp_diff_t *d, natcmp_diff_input_t *in)
+{
+    if (in->hlen) {
+        return 1;
+    }
+    return natcmp_diff_line(d, in, 0, &in->hlen);
+}
+
+// reverses s[0 .. len)
+static inline void natcmp_diff_reverse(unsigned char *s, size_t len)
+{
+    for (size_t i = 0, j = len; i + 1 < j; i++, j--) {
+        unsigned char t = s[i];
+        s[i]            = s[j - 1];
+        s[j - 1]        = t;
+    }
+}
+
+// moves the `len` bytes at s + off to s, and s[0 .. off) after them
+static inline void natcmp_diff_rotate(unsigned char *s, size_t off, size_t len)
+{
+    natcmp_diff_reverse(s, off);
+    natcmp_diff_reverse(s + off, len);
+    natcmp_diff_reverse(s, off + len);
+}
+
+/**
+ * natcmp_diff_group
+ *
+ * Reads the lines of an input that natcmp() considers equal to its head into
+ * the buffer, each NUL-terminated, sets `glen` to their length and puts them
+ * in the order of natcmp_total(). A line is only moved when it is out of
+ * order, so a run that is already in that order is read in linear time.
+ */
+static inline int natcmp_diff_group(natcmp_diff_t *d, natcmp_diff_input_t *in)
+{
+    size_t off  = in->hlen;
+    size_t last = 0;
+    size_t len  = 0;
+    int rv;
+
+    while ((rv = natcmp_diff_line(d, in, off, &len)) == 1) {
+        unsigned char *s = in->buf + in->pos;
+        d->merged++;
+        if (natcmp(s + off, s, d->compare) != 0) {
+            s[off + len - 1] = '\n';
+            break;
+        }
+        d->merged++;
+        if (natcmp_total(s + off, s + last, d->compare) < 0) {
+            // insert before the first greater line
+            size_t at = 0;
+            while (natcmp_total(s + off, s + at, d->compare) >= 0) {
+                at += strlen((const char *)s + at) + 1;
+                d->merged++;
+            }
+            natcmp_diff_rotate(s + at, off - at, len);
+            last += len;
+        } else {
+            last = off;
+        }
+        off += len;
+    }
+    in->glen = off;
+    return (rv < 0) ? -1 : 0;
+}
+
+/**
+ * natcmp_diff_ffwd
+ *
+ * Returns in `c` the whole lines that every input has next, byte for byte,
+ * and skips them in every input. Returns 1 if there was at least one line.
+ */
+static inline int natcmp_diff_ffwd(natcmp_diff_t *d, natcmp_diff_chunk_t *c)
+{
+    natcmp_diff_input_t *first = d->in;
+    size_t common              = (size_t)-1;
+
+    for (size_t i = 0; i < d->n; i++) {
+        natcmp_diff_input_t *in = d->in + i;
+        if (in->len - in->pos < in->cap / 2 && !in->eof &&
+            natcmp_diff_read(in) != 0) {
+            return -1;
+        }
+        size_t avail = in->len - in->pos;
+        if (i > 0 && avail > common) {
+            avail = common;
+        }
+        if (i > 0) {
+            avail = natcmp_mismatch(first->buf + first->pos,
+                                    in->buf + in->pos, avail);
+        }
+        common = avail;
+    }
+
+    // back off to the end of the last common line
+    const unsigned char *s = first->buf + first->pos;
+    while (common > 0 && s[common - 1] != '\n') {
+        common--;
+    }
+    if (common == 0) {
+        return 0;
+    }
+    c->ptr   = s;
+    c->len   = common;
+    c->count = 0;
+    c->mask  = d->all;
+    for (const unsigned char *p = s; p < s + common; c->count++) {
+        p = (const unsigned char *)memchr(p, '\n', (size_t)(s + common - p));
+        p++;
+    }
+    for (size_t i = 0; i < d->n; i++) {
+        d->in[i].pos += common;
+    }
+    d->ffwd += c->count;
+    return 1;
+}
+
+/**
+ * natcmp_diff_next
+ *
+ * Returns the next line in natural order and the inputs that contain it, or
+ * a stretch of lines that every input contains.
+ *
+ * @param d    Diff
+ * @param c    Receives the lines
+ * @return int 1 if lines were returned, 0 at the end of every input, -1 with
+ *             errno set on a read or allocation error
+ */
+static inline int natcmp_diff_next(natcmp_diff_t *d, natcmp_diff_chunk_t *c)
+{
+    natcmp_diff_input_t *min = NULL;
+    uint64_t group           = 0;
+    uint64_t mask            = 0;
+
+    if (d->aligned) {
+        int rv = natcmp_diff_ffwd(d, c);
+        if (rv != 0) {
+            return rv;
+        }
+    }
+
+    // smallest head in natural order and the inputs whose head is equal
+    for (size_t i = 0; i < d->n; i++) {
+        natcmp_diff_input_t *in = d->in + i;
+        int rv                  = natcmp_diff_head(d, in);
+        if (rv < 0) {
+            return -1;
+        } else if (rv == 0) {
+            continue;
+        }
+        int cmp = -1;
+        if (min) {
+            cmp = natcmp(in->buf + in->pos, min->buf + min->pos, d->compare);
+            d->merged++;
+        }
+        if (cmp < 0) {
+            min   = in;
+            group = (uint64_t)1 << i;
+        } else if (cmp == 0) {
+            group |= (uint64_t)1 << i;
+        }
+    }
+    if (!min) {
+        return 0;
+    }
+
+    // lines that natcmp() considers equal may come in any order, so when
+    // several inputs have them, they are read whole and matched by bytes
+    min = NULL;
+    for (size_t i = 0; i < d->n; i++) {
+        natcmp_diff_input_t *in = d->in + i;
+        if (!(group & ((uint64_t)1 << i))) {
+            continue;
+        }
+        if ((group & (group - 1)) && !in->glen &&
+            natcmp_diff_group(d, in) != 0) {
+            return -1;
+        }
+        int cmp = -1;
+        if (min) {
+            cmp = natcmp_total(in->buf + in->pos, min->buf + min->pos,
+                               d->compare);
+            d->merged++;
+        }
+        if (cmp < 0) {
+            min  = in;
+            mask = (uint64_t)1 << i;
+        } else if (cmp == 0) {
+            mask |= (uint64_t)1 << i;
+        }
+    }
+
+    c->ptr   = min->buf + min->pos;
+    c->len   = min->hlen;
+    c->count = 1;
+    c->mask  = mask;
+    min->buf[min->pos + min->hlen - 1] = '\n';
+
+    d->aligned = (mask == d->all);
+    for (size_t i = 0; i < d->n; i++) {
+        natcmp_diff_input_t *in = d->in + i;
+        if (mask & ((uint64_t)1 << i)) {
+            in->pos += in->hlen;
+            in->glen = in->glen ? in->glen - in->hlen : 0;
+            in->hlen = 0;
+            if (in->glen) {
+                in->hlen = strlen((const char *)in->buf + in->pos) + 1;
+            }
+        }
+        if (in->glen) {
+            d->aligned = 0;
+        }
+    }
+    return 1;
+}
+
+#endif /* natcmp_diff_h */
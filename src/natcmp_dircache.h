@@ -0,0 +1,464 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_dircache_h
+#define natcmp_dircache_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_walk.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Directory cache
+ *
+ * natcmp_dircache_t keeps the names of a directory sorted with natcmp_total(),
+ * so that listing the directory in natural order is a scan of an array. The
+ * list is read once and then kept current with natcmp_dircache_insert() and
+ * natcmp_dircache_remove(), which find their position by binary search. On
+ * Linux, natcmp_dircache_watch() and natcmp_dircache_update() apply the
+ * changes reported by inotify.
+ *
+ * Snapshots give a stable view of the list while it changes: the names
+ * removed while a snapshot is alive are only released when the last snapshot
+ * is. Like natcmp_walk.h, this header needs _POSIX_C_SOURCE 200809L or later
+ * under a strict C standard.
+ */
+
+/**
+ * natcmp_dircache_t
+ *
+ * Sorted directory cache. Initialize it with natcmp_dircache_open() and
+ * release it with natcmp_dircache_close().
+ */
+typedef struct {
+    char *path;                    // path of the directory
+    const unsigned char **names;   // names in natcmp_total() order
+    size_t n;                      // number of names
+    size_t cap;                    // number of allocated slots of names
+    const unsigned char **grave;   // names removed while snapshots are alive
+    size_t ngrave;                 // number of names in grave
+    size_t gravecap;               // number of allocated slots of grave
+    size_t nsnap;                  // number of live snapshots
+    int fd;                        // inotify descriptor, or -1
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+} natcmp_dircache_t;
+
+/**
+ * natcmp_dircache_snapshot_t
+ *
+ * Stable copy of the list of a cache.
+ */
+typedef struct {
+    const unsigned char **names; // names in natcmp_total() order
+    size_t n;                    // number of names
+} natcmp_dircache_snapshot_t;
+
+static inline void natcmp_dircache_release_name(natcmp_dircache_t *c,
+                                                const unsigned char *name)
+{
+    natcmp_free(c->alloc, (void *)name, strlen((const char *)name) + 1);
+}
+
+// grows an array of names to hold at least `need` names
+static inline int natcmp_dircache_grow(natcmp_dircache_t *c,
+                                       const unsigned char ***names,
+                                       size_t *cap, size_t n, size_t need)
+{
+    if (need <= *cap) {
+        return 0;
+    }
+    size_t newcap = *cap ? *cap : 64;
+    while (newcap < need) {
+        newcap *= 2;
+    }
+    const unsigned char **p = (const unsigned char **)natcmp_alloc_array(
+        c->alloc, newcap, sizeof(*p));
+    if (!p) {
+        return -1;
+    }
+    if (n) {
+        memcpy((void *)p, (void *)*names, sizeof(*p) * n);
+    }
+    natcmp_free(c->alloc, (void *)*names, sizeof(**names) * *cap);
+    *names = p;
+    *cap   = newcap;
+    return 0;
+}
+
+// releases a name now, or when the last snapshot is released
+static inline int natcmp_dircache_discard(natcmp_dircache_t *c,
+                                          const unsigned char *name)
+{
+    if (!c->nsnap) {
+        natcmp_dircache_release_name(c, name);
+        return 0;
+    } else if (natcmp_dircache_grow(c, &c->grave, &c->gravecap, c->ngrave,
+                                    c->ngrave + 1) != 0) {
+        return -1;
+    }
+    c->grave[c->ngrave++] = name;
+    return 0;
+}
+
+/**
+ * natcmp_dircache_search
+ *
+ * Returns the index of the first name of the cache that is not less than
+ * `name` in natcmp_total() order; it is `name` itself if the cache has it.
+ */
+static inline size_t natcmp_dircache_search(const natcmp_dircache_t *c,
+                                            const unsigned char *name)
+{
+    size_t lo = 0;
+    size_t n  = c->n;
+    while (n > 0) {
+        size_t half = n / 2;
+        if (natcmp_total(c->names[lo + half], name, c->compare) < 0) {
+            lo += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return lo;
+}
+
+/**
+ * natcmp_dircache_insert
+ *
+ * Adds a name to the cache.
+ *
+ * @return int  1 if it was added, 0 if the cache already has it, -1 on
+ *              failure with errno set to ENOMEM
+ */
+static inline int natcmp_dircache_insert(natcmp_dircache_t *c,
+                                         const unsigned char *name)
+{
+    size_t i = natcmp_dircache_search(c, name);
+    if (i < c->n &&
+        strcmp((const char *)c->names[i], (const char *)name) == 0) {
+        return 0;
+    }
+
+    size_t len       = strlen((const char *)name) + 1;
+    unsigned char *p = (unsigned char *)natcmp_alloc(c->alloc, len);
+    if (!p) {
+        return -1;
+    } else if (natcmp_dircache_grow(c, &c->names, &c->cap, c->n, c->n + 1) !=
+               0) {
+        natcmp_free(c->alloc, p, len);
+        return -1;
+    }
+    memcpy(p, name, len);
+    memmove((void *)(c->names + i + 1), (void *)(c->names + i),
+            sizeof(*c->names) * (c->n - i));
+    c->names[i] = p;
+    c->n++;
+    return 1;
+}
+
+/**
+ * natcmp_dircache_remove
+ *
+ * Removes a name from the cache.
+ *
+ * @return int  1 if it was removed, 0 if the cache does not have it, -1 on
+ *              failure with errno set to ENOMEM
+ */
+static inline int natcmp_dircache_remove(natcmp_dircache_t *c,
+                                         const unsigned char *name)
+{
+    size_t i = natcmp_dircache_search(c, name);
+    if (i == c->n ||
+        strcmp((const char *)c->names[i], (const char *)name) != 0) {
+        return 0;
+    } else if (natcmp_dircache_discard(c, c->names[i]) != 0) {
+        return -1;
+    }
+    memmove((void *)(c->names + i), (void *)(c->names + i + 1),
+            sizeof(*c->names) * (c->n - i - 1));
+    c->n--;
+    return 1;
+}
+
+/**
+ * natcmp_dircache_reload
+ *
+ * Reads the directory again and replaces the list of the cache.
+ *
+ * @return int  0 on success, -1 on failure with errno set (the cache is left
+ *              unchanged)
+ */
+static inline int natcmp_dircache_reload(natcmp_dircache_t *c)
+{
+    natcmp_dir_t d;
+    const unsigned char **names = NULL;
+    size_t cap                  = 0;
+
+    if (natcmp_dir_read(&d, c->path, c->compare, c->alloc) != 0) {
+        return -1;
+    } else if (natcmp_dircache_grow(c, &names, &cap, 0, d.n) != 0) {
+        natcmp_dir_free(&d);
+        return -1;
+    }
+
+    // copy the names, ordering names that natcmp() finds equal by bytes
+    size_t n = 0;
+    for (; n < d.n; n++) {
+        size_t len = strlen((const char *)d.names[n]) + 1;
+        unsigned char *p = (unsigned char *)natcmp_alloc(c->alloc, len);
+        if (!p) {
+            break;
+        }
+        memcpy(p, d.names[n], len);
+        size_t j = n;
+        while (j > 0 && natcmp_total(names[j - 1], p, c->compare) > 0) {
+            names[j] = names[j - 1];
+            j--;
+        }
+        names[j] = p;
+    }
+    natcmp_dir_free(&d);
+    // room for the old names while snapshots are alive, so that discarding
+    // them below cannot fail
+    if (n < d.n ||
+        (c->nsnap && natcmp_dircache_grow(c, &c->grave, &c->gravecap,
+                                          c->ngrave, c->ngrave + c->n) != 0)) {
+        while (n) {
+            natcmp_dircache_release_name(c, names[--n]);
+        }
+        natcmp_free(c->alloc, (void *)names, sizeof(*names) * cap);
+        return -1;
+    }
+
+    for (size_t i = 0; i < c->n; i++) {
+        natcmp_dircache_discard(c, c->names[i]);
+    }
+    natcmp_free(c->alloc, (void *)c->names, sizeof(*c->names) * c->cap);
+    c->names = names;
+    c->n     = n;
+    c->cap   = cap;
+    return 0;
+}
+
+/**
+ * natcmp_dircache_close
+ *
+ * Releases the memory of a cache and stops watching its directory. All
+ * snapshots must have been released.
+ */
+static inline void natcmp_dircache_close(natcmp_dircache_t *c)
+{
+#ifdef __linux__
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+#endif
+    for (size_t i = 0; i < c->n; i++) {
+        natcmp_dircache_release_name(c, c->names[i]);
+    }
+    for (size_t i = 0; i < c->ngrave; i++) {
+        natcmp_dircache_release_name(c, c->grave[i]);
+    }
+    natcmp_free(c->alloc, (void *)c->names, sizeof(*c->names) * c->cap);
+    natcmp_free(c->alloc, (void *)c->grave, sizeof(*c->grave) * c->gravecap);
+    if (c->path) {
+        natcmp_free(c->alloc, c->path, strlen(c->path) + 1);
+    }
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+/**
+ * natcmp_dircache_open
+ *
+ * Reads the directory `path` into a new cache.
+ *
+ * @param c        Cache to initialize
+ * @param path     Path of the directory
+ * @param compare  Callback function for comparing non-digit portions
+ * @param alloc    Allocator or NULL
+ * @return int     0 on success, -1 on failure with errno set
+ */
+static inline int natcmp_dircache_open(natcmp_dircache_t *c, const char *path,
+                                       natcmp_nondigit_cmp_func_t compare,
+                                       const natcmp_allocator_t *alloc)
+{
+    size_t len = strlen(path) + 1;
+
+    memset(c, 0, sizeof(*c));
+    c->fd      = -1;
+    c->compare = compare;
+    c->alloc   = alloc;
+    c->path    = (char *)natcmp_alloc(alloc, len);
+    if (!c->path) {
+        return -1;
+    }
+    memcpy(c->path, path, len);
+    if (natcmp_dircache_reload(c) != 0) {
+        int err = errno;
+        natcmp_dircache_close(c);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * natcmp_dircache_snapshot
+ *
+ * Copies the current list of the cache into `s`. The names stay valid until
+ * the snapshot is released with natcmp_dircache_release(), even if they are
+ * removed from the cache meanwhile.
+ *
+ * @return int  0 on success, -1 on failure with errno set to ENOMEM
+ */
+static inline int natcmp_dircache_snapshot(natcmp_dircache_t *c,
+                                           natcmp_dircache_snapshot_t *s)
+{
+    s->n     = c->n;
+    s->names = (const unsigned char **)natcmp_alloc_array(c->alloc, c->n,
+                                                          sizeof(*s->names));
+    if (!s->names) {
+        return -1;
+    }
+    if (c->n) {
+        memcpy((void *)s->names, (void *)c->names, sizeof(*s->names) * c->n);
+    }
+    c->nsnap++;
+    return 0;
+}
+
+/**
+ * natcmp_dircache_release
+ *
+ * Releases a snapshot, and the names removed from the cache while it was
+ * alive if it is the last one.
+ */
+static inline void natcmp_dircache_release(natcmp_dircache_t *c,
+                                           natcmp_dircache_snapshot_t *s)
+{
+    natcmp_free(c->alloc, (void *)s->names, sizeof(*s->names) * s->n);
+    s->names = NULL;
+    s->n     = 0;
+    if (--c->nsnap == 0) {
+        while (c->ngrave) {
+            natcmp_dircache_release_name(c, c->grave[--c->ngrave]);
+        }
+    }
+}
+
+#ifdef __linux__
+
+/**
+ * natcmp_dircache_watch
+ *
+ * Starts watching the directory with inotify and reads it again, so that no
+ * change made before the watch is missed.
+ *
+ * @return int  Non-blocking inotify descriptor to poll for changes, or -1 on
+ *              failure with errno set
+ */
+static inline int natcmp_dircache_watch(natcmp_dircache_t *c)
+{
+    if (c->fd < 0) {
+        c->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (c->fd < 0) {
+            return -1;
+        } else if (inotify_add_watch(c->fd, c->path,
+                                     IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                         IN_MOVED_TO | IN_ONLYDIR) < 0 ||
+                   natcmp_dircache_reload(c) != 0) {
+            int err = errno;
+            close(c->fd);
+            c->fd = -1;
+            errno = err;
+            return -1;
+        }
+    }
+    return c->fd;
+}
+
+/**
+ * natcmp_dircache_update
+ *
+ * Applies the pending inotify events to the cache without blocking. When
+ * events were lost (the inotify queue overflowed), the directory is read
+ * again.
+ *
+ * @return int  Number of names added or removed, or -1 on failure with errno
+ *              set
+ */
+static inline int natcmp_dircache_update(natcmp_dircache_t *c)
+{
+    union {
+        struct inotify_event ev;
+        char buf[4096];
+    } u;
+    int count = 0;
+
+    if (c->fd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (;;) {
+        ssize_t len = read(c->fd, u.buf, sizeof(u.buf));
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return count;
+            } else if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        for (ssize_t off = 0; off < len;) {
+            const struct inotify_event *ev =
+                (const struct inotify_event *)(void *)(u.buf + off);
+            const unsigned char *name = (const unsigned char *)ev->name;
+            int rv                    = 0;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                rv = (natcmp_dircache_reload(c) == 0) ? 1 : -1;
+            } else if (!ev->len) {
+                // event of the directory itself
+            } else if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                rv = natcmp_dircache_insert(c, name);
+            } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                rv = natcmp_dircache_remove(c, name);
+            }
+            if (rv < 0) {
+                return -1;
+            }
+            count += rv;
+            off += (ssize_t)(sizeof(*ev) + ev->len);
+        }
+    }
+}
+
+#endif /* __linux__ */
+
+#endif /* natcmp_dircache_h */
@@ -0,0 +1,1085 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_extsort_h
+#define natcmp_extsort_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_io.h"
+#include "natcmp_sort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#ifndef NATCMP_EXTSORT_THREADS
+#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0
+#define NATCMP_EXTSORT_THREADS 1
+#else
+#define NATCMP_EXTSORT_THREADS 0
+#endif
+#endif
+#if NATCMP_EXTSORT_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * External sort
+ *
+ * natcmp_extsort() sorts the lines of a file of any size in natural order
+ * within a memory budget. The input is read in chunks of a quarter of the
+ * budget; each chunk is sorted with natcmp_sort_merge() and written as a run
+ * to an unlinked temporary file, and the runs are merged in one pass.
+ *
+ * All I/O goes through natcmp_io.h: the next chunk is read while the current
+ * one is sorted and the previous run is written, and every run being merged
+ * has a block read ahead while the current one is consumed, so the disk and
+ * the CPU are busy at the same time when the io_uring backend is in use.
+ *
+ * Input that is not a regular file (a pipe, for instance) is sorted as a
+ * stream instead: it is read in chunks of a sixteenth of the budget (up to
+ * NATCMP_EXTSORT_STREAM_CHUNK), and each chunk is handed to a worker thread
+ * that sorts it in memory while the next one is read, so that at the end of
+ * the input only one merge of the sorted chunks remains. When the chunks
+ * take more than the budget, the worker writes the sorted chunks as runs and
+ * they are merged from the temporary file. When the worker runs on a thread,
+ * the allocator must be safe to use from two threads. Without POSIX threads,
+ * or with NATCMP_EXTSORT_THREADS defined to 0, the chunks are sorted by the
+ * reader.
+ *
+ * Lines end with '\n'; a missing newline is added to the last line. Lines
+ * must not contain NUL bytes, and must be shorter than a chunk unless the
+ * input is sorted as a stream. The sort is stable. The temporary file needs
+ * _POSIX_C_SOURCE 200809L or later under a strict C standard.
+ */
+
+#define NATCMP_EXTSORT_MEMORY       ((size_t)64 << 20) // default memory budget
+#define NATCMP_EXTSORT_MIN_BLOCK    ((size_t)4096)     // smallest I/O block
+#define NATCMP_EXTSORT_DEPTH        64                 // operations in flight
+#define NATCMP_EXTSORT_STREAM_CHUNK ((size_t)8 << 20)  // largest stream chunk
+
+/**
+ * natcmp_extsort_opts_t
+ *
+ * Options of natcmp_extsort(). Zero-initialized members select the defaults.
+ */
+typedef struct {
+    size_t memory;      // bytes of buffers (NATCMP_EXTSORT_MEMORY)
+    const char *tmpdir; // directory of the temporary file ($TMPDIR or /tmp)
+    int ioflags;        // flags of natcmp_io_init()
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+    int stream; // 1 to sort a regular file as a stream
+} natcmp_extsort_opts_t;
+
+typedef struct {
+    off_t off; // offset in the temporary file
+    off_t len; // number of bytes
+} natcmp_extsort_run_t;
+
+typedef struct {
+    natcmp_io_t io;
+    int spill;                   // temporary file, or -1
+    off_t spilllen;              // size of the temporary file
+    natcmp_extsort_run_t *runs;  // runs in input order
+    size_t nruns;                // number of runs
+    size_t runcap;               // number of allocated runs
+    const unsigned char **lines; // lines of the chunk being sorted
+    size_t linecap;              // number of allocated lines
+    size_t memory;
+    const char *tmpdir;
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+} natcmp_extsort_t;
+
+// cursor over a run being merged
+typedef struct {
+    unsigned char *buf[2];    // current block and block read ahead
+    int cur;                  // index of the current block
+    int pending;              // 1 if a block is being read ahead
+    natcmp_io_op_t op;        // read of the block ahead
+    off_t off;                // offset of the next block to read
+    off_t end;                // end of the run
+    size_t pos;               // position in the current block
+    size_t len;               // length of the current block
+    unsigned char *line;      // line spanning two blocks
+    size_t linecap;           // size of line
+    const unsigned char *str; // current line
+    size_t slen;              // length of str
+} natcmp_extsort_cursor_t;
+
+// grows an array to hold at least `need` elements
+static inline int natcmp_extsort_grow(natcmp_extsort_t *s, void **arr,
+                                      size_t *cap, size_t size, size_t used,
+                                      size_t need)
+{
+    if (need <= *cap) {
+        return 0;
+    }
+    size_t newcap = *cap ? *cap : 64;
+    while (newcap < need) {
+        newcap *= 2;
+    }
+    void *p = natcmp_alloc_array(s->alloc, newcap, size);
+    if (!p) {
+        return -1;
+    }
+    if (used) {
+        memcpy(p, *arr, size * used);
+    }
+    natcmp_free(s->alloc, *arr, size * *cap);
+    *arr = p;
+    *cap = newcap;
+    return 0;
+}
+
+// creates the unlinked temporary file
+static inline int natcmp_extsort_open_spill(natcmp_extsort_t *s)
+{
+    static const char name[] = "/natcmpXXXXXX";
+    size_t len               = strlen(s->tmpdir);
+    char *path = (char *)natcmp_alloc(s->alloc, len + sizeof(name));
+    if (!path) {
+        return -1;
+    }
+    memcpy(path, s->tmpdir, len);
+    memcpy(path + len, name, sizeof(name));
+    s->spill = mkstemp(path);
+    if (s->spill >= 0) {
+        unlink(path);
+    }
+    natcmp_free(s->alloc, path, len + sizeof(name));
+    return (s->spill < 0) ? -1 : 0;
+}
+
+// splits buf[0..len) into NUL-terminated lines and sorts them into *lines;
+// buf[len] must be writable
+static inline int natcmp_extsort_split(natcmp_extsort_t *s, unsigned char *buf,
+                                       size_t len,
+                                       const unsigned char ***lines,
+                                       size_t *cap, size_t *nlines)
+{
+    size_t n = 0;
+    for (size_t pos = 0; pos < len; n++) {
+        unsigned char *p  = buf + pos;
+        unsigned char *nl = (unsigned char *)memchr(p, '\n', len - pos);
+        size_t l          = nl ? (size_t)(nl - p) : len - pos;
+        if (memchr(p, '\0', l)) {
+            errno = EINVAL;
+            return -1;
+        } else if (natcmp_extsort_grow(s, (void **)lines, cap, sizeof(**lines),
+                                       n, n + 1) != 0) {
+            return -1;
+        }
+        p[l]        = '\0';
+        (*lines)[n] = p;
+        pos += l + 1;
+    }
+    *nlines = n;
+    return natcmp_sort_merge(*lines, n, s->compare, s->alloc);
+}
+
+// copies lines to out, each followed by a newline
+static inline size_t natcmp_extsort_join(const unsigned char **lines, size_t n,
+                                         unsigned char *out)
+{
+    size_t o = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t l = strlen((const char *)lines[i]);
+        memcpy(out + o, lines[i], l);
+        out[o + l] = '\n';
+        o += l + 1;
+    }
+    return o;
+}
+
+// reads the input and writes its sorted runs, or the output if the input
+// fits in one chunk
+static inline int natcmp_extsort_runs(natcmp_extsort_t *s, int in, int out)
+{
+    size_t chunk = s->memory / 4;
+    if (chunk < NATCMP_EXTSORT_MIN_BLOCK) {
+        chunk = NATCMP_EXTSORT_MIN_BLOCK;
+    }
+    unsigned char *rbuf[2];
+    unsigned char *wbuf[2];
+    natcmp_io_op_t rop;
+    natcmp_io_op_t wop[2];
+    int wpending[2] = {0, 0};
+    size_t have     = 0;
+    int cur         = 0;
+    int eof         = 0;
+    int rv          = -1;
+
+    rbuf[0] = (unsigned char *)natcmp_alloc(s->alloc, chunk + 1);
+    rbuf[1] = (unsigned char *)natcmp_alloc(s->alloc, chunk + 1);
+    wbuf[0] = (unsigned char *)natcmp_alloc(s->alloc, chunk + 1);
+    wbuf[1] = (unsigned char *)natcmp_alloc(s->alloc, chunk + 1);
+    if (!rbuf[0] || !rbuf[1] || !wbuf[0] || !wbuf[1] ||
+        natcmp_io_read(&s->io, &rop, in, rbuf[0], chunk, -1) != 0) {
+        goto done;
+    }
+
+    for (;;) {
+        // fill the chunk
+        for (;;) {
+            ssize_t n = natcmp_io_wait(&s->io, &rop);
+            if (n < 0) {
+                goto done;
+            } else if (n == 0) {
+                eof = 1;
+                break;
+            }
+            have += (size_t)n;
+            if (have == chunk) {
+                break;
+            } else if (natcmp_io_read(&s->io, &rop, in, rbuf[cur] + have,
+                                      chunk - have, -1) != 0) {
+                goto done;
+            }
+        }
+
+        // keep the incomplete last line for the next chunk, and read it
+        size_t end = have;
+        if (!eof) {
+            while (end && rbuf[cur][end - 1] != '\n') {
+                end--;
+            }
+            if (!end) {
+                errno = ENOBUFS;
+                goto done;
+            }
+        }
+        int next = 1 - cur;
+        memcpy(rbuf[next], rbuf[cur] + end, have - end);
+        have -= end;
+        if (!eof && natcmp_io_read(&s->io, &rop, in, rbuf[next] + have,
+                                   chunk - have, -1) != 0) {
+            goto done;
+        }
+
+        // sort while the next chunk is read and the previous run written
+        size_t n;
+        if (wpending[cur]) {
+            wpending[cur] = 0;
+            if (natcmp_io_write_all(&s->io, &wop[cur]) != 0) {
+                goto done;
+            }
+        }
+        if (natcmp_extsort_split(s, rbuf[cur], end, &s->lines, &s->linecap,
+                                 &n) != 0) {
+            goto done;
+        }
+        size_t len = natcmp_extsort_join(s->lines, n, wbuf[cur]);
+        if (eof && !s->nruns) {
+            // the whole input fits in one chunk
+            if (len && (natcmp_io_write(&s->io, &wop[cur], out, wbuf[cur],
+                                        len, -1) != 0 ||
+                        natcmp_io_write_all(&s->io, &wop[cur]) != 0)) {
+                goto done;
+            }
+            rv = 0;
+            goto done;
+        } else if (len) {
+            if ((s->spill < 0 && natcmp_extsort_open_spill(s) != 0) ||
+                natcmp_extsort_grow(s, (void **)&s->runs, &s->runcap,
+                                    sizeof(*s->runs), s->nruns,
+                                    s->nruns + 1) != 0 ||
+                natcmp_io_write(&s->io, &wop[cur], s->spill, wbuf[cur], len,
+                                s->spilllen) != 0) {
+                goto done;
+            }
+            wpending[cur]         = 1;
+            s->runs[s->nruns].off = s->spilllen;
+            s->runs[s->nruns].len = (off_t)len;
+            s->nruns++;
+            s->spilllen += (off_t)len;
+        }
+        if (eof) {
+            break;
+        }
+        cur = next;
+    }
+
+    rv = 0;
+    for (int i = 0; i < 2; i++) {
+        if (wpending[i]) {
+            wpending[i] = 0;
+            if (natcmp_io_write_all(&s->io, &wop[i]) != 0) {
+                rv = -1;
+            }
+        }
+    }
+
+done:
+    if (rv != 0) {
+        int err = errno;
+        natcmp_io_drain(&s->io);
+        errno = err;
+    }
+    for (int i = 0; i < 2; i++) {
+        natcmp_free(s->alloc, rbuf[i], chunk + 1);
+        natcmp_free(s->alloc, wbuf[i], chunk + 1);
+    }
+    return rv;
+}
+
+// reads the next block of a run ahead
+static inline int natcmp_extsort_fetch(natcmp_extsort_t *s,
+                                       natcmp_extsort_cursor_t *c, size_t block)
+{
+    if (c->off < c->end) {
+        size_t len = block;
+        if ((off_t)len > c->end - c->off) {
+            len = (size_t)(c->end - c->off);
+        }
+        if (natcmp_io_read(&s->io, &c->op, s->spill, c->buf[1 - c->cur], len,
+                           c->off) != 0) {
+            return -1;
+        }
+        c->off += (off_t)len;
+        c->pending = 1;
+    }
+    return 0;
+}
+
+// moves a cursor to the next line of its run
+static inline int natcmp_extsort_next(natcmp_extsort_t *s,
+                                      natcmp_extsort_cursor_t *c, size_t block)
+{
+    size_t part = 0;
+    for (;;) {
+        unsigned char *p  = c->buf[c->cur] + c->pos;
+        size_t rem        = c->len - c->pos;
+        unsigned char *nl = (unsigned char *)memchr(p, '\n', rem);
+        size_t l          = nl ? (size_t)(nl - p) : rem;
+        if (nl && !part) {
+            *nl     = '\0';
+            c->str  = p;
+            c->slen = l;
+            c->pos += l + 1;
+            return 1;
+        } else if (natcmp_extsort_grow(s, (void **)&c->line, &c->linecap, 1,
+                                       part, part + l + 1) != 0) {
+            return -1;
+        }
+        memcpy(c->line + part, p, l);
+        part += l;
+        if (nl) {
+            c->line[part] = '\0';
+            c->str        = c->line;
+            c->slen       = part;
+            c->pos += l + 1;
+            return 1;
+        } else if (!c->pending) {
+            if (part) {
+                errno = EIO;
+                return -1;
+            }
+            return 0;
+        }
+
+        // switch to the block read ahead and read the next one
+        ssize_t n  = natcmp_io_wait(&s->io, &c->op);
+        c->pending = 0;
+        if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            return -1;
+        } else if ((size_t)n < c->op.len) {
+            c->off = c->op.off + (off_t)n;
+        }
+        c->cur = 1 - c->cur;
+        c->pos = 0;
+        c->len = (size_t)n;
+        if (natcmp_extsort_fetch(s, c, block) != 0) {
+            return -1;
+        }
+    }
+}
+
+// returns 1 if the line at heads[i] goes before the line at heads[j]
+static inline int natcmp_extsort_before(natcmp_extsort_t *s,
+                                        const unsigned char **heads, size_t i,
+                                        size_t j)
+{
+    int rv = natcmp(heads[i], heads[j], s->compare);
+    return rv < 0 || (rv == 0 && i < j);
+}
+
+static inline void natcmp_extsort_sift(natcmp_extsort_t *s,
+                                       const unsigned char **heads,
+                                       size_t *heap, size_t n, size_t i)
+{
+    for (;;) {
+        size_t m = i;
+        size_t l = 2 * i + 1;
+        if (l < n && natcmp_extsort_before(s, heads, heap[l], heap[m])) {
+            m = l;
+        }
+        if (l + 1 < n &&
+            natcmp_extsort_before(s, heads, heap[l + 1], heap[m])) {
+            m = l + 1;
+        }
+        if (m == i) {
+            return;
+        }
+        size_t t = heap[i];
+        heap[i]  = heap[m];
+        heap[m]  = t;
+        i        = m;
+    }
+}
+
+// double-buffered output of a merge
+typedef struct {
+    natcmp_io_t *io;
+    int fd;
+    unsigned char *buf[2]; // block being filled and block being written
+    size_t block;          // size of a block
+    int cur;               // index of the block being filled
+    size_t pos;            // number of bytes in the block being filled
+    natcmp_io_op_t op;     // write of the other block
+    int pending;           // 1 if op is in flight
+} natcmp_extsort_out_t;
+
+static inline int natcmp_extsort_out_init(natcmp_extsort_t *s,
+                                          natcmp_extsort_out_t *o, int fd,
+                                          size_t block)
+{
+    memset(o, 0, sizeof(*o));
+    o->io     = &s->io;
+    o->fd     = fd;
+    o->block  = block;
+    o->buf[0] = (unsigned char *)natcmp_alloc(s->alloc, block);
+    o->buf[1] = (unsigned char *)natcmp_alloc(s->alloc, block);
+    return (o->buf[0] && o->buf[1]) ? 0 : -1;
+}
+
+static inline void natcmp_extsort_out_free(natcmp_extsort_t *s,
+                                           natcmp_extsort_out_t *o)
+{
+    natcmp_free(s->alloc, o->buf[0], o->block);
+    natcmp_free(s->alloc, o->buf[1], o->block);
+}
+
+// writes the block being filled once the previous one has been written
+static inline int natcmp_extsort_out_flush(natcmp_extsort_out_t *o)
+{
+    if (o->pending) {
+        o->pending = 0;
+        if (natcmp_io_write_all(o->io, &o->op) != 0) {
+            return -1;
+        }
+    }
+    if (o->pos) {
+        if (natcmp_io_write(o->io, &o->op, o->fd, o->buf[o->cur], o->pos,
+                            -1) != 0) {
+            return -1;
+        }
+        o->pending = 1;
+        o->cur     = 1 - o->cur;
+        o->pos     = 0;
+    }
+    return 0;
+}
+
+// writes the rest of the output and waits for it
+static inline int natcmp_extsort_out_finish(natcmp_extsort_out_t *o)
+{
+    if (natcmp_extsort_out_flush(o) != 0) {
+        return -1;
+    } else if (o->pending) {
+        o->pending = 0;
+        return natcmp_io_write_all(o->io, &o->op);
+    }
+    return 0;
+}
+
+// appends a line of `len` bytes and a newline
+static inline int natcmp_extsort_put(natcmp_extsort_out_t *o,
+                                     const unsigned char *p, size_t len)
+{
+    size_t l = len + 1;
+    while (l) {
+        size_t m = o->block - o->pos;
+        if (m > l) {
+            m = l;
+        }
+        if (l == m) {
+            memcpy(o->buf[o->cur] + o->pos, p, m - 1);
+            o->buf[o->cur][o->pos + m - 1] = '\n';
+        } else {
+            memcpy(o->buf[o->cur] + o->pos, p, m);
+        }
+        o->pos += m;
+        p += m;
+        l -= m;
+        if (o->pos == o->block && natcmp_extsort_out_flush(o) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// merges the runs into out
+static inline int natcmp_extsort_merge(natcmp_extsort_t *s, int out)
+{
+    size_t k     = s->nruns;
+    size_t block = s->memory / (2 * k + 2);
+    if (block < NATCMP_EXTSORT_MIN_BLOCK) {
+        block = NATCMP_EXTSORT_MIN_BLOCK;
+    }
+    natcmp_extsort_cursor_t *cur = (natcmp_extsort_cursor_t *)
+        natcmp_alloc_array(s->alloc, k, sizeof(*cur));
+    const unsigned char **heads = (const unsigned char **)natcmp_alloc_array(
+        s->alloc, k, sizeof(*heads));
+    size_t *heap = (size_t *)natcmp_alloc_array(s->alloc, k, sizeof(*heap));
+    natcmp_extsort_out_t o;
+    size_t nheap = 0;
+    size_t ncur  = 0;
+    int rv       = -1;
+
+    if (natcmp_extsort_out_init(s, &o, out, block) != 0 || !cur || !heads ||
+        !heap) {
+        goto done;
+    }
+    for (; ncur < k; ncur++) {
+        natcmp_extsort_cursor_t *c = cur + ncur;
+        memset(c, 0, sizeof(*c));
+        c->off    = s->runs[ncur].off;
+        c->end    = c->off + s->runs[ncur].len;
+        c->buf[0] = (unsigned char *)natcmp_alloc(s->alloc, block);
+        c->buf[1] = (unsigned char *)natcmp_alloc(s->alloc, block);
+        if (!c->buf[0] || !c->buf[1]) {
+            ncur++;
+            goto done;
+        }
+        // the first block is read ahead into buf[0] from an empty buf[1]
+        c->cur = 1;
+        if (natcmp_extsort_fetch(s, c, block) != 0) {
+            ncur++;
+            goto done;
+        }
+    }
+    for (size_t i = 0; i < k; i++) {
+        int r = natcmp_extsort_next(s, cur + i, block);
+        if (r < 0) {
+            goto done;
+        } else if (r) {
+            heads[i]      = cur[i].str;
+            heap[nheap++] = i;
+        }
+    }
+    for (size_t i = nheap / 2; i-- > 0;) {
+        natcmp_extsort_sift(s, heads, heap, nheap, i);
+    }
+
+    while (nheap) {
+        size_t i = heap[0];
+        if (natcmp_extsort_put(&o, cur[i].str, cur[i].slen) != 0) {
+            goto done;
+        }
+        int r = natcmp_extsort_next(s, cur + i, block);
+        if (r < 0) {
+            goto done;
+        } else if (r) {
+            heads[i] = cur[i].str;
+        } else {
+            heap[0] = heap[--nheap];
+        }
+        natcmp_extsort_sift(s, heads, heap, nheap, 0);
+    }
+    if (natcmp_extsort_out_finish(&o) != 0) {
+        goto done;
+    }
+    rv = 0;
+
+done:
+    if (rv != 0) {
+        int err = errno;
+        natcmp_io_drain(&s->io);
+        errno = err;
+    }
+    for (size_t i = 0; i < ncur; i++) {
+        natcmp_free(s->alloc, cur[i].buf[0], block);
+        natcmp_free(s->alloc, cur[i].buf[1], block);
+        natcmp_free(s->alloc, cur[i].line, cur[i].linecap);
+    }
+    natcmp_extsort_out_free(s, &o);
+    natcmp_free(s->alloc, cur, sizeof(*cur) * k);
+    natcmp_free(s->alloc, (void *)heads, sizeof(*heads) * k);
+    natcmp_free(s->alloc, heap, sizeof(*heap) * k);
+    return rv;
+}
+
+// chunk of a stream, sorted in memory
+typedef struct {
+    unsigned char *buf;          // lines (NULL once written as a run)
+    size_t size;                 // size of buf
+    size_t len;                  // number of bytes of lines in buf
+    const unsigned char **lines; // sorted lines
+    size_t nlines;               // number of lines
+    size_t linecap;              // number of allocated lines
+} natcmp_extsort_chunk_t;
+
+// state shared by the reader and the sorting worker of a stream
+typedef struct {
+    natcmp_extsort_t *s;
+    int ioflags;                    // flags of the queue of the worker
+    natcmp_extsort_chunk_t *chunks; // chunks in input order
+    size_t nchunks;                 // number of chunks read
+    size_t chunkcap;                // number of allocated chunks
+    size_t nsorted;                 // number of chunks sorted
+    size_t nspilled;                // number of chunks written as runs
+    size_t resident;                // bytes of chunks in memory
+    int eof;                        // 1 once the input is read
+    int err;                        // errno of the worker on failure
+    int threaded;                   // 1 if the worker runs on a thread
+#if NATCMP_EXTSORT_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+} natcmp_extsort_stream_t;
+
+static inline void natcmp_extsort_lock(natcmp_extsort_stream_t *st)
+{
+#if NATCMP_EXTSORT_THREADS
+    if (st->threaded) {
+        pthread_mutex_lock(&st->lock);
+    }
+#endif
+    (void)st;
+}
+
+static inline void natcmp_extsort_unlock(natcmp_extsort_stream_t *st)
+{
+#if NATCMP_EXTSORT_THREADS
+    if (st->threaded) {
+        pthread_mutex_unlock(&st->lock);
+    }
+#endif
+    (void)st;
+}
+
+// writes a sorted chunk as a run at the end of the temporary file
+static inline int natcmp_extsort_spill(natcmp_extsort_t *s, natcmp_io_t *io,
+                                       const natcmp_extsort_chunk_t *c)
+{
+    natcmp_io_op_t op;
+    unsigned char *out = (unsigned char *)natcmp_alloc(s->alloc, c->len + 1);
+    if (!out || (s->spill < 0 && natcmp_extsort_open_spill(s) != 0) ||
+        natcmp_extsort_grow(s, (void **)&s->runs, &s->runcap,
+                            sizeof(*s->runs), s->nruns, s->nruns + 1) != 0) {
+        natcmp_free(s->alloc, out, c->len + 1);
+        return -1;
+    }
+
+    size_t len = natcmp_extsort_join(c->lines, c->nlines, out);
+    int rv     = 0;
+    if (len) {
+        rv = (natcmp_io_write(io, &op, s->spill, out, len, s->spilllen) ==
+                  0 &&
+              natcmp_io_write_all(io, &op) == 0)
+                 ? 0
+                 : -1;
+    }
+    natcmp_free(s->alloc, out, c->len + 1);
+    if (rv == 0 && len) {
+        s->runs[s->nruns].off = s->spilllen;
+        s->runs[s->nruns].len = (off_t)len;
+        s->nruns++;
+        s->spilllen += (off_t)len;
+    }
+    return rv;
+}
+
+// releases the memory of a chunk
+static inline void natcmp_extsort_chunk_free(natcmp_extsort_t *s,
+                                             natcmp_extsort_chunk_t *c)
+{
+    natcmp_free(s->alloc, c->buf, c->size);
+    natcmp_free(s->alloc, (void *)c->lines, sizeof(*c->lines) * c->linecap);
+    c->buf     = NULL;
+    c->lines   = NULL;
+    c->linecap = 0;
+}
+
+// sorts the chunks read so far; on a thread, waits for more until the end
+// of the input. Sorted chunks are written as runs while the chunks in memory
+// take more than the memory budget.
+static inline int natcmp_extsort_work(natcmp_extsort_stream_t *st)
+{
+    natcmp_extsort_t *s = st->s;
+    natcmp_io_t io;
+    int hasio = 0;
+    int rv    = 0;
+
+    natcmp_extsort_lock(st);
+    for (;;) {
+#if NATCMP_EXTSORT_THREADS
+        while (st->threaded && st->nsorted == st->nchunks && !st->eof) {
+            pthread_cond_wait(&st->cond, &st->lock);
+        }
+#endif
+        if (st->nsorted == st->nchunks) {
+            break;
+        }
+
+        // sort the next chunk without holding the lock
+        natcmp_extsort_chunk_t c = st->chunks[st->nsorted];
+        natcmp_extsort_unlock(st);
+        rv = natcmp_extsort_split(s, c.buf, c.len, &c.lines, &c.linecap,
+                                  &c.nlines);
+        natcmp_extsort_lock(st);
+        st->chunks[st->nsorted++] = c;
+        if (rv != 0) {
+            break;
+        }
+
+        while (st->resident > s->memory && st->nspilled < st->nsorted) {
+            c = st->chunks[st->nspilled];
+            natcmp_extsort_unlock(st);
+            if (!hasio) {
+                natcmp_io_init(&io, 1, st->ioflags);
+                hasio = 1;
+            }
+            rv = natcmp_extsort_spill(s, &io, &c);
+            natcmp_extsort_chunk_free(s, &c);
+            natcmp_extsort_lock(st);
+            st->chunks[st->nspilled++] = c;
+            st->resident -= c.size;
+            if (rv != 0) {
+                break;
+            }
+        }
+        if (rv != 0) {
+            break;
+        }
+    }
+    if (rv != 0) {
+        st->err = errno;
+    }
+    natcmp_extsort_unlock(st);
+    if (hasio) {
+        natcmp_io_close(&io);
+    }
+    return rv;
+}
+
+#if NATCMP_EXTSORT_THREADS
+static inline void *natcmp_extsort_worker(void *arg)
+{
+    natcmp_extsort_work((natcmp_extsort_stream_t *)arg);
+    return NULL;
+}
+#endif
+
+// hands a chunk read from the input to the worker
+static inline int natcmp_extsort_submit(natcmp_extsort_stream_t *st,
+                                        unsigned char *buf, size_t size,
+                                        size_t len)
+{
+    natcmp_extsort_lock(st);
+    int rv = natcmp_extsort_grow(st->s, (void **)&st->chunks, &st->chunkcap,
+                                 sizeof(*st->chunks), st->nchunks,
+                                 st->nchunks + 1);
+    if (rv != 0) {
+        natcmp_free(st->s->alloc, buf, size);
+    } else {
+        natcmp_extsort_chunk_t *c = st->chunks + st->nchunks++;
+        memset(c, 0, sizeof(*c));
+        c->buf  = buf;
+        c->size = size;
+        c->len  = len;
+        st->resident += size;
+        if (st->err) {
+            errno = st->err;
+            rv    = -1;
+        }
+    }
+#if NATCMP_EXTSORT_THREADS
+    if (st->threaded) {
+        pthread_cond_signal(&st->cond);
+    }
+#endif
+    natcmp_extsort_unlock(st);
+
+    if (rv == 0 && !st->threaded) {
+        return natcmp_extsort_work(st);
+    }
+    return rv;
+}
+
+// reads the input in chunks and hands them to the worker
+static inline int natcmp_extsort_read(natcmp_extsort_stream_t *st, int in,
+                                      size_t chunk)
+{
+    natcmp_extsort_t *s = st->s;
+    natcmp_io_op_t op;
+    size_t size        = chunk + 1;
+    size_t have        = 0;
+    unsigned char *buf = (unsigned char *)natcmp_alloc(s->alloc, size);
+    if (!buf) {
+        return -1;
+    }
+
+    for (;;) {
+        if (have == size - 1) {
+            // hand over the complete lines and keep the last one
+            size_t end = have;
+            while (end && buf[end - 1] != '\n') {
+                end--;
+            }
+            size_t tail  = have - end;
+            size_t nsize = (tail < chunk ? chunk : 2 * tail) + 1;
+            unsigned char *next =
+                (unsigned char *)natcmp_alloc(s->alloc, nsize);
+            if (!next) {
+                natcmp_free(s->alloc, buf, size);
+                return -1;
+            }
+            memcpy(next, buf + end, tail);
+            if (end) {
+                if (natcmp_extsort_submit(st, buf, size, end) != 0) {
+                    natcmp_free(s->alloc, next, nsize);
+                    return -1;
+                }
+            } else {
+                natcmp_free(s->alloc, buf, size);
+            }
+            buf  = next;
+            size = nsize;
+            have = tail;
+        }
+
+        ssize_t n;
+        if (natcmp_io_read(&s->io, &op, in, buf + have, size - 1 - have, -1) !=
+                0 ||
+            (n = natcmp_io_wait(&s->io, &op)) < 0) {
+            natcmp_free(s->alloc, buf, size);
+            return -1;
+        } else if (n == 0) {
+            break;
+        }
+        have += (size_t)n;
+    }
+
+    if (have) {
+        return natcmp_extsort_submit(st, buf, size, have);
+    }
+    natcmp_free(s->alloc, buf, size);
+    return 0;
+}
+
+// merges the sorted chunks in memory into out
+static inline int natcmp_extsort_merge_chunks(natcmp_extsort_stream_t *st,
+                                              int out, size_t block)
+{
+    natcmp_extsort_t *s = st->s;
+    size_t k            = st->nchunks;
+    const unsigned char **heads = (const unsigned char **)natcmp_alloc_array(
+        s->alloc, k, sizeof(*heads));
+    size_t *pos  = (size_t *)natcmp_alloc_array(s->alloc, k, sizeof(*pos));
+    size_t *heap = (size_t *)natcmp_alloc_array(s->alloc, k, sizeof(*heap));
+    natcmp_extsort_out_t o;
+    size_t nheap = 0;
+    int rv       = -1;
+
+    if (natcmp_extsort_out_init(s, &o, out, block) != 0 || !heads || !pos ||
+        !heap) {
+        goto done;
+    }
+    for (size_t i = 0; i < k; i++) {
+        pos[i] = 0;
+        if (st->chunks[i].nlines) {
+            heads[i]      = st->chunks[i].lines[0];
+            heap[nheap++] = i;
+        }
+    }
+    for (size_t i = nheap / 2; i-- > 0;) {
+        natcmp_extsort_sift(s, heads, heap, nheap, i);
+    }
+
+    while (nheap) {
+        size_t i                        = heap[0];
+        const natcmp_extsort_chunk_t *c = st->chunks + i;
+        if (natcmp_extsort_put(&o, heads[i],
+                               strlen((const char *)heads[i])) != 0) {
+            goto done;
+        } else if (++pos[i] < c->nlines) {
+            heads[i] = c->lines[pos[i]];
+        } else {
+            heap[0] = heap[--nheap];
+        }
+        natcmp_extsort_sift(s, heads, heap, nheap, 0);
+    }
+    if (natcmp_extsort_out_finish(&o) != 0) {
+        goto done;
+    }
+    rv = 0;
+
+done:
+    if (rv != 0) {
+        int err = errno;
+        natcmp_io_drain(&s->io);
+        errno = err;
+    }
+    natcmp_extsort_out_free(s, &o);
+    natcmp_free(s->alloc, (void *)heads, sizeof(*heads) * k);
+    natcmp_free(s->alloc, pos, sizeof(*pos) * k);
+    natcmp_free(s->alloc, heap, sizeof(*heap) * k);
+    return rv;
+}
+
+// sorts a stream: reads it in chunks that a worker sorts meanwhile, and
+// merges the chunks in memory, or the runs written when they did not fit
+static inline int natcmp_extsort_streaming(natcmp_extsort_t *s, int in,
+                                           int out, int ioflags)
+{
+    natcmp_extsort_stream_t st;
+    size_t chunk = s->memory / 16;
+    if (chunk > NATCMP_EXTSORT_STREAM_CHUNK) {
+        chunk = NATCMP_EXTSORT_STREAM_CHUNK;
+    } else if (chunk < NATCMP_EXTSORT_MIN_BLOCK) {
+        chunk = NATCMP_EXTSORT_MIN_BLOCK;
+    }
+
+    memset(&st, 0, sizeof(st));
+    st.s       = s;
+    st.ioflags = ioflags;
+#if NATCMP_EXTSORT_THREADS
+    if (pthread_mutex_init(&st.lock, NULL) == 0) {
+        if (pthread_cond_init(&st.cond, NULL) == 0) {
+            st.threaded = 1;
+            if (pthread_create(&st.thread, NULL, natcmp_extsort_worker, &st) !=
+                0) {
+                pthread_cond_destroy(&st.cond);
+                st.threaded = 0;
+            }
+        }
+        if (!st.threaded) {
+            pthread_mutex_destroy(&st.lock);
+        }
+    }
+#endif
+
+    int rv = natcmp_extsort_read(&st, in, chunk);
+    int err = errno;
+#if NATCMP_EXTSORT_THREADS
+    if (st.threaded) {
+        pthread_mutex_lock(&st.lock);
+        st.eof = 1;
+        pthread_cond_signal(&st.cond);
+        pthread_mutex_unlock(&st.lock);
+        pthread_join(st.thread, NULL);
+        pthread_cond_destroy(&st.cond);
+        pthread_mutex_destroy(&st.lock);
+        st.threaded = 0;
+    }
+#endif
+    if (rv == 0 && st.err) {
+        rv  = -1;
+        err = st.err;
+    }
+
+    if (rv == 0 && st.nspilled) {
+        // the chunks did not fit: write the rest as runs and merge them
+        for (size_t i = st.nspilled; rv == 0 && i < st.nchunks; i++) {
+            rv  = natcmp_extsort_spill(s, &s->io, st.chunks + i);
+            err = errno;
+            natcmp_extsort_chunk_free(s, st.chunks + i);
+        }
+        if (rv == 0) {
+            rv  = natcmp_extsort_merge(s, out);
+            err = errno;
+        }
+    } else if (rv == 0) {
+        rv  = natcmp_extsort_merge_chunks(&st, out, chunk);
+        err = errno;
+    }
+
+    for (size_t i = 0; i < st.nchunks; i++) {
+        natcmp_extsort_chunk_free(s, st.chunks + i);
+    }
+    natcmp_free(s->alloc, st.chunks, sizeof(*st.chunks) * st.chunkcap);
+    errno = err;
+    return rv;
+}
+
+/**
+ * natcmp_extsort
+ *
+ * Sorts the lines read from `in` in natural order and writes them to `out`.
+ * Both may be pipes.
+ *
+ * @param in    Input file descriptor
+ * @param out   Output file descriptor
+ * @param opts  Options, or NULL for the defaults
+ * @return int  0 on success, -1 on failure with errno set (ENOBUFS if a line
+ *              does not fit in a chunk, EINVAL if a line contains a NUL byte)
+ */
+static inline int natcmp_extsort(int in, int out,
+                                 const natcmp_extsort_opts_t *opts)
+{
+    static const natcmp_extsort_opts_t defaults;
+    natcmp_extsort_t s;
+
+    if (!opts) {
+        opts = &defaults;
+    }
+    memset(&s, 0, sizeof(s));
+    s.spill   = -1;
+    s.memory  = opts->memory ? opts->memory : NATCMP_EXTSORT_MEMORY;
+    s.tmpdir  = opts->tmpdir;
+    s.compare = opts->compare;
+    s.alloc   = opts->alloc;
+    if (!s.tmpdir) {
+        s.tmpdir = getenv("TMPDIR");
+        if (!s.tmpdir || !*s.tmpdir) {
+            s.tmpdir = "/tmp";
+        }
+    }
+    natcmp_io_init(&s.io, NATCMP_EXTSORT_DEPTH, opts->ioflags);
+
+    struct stat sb;
+    int rv;
+    if (opts->stream || fstat(in, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+        rv = natcmp_extsort_streaming(&s, in, out, opts->ioflags);
+    } else if ((rv = natcmp_extsort_runs(&s, in, out)) == 0 && s.nruns) {
+        rv = natcmp_extsort_merge(&s, out);
+    }
+
+    int err = errno;
+    natcmp_io_close(&s.io);
+    if (s.spill >= 0) {
+        close(s.spill);
+    }
+    natcmp_free(s.alloc, s.runs, sizeof(*s.runs) * s.runcap);
+    natcmp_free(s.alloc, (void *)s.lines, sizeof(*s.lines) * s.linecap);
+    errno = err;
+    return rv;
+}
+
+#endif /* natcmp_extsort_h */
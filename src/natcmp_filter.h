@@ -0,0 +1,349 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_filter_h
+#define natcmp_filter_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_key.h"
+
+/**
+ * Range filter
+ *
+ * natcmp_filter_t answers "may any string in [lo, hi] exist?" for a set of
+ * strings in the order of natcmp(a, b, NULL), with no false negatives. Like
+ * the base and real variants of SuRF, it stores the sort key of each string
+ * truncated to the shortest prefix that tells it apart from its neighbours,
+ * plus `extra` more bytes: a query is answered by finding the first stored
+ * prefix that may reach `lo` and checking that it does not exceed `hi`, and
+ * more extra bytes mean fewer false positives for more space.
+ *
+ * Prefixes are stored in order and front-coded (the length shared with the
+ * previous prefix, the length of the rest with a bit telling whether the
+ * prefix is the whole key, and the rest) in blocks of
+ * NATCMP_FILTER_BLOCK prefixes, whose offsets are kept in an index for
+ * binary search. Prefixes are at most NATCMP_FILTER_KEYMAX bytes.
+ */
+#define NATCMP_FILTER_BLOCK  16
+#define NATCMP_FILTER_KEYMAX 256
+
+/**
+ * natcmp_filter_t
+ *
+ * Range filter. Build it with natcmp_filter_build() and release it with
+ * natcmp_filter_free().
+ */
+typedef struct {
+    unsigned char *data; // front-coded prefixes
+    size_t len;          // number of bytes used in data
+    size_t cap;          // size of data
+    size_t *index;       // offsets of the blocks in data
+    size_t nindex;       // number of slots of index
+    size_t nblock;       // number of blocks
+    size_t n;            // number of prefixes
+    const natcmp_allocator_t *alloc;
+} natcmp_filter_t;
+
+static inline int natcmp_filter_put(natcmp_filter_t *f, const void *p,
+                                    size_t len)
+{
+    if (f->cap - f->len < len) {
+        size_t cap = f->cap ? f->cap : 256;
+        while (cap - f->len < len) {
+            cap *= 2;
+        }
+        unsigned char *data = (unsigned char *)natcmp_alloc(f->alloc, cap);
+        if (!data) {
+            return -1;
+        }
+        if (f->len) {
+            memcpy(data, f->data, f->len);
+        }
+        natcmp_free(f->alloc, f->data, f->cap);
+        f->data = data;
+        f->cap  = cap;
+    }
+    memcpy(f->data + f->len, p, len);
+    f->len += len;
+    return 0;
+}
+
+// appends `v` as a LEB128 varint
+static inline int natcmp_filter_put_varint(natcmp_filter_t *f, size_t v)
+{
+    unsigned char buf[sizeof(size_t) * 8 / 7 + 1];
+    size_t len = 0;
+    do {
+        buf[len++] = (unsigned char)((v & 0x7f) | (v > 0x7f ? 0x80 : 0));
+        v >>= 7;
+    } while (v);
+    return natcmp_filter_put(f, buf, len);
+}
+
+static inline size_t natcmp_filter_get_varint(const unsigned char **p)
+{
+    size_t v           = 0;
+    unsigned int shift = 0;
+    while (**p & 0x80) {
+        v |= (size_t)(*(*p)++ & 0x7f) << shift;
+        shift += 7;
+    }
+    return v | ((size_t)*(*p)++ << shift);
+}
+
+static inline size_t natcmp_filter_lcp(const unsigned char *a, size_t alen,
+                                       const unsigned char *b, size_t blen)
+{
+    size_t n = (alen < blen) ? alen : blen;
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+// writes the key of s truncated to NATCMP_FILTER_KEYMAX bytes
+static inline size_t natcmp_filter_key(const unsigned char *s,
+                                       unsigned char *buf)
+{
+    size_t len = natcmp_key(s, buf, NATCMP_FILTER_KEYMAX);
+    return (len < NATCMP_FILTER_KEYMAX) ? len : NATCMP_FILTER_KEYMAX;
+}
+
+/**
+ * natcmp_filter_free
+ *
+ * Releases the memory of a filter.
+ */
+static inline void natcmp_filter_free(natcmp_filter_t *f)
+{
+    natcmp_free(f->alloc, f->data, f->cap);
+    natcmp_free(f->alloc, f->index, sizeof(*f->index) * f->nindex);
+    f->data   = NULL;
+    f->index  = NULL;
+    f->len    = 0;
+    f->cap    = 0;
+    f->nindex = 0;
+    f->nblock = 0;
+    f->n      = 0;
+}
+
+/**
+ * natcmp_filter_build
+ *
+ * Builds a filter over n strings sorted with natcmp(a, b, NULL).
+ *
+ * @param f      Filter to initialize
+ * @param strs   Sorted strings
+ * @param n      Number of strings
+ * @param extra  Number of key bytes kept past the distinguishing prefix
+ *               (0 for the smallest filter, more for fewer false positives)
+ * @param alloc  Allocator or NULL
+ * @return int   0 on success, -1 on failure with errno set to ENOMEM
+ */
+static inline int natcmp_filter_build(natcmp_filter_t *f,
+                                      const unsigned char *const *strs,
+                                      size_t n, size_t extra,
+                                      const natcmp_allocator_t *alloc)
+{
+    unsigned char keys[3][NATCMP_FILTER_KEYMAX];
+    unsigned char last[NATCMP_FILTER_KEYMAX]; // previous stored prefix
+    size_t lens[3]      = {0, 0, 0};
+    size_t lastlen      = 0;
+    unsigned char *prev = keys[0]; // key of the previous string
+    unsigned char *cur  = keys[1]; // key of the current string
+    unsigned char *next = keys[2]; // key of the next string
+
+    memset(f, 0, sizeof(*f));
+    f->alloc  = alloc;
+    f->nindex = n / NATCMP_FILTER_BLOCK + 1;
+    f->index  = (size_t *)natcmp_alloc_array(alloc, f->nindex,
+                                             sizeof(*f->index));
+    if (!f->index) {
+        return -1;
+    }
+
+    if (n) {
+        lens[1] = natcmp_filter_key(strs[0], cur);
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t lcp = 0;
+        if (i > 0) {
+            lcp = natcmp_filter_lcp(prev, lens[0], cur, lens[1]);
+        }
+        if (i + 1 < n) {
+            lens[2]  = natcmp_filter_key(strs[i + 1], next);
+            size_t l = natcmp_filter_lcp(cur, lens[1], next, lens[2]);
+            lcp      = (l > lcp) ? l : lcp;
+        }
+
+        // shortest distinguishing prefix plus extra bytes
+        size_t len    = lcp + 1 + extra;
+        len           = (len < lens[1]) ? len : lens[1];
+        size_t shared = natcmp_filter_lcp(last, lastlen, cur, len);
+        // a prefix equal to the previous one (equal strings) is stored once
+        if (!f->n || shared != len || len != lastlen) {
+            if (f->n % NATCMP_FILTER_BLOCK == 0) {
+                f->index[f->nblock++] = f->len;
+                shared                = 0;
+            }
+            // the low bit tells whether the prefix is the whole key
+            if (natcmp_filter_put_varint(f, shared) != 0 ||
+                natcmp_filter_put_varint(
+                    f, (len - shared) * 2 + (len == lens[1])) != 0 ||
+                natcmp_filter_put(f, cur + shared, len - shared) != 0) {
+                natcmp_filter_free(f);
+                return -1;
+            }
+            memcpy(last, cur, len);
+            lastlen = len;
+            f->n++;
+        }
+
+        // rotate the key buffers
+        unsigned char *tmp = prev;
+        prev               = cur;
+        cur                = next;
+        next               = tmp;
+        lens[0]            = lens[1];
+        lens[1]            = lens[2];
+    }
+    return 0;
+}
+
+/**
+ * natcmp_filter_cursor_t
+ *
+ * Decoder of the prefixes of a block.
+ */
+typedef struct {
+    const unsigned char *p; // next entry
+    size_t left;            // number of entries left in the block
+    unsigned char key[NATCMP_FILTER_KEYMAX]; // current prefix
+    size_t len;                              // length of the current prefix
+    int full;                                // prefix is the whole key
+} natcmp_filter_cursor_t;
+
+static inline void natcmp_filter_seek(const natcmp_filter_t *f,
+                                      natcmp_filter_cursor_t *c, size_t block)
+{
+    c->p    = f->data + f->index[block];
+    c->left = (block + 1 < f->nblock) ? NATCMP_FILTER_BLOCK
+                                      : f->n - block * NATCMP_FILTER_BLOCK;
+    c->len  = 0;
+}
+
+static inline void natcmp_filter_next(natcmp_filter_cursor_t *c)
+{
+    size_t shared = natcmp_filter_get_varint(&c->p);
+    size_t rest   = natcmp_filter_get_varint(&c->p);
+    c->full       = (int)(rest & 1);
+    rest >>= 1;
+    memcpy(c->key + shared, c->p, rest);
+    c->p += rest;
+    c->len = shared + rest;
+    c->left--;
+}
+
+// returns 1 if every key that starts with the prefix at the cursor is less
+// than key lo
+static inline int natcmp_filter_below(const natcmp_filter_cursor_t *c,
+                                      const unsigned char *lo, size_t lolen)
+{
+    int cmp = memcmp(c->key, lo, (c->len < lolen) ? c->len : lolen);
+    return cmp < 0 || (cmp == 0 && c->full && c->len < lolen);
+}
+
+/**
+ * natcmp_filter_may_contain
+ *
+ * Returns 0 if no string of the filter is in [lo, hi] (in the order of
+ * natcmp(a, b, NULL)), and 1 if one may be.
+ *
+ * @param f   Filter
+ * @param lo  Lower bound, or NULL for no lower bound
+ * @param hi  Upper bound, or NULL for no upper bound
+ * @return int  0 or 1
+ */
+static inline int natcmp_filter_may_contain(const natcmp_filter_t *f,
+                                            const unsigned char *lo,
+                                            const unsigned char *hi)
+{
+    unsigned char lokey[NATCMP_FILTER_KEYMAX];
+    unsigned char hikey[NATCMP_FILTER_KEYMAX];
+    size_t lolen = 0;
+    size_t hilen = 0;
+    int hitrunc  = 0;
+    natcmp_filter_cursor_t c;
+
+    if (!f->n) {
+        return 0;
+    }
+    if (lo) {
+        // a truncated lower bound is a smaller bound, which is safe
+        lolen = natcmp_filter_key(lo, lokey);
+    }
+    if (hi) {
+        hilen   = natcmp_key(hi, hikey, sizeof(hikey));
+        hitrunc = (hilen > sizeof(hikey));
+        hilen   = hitrunc ? sizeof(hikey) : hilen;
+    }
+
+    // find the first block whose first prefix is not below lo
+    size_t lob = 0;
+    size_t hib = f->nblock;
+    while (lob < hib) {
+        size_t mid = lob + (hib - lob) / 2;
+        natcmp_filter_seek(f, &c, mid);
+        natcmp_filter_next(&c);
+        if (natcmp_filter_below(&c, lokey, lolen)) {
+            lob = mid + 1;
+        } else {
+            hib = mid;
+        }
+    }
+
+    // the first prefix not below lo is in the previous block or starts this
+    // one; every prefix skipped so far belongs to a string less than lo
+    size_t b = lob ? lob - 1 : 0;
+    natcmp_filter_seek(f, &c, b);
+    do {
+        if (!c.left) {
+            if (++b >= f->nblock) {
+                return 0;
+            }
+            natcmp_filter_seek(f, &c, b);
+        }
+        natcmp_filter_next(&c);
+    } while (natcmp_filter_below(&c, lokey, lolen));
+
+    if (!hi) {
+        return 1;
+    } else if (hitrunc) {
+        // any prefix that does not exceed the known part of hi may be in range
+        return memcmp(c.key, hikey, (c.len < hilen) ? c.len : hilen) <= 0;
+    }
+    return natcmp_keycmp(c.key, c.len, hikey, hilen) <= 0;
+}
+
+#endif /* natcmp_filter_h */
@@ -0,0 +1,455 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_io_h
+#define natcmp_io_h
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/**
+ * Asynchronous file I/O
+ *
+ * natcmp_io_t queues reads and writes described by natcmp_io_op_t and
+ * reports their completion, so that the callers can work on one buffer while
+ * the next one is read or the previous one is written.
+ *
+ * On Linux, the operations are run by the kernel through an io_uring ring
+ * created with raw system calls (no liburing is needed). The ring is used
+ * when the header is compiled with _GNU_SOURCE or _DEFAULT_SOURCE defined
+ * (for syscall()) by GCC or Clang (for the atomic builtins), and when the
+ * running kernel supports it. Otherwise the operations are run synchronously
+ * with pread() and pwrite() when they are submitted; the interface and the
+ * results are the same.
+ *
+ * The synchronous backend can also be chosen explicitly: at run time by
+ * passing the NATCMP_IO_NOURING flag to natcmp_io_init(), or at compile time
+ * by defining NATCMP_IO_DISABLE_URING before including this header, which
+ * leaves the io_uring code and its system headers out of the build.
+ */
+
+#if defined(__linux__) && defined(__GNUC__) &&                                 \
+    (defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE)) &&                      \
+    !defined(NATCMP_IO_DISABLE_URING)
+#define NATCMP_IO_HAVE_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#define NATCMP_IO_SYNC  0 // operations run synchronously
+#define NATCMP_IO_URING 1 // operations run by io_uring
+
+// flag of natcmp_io_init(): do not use io_uring (see NATCMP_IO_DISABLE_URING
+// to leave it out at compile time)
+#define NATCMP_IO_NOURING 0x01
+
+// largest number of bytes transferred by one operation
+#define NATCMP_IO_MAX_LEN ((size_t)1 << 30)
+
+/**
+ * natcmp_io_op_t
+ *
+ * Read or write operation. It is owned by the caller and must stay alive and
+ * unchanged from natcmp_io_read() or natcmp_io_write() until natcmp_io_wait()
+ * has returned for it.
+ */
+typedef struct {
+    int fd;      // file descriptor
+    int write;   // 1 for a write, 0 for a read
+    void *buf;   // buffer to read into or write from
+    size_t len;  // number of bytes to transfer
+    off_t off;   // file offset, or -1 for the current position
+    int done;    // 1 once completed
+    ssize_t res; // number of bytes transferred, or -1
+    int err;     // errno value when res is -1
+} natcmp_io_op_t;
+
+/**
+ * natcmp_io_t
+ *
+ * Queue of operations. Initialize it with natcmp_io_init() and release it
+ * with natcmp_io_close().
+ */
+typedef struct {
+    int backend;        // NATCMP_IO_SYNC or NATCMP_IO_URING
+    size_t inflight;    // number of submitted operations not yet reaped
+    // io_uring state
+    int ring;           // ring descriptor, or -1
+    unsigned entries;   // number of submission queue entries
+    void *sq;           // mapping of the submission queue ring
+    size_t sqsize;      // size of sq
+    void *cq;           // mapping of the completion queue ring
+    size_t cqsize;      // size of cq
+    void *sqes;         // mapping of the submission queue entries
+    size_t sqessize;    // size of sqes
+    unsigned *sq_tail;  // tail of the submission queue
+    unsigned *sq_mask;  // index mask of the submission queue
+    unsigned *sq_array; // index array of the submission queue
+    unsigned *cq_head;  // head of the completion queue
+    unsigned *cq_tail;  // tail of the completion queue
+    unsigned *cq_mask;  // index mask of the completion queue
+    void *cqes;         // completion queue entries
+} natcmp_io_t;
+
+// runs an operation synchronously
+static inline void natcmp_io_run(natcmp_io_op_t *op)
+{
+    ssize_t n;
+    do {
+        if (op->off < 0) {
+            n = op->write ? write(op->fd, op->buf, op->len)
+                          : read(op->fd, op->buf, op->len);
+        } else {
+            n = op->write ? pwrite(op->fd, op->buf, op->len, op->off)
+                          : pread(op->fd, op->buf, op->len, op->off);
+        }
+    } while (n < 0 && errno == EINTR);
+    op->res  = n;
+    op->err  = (n < 0) ? errno : 0;
+    op->done = 1;
+}
+
+#ifdef NATCMP_IO_HAVE_URING
+
+static inline int natcmp_io_enter(natcmp_io_t *io, unsigned submit,
+                                  unsigned wait)
+{
+    long rv;
+    do {
+        rv = syscall(__NR_io_uring_enter, io->ring, submit, wait,
+                     wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (rv < 0 && errno == EINTR);
+    return (rv < 0) ? -1 : (int)rv;
+}
+
+// releases the mappings and the descriptor of the ring
+static inline void natcmp_io_unmap(natcmp_io_t *io)
+{
+    if (io->sqes) {
+        munmap(io->sqes, io->sqessize);
+    }
+    if (io->cq) {
+        munmap(io->cq, io->cqsize);
+    }
+    if (io->sq) {
+        munmap(io->sq, io->sqsize);
+    }
+    if (io->ring >= 0) {
+        close(io->ring);
+    }
+    io->ring = -1;
+    io->sq = io->cq = io->sqes = NULL;
+}
+
+static inline int natcmp_io_setup(natcmp_io_t *io, unsigned depth)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    long fd = syscall(__NR_io_uring_setup, depth, &p);
+    if (fd < 0) {
+        return -1;
+    }
+    io->ring     = (int)fd;
+    io->entries  = p.sq_entries;
+    io->sqsize   = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    io->cqsize   = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    io->sqessize = p.sq_entries * sizeof(struct io_uring_sqe);
+
+#define map(size, off)                                                         \
+    mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,        \
+         io->ring, (off_t)(off))
+    void *sq   = map(io->sqsize, IORING_OFF_SQ_RING);
+    void *cq   = map(io->cqsize, IORING_OFF_CQ_RING);
+    void *sqes = map(io->sqessize, IORING_OFF_SQES);
+#undef map
+    io->sq   = (sq == MAP_FAILED) ? NULL : sq;
+    io->cq   = (cq == MAP_FAILED) ? NULL : cq;
+    io->sqes = (sqes == MAP_FAILED) ? NULL : sqes;
+    if (!io->sq || !io->cq || !io->sqes) {
+        natcmp_io_unmap(io);
+        return -1;
+    }
+
+    unsigned char *s = (unsigned char *)io->sq;
+    unsigned char *c = (unsigned char *)io->cq;
+    io->sq_tail      = (unsigned *)(void *)(s + p.sq_off.tail);
+    io->sq_mask      = (unsigned *)(void *)(s + p.sq_off.ring_mask);
+    io->sq_array     = (unsigned *)(void *)(s + p.sq_off.array);
+    io->cq_head      = (unsigned *)(void *)(c + p.cq_off.head);
+    io->cq_tail      = (unsigned *)(void *)(c + p.cq_off.tail);
+    io->cq_mask      = (unsigned *)(void *)(c + p.cq_off.ring_mask);
+    io->cqes         = c + p.cq_off.cqes;
+    return 0;
+}
+
+// reaps the available completions, waiting for one if `wait` is set
+static inline int natcmp_io_reap(natcmp_io_t *io, int wait)
+{
+    for (;;) {
+        unsigned head = *io->cq_head;
+        unsigned tail = __atomic_load_n(io->cq_tail, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            for (; head != tail; head++) {
+                struct io_uring_cqe *cqe =
+                    (struct io_uring_cqe *)io->cqes + (head & *io->cq_mask);
+                natcmp_io_op_t *op =
+                    (natcmp_io_op_t *)(uintptr_t)cqe->user_data;
+                op->res  = (cqe->res < 0) ? -1 : (ssize_t)cqe->res;
+                op->err  = (cqe->res < 0) ? -cqe->res : 0;
+                op->done = 1;
+                io->inflight--;
+            }
+            __atomic_store_n(io->cq_head, head, __ATOMIC_RELEASE);
+            return 0;
+        } else if (!wait || !io->inflight) {
+            return 0;
+        } else if (natcmp_io_enter(io, 0, 1) < 0) {
+            return -1;
+        }
+    }
+}
+
+static inline int natcmp_io_push(natcmp_io_t *io, natcmp_io_op_t *op)
+{
+    if (io->inflight == io->entries && natcmp_io_reap(io, 1) != 0) {
+        return -1;
+    }
+
+    unsigned tail            = *io->sq_tail;
+    unsigned idx             = tail & *io->sq_mask;
+    struct io_uring_sqe *sqe = (struct io_uring_sqe *)io->sqes + idx;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = (uint8_t)(op->write ? IORING_OP_WRITE : IORING_OP_READ);
+    sqe->fd        = op->fd;
+    sqe->addr      = (uint64_t)(uintptr_t)op->buf;
+    sqe->len       = (uint32_t)op->len;
+    sqe->off       = (uint64_t)(int64_t)op->off;
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    io->sq_array[idx] = idx;
+    __atomic_store_n(io->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    // the kernel may refuse new work until completions are reaped
+    int rv;
+    while ((rv = natcmp_io_enter(io, 1, 0)) < 0 &&
+           (errno == EAGAIN || errno == EBUSY) && io->inflight) {
+        if (natcmp_io_reap(io, 1) != 0) {
+            return -1;
+        }
+    }
+    if (rv < 0) {
+        // withdraw the entry
+        __atomic_store_n(io->sq_tail, tail, __ATOMIC_RELEASE);
+        return -1;
+    }
+    io->inflight++;
+    return 0;
+}
+
+#endif /* NATCMP_IO_HAVE_URING */
+
+/**
+ * natcmp_io_init
+ *
+ * Initializes a queue, using io_uring when it is available and not disabled
+ * by NATCMP_IO_NOURING.
+ *
+ * @param io     Queue to initialize
+ * @param depth  Largest number of operations in flight (rounded up)
+ * @param flags  NATCMP_IO_NOURING or 0
+ * @return int   Backend in use: NATCMP_IO_URING or NATCMP_IO_SYNC
+ */
+static inline int natcmp_io_init(natcmp_io_t *io, unsigned depth, int flags)
+{
+    memset(io, 0, sizeof(*io));
+    io->ring    = -1;
+    io->backend = NATCMP_IO_SYNC;
+#ifdef NATCMP_IO_HAVE_URING
+    if (!(flags & NATCMP_IO_NOURING) &&
+        natcmp_io_setup(io, depth ? depth : 1) == 0) {
+        io->backend = NATCMP_IO_URING;
+    }
+#else
+    (void)depth;
+    (void)flags;
+#endif
+    return io->backend;
+}
+
+/**
+ * natcmp_io_submit
+ *
+ * Submits an operation prepared by the caller. Reads and writes of more than
+ * NATCMP_IO_MAX_LEN bytes are shortened to that length, and reads and writes
+ * may transfer fewer bytes than requested, as with read() and write().
+ *
+ * @return int  0 on success, -1 on failure with errno set (the operation was
+ *              not submitted)
+ */
+static inline int natcmp_io_submit(natcmp_io_t *io, natcmp_io_op_t *op)
+{
+    op->done = 0;
+    op->res  = 0;
+    op->err  = 0;
+    if (op->len > NATCMP_IO_MAX_LEN) {
+        op->len = NATCMP_IO_MAX_LEN;
+    }
+#ifdef NATCMP_IO_HAVE_URING
+    if (io->backend == NATCMP_IO_URING) {
+        return natcmp_io_push(io, op);
+    }
+#endif
+    (void)io;
+    natcmp_io_run(op);
+    return 0;
+}
+
+/**
+ * natcmp_io_read
+ *
+ * Prepares and submits a read of up to `len` bytes at `off` (-1 for the
+ * current position of `fd`, as with pipes).
+ */
+static inline int natcmp_io_read(natcmp_io_t *io, natcmp_io_op_t *op, int fd,
+                                 void *buf, size_t len, off_t off)
+{
+    op->fd    = fd;
+    op->write = 0;
+    op->buf   = buf;
+    op->len   = len;
+    op->off   = off;
+    return natcmp_io_submit(io, op);
+}
+
+/**
+ * natcmp_io_write
+ *
+ * Prepares and submits a write of up to `len` bytes at `off` (-1 for the
+ * current position of `fd`). Writes at the current position must not overlap
+ * in time, since their order is not guaranteed.
+ */
+static inline int natcmp_io_write(natcmp_io_t *io, natcmp_io_op_t *op, int fd,
+                                  const void *buf, size_t len, off_t off)
+{
+    op->fd    = fd;
+    op->write = 1;
+    op->buf   = (void *)(uintptr_t)buf;
+    op->len   = len;
+    op->off   = off;
+    return natcmp_io_submit(io, op);
+}
+
+/**
+ * natcmp_io_wait
+ *
+ * Waits for the completion of a submitted operation.
+ *
+ * @return ssize_t  Number of bytes transferred (0 at the end of a file), or
+ *                  -1 on failure with errno set
+ */
+static inline ssize_t natcmp_io_wait(natcmp_io_t *io, natcmp_io_op_t *op)
+{
+#ifdef NATCMP_IO_HAVE_URING
+    while (!op->done) {
+        if (natcmp_io_reap(io, 1) != 0) {
+            return -1;
+        } else if (!op->done && !io->inflight) {
+            // not submitted to this queue
+            errno = EINVAL;
+            return -1;
+        }
+    }
+#endif
+    (void)io;
+    if (op->res < 0) {
+        errno = op->err;
+    }
+    return op->res;
+}
+
+/**
+ * natcmp_io_write_all
+ *
+ * Waits for a submitted write and writes the rest of its buffer if it was
+ * shortened.
+ *
+ * @return int  0 on success, -1 on failure with errno set
+ */
+static inline int natcmp_io_write_all(natcmp_io_t *io, natcmp_io_op_t *op)
+{
+    for (;;) {
+        ssize_t n = natcmp_io_wait(io, op);
+        if (n < 0) {
+            return -1;
+        } else if (n == 0 && op->len) {
+            errno = EIO;
+            return -1;
+        } else if ((size_t)n == op->len) {
+            return 0;
+        }
+        unsigned char *p = (unsigned char *)op->buf + n;
+        off_t off        = (op->off < 0) ? -1 : op->off + (off_t)n;
+        if (natcmp_io_write(io, op, op->fd, p, op->len - (size_t)n, off) !=
+            0) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * natcmp_io_drain
+ *
+ * Waits for all the operations in flight, so that their buffers can be
+ * released. Their results are left in their natcmp_io_op_t.
+ */
+static inline void natcmp_io_drain(natcmp_io_t *io)
+{
+#ifdef NATCMP_IO_HAVE_URING
+    if (io->backend == NATCMP_IO_URING) {
+        while (io->inflight && natcmp_io_reap(io, 1) == 0) {
+        }
+    }
+#endif
+    (void)io;
+}
+
+/**
+ * natcmp_io_close
+ *
+ * Waits for the operations in flight and releases the queue.
+ */
+static inline void natcmp_io_close(natcmp_io_t *io)
+{
+    natcmp_io_drain(io);
+#ifdef NATCMP_IO_HAVE_URING
+    if (io->backend == NATCMP_IO_URING) {
+        natcmp_io_unmap(io);
+    }
+#endif
+    io->backend  = NATCMP_IO_SYNC;
+    io->inflight = 0;
+}
+
+#endif /* natcmp_io_h */
@@ -0,0 +1,786 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+
+#ifndef natcmp_jsonl_h
+#define natcmp_jsonl_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_sort.h"
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * JSON Lines sorting
+ *
+ * natcmp_jsonl_t sorts JSON Lines records by the value at a key path such as
+ * ".object.name" or ".tags[0]" in natural order, without building a document
+ * tree: natcmp_jsonl_find() walks the record once, skipping the members and
+ * elements that are not on the path.
+ *
+ * - The scanner tests 8 bytes at a time for the bytes it stops at (quotes,
+ *   backslashes and brackets), so strings and nested values that are not on
+ *   the path are skipped a word at a time.
+ * - A string key without escapes is used where it is: its closing quote is
+ *   overwritten by a NUL byte while the records are sorted, and restored
+ *   afterwards. Keys with escapes are unescaped into a copy, and keys that
+ *   are not strings (numbers, booleans, objects, arrays) are copied as they
+ *   are written.
+ * - Records without the key, or with a null key, sort first. The sort is
+ *   stable.
+ *
+ * Only the parts of a record that are scanned are checked; a record that is
+ * not valid JSON may still be sorted.
+ */
+
+// maximum number of segments of a key path
+#define NATCMP_JSONL_MAX_DEPTH 32
+
+// types of natcmp_jsonl_span_t
+#define NATCMP_JSONL_STRING 1
+#define NATCMP_JSONL_NULL   2
+#define NATCMP_JSONL_OTHER  3
+
+/**
+ * natcmp_jsonl_path_t
+ *
+ * Compiled key path. The names point into the string given to
+ * natcmp_jsonl_path_compile(), which must outlive the path.
+ */
+typedef struct {
+    struct {
+        const char *name; // member name, or NULL for an array index
+        size_t len;       // length of name, or the array index
+    } seg[NATCMP_JSONL_MAX_DEPTH];
+    size_t n;
+} natcmp_jsonl_path_t;
+
+/**
+ * natcmp_jsonl_span_t
+ *
+ * Value found by natcmp_jsonl_find(): the contents of a string between its
+ * quotes, or the text of any other value.
+ */
+typedef struct {
+    const unsigned char *ptr;
+    size_t len;
+    int type;    // NATCMP_JSONL_STRING, NATCMP_JSONL_NULL or NATCMP_JSONL_OTHER
+    int escaped; // the string has escapes (or NUL bytes) to unescape
+} natcmp_jsonl_span_t;
+
+/**
+ * natcmp_jsonl_path_compile
+ *
+ * Compiles a key path made of ".name", ".\"quoted name\"", "[\"name\"]" and
+ * "[index]" segments. "." alone is the whole record.
+ *
+ * @param p     Path to initialize
+ * @param path  Key path, e.g. ".object.name"
+ * @return int  0 on success, -1 with errno set to EINVAL for a malformed
+ *              path or one of more than NATCMP_JSONL_MAX_DEPTH segments
+ */
+static inline int natcmp_jsonl_path_compile(natcmp_jsonl_path_t *p,
+                                            const char *path)
+{
+    p->n = 0;
+    if (path[0] == '.' && path[1] == '\0') {
+        return 0;
+    }
+    while (*path) {
+        const char *name = NULL;
+        size_t len       = 0;
+        if (p->n == NATCMP_JSONL_MAX_DEPTH) {
+            goto INVALID;
+        } else if (path[0] == '[' && path[1] != '"') {
+            // array index
+            for (path++; *path >= '0' && *path <= '9'; path++) {
+                if (len > ((size_t)-1 - 9) / 10) {
+                    goto INVALID;
+                }
+                len = len * 10 + (size_t)(*path - '0');
+            }
+            if (path[-1] == '[' || *path++ != ']') {
+                goto INVALID;
+            }
+        } else if (*path == '.' || *path == '[') {
+            char close = (*path == '[') ? ']' : '\0';
+            if (path[1] == '"') {
+                name = path + 2;
+                path = strchr(name, '"');
+                if (!path) {
+                    goto INVALID;
+                }
+                len = (size_t)(path++ - name);
+            } else if (!close) {
+                name = ++path;
+                len  = strcspn(path, ".[");
+                path += len;
+                if (!len) {
+                    goto INVALID;
+                }
+            }
+            if (close && *path++ != close) {
+                goto INVALID;
+            }
+        } else {
+            goto INVALID;
+        }
+        p->seg[p->n].name  = name;
+        p->seg[p->n++].len = len;
+    }
+    return 0;
+
+INVALID:
+    errno = EINVAL;
+    return -1;
+}
+
+// mask of the bytes of w that are equal to c (the high bit of each is set)
+static inline uint64_t natcmp_jsonl_swar_eq(uint64_t w, unsigned char c)
+{
+    const uint64_t low7 = UINT64_C(0x7f7f7f7f7f7f7f7f);
+    uint64_t x          = w ^ (UINT64_C(0x0101010101010101) * c);
+    return ~(((x & low7) + low7) | x | low7);
+}
+
+static inline size_t natcmp_jsonl_ws(const unsigned char *s, size_t len,
+                                     size_t i)
+{
+    while (i < len &&
+           (s[i] == ' ' || s[i] == '\t' || s[i] == '\n' || s[i] == '\r')) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * natcmp_jsonl_skip_string
+ *
+ * Returns the index of the closing quote of the string whose contents start
+ * at s[i], or len if it is not closed. Sets *escaped if the string contains
+ * a backslash or a NUL byte.
+ */
+static inline size_t natcmp_jsonl_skip_string(const unsigned char *s,
+                                              size_t len, size_t i,
+                                              int *escaped)
+{
+    for (;;) {
+        while (i + 8 <= len) {
+            uint64_t w = natcmp_swar_load(s + i);
+            if (natcmp_jsonl_swar_eq(w, '"') | natcmp_jsonl_swar_eq(w, '\\') |
+                natcmp_jsonl_swar_eq(w, '\0')) {
+                break;
+            }
+            i += 8;
+        }
+        if (i >= len) {
+            return len;
+        } else if (s[i] == '"') {
+            return i;
+        } else if (s[i] == '\\') {
+            *escaped = 1;
+            i += 2;
+        } else {
+            *escaped |= (s[i] == '\0');
+            i++;
+        }
+    }
+}
+
+/**
+ * natcmp_jsonl_skip_value
+ *
+ * Returns the index just past the value that starts at s[i], or len + 1 if
+ * the value is malformed.
+ */
+static inline size_t natcmp_jsonl_skip_value(const unsigned char *s,
+                                             size_t len, size_t i)
+{
+    int escaped = 0;
+    size_t depth;
+
+    if (i >= len) {
+        return len + 1;
+    } else if (s[i] == '"') {
+        i = natcmp_jsonl_skip_string(s, len, i + 1, &escaped);
+        return (i < len) ? i + 1 : len + 1;
+    } else if (s[i] != '{' && s[i] != '[') {
+        // scalar
+        size_t start = i;
+        while (i < len && s[i] != ',' && s[i] != '}' && s[i] != ']' &&
+               s[i] != ' ' && s[i] != '\t' && s[i] != '\n' && s[i] != '\r') {
+            i++;
+        }
+        return (i > start) ? i : len + 1;
+    }
+
+    // object or array: count the brackets outside of strings. With bit 5
+    // set, '[' and ']' become '{' and '}', so three tests find the bytes of
+    // interest in a word (and a few others, which are skipped one by one)
+    depth = 0;
+    for (;;) {
+        while (i + 8 <= len) {
+            uint64_t w = natcmp_swar_load(s + i) | UINT64_C(0x2020202020202020);
+            if (natcmp_jsonl_swar_eq(w, '{') | natcmp_jsonl_swar_eq(w, '}') |
+                natcmp_jsonl_swar_eq(w, '"')) {
+                break;
+            }
+            i += 8;
+        }
+        if (i >= len) {
+            return len + 1;
+        }
+        switch (s[i]) {
+        case '"':
+            i = natcmp_jsonl_skip_string(s, len, i + 1, &escaped);
+            if (i >= len) {
+                return len + 1;
+            }
+            break;
+        case '{':
+        case '[':
+            depth++;
+            break;
+        case '}':
+        case ']':
+            if (--depth == 0) {
+                return i + 1;
+            }
+            break;
+        }
+        i++;
+    }
+}
+
+static inline unsigned natcmp_jsonl_hex4(const unsigned char *s)
+{
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        unsigned c = s[i];
+        if (c >= '0' && c <= '9') {
+            c -= '0';
+        } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+            c = (c | 0x20) - 'a' + 10;
+        } else {
+            return 0x110000;
+        }
+        v = (v << 4) | c;
+    }
+    return v;
+}
+
+/**
+ * natcmp_jsonl_unescape_char
+ *
+ * Decodes the character or escape sequence at s[*i] into out (up to 4
+ * bytes), advances *i past it and returns the number of bytes written.
+ * Surrogate pairs are combined, a lone surrogate is decoded as U+FFFD and a
+ * malformed escape is kept as it is written.
+ */
+static inline size_t natcmp_jsonl_unescape_char(const unsigned char *s,
+                                                size_t len, size_t *i,
+                                                unsigned char *out)
+{
+    unsigned cp;
+
+    if (s[*i] != '\\' || *i + 1 >= len) {
+        out[0] = s[(*i)++];
+        return 1;
+    }
+    switch (s[*i + 1]) {
+    case '"':
+    case '\\':
+    case '/':
+        out[0] = s[*i + 1];
+        break;
+    case 'b':
+        out[0] = '\b';
+        break;
+    case 'f':
+        out[0] = '\f';
+        break;
+    case 'n':
+        out[0] = '\n';
+        break;
+    case 'r':
+        out[0] = '\r';
+        break;
+    case 't':
+        out[0] = '\t';
+        break;
+    case 'u':
+        cp = (*i + 6 <= len) ? natcmp_jsonl_hex4(s + *i + 2) : 0x110000;
+        if (cp == 0x110000) {
+            out[0] = s[(*i)++];
+            return 1;
+        }
+        *i += 6;
+        if (cp >= 0xd800 && cp <= 0xdbff && *i + 6 <= len && s[*i] == '\\' &&
+            s[*i + 1] == 'u') {
+            unsigned lo = natcmp_jsonl_hex4(s + *i + 2);
+            if (lo >= 0xdc00 && lo <= 0xdfff) {
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                *i += 6;
+            }
+        }
+        if (cp >= 0xd800 && cp <= 0xdfff) {
+            cp = 0xfffd;
+        }
+        if (cp < 0x80) {
+            out[0] = (unsigned char)cp;
+            return 1;
+        } else if (cp < 0x800) {
+            out[0] = (unsigned char)(0xc0 | (cp >> 6));
+            out[1] = (unsigned char)(0x80 | (cp & 0x3f));
+            return 2;
+        } else if (cp < 0x10000) {
+            out[0] = (unsigned char)(0xe0 | (cp >> 12));
+            out[1] = (unsigned char)(0x80 | ((cp >> 6) & 0x3f));
+            out[2] = (unsigned char)(0x80 | (cp & 0x3f));
+            return 3;
+        }
+        out[0] = (unsigned char)(0xf0 | (cp >> 18));
+        out[1] = (unsigned char)(0x80 | ((cp >> 12) & 0x3f));
+        out[2] = (unsigned char)(0x80 | ((cp >> 6) & 0x3f));
+        out[3] = (unsigned char)(0x80 | (cp & 0x3f));
+        return 4;
+    default:
+        out[0] = s[(*i)++];
+        return 1;
+    }
+    *i += 2;
+    return 1;
+}
+
+/**
+ * natcmp_jsonl_unescape
+ *
+ * Unescapes the contents of a JSON string into out, which needs `len` bytes
+ * at most (the result is never longer than the escaped string). Escapes are
+ * decoded as natcmp_jsonl_unescape_char() does. out is not NUL-terminated.
+ *
+ * @param s    Contents of the string, without the quotes
+ * @param len  Length of s
+ * @param out  Output buffer of at least len bytes
+ * @return size_t  Number of bytes written
+ */
+static inline size_t natcmp_jsonl_unescape(const unsigned char *s, size_t len,
+                                           unsigned char *out)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len;) {
+        if (s[i] == '\\') {
+            n += natcmp_jsonl_unescape_char(s, len, &i, out + n);
+        } else {
+            out[n++] = s[i++];
+        }
+    }
+    return n;
+}
+
+// compares a member name as written in the record with a path segment
+static inline int natcmp_jsonl_name_eq(const unsigned char *s, size_t len,
+                                       int escaped, const char *name,
+                                       size_t nlen)
+{
+    unsigned char buf[4];
+    size_t i = 0;
+    size_t k = 0;
+
+    if (!escaped) {
+        return len == nlen && memcmp(s, name, len) == 0;
+    }
+    while (i < len) {
+        size_t n = natcmp_jsonl_unescape_char(s, len, &i, buf);
+        if (k + n > nlen || memcmp(buf, name + k, n) != 0) {
+            return 0;
+        }
+        k += n;
+    }
+    return k == nlen;
+}
+
+/**
+ * natcmp_jsonl_find
+ *
+ * Finds the value at the key path in a JSON record.
+ *
+ * @param rec   JSON text of the record
+ * @param len   Length of rec
+ * @param p     Compiled key path
+ * @param span  Receives the value
+ * @return int  1 if the value was found, 0 if the record has no value at the
+ *              path, -1 with errno set to EINVAL if the record is malformed
+ */
+static inline int natcmp_jsonl_find(const unsigned char *rec, size_t len,
+                                    const natcmp_jsonl_path_t *p,
+                                    natcmp_jsonl_span_t *span)
+{
+    size_t i = natcmp_jsonl_ws(rec, len, 0);
+
+    for (size_t d = 0; d < p->n; d++) {
+        const char *name = p->seg[d].name;
+        size_t idx       = 0;
+        if (i >= len) {
+            goto INVALID;
+        } else if (rec[i] != (name ? '{' : '[')) {
+            // not an object or an array: there is nothing at the path
+            return (natcmp_jsonl_skip_value(rec, len, i) > len) ? -1 : 0;
+        }
+        i = natcmp_jsonl_ws(rec, len, i + 1);
+        if (i < len && rec[i] == (name ? '}' : ']')) {
+            return 0;
+        }
+        for (;;) {
+            int found = 0;
+            if (name) {
+                int escaped  = 0;
+                size_t start = i + 1;
+                if (i >= len || rec[i] != '"') {
+                    goto INVALID;
+                }
+                i = natcmp_jsonl_skip_string(rec, len, start, &escaped);
+                if (i >= len) {
+                    goto INVALID;
+                }
+                found = natcmp_jsonl_name_eq(rec + start, i - start, escaped,
+                                             name, p->seg[d].len);
+                i     = natcmp_jsonl_ws(rec, len, i + 1);
+                if (i >= len || rec[i] != ':') {
+                    goto INVALID;
+                }
+                i = natcmp_jsonl_ws(rec, len, i + 1);
+            } else {
+                found = (idx++ == p->seg[d].len);
+            }
+            if (found) {
+                break;
+            }
+            i = natcmp_jsonl_skip_value(rec, len, i);
+            if (i > len) {
+                goto INVALID;
+            }
+            i = natcmp_jsonl_ws(rec, len, i);
+            if (i < len && rec[i] == ',') {
+                i = natcmp_jsonl_ws(rec, len, i + 1);
+            } else if (i < len && rec[i] == (name ? '}' : ']')) {
+                return 0;
+            } else {
+                goto INVALID;
+            }
+        }
+    }
+
+    span->escaped = 0;
+    if (i < len && rec[i] == '"') {
+        size_t end = natcmp_jsonl_skip_string(rec, len, i + 1, &span->escaped);
+        if (end >= len) {
+            goto INVALID;
+        }
+        span->ptr  = rec + i + 1;
+        span->len  = end - i - 1;
+        span->type = NATCMP_JSONL_STRING;
+    } else {
+        size_t end = natcmp_jsonl_skip_value(rec, len, i);
+        if (end > len) {
+            goto INVALID;
+        }
+        span->ptr  = rec + i;
+        span->len  = end - i;
+        span->type = (span->len == 4 && memcmp(span->ptr, "null", 4) == 0) ?
+                         NATCMP_JSONL_NULL :
+                         NATCMP_JSONL_OTHER;
+    }
+    return 1;
+
+INVALID:
+    errno = EINVAL;
+    return -1;
+}
+
+/**
+ * natcmp_jsonl_rec_t
+ *
+ * Record of natcmp_jsonl_t.
+ */
+typedef struct {
+    unsigned char *line; // JSON text of the record
+    size_t len;          // length of line
+    unsigned char *key;  // key in line, NULL if copied or missing
+    size_t off;          // offset of the copied key, or (size_t)-1
+} natcmp_jsonl_rec_t;
+
+/**
+ * natcmp_jsonl_t
+ *
+ * Sorter. Initialize it with natcmp_jsonl_init(), add the records with
+ * natcmp_jsonl_add(), sort them with natcmp_jsonl_sort() and release it with
+ * natcmp_jsonl_free().
+ */
+typedef struct {
+    natcmp_jsonl_rec_t *recs; // records, in order after natcmp_jsonl_sort()
+    size_t n;                 // number of records
+    size_t cap;               // number of allocated records
+    unsigned char *keys;      // copied keys, each NUL-terminated
+    size_t klen;              // number of bytes used in keys
+    size_t kcap;              // size of keys
+    natcmp_jsonl_path_t path;
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+} natcmp_jsonl_t;
+
+/**
+ * natcmp_jsonl_init
+ *
+ * Initializes a sorter.
+ *
+ * @param s        Sorter to initialize
+ * @param path     Key path (see natcmp_jsonl_path_compile()); it must
+ *                 outlive the sorter
+ * @param compare  Callback function for comparing non-digit portions
+ *                 (NULL selects natcmp_nondigit_cmp_ascii)
+ * @param alloc    Allocator (NULL selects malloc)
+ * @return int  0 on success, -1 with errno set to EINVAL for a malformed path
+ */
+static inline int natcmp_jsonl_init(natcmp_jsonl_t *s, const char *path,
+                                    natcmp_nondigit_cmp_func_t compare,
+                                    const natcmp_allocator_t *alloc)
+{
+    s->recs    = NULL;
+    s->n       = 0;
+    s->cap     = 0;
+    s->keys    = NULL;
+    s->klen    = 0;
+    s->kcap    = 0;
+    s->compare = compare;
+    s->alloc   = alloc;
+    return natcmp_jsonl_path_compile(&s->path, path);
+}
+
+/**
+ * natcmp_jsonl_free
+ *
+ * Releases the memory of a sorter. The lines of records that were added but
+ * not sorted keep the NUL byte written over the closing quote of their key.
+ */
+static inline void natcmp_jsonl_free(natcmp_jsonl_t *s)
+{
+    natcmp_free(s->alloc, s->recs, sizeof(*s->recs) * s->cap);
+    natcmp_free(s->alloc, s->keys, s->kcap);
+    s->recs = NULL;
+    s->keys = NULL;
+    s->n    = 0;
+    s->cap  = 0;
+    s->klen = 0;
+    s->kcap = 0;
+}
+
+// copies a key into s->keys, unescaping strings
+static inline int natcmp_jsonl_copy(natcmp_jsonl_t *s,
+                                    const natcmp_jsonl_span_t *span)
+{
+    if (s->kcap - s->klen <= span->len) {
+        size_t cap = s->kcap ? s->kcap : 4096;
+        while (cap - s->klen <= span->len) {
+            if (cap > (size_t)-1 / 2) {
+                errno = ENOMEM;
+                return -1;
+            }
+            cap *= 2;
+        }
+        unsigned char *keys = natcmp_alloc(s->alloc, cap);
+        if (!keys) {
+            return -1;
+        }
+        if (s->klen) {
+            memcpy(keys, s->keys, s->klen);
+        }
+        natcmp_free(s->alloc, s->keys, s->kcap);
+        s->keys = keys;
+        s->kcap = cap;
+    }
+
+    unsigned char *dst = s->keys + s->klen;
+    size_t n           = span->len;
+    if (span->type == NATCMP_JSONL_STRING) {
+        n = natcmp_jsonl_unescape(span->ptr, span->len, dst);
+    } else {
+        memcpy(dst, span->ptr, n);
+    }
+    dst[n] = '\0';
+    s->klen += n + 1;
+    return 0;
+}
+
+/**
+ * natcmp_jsonl_add
+ *
+ * Adds a record. The line is not copied: it must stay valid until the
+ * records are written out, and it is modified until natcmp_jsonl_sort()
+ * returns (see above).
+ *
+ * @param s     Sorter
+ * @param line  JSON text of the record
+ * @param len   Length of line
+ * @return int  0 on success, -1 with errno set to EINVAL if the record is
+ *              malformed on the way to the key, or ENOMEM
+ */
+static inline int natcmp_jsonl_add(natcmp_jsonl_t *s, unsigned char *line,
+                                   size_t len)
+{
+    natcmp_jsonl_span_t span;
+    natcmp_jsonl_rec_t *rec;
+    int rv = natcmp_jsonl_find(line, len, &s->path, &span);
+
+    if (rv < 0) {
+        return -1;
+    } else if (s->n == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 1024;
+        natcmp_jsonl_rec_t *recs =
+            natcmp_alloc_array(s->alloc, cap, sizeof(*recs));
+        if (!recs) {
+            return -1;
+        }
+        if (s->n) {
+            memcpy(recs, s->recs, sizeof(*recs) * s->n);
+        }
+        natcmp_free(s->alloc, s->recs, sizeof(*s->recs) * s->cap);
+        s->recs = recs;
+        s->cap  = cap;
+    }
+
+    rec       = s->recs + s->n;
+    rec->line = line;
+    rec->len  = len;
+    rec->key  = NULL;
+    rec->off  = (size_t)-1;
+    if (rv == 0 || span.type == NATCMP_JSONL_NULL) {
+        // no key
+    } else if (span.type == NATCMP_JSONL_STRING && !span.escaped) {
+        // terminate the key in place
+        rec->key           = line + (span.ptr - line);
+        rec->key[span.len] = '\0';
+    } else {
+        rec->off = s->klen;
+        if (natcmp_jsonl_copy(s, &span) != 0) {
+            return -1;
+        }
+    }
+    s->n++;
+    return 0;
+}
+
+// orders records without a key first
+static inline int natcmp_jsonl_cmp(const natcmp_jsonl_rec_t *a,
+                                   const natcmp_jsonl_rec_t *b,
+                                   natcmp_nondigit_cmp_func_t compare)
+{
+    if (!a->key || !b->key) {
+        return (a->key != NULL) - (b->key != NULL);
+    }
+    return natcmp(a->key, b->key, compare);
+}
+
+static inline void natcmp_jsonl_sort_rec(natcmp_jsonl_rec_t *recs, size_t n,
+                                         natcmp_jsonl_rec_t *buf,
+                                         natcmp_nondigit_cmp_func_t compare)
+{
+    if (n <= NATCMP_SORT_INSERTION) {
+        for (size_t i = 1; i < n; i++) {
+            natcmp_jsonl_rec_t r = recs[i];
+            size_t j             = i;
+            while (j > 0 && natcmp_jsonl_cmp(recs + j - 1, &r, compare) > 0) {
+                recs[j] = recs[j - 1];
+                j--;
+            }
+            recs[j] = r;
+        }
+        return;
+    }
+
+    size_t mid = n / 2;
+    natcmp_jsonl_sort_rec(recs, mid, buf, compare);
+    natcmp_jsonl_sort_rec(recs + mid, n - mid, buf, compare);
+    if (natcmp_jsonl_cmp(recs + mid - 1, recs + mid, compare) <= 0) {
+        return;
+    }
+
+    size_t i = 0;
+    size_t j = mid;
+    size_t k = 0;
+    memcpy(buf, recs, sizeof(*recs) * mid);
+    while (i < mid && j < n) {
+        recs[k++] = (natcmp_jsonl_cmp(buf + i, recs + j, compare) <= 0) ?
+                        buf[i++] :
+                        recs[j++];
+    }
+    while (i < mid) {
+        recs[k++] = buf[i++];
+    }
+}
+
+/**
+ * natcmp_jsonl_sort
+ *
+ * Sorts the records by their key with a stable merge sort, then restores
+ * the lines. s->recs[0..s->n) are the records in order; their `key` members
+ * are no longer valid.
+ *
+ * @param s     Sorter
+ * @return int  0 on success, -1 with errno set to ENOMEM on failure (the
+ *              lines are restored and the records are left in an unspecified
+ *              order)
+ */
+static inline int natcmp_jsonl_sort(natcmp_jsonl_t *s)
+{
+    size_t size             = sizeof(*s->recs) * (s->n / 2);
+    natcmp_jsonl_rec_t *buf = NULL;
+    int rv                  = 0;
+
+    // the copied keys can be resolved now that s->keys is not reallocated
+    for (size_t i = 0; i < s->n; i++) {
+        if (s->recs[i].off != (size_t)-1) {
+            s->recs[i].key = s->keys + s->recs[i].off;
+        }
+    }
+    if (s->n > NATCMP_SORT_INSERTION &&
+        (buf = natcmp_alloc(s->alloc, size)) == NULL) {
+        rv = -1;
+    } else {
+        natcmp_jsonl_sort_rec(s->recs, s->n, buf, s->compare);
+        natcmp_free(s->alloc, buf, size);
+    }
+
+    for (size_t i = 0; i < s->n; i++) {
+        natcmp_jsonl_rec_t *r = s->recs + i;
+        if (r->key && r->off == (size_t)-1) {
+            r->key[strlen((const char *)r->key)] = '"';
+        }
+        r->key = NULL;
+        r->off = (size_t)-1;
+    }
+    return rv;
+}
+
+#endif /* natcmp_jsonl_h */
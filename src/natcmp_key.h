@@ -0,0 +1,671 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_key_h
+#define natcmp_key_h
+
+#include "natcmp.h"
+#include <errno.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#ifndef NATCMP_KEY_THREADS
+#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0
+#define NATCMP_KEY_THREADS 1
+#else
+#define NATCMP_KEY_THREADS 0
+#endif
+#endif
+#if NATCMP_KEY_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * Sort key format
+ *
+ * A sort key is a binary string whose memcmp() order matches the order of
+ * natcmp() with the built-in natcmp_nondigit_cmp_ascii callback. The key is a
+ * sequence of self-delimiting tokens, one for each text or digit run:
+ *
+ *   text run:  NATCMP_KEY_TAG_TEXT, lower-cased bytes..., 0x00
+ *   digit run: NATCMP_KEY_TAG_DIGIT, <len>, packed digits..., <zeros>
+ *
+ * <len> is the number of significant digits and <zeros> is the number of
+ * leading zeros, both encoded as a byte count followed by big-endian bytes.
+ * Significant digits are packed two per byte (0-99). Since the digit tag is
+ * less than the text tag, and the shorter key is less when one key is a prefix
+ * of the other, the end of string < digit < non-digit rule of natcmp() holds.
+ *
+ * Keys contain NUL bytes; compare them with natcmp_keycmp().
+ *
+ * A total-order key (natcmp_key_total()) appends a 0x00 end marker and the raw
+ * bytes of the string. The end marker is less than any tag, so the natural
+ * order is kept, and strings with equal natural keys are ordered by their
+ * bytes like natcmp_total().
+ */
+#define NATCMP_KEY_TAG_DIGIT 0x01
+#define NATCMP_KEY_TAG_TEXT  0x02
+
+/**
+ * natcmp_key_writer_t
+ *
+ * Bounded output buffer used while encoding a key. Bytes that do not fit in
+ * the buffer are counted but not written.
+ */
+typedef struct {
+    unsigned char *buf; // output buffer
+    size_t size;        // size of output buffer
+    size_t len;         // number of bytes produced so far
+} natcmp_key_writer_t;
+
+static inline void natcmp_key_put_byte(natcmp_key_writer_t *w, unsigned char c)
+{
+    if (w->len < w->size) {
+        w->buf[w->len] = c;
+    }
+    w->len++;
+}
+
+static inline void natcmp_key_put_size(natcmp_key_writer_t *w, size_t n)
+{
+    // number of bytes required to represent n (at least 1)
+    unsigned char nbyte = 1;
+    while (nbyte < sizeof(size_t) && (n >> (nbyte * 8)) != 0) {
+        nbyte++;
+    }
+    natcmp_key_put_byte(w, nbyte);
+    while (nbyte--) {
+        natcmp_key_put_byte(w, (unsigned char)(n >> (nbyte * 8)));
+    }
+}
+
+/**
+ * natcmp_key_span_text
+ *
+ * Returns the length of the leading non-digit run of s[0..len).
+ */
+static inline size_t natcmp_key_span_text(const unsigned char *s, size_t len)
+{
+    size_t i = 0;
+    while (i + 8 <= len && !natcmp_swar_digits(natcmp_swar_load(s + i))) {
+        i += 8;
+    }
+    while (i < len && !isdigit(s[i])) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * natcmp_key_span_digits
+ *
+ * Returns the length of the leading digit run of s[0..len).
+ */
+static inline size_t natcmp_key_span_digits(const unsigned char *s, size_t len)
+{
+    const uint64_t all = UINT64_C(0x8080808080808080);
+    size_t i           = 0;
+    while (i + 8 <= len && natcmp_swar_digits(natcmp_swar_load(s + i)) == all) {
+        i += 8;
+    }
+    while (i < len && isdigit(s[i])) {
+        i++;
+    }
+    return i;
+}
+
+static inline void natcmp_key_put_text(natcmp_key_writer_t *w,
+                                       const unsigned char *s, size_t len)
+{
+    size_t i = 0;
+    natcmp_key_put_byte(w, NATCMP_KEY_TAG_TEXT);
+    // lower-case 8 bytes at a time while they fit in the buffer
+    while (i + 8 <= len && w->len + 8 <= w->size) {
+        uint64_t v = natcmp_swar_load(s + i);
+        v |= natcmp_swar_between(v, 'A' - 1, 'Z' + 1) >> 2;
+        memcpy(w->buf + w->len, &v, sizeof(v));
+        w->len += 8;
+        i += 8;
+    }
+    for (; i < len; i++) {
+        unsigned char c = s[i];
+        natcmp_key_put_byte(
+            w, (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c);
+    }
+    natcmp_key_put_byte(w, 0);
+}
+
+static inline void natcmp_key_put_digits(natcmp_key_writer_t *w,
+                                         const unsigned char *s, size_t len)
+{
+    size_t zeros = 0;
+    size_t i     = 0;
+    // skip leading zeros but keep the last digit
+    while (zeros + 1 < len && s[zeros] == '0') {
+        zeros++;
+    }
+    s += zeros;
+    len -= zeros;
+
+    natcmp_key_put_byte(w, NATCMP_KEY_TAG_DIGIT);
+    natcmp_key_put_size(w, len);
+    for (; i + 1 < len; i += 2) {
+        natcmp_key_put_byte(w, (unsigned char)((s[i] - '0') * 10 +
+                                               (s[i + 1] - '0')));
+    }
+    if (i < len) {
+        natcmp_key_put_byte(w, (unsigned char)(s[i] - '0'));
+    }
+    natcmp_key_put_size(w, zeros);
+}
+
+/**
+ * natcmp_key_encode
+ *
+ * Encodes s[0..len) into the writer as a sequence of key tokens.
+ */
+static inline void natcmp_key_encode(natcmp_key_writer_t *w,
+                                     const unsigned char *s, size_t len)
+{
+    while (len) {
+        size_t n = 0;
+        if (isdigit(*s)) {
+            n = natcmp_key_span_digits(s, len);
+            natcmp_key_put_digits(w, s, n);
+        } else {
+            n = natcmp_key_span_text(s, len);
+            natcmp_key_put_text(w, s, n);
+        }
+        s += n;
+        len -= n;
+    }
+}
+
+/**
+ * natcmp_key
+ *
+ * Generates a sort key for the string s. Comparing two keys with
+ * natcmp_keycmp() gives the same result as comparing the original strings with
+ * natcmp(a, b, NULL).
+ *
+ * Like snprintf(), the return value is the full length of the key even if the
+ * buffer is too small. A truncated key is a prefix of the full key, so it still
+ * orders correctly against other keys truncated to the same length, only ties
+ * have to be resolved with natcmp().
+ *
+ * @param s     String to generate the key for
+ * @param buf   Output buffer (may be NULL if size is 0)
+ * @param size  Size of the output buffer
+ * @return size_t  Length of the full key
+ */
+static inline size_t natcmp_key(const unsigned char *s, unsigned char *buf,
+                                size_t size)
+{
+    natcmp_key_writer_t w = {buf, size, 0};
+    natcmp_key_encode(&w, s, strlen((const char *)s));
+    return w.len;
+}
+
+/**
+ * natcmp_key_prefix
+ *
+ * Returns the first 8 bytes of the sort key of s as a big-endian integer,
+ * padded with zero bytes, without encoding the rest of the key. Prefixes are
+ * ordered like the strings: if natcmp_key_prefix(a) < natcmp_key_prefix(b)
+ * then natcmp(a, b, NULL) < 0. Equal prefixes have to be resolved with
+ * natcmp().
+ *
+ * @param s  String to generate the key prefix for
+ * @return uint64_t  Key prefix
+ */
+static inline uint64_t natcmp_key_prefix(const unsigned char *s)
+{
+    unsigned char buf[8]  = {0};
+    natcmp_key_writer_t w = {buf, sizeof(buf), 0};
+    uint64_t v            = 0;
+
+    while (*s && w.len < sizeof(buf)) {
+        size_t n = 0;
+        if (isdigit(*s)) {
+            while (isdigit(s[n])) {
+                n++;
+            }
+            natcmp_key_put_digits(&w, s, n);
+        } else {
+            // only the bytes that fit after the tag are needed; if the run
+            // is longer, its terminator does not fit either and the buffer
+            // is full
+            size_t max = sizeof(buf) - w.len - 1;
+            while (n < max && s[n] && !isdigit(s[n])) {
+                n++;
+            }
+            natcmp_key_put_text(&w, s, n);
+        }
+        s += n;
+    }
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        v = (v << 8) | buf[i];
+    }
+    return v;
+}
+
+/**
+ * natcmp_key_encode_total
+ *
+ * Encodes s[0..len) followed by the end marker and the raw bytes of s.
+ */
+static inline void natcmp_key_encode_total(natcmp_key_writer_t *w,
+                                           const unsigned char *s, size_t len)
+{
+    natcmp_key_encode(w, s, len);
+    natcmp_key_put_byte(w, 0);
+    if (w->len + len <= w->size) {
+        memcpy(w->buf + w->len, s, len);
+        w->len += len;
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        natcmp_key_put_byte(w, s[i]);
+    }
+}
+
+/**
+ * natcmp_key_total
+ *
+ * Generates a total-order sort key for the string s. Comparing two keys with
+ * natcmp_keycmp() gives the same result as comparing the original strings with
+ * natcmp_total(a, b, NULL), so only identical strings have identical keys.
+ * The length semantics are the same as natcmp_key().
+ *
+ * @param s     String to generate the key for
+ * @param buf   Output buffer (may be NULL if size is 0)
+ * @param size  Size of the output buffer
+ * @return size_t  Length of the full key
+ */
+static inline size_t natcmp_key_total(const unsigned char *s,
+                                      unsigned char *buf, size_t size)
+{
+    natcmp_key_writer_t w = {buf, size, 0};
+    natcmp_key_encode_total(&w, s, strlen((const char *)s));
+    return w.len;
+}
+
+/**
+ * natcmp_keycmp
+ *
+ * Compares two sort keys generated by natcmp_key().
+ *
+ * @param a     First key
+ * @param alen  Length of first key
+ * @param b     Second key
+ * @param blen  Length of second key
+ * @return int  Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ */
+static inline int natcmp_keycmp(const unsigned char *a, size_t alen,
+                                const unsigned char *b, size_t blen)
+{
+    int cmp = memcmp(a, b, (alen < blen) ? alen : blen);
+    if (cmp != 0) {
+        return (cmp < 0) ? -1 : 1;
+    } else if (alen != blen) {
+        return (alen < blen) ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * natcmp_arena_t
+ *
+ * Contiguous buffer receiving the keys generated by natcmp_keys_bulk().
+ * Keys are written from offset `used` up to `size`, and `used` is advanced
+ * past the written keys on success.
+ *
+ * To split the work across threads of your own, compute the key size of
+ * each range of strings with natcmp_keys_size() and give every thread its
+ * own arena that shares the same `buf`, with `used` set to the start and
+ * `size` set to the end of its slice. The offsets then refer to the one
+ * shared buffer.
+ */
+typedef struct {
+    unsigned char *buf; // key buffer
+    size_t size;        // end of the usable area of buf
+    size_t used;        // offset where the next key is written
+} natcmp_arena_t;
+
+/**
+ * natcmp_key_encode_func_t
+ *
+ * Encoder used by the bulk key functions.
+ */
+typedef void (*natcmp_key_encode_func_t)(natcmp_key_writer_t *w,
+                                         const unsigned char *s, size_t len);
+
+/**
+ * Threaded key generation
+ *
+ * With NATCMP_KEY_THREADS (on by default where POSIX threads are available),
+ * natcmp_keys_size() and natcmp_keys_bulk() split inputs of at least
+ * NATCMP_KEY_PAR_MIN strings per thread into one slice per online CPU, up to
+ * NATCMP_KEY_MAX_THREADS. natcmp_keys_bulk() then runs two passes: the
+ * threads size their slices, the slices are laid out one after the other in
+ * the arena, and the threads fill them in. With NATCMP_KEY_THREADS defined
+ * to 0, or for smaller inputs, the keys are generated by the caller in one
+ * pass. natcmp_keys_size_par() and natcmp_keys_bulk_par() take the number of
+ * threads from the caller instead.
+ */
+#ifndef NATCMP_KEY_PAR_MIN
+#define NATCMP_KEY_PAR_MIN 65536
+#endif
+#ifndef NATCMP_KEY_MAX_THREADS
+#define NATCMP_KEY_MAX_THREADS 16
+#endif
+
+// encodes strings[0..n) into w, storing the offset of each key if out is set
+static inline void natcmp_keys_encode_all(natcmp_key_writer_t *w,
+                                          const unsigned char *const *strings,
+                                          size_t n, size_t *out,
+                                          natcmp_key_encode_func_t encode)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (out) {
+            out[i] = w->len;
+        }
+        encode(w, strings[i], strlen((const char *)strings[i]));
+    }
+}
+
+#if NATCMP_KEY_THREADS
+/**
+ * natcmp_keys_slice_t
+ *
+ * Range of strings whose keys are sized or written by one thread.
+ */
+typedef struct {
+    const unsigned char *const *strings; // first string of the slice
+    size_t n;                            // number of strings
+    size_t *out;                         // offsets of the slice, or NULL
+    unsigned char *buf;                  // shared key buffer (fill pass)
+    size_t start;                        // offset of the slice in buf
+    size_t len;                          // length of the keys of the slice
+    natcmp_key_encode_func_t encode;     // key encoder
+} natcmp_keys_slice_t;
+
+static inline void *natcmp_keys_worker(void *arg)
+{
+    natcmp_keys_slice_t *sl = (natcmp_keys_slice_t *)arg;
+    if (!sl->out) {
+        // size pass
+        natcmp_key_writer_t w = {NULL, 0, 0};
+        natcmp_keys_encode_all(&w, sl->strings, sl->n, NULL, sl->encode);
+        sl->len = w.len;
+    } else {
+        // fill pass; the slice has exactly sl->len bytes from sl->start
+        natcmp_key_writer_t w = {sl->buf, sl->start + sl->len, sl->start};
+        natcmp_keys_encode_all(&w, sl->strings, sl->n, sl->out, sl->encode);
+    }
+    return NULL;
+}
+
+/**
+ * natcmp_keys_run
+ *
+ * Runs the worker on every slice, the first one on the calling thread.
+ * A slice whose thread cannot be created is run by the caller as well.
+ */
+static inline void natcmp_keys_run(natcmp_keys_slice_t *sl, size_t nslice)
+{
+    pthread_t thread[NATCMP_KEY_MAX_THREADS];
+    int started[NATCMP_KEY_MAX_THREADS] = {0};
+
+    for (size_t t = 1; t < nslice; t++) {
+        started[t] =
+            (pthread_create(&thread[t], NULL, natcmp_keys_worker, &sl[t]) == 0);
+    }
+    natcmp_keys_worker(&sl[0]);
+    for (size_t t = 1; t < nslice; t++) {
+        if (started[t]) {
+            pthread_join(thread[t], NULL);
+        } else {
+            natcmp_keys_worker(&sl[t]);
+        }
+    }
+}
+
+/**
+ * natcmp_keys_sized_slices
+ *
+ * Splits strings[0..n) into nslice slices and sizes them on threads.
+ */
+static inline void natcmp_keys_sized_slices(natcmp_keys_slice_t *sl,
+                                            size_t nslice,
+                                            const unsigned char *const *strings,
+                                            size_t n,
+                                            natcmp_key_encode_func_t encode)
+{
+    for (size_t t = 0; t < nslice; t++) {
+        size_t begin  = n / nslice * t + (t < n % nslice ? t : n % nslice);
+        size_t count  = n / nslice + (t < n % nslice);
+        sl[t].strings = strings + begin;
+        sl[t].n       = count;
+        sl[t].out     = NULL;
+        sl[t].buf     = NULL;
+        sl[t].start   = 0;
+        sl[t].len     = 0;
+        sl[t].encode  = encode;
+    }
+    natcmp_keys_run(sl, nslice);
+}
+#endif
+
+/**
+ * natcmp_keys_threads
+ *
+ * Returns the number of threads used for n strings.
+ */
+static inline size_t natcmp_keys_threads(size_t n)
+{
+    size_t nthread = 1;
+#if NATCMP_KEY_THREADS && defined(_SC_NPROCESSORS_ONLN)
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    nthread   = (ncpu > 1) ? (size_t)ncpu : 1;
+    if (nthread > NATCMP_KEY_MAX_THREADS) {
+        nthread = NATCMP_KEY_MAX_THREADS;
+    }
+    // every slice gets at least NATCMP_KEY_PAR_MIN strings
+    size_t most = n / NATCMP_KEY_PAR_MIN;
+    if (nthread > most) {
+        nthread = most ? most : 1;
+    }
+#else
+    (void)n;
+#endif
+    return nthread;
+}
+
+/**
+ * natcmp_keys_size_par
+ *
+ * natcmp_keys_size_with() with an explicit number of threads (at most
+ * NATCMP_KEY_MAX_THREADS; 1 or less runs on the caller only).
+ */
+static inline size_t natcmp_keys_size_par(const unsigned char *const *strings,
+                                          size_t n,
+                                          natcmp_key_encode_func_t encode,
+                                          size_t nthread)
+{
+#if NATCMP_KEY_THREADS
+    if (nthread > NATCMP_KEY_MAX_THREADS) {
+        nthread = NATCMP_KEY_MAX_THREADS;
+    }
+    if (nthread > 1 && n >= nthread) {
+        natcmp_keys_slice_t sl[NATCMP_KEY_MAX_THREADS];
+        size_t len = 0;
+        natcmp_keys_sized_slices(sl, nthread, strings, n, encode);
+        for (size_t t = 0; t < nthread; t++) {
+            len += sl[t].len;
+        }
+        return len;
+    }
+#else
+    (void)nthread;
+#endif
+    natcmp_key_writer_t w = {NULL, 0, 0};
+    natcmp_keys_encode_all(&w, strings, n, NULL, encode);
+    return w.len;
+}
+
+/**
+ * natcmp_keys_bulk_par
+ *
+ * natcmp_keys_bulk() with an explicit number of threads (at most
+ * NATCMP_KEY_MAX_THREADS; 1 or less runs on the caller only).
+ */
+static inline int natcmp_keys_bulk_par(const unsigned char *const *strings,
+                                       size_t n, natcmp_arena_t *arena,
+                                       size_t *out,
+                                       natcmp_key_encode_func_t encode,
+                                       size_t nthread)
+{
+#if NATCMP_KEY_THREADS
+    if (nthread > NATCMP_KEY_MAX_THREADS) {
+        nthread = NATCMP_KEY_MAX_THREADS;
+    }
+    if (nthread > 1 && n >= nthread) {
+        natcmp_keys_slice_t sl[NATCMP_KEY_MAX_THREADS];
+        natcmp_keys_sized_slices(sl, nthread, strings, n, encode);
+
+        // lay the slices out and check the size before writing anything
+        size_t used = arena->used;
+        for (size_t t = 0; t < nthread; t++) {
+            if (used > arena->size || sl[t].len > arena->size - used) {
+                errno = ENOBUFS;
+                return -1;
+            }
+            sl[t].out   = out + (size_t)(sl[t].strings - strings);
+            sl[t].buf   = arena->buf;
+            sl[t].start = used;
+            used += sl[t].len;
+        }
+        natcmp_keys_run(sl, nthread);
+        out[n]      = used;
+        arena->used = used;
+        return 0;
+    }
+#else
+    (void)nthread;
+#endif
+    natcmp_key_writer_t w = {arena->buf, arena->size, arena->used};
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = w.len;
+        encode(&w, strings[i], strlen((const char *)strings[i]));
+        if (w.len > w.size) {
+            errno = ENOBUFS;
+            return -1;
+        }
+    }
+    out[n]      = w.len;
+    arena->used = w.len;
+    return 0;
+}
+
+static inline size_t natcmp_keys_size_with(const unsigned char *const *strings,
+                                           size_t n,
+                                           natcmp_key_encode_func_t encode)
+{
+    return natcmp_keys_size_par(strings, n, encode, natcmp_keys_threads(n));
+}
+
+static inline int natcmp_keys_bulk_with(const unsigned char *const *strings,
+                                        size_t n, natcmp_arena_t *arena,
+                                        size_t *out,
+                                        natcmp_key_encode_func_t encode)
+{
+    return natcmp_keys_bulk_par(strings, n, arena, out, encode,
+                                natcmp_keys_threads(n));
+}
+
+/**
+ * natcmp_keys_size
+ *
+ * Returns the total number of bytes natcmp_keys_bulk() writes for the
+ * strings.
+ *
+ * @param strings  Array of strings
+ * @param n        Number of strings
+ * @return size_t  Total length of the keys
+ */
+static inline size_t natcmp_keys_size(const unsigned char *const *strings,
+                                      size_t n)
+{
+    return natcmp_keys_size_with(strings, n, natcmp_key_encode);
+}
+
+/**
+ * natcmp_keys_bulk
+ *
+ * Generates sort keys for n strings into one contiguous arena.
+ * The key of strings[i] is stored at arena->buf + out[i] and its length is
+ * out[i + 1] - out[i], so `out` must have room for n + 1 offsets.
+ *
+ * @param strings  Array of strings
+ * @param n        Number of strings
+ * @param arena    Arena to store the keys
+ * @param out      Output array of n + 1 offsets
+ * @return int     0 on success, -1 with errno set to ENOBUFS if the arena is
+ *                 too small (arena->used is left unchanged, but the bytes of
+ *                 arena->buf past it and the contents of `out` are
+ *                 unspecified)
+ */
+static inline int natcmp_keys_bulk(const unsigned char *const *strings,
+                                   size_t n, natcmp_arena_t *arena, size_t *out)
+{
+    return natcmp_keys_bulk_with(strings, n, arena, out, natcmp_key_encode);
+}
+
+/**
+ * natcmp_keys_size_total
+ *
+ * Same as natcmp_keys_size() but for natcmp_keys_bulk_total().
+ */
+static inline size_t natcmp_keys_size_total(const unsigned char *const *strings,
+                                            size_t n)
+{
+    return natcmp_keys_size_with(strings, n, natcmp_key_encode_total);
+}
+
+/**
+ * natcmp_keys_bulk_total
+ *
+ * Same as natcmp_keys_bulk() but generates total-order keys like
+ * natcmp_key_total().
+ */
+static inline int natcmp_keys_bulk_total(const unsigned char *const *strings,
+                                         size_t n, natcmp_arena_t *arena,
+                                         size_t *out)
+{
+    return natcmp_keys_bulk_with(strings, n, arena, out,
+                                 natcmp_key_encode_total);
+}
+
+#endif /* natcmp_key_h */
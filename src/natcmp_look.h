@@ -0,0 +1,314 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+
+#ifndef natcmp_look_h
+#define natcmp_look_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Sorted file lookup
+ *
+ * natcmp_look_t finds lines in a text file whose lines are sorted in natural
+ * order, like look(1) does for dictionary order, without reading the file.
+ * The file is mapped into memory and binary-searched on byte offsets: each
+ * probe backs up from the middle of the remaining range to the start of its
+ * line, compares that line with the key and halves the range, so a search
+ * compares O(log n) lines and touches O(log n) pages (plus the pages of the
+ * probed lines themselves).
+ *
+ * A line is the bytes up to, but not including, the next newline; the last
+ * line need not end with one. Each probed line is copied into a scratch
+ * buffer to be NUL-terminated for natcmp(), so lines containing NUL bytes
+ * compare as if they ended there. Searching a file that is not sorted with
+ * the same comparison returns unspecified (but valid) offsets.
+ *
+ * natcmp_look_open() uses POSIX file mapping functions; define
+ * _POSIX_C_SOURCE to 200809L or later before including any header when
+ * compiling with a strict C standard.
+ */
+
+/**
+ * natcmp_look_t
+ *
+ * Sorted lines to search, either a mapped file or a caller's buffer.
+ */
+typedef struct {
+    const unsigned char *map; // lines
+    size_t len;               // size of map in bytes
+    int mapped;               // 1 if map was mapped by natcmp_look_open()
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+    unsigned char *buf; // NUL-terminated copy of the probed line
+    size_t cap;         // size of buf
+    size_t nprobe;      // number of lines compared so far
+} natcmp_look_t;
+
+/**
+ * natcmp_look_init
+ *
+ * Prepares to search the lines of map[0..len), which must stay alive and
+ * unchanged until natcmp_look_close().
+ *
+ * @param lk       Lookup state to initialize
+ * @param map      Sorted lines
+ * @param len      Size of map in bytes
+ * @param compare  Comparison for non-digit parts, or NULL for the default
+ * @param alloc    Allocator for the scratch buffer, or NULL for malloc()
+ */
+static inline void natcmp_look_init(natcmp_look_t *lk, const void *map,
+                                    size_t len,
+                                    natcmp_nondigit_cmp_func_t compare,
+                                    const natcmp_allocator_t *alloc)
+{
+    lk->map     = (const unsigned char *)map;
+    lk->len     = len;
+    lk->mapped  = 0;
+    lk->compare = compare;
+    lk->alloc   = alloc;
+    lk->buf     = NULL;
+    lk->cap     = 0;
+    lk->nprobe  = 0;
+}
+
+/**
+ * natcmp_look_open
+ *
+ * Maps the file at `path` read-only and prepares to search its lines.
+ *
+ * @param lk       Lookup state to initialize
+ * @param path     Sorted text file
+ * @param compare  Comparison for non-digit parts, or NULL for the default
+ * @param alloc    Allocator for the scratch buffer, or NULL for malloc()
+ * @return int     0 on success, -1 with errno set on failure (EFBIG if the
+ *                 file does not fit in the address space)
+ */
+static inline int natcmp_look_open(natcmp_look_t *lk, const char *path,
+                                   natcmp_nondigit_cmp_func_t compare,
+                                   const natcmp_allocator_t *alloc)
+{
+    struct stat st;
+    void *map = NULL;
+    int fd    = open(path, O_RDONLY);
+
+    natcmp_look_init(lk, NULL, 0, compare, alloc);
+    if (fd < 0) {
+        return -1;
+    } else if (fstat(fd, &st) != 0) {
+        goto fail;
+    } else if ((uintmax_t)st.st_size > SIZE_MAX) {
+        errno = EFBIG;
+        goto fail;
+    } else if (st.st_size > 0) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            goto fail;
+        }
+        // a search reads a few scattered pages: read-ahead would be wasted
+        posix_madvise(map, (size_t)st.st_size, POSIX_MADV_RANDOM);
+        lk->map    = (const unsigned char *)map;
+        lk->len    = (size_t)st.st_size;
+        lk->mapped = 1;
+    }
+    close(fd);
+    return 0;
+
+fail:
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+    }
+    return -1;
+}
+
+/**
+ * natcmp_look_close
+ *
+ * Releases the scratch buffer and unmaps the file mapped by
+ * natcmp_look_open().
+ */
+static inline void natcmp_look_close(natcmp_look_t *lk)
+{
+    if (lk->mapped) {
+        munmap((void *)(uintptr_t)lk->map, lk->len);
+    }
+    natcmp_free(lk->alloc, lk->buf, lk->cap);
+    natcmp_look_init(lk, NULL, 0, lk->compare, lk->alloc);
+}
+
+/**
+ * natcmp_look_line_start
+ *
+ * Returns the offset of the start of the line containing the byte at `off`,
+ * which is not before `lo` (a line start).
+ */
+static inline size_t natcmp_look_line_start(const natcmp_look_t *lk,
+                                            size_t lo, size_t off)
+{
+    while (off > lo && lk->map[off - 1] != '\n') {
+        off--;
+    }
+    return off;
+}
+
+/**
+ * natcmp_look_line_end
+ *
+ * Returns the offset of the newline ending the line that starts at `off`, or
+ * the size of the map for a last line without one.
+ */
+static inline size_t natcmp_look_line_end(const natcmp_look_t *lk, size_t off)
+{
+    const unsigned char *nl =
+        (const unsigned char *)memchr(lk->map + off, '\n', lk->len - off);
+    return nl ? (size_t)(nl - lk->map) : lk->len;
+}
+
+/**
+ * natcmp_look_cmp
+ *
+ * Compares the line map[start..end) with `key`. Returns -1, 0 or 1 like
+ * natcmp(), or -2 with errno set to ENOMEM if the line cannot be copied.
+ */
+static inline int natcmp_look_cmp(natcmp_look_t *lk, size_t start, size_t end,
+                                  const unsigned char *key)
+{
+    size_t n = end - start;
+    if (n >= lk->cap) {
+        size_t cap = lk->cap ? lk->cap : 256;
+        while (cap <= n) {
+            cap *= 2;
+        }
+        unsigned char *buf = (unsigned char *)natcmp_alloc(lk->alloc, cap);
+        if (!buf) {
+            return -2;
+        }
+        natcmp_free(lk->alloc, lk->buf, lk->cap);
+        lk->buf = buf;
+        lk->cap = cap;
+    }
+    memcpy(lk->buf, lk->map + start, n);
+    lk->buf[n] = 0;
+    lk->nprobe++;
+    return natcmp(lk->buf, key, lk->compare);
+}
+
+/**
+ * natcmp_look_search
+ *
+ * Returns in *off the offset of the first line in [lo, hi) that is not less
+ * than `key` (greater than `key` if `after` is set), or hi if there is none.
+ * lo and hi must be line starts (or the size of the map).
+ */
+static inline int natcmp_look_search(natcmp_look_t *lk,
+                                     const unsigned char *key, int after,
+                                     size_t lo, size_t hi, size_t *off)
+{
+    // lines starting before lo are before the result, lines from hi are not
+    while (lo < hi) {
+        size_t mid   = lo + (hi - lo) / 2;
+        size_t start = natcmp_look_line_start(lk, lo, mid);
+        size_t end   = natcmp_look_line_end(lk, start);
+        int res      = natcmp_look_cmp(lk, start, end, key);
+        if (res == -2) {
+            return -1;
+        } else if (res < 0 || (after && res == 0)) {
+            lo = (end < lk->len) ? end + 1 : end;
+        } else {
+            hi = start;
+        }
+    }
+    *off = lo;
+    return 0;
+}
+
+/**
+ * natcmp_look_lower
+ *
+ * Finds the first line that is not less than `key`.
+ *
+ * @param lk   Lookup state
+ * @param key  Key to search for
+ * @param off  Receives the offset of the line, or the size of the map if
+ *             every line is less than key
+ * @return int 0 on success, -1 with errno set to ENOMEM on failure
+ */
+static inline int natcmp_look_lower(natcmp_look_t *lk,
+                                    const unsigned char *key, size_t *off)
+{
+    return natcmp_look_search(lk, key, 0, 0, lk->len, off);
+}
+
+/**
+ * natcmp_look_upper
+ *
+ * Finds the first line that is greater than `key`.
+ *
+ * @param lk   Lookup state
+ * @param key  Key to search for
+ * @param off  Receives the offset of the line, or the size of the map if no
+ *             line is greater than key
+ * @return int 0 on success, -1 with errno set to ENOMEM on failure
+ */
+static inline int natcmp_look_upper(natcmp_look_t *lk,
+                                    const unsigned char *key, size_t *off)
+{
+    return natcmp_look_search(lk, key, 1, 0, lk->len, off);
+}
+
+/**
+ * natcmp_look_range
+ *
+ * Finds the lines between `first` and `last` inclusive, in natural order.
+ * They are the bytes map[*start..*end), which end with a newline unless
+ * *end is the size of the map; *start == *end if there is no such line. Use
+ * the same key for both bounds to find the lines equal to it.
+ *
+ * @param lk     Lookup state
+ * @param first  Lower bound
+ * @param last   Upper bound
+ * @param start  Receives the offset of the first line of the range
+ * @param end    Receives the offset just past the range
+ * @return int   0 on success, -1 with errno set to ENOMEM on failure
+ */
+static inline int natcmp_look_range(natcmp_look_t *lk,
+                                    const unsigned char *first,
+                                    const unsigned char *last, size_t *start,
+                                    size_t *end)
+{
+    if (natcmp_look_search(lk, first, 0, 0, lk->len, start) != 0 ||
+        natcmp_look_search(lk, last, 1, *start, lk->len, end) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+#endif /* natcmp_look_h */
@@ -0,0 +1,574 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_pack_h
+#define natcmp_pack_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_key.h"
+#include <stdint.h>
+
+/**
+ * Packed name lists
+ *
+ * natcmp_pack() compresses a list of names such as "frame_000001.exr" ...
+ * "frame_250000.exr" into range records. Each name is split at its last
+ * digit run into a template (the stem before it, the suffix after it and the
+ * zero-padded width of the run, or 0 if it has no leading zero) and a number.
+ * Consecutive names with the same template whose numbers grow by the same
+ * stride form one record; names without a digit run (or with a run of more
+ * than 19 significant digits or wider than 20 digits) are stored as records
+ * of their own.
+ *
+ * Format (<v> is an unsigned LEB128 varint):
+ *
+ *   "NCPK", version, <number of names>, <number of records>, records...
+ *
+ *   record: flags, [template], [<start> <count> [<stride>]]
+ *     flags bit 0: the record has a number
+ *     flags bit 1: the template is the one of the previous record
+ *     template:    <stem length> stem <suffix length> suffix <width>
+ *     <stride> is present only if <count> is greater than 1
+ *
+ * A record without a number has an empty suffix and a stem holding the whole
+ * name. The list is restored in its original order by natcmp_pack_next(), and
+ * the name of a given rank is found with natcmp_pack_index_t.
+ */
+#define NATCMP_PACK_MAGIC    "NCPK"
+#define NATCMP_PACK_VERSION  1
+#define NATCMP_PACK_F_NUMBER 0x01
+#define NATCMP_PACK_F_SAME   0x02
+
+/**
+ * natcmp_pack_name_t
+ *
+ * A name split at its last digit run.
+ */
+typedef struct {
+    const unsigned char *stem;   // text before the digit run
+    size_t stemlen;              // length of stem
+    const unsigned char *suffix; // text after the digit run
+    size_t suffixlen;            // length of suffix
+    size_t width;                // zero-padded width, 0 if not padded
+    uint64_t value;              // value of the digit run
+    int number;                  // 1 if the name has a usable digit run
+} natcmp_pack_name_t;
+
+static inline void natcmp_pack_split(const unsigned char *s,
+                                     natcmp_pack_name_t *nm)
+{
+    size_t len = strlen((const char *)s);
+    size_t end = len;
+    while (end > 0 && !isdigit(s[end - 1])) {
+        end--;
+    }
+    size_t begin = end;
+    while (begin > 0 && isdigit(s[begin - 1])) {
+        begin--;
+    }
+
+    size_t sig = begin;
+    while (sig + 1 < end && s[sig] == '0') {
+        sig++;
+    }
+    // the value must fit in 64 bits, and the padded width in the 20 digits
+    // that a record can describe
+    nm->number = (end > begin && end - sig <= 19 && end - begin <= 20);
+    if (!nm->number) {
+        nm->stem      = s;
+        nm->stemlen   = len;
+        nm->suffix    = s + len;
+        nm->suffixlen = 0;
+        nm->width     = 0;
+        nm->value     = 0;
+        return;
+    }
+    nm->stem      = s;
+    nm->stemlen   = begin;
+    nm->suffix    = s + end;
+    nm->suffixlen = len - end;
+    nm->width     = (sig > begin) ? end - begin : 0;
+    nm->value     = 0;
+    for (size_t i = sig; i < end; i++) {
+        nm->value = nm->value * 10 + (uint64_t)(s[i] - '0');
+    }
+}
+
+// writes the decimal digits of v, zero-padded to width, and returns their
+// number
+static inline size_t natcmp_pack_render(uint64_t v, size_t width,
+                                        unsigned char *buf)
+{
+    unsigned char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (unsigned char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    size_t len = (n < width) ? width : n;
+    memset(buf, '0', len - n);
+    for (size_t i = 0; i < n; i++) {
+        buf[len - 1 - i] = tmp[i];
+    }
+    return len;
+}
+
+// returns 1 if s is the name of template `t` with number v
+static inline int natcmp_pack_match(const unsigned char *s,
+                                    const natcmp_pack_name_t *t, uint64_t v)
+{
+    unsigned char digits[32];
+    size_t n = natcmp_pack_render(v, t->width, digits);
+    return memcmp(s, t->stem, t->stemlen) == 0 &&
+           memcmp(s + t->stemlen, digits, n) == 0 &&
+           strcmp((const char *)s + t->stemlen + n,
+                  (const char *)t->suffix) == 0;
+}
+
+static inline int natcmp_pack_same_template(const natcmp_pack_name_t *a,
+                                            const natcmp_pack_name_t *b)
+{
+    return a->number == b->number && a->width == b->width &&
+           a->stemlen == b->stemlen && a->suffixlen == b->suffixlen &&
+           memcmp(a->stem, b->stem, a->stemlen) == 0 &&
+           memcmp(a->suffix, b->suffix, a->suffixlen) == 0;
+}
+
+static inline void natcmp_pack_put_varint(natcmp_key_writer_t *w, uint64_t v)
+{
+    while (v > 0x7f) {
+        natcmp_key_put_byte(w, (unsigned char)((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    natcmp_key_put_byte(w, (unsigned char)v);
+}
+
+static inline void natcmp_pack_put_bytes(natcmp_key_writer_t *w,
+                                         const unsigned char *p, size_t len)
+{
+    natcmp_pack_put_varint(w, len);
+    for (size_t i = 0; i < len; i++) {
+        natcmp_key_put_byte(w, p[i]);
+    }
+}
+
+/**
+ * natcmp_pack_run
+ *
+ * Finds the record that starts at strs[i]: splits the name into `nm` and
+ * sets the number of names of the record and their stride.
+ */
+static inline void natcmp_pack_run(const unsigned char *const *strs, size_t n,
+                                   size_t i, natcmp_pack_name_t *nm,
+                                   uint64_t *count, uint64_t *stride)
+{
+    natcmp_pack_name_t next;
+
+    natcmp_pack_split(strs[i], nm);
+    *count  = 1;
+    *stride = 0;
+    if (!nm->number || i + 1 >= n) {
+        return;
+    }
+    natcmp_pack_split(strs[i + 1], &next);
+    if (!next.number || next.value <= nm->value ||
+        !natcmp_pack_same_template(nm, &next) ||
+        !natcmp_pack_match(strs[i + 1], nm, next.value)) {
+        return;
+    }
+
+    uint64_t v = next.value;
+    *stride    = next.value - nm->value;
+    *count     = 2;
+    while (i + *count < n && v <= UINT64_MAX - *stride &&
+           natcmp_pack_match(strs[i + *count], nm, v + *stride)) {
+        v += *stride;
+        (*count)++;
+    }
+}
+
+/**
+ * natcmp_pack
+ *
+ * Compresses a list of names (typically sorted with natcmp()) into `buf`.
+ *
+ * @param strs     Names
+ * @param n        Number of names
+ * @param buf      Output buffer
+ * @param size     Size of the output buffer
+ * @return size_t  Length of the packed list. Like snprintf(), the full
+ *                 length is returned even if `size` is too small.
+ */
+static inline size_t natcmp_pack(const unsigned char *const *strs, size_t n,
+                                 unsigned char *buf, size_t size)
+{
+    natcmp_key_writer_t w = {buf, size, 0};
+    natcmp_pack_name_t prev;
+    natcmp_pack_name_t nm;
+    uint64_t count  = 0;
+    uint64_t stride = 0;
+    size_t nrec     = 0;
+
+    for (size_t i = 0; i < n; i += (size_t)count, nrec++) {
+        natcmp_pack_run(strs, n, i, &nm, &count, &stride);
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        natcmp_key_put_byte(&w, (unsigned char)NATCMP_PACK_MAGIC[i]);
+    }
+    natcmp_key_put_byte(&w, NATCMP_PACK_VERSION);
+    natcmp_pack_put_varint(&w, n);
+    natcmp_pack_put_varint(&w, nrec);
+
+    for (size_t i = 0; i < n; i += (size_t)count) {
+        natcmp_pack_run(strs, n, i, &nm, &count, &stride);
+        int same = i > 0 && natcmp_pack_same_template(&prev, &nm);
+        natcmp_key_put_byte(
+            &w, (unsigned char)((nm.number ? NATCMP_PACK_F_NUMBER : 0) |
+                                (same ? NATCMP_PACK_F_SAME : 0)));
+        if (!same) {
+            natcmp_pack_put_bytes(&w, nm.stem, nm.stemlen);
+            natcmp_pack_put_bytes(&w, nm.suffix, nm.suffixlen);
+            natcmp_pack_put_varint(&w, nm.width);
+        }
+        if (nm.number) {
+            natcmp_pack_put_varint(&w, nm.value);
+            natcmp_pack_put_varint(&w, count);
+            if (count > 1) {
+                natcmp_pack_put_varint(&w, stride);
+            }
+        }
+        prev = nm;
+    }
+    return w.len;
+}
+
+/**
+ * natcmp_pack_reader_t
+ *
+ * Streaming decoder of a packed list.
+ */
+typedef struct {
+    const unsigned char *buf; // packed list
+    size_t size;              // length of the packed list
+    size_t pos;               // offset of the next record
+    size_t n;                 // number of names
+    size_t nrec;              // number of records
+    size_t rec;               // number of records read
+    size_t tpl;               // offset of the record holding the template
+    // template of the current record
+    const unsigned char *stem;
+    size_t stemlen;
+    const unsigned char *suffix;
+    size_t suffixlen;
+    size_t width;
+    // current record
+    int number;      // the record has a number
+    uint64_t value;  // number of the next name
+    uint64_t stride; // stride of the numbers
+    uint64_t left;   // number of names left in the record
+} natcmp_pack_reader_t;
+
+static inline int natcmp_pack_get_varint(natcmp_pack_reader_t *r,
+                                         uint64_t *v)
+{
+    *v = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+        if (r->pos >= r->size) {
+            break;
+        }
+        unsigned char c = r->buf[r->pos++];
+        *v |= (uint64_t)(c & 0x7f) << shift;
+        if (!(c & 0x80)) {
+            return 0;
+        }
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+static inline int natcmp_pack_get_bytes(natcmp_pack_reader_t *r,
+                                        const unsigned char **p, size_t *len)
+{
+    uint64_t v = 0;
+    if (natcmp_pack_get_varint(r, &v) != 0 || v > r->size - r->pos) {
+        errno = EINVAL;
+        return -1;
+    }
+    *p   = r->buf + r->pos;
+    *len = (size_t)v;
+    r->pos += *len;
+    return 0;
+}
+
+/**
+ * natcmp_pack_record
+ *
+ * Reads the record at the current position.
+ *
+ * @return int  0 on success, -1 with errno set to EINVAL if it is malformed
+ */
+static inline int natcmp_pack_record(natcmp_pack_reader_t *r)
+{
+    size_t offset = r->pos;
+    uint64_t v    = 0;
+
+    if (r->pos >= r->size) {
+        errno = EINVAL;
+        return -1;
+    }
+    unsigned char flags = r->buf[r->pos++];
+    if (!(flags & NATCMP_PACK_F_SAME)) {
+        if (natcmp_pack_get_bytes(r, &r->stem, &r->stemlen) != 0 ||
+            natcmp_pack_get_bytes(r, &r->suffix, &r->suffixlen) != 0 ||
+            natcmp_pack_get_varint(r, &v) != 0 || v > 20) {
+            errno = EINVAL;
+            return -1;
+        }
+        r->width = (size_t)v;
+        r->tpl   = offset;
+    } else if (!r->stem) {
+        // no previous template
+        errno = EINVAL;
+        return -1;
+    }
+
+    r->number = (flags & NATCMP_PACK_F_NUMBER) != 0;
+    r->value  = 0;
+    r->stride = 0;
+    r->left   = 1;
+    if (r->number &&
+        (natcmp_pack_get_varint(r, &r->value) != 0 ||
+         natcmp_pack_get_varint(r, &r->left) != 0 || !r->left ||
+         (r->left > 1 && natcmp_pack_get_varint(r, &r->stride) != 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->rec++;
+    return 0;
+}
+
+/**
+ * natcmp_pack_open
+ *
+ * Initializes a reader over the output of natcmp_pack().
+ *
+ * @return int  0 on success, -1 with errno set to EINVAL if the header is
+ *              malformed
+ */
+static inline int natcmp_pack_open(natcmp_pack_reader_t *r,
+                                   const unsigned char *buf, size_t size)
+{
+    uint64_t n    = 0;
+    uint64_t nrec = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->buf  = buf;
+    r->size = size;
+    r->pos  = 5;
+    if (size < 5 || memcmp(buf, NATCMP_PACK_MAGIC, 4) != 0 ||
+        buf[4] != NATCMP_PACK_VERSION || natcmp_pack_get_varint(r, &n) != 0 ||
+        natcmp_pack_get_varint(r, &nrec) != 0 || nrec > n) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->n    = (size_t)n;
+    r->nrec = (size_t)nrec;
+    return 0;
+}
+
+/**
+ * natcmp_pack_next
+ *
+ * Decodes the next name into `buf` as a NUL-terminated string.
+ *
+ * @param r     Reader
+ * @param buf   Output buffer
+ * @param size  Size of the output buffer
+ * @param len   Output parameter to store the length of the name
+ * @return int  1 if a name was decoded, 0 at the end of the list, -1 on
+ *              failure with errno set to EINVAL (malformed input) or ENOBUFS
+ *              (`size` is not larger than `*len`; the reader does not move)
+ */
+static inline int natcmp_pack_next(natcmp_pack_reader_t *r,
+                                   unsigned char *buf, size_t size,
+                                   size_t *len)
+{
+    unsigned char digits[32];
+    size_t ndigit = 0;
+
+    if (!r->left) {
+        if (r->rec == r->nrec) {
+            return 0;
+        } else if (natcmp_pack_record(r) != 0) {
+            return -1;
+        }
+    }
+    if (r->number) {
+        ndigit = natcmp_pack_render(r->value, r->width, digits);
+    }
+    *len = r->stemlen + ndigit + r->suffixlen;
+    if (*len >= size) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    memcpy(buf, r->stem, r->stemlen);
+    memcpy(buf + r->stemlen, digits, ndigit);
+    memcpy(buf + r->stemlen + ndigit, r->suffix, r->suffixlen);
+    buf[*len] = 0;
+    r->value += r->stride;
+    r->left--;
+    return 1;
+}
+
+/**
+ * natcmp_pack_entry_t
+ *
+ * Entry of the rank index of a packed list.
+ */
+typedef struct {
+    size_t rank;   // rank of the first name of the record
+    size_t offset; // offset of the record
+    size_t tpl;    // offset of the record holding its template
+} natcmp_pack_entry_t;
+
+/**
+ * natcmp_pack_index_t
+ *
+ * Rank index of a packed list: one entry per record.
+ */
+typedef struct {
+    const unsigned char *buf; // packed list
+    size_t size;              // length of the packed list
+    size_t n;                 // number of names
+    natcmp_pack_entry_t *ent; // entries
+    size_t nent;              // number of entries
+    const natcmp_allocator_t *alloc;
+} natcmp_pack_index_t;
+
+/**
+ * natcmp_pack_index
+ *
+ * Builds the rank index of a packed list.
+ *
+ * @return int  0 on success, -1 on failure with errno set to EINVAL
+ *              (malformed input) or ENOMEM
+ */
+static inline int natcmp_pack_index(natcmp_pack_index_t *idx,
+                                    const unsigned char *buf, size_t size,
+                                    const natcmp_allocator_t *alloc)
+{
+    natcmp_pack_reader_t r;
+    size_t rank = 0;
+
+    memset(idx, 0, sizeof(*idx));
+    if (natcmp_pack_open(&r, buf, size) != 0) {
+        return -1;
+    }
+    idx->ent = (natcmp_pack_entry_t *)natcmp_alloc_array(alloc, r.nrec,
+                                                         sizeof(*idx->ent));
+    if (!idx->ent) {
+        return -1;
+    }
+    idx->buf   = buf;
+    idx->size  = size;
+    idx->n     = r.n;
+    idx->nent  = r.nrec;
+    idx->alloc = alloc;
+    for (size_t i = 0; i < r.nrec; i++) {
+        idx->ent[i].rank   = rank;
+        idx->ent[i].offset = r.pos;
+        if (natcmp_pack_record(&r) != 0 || r.left > r.n - rank) {
+            natcmp_free(alloc, idx->ent, sizeof(*idx->ent) * idx->nent);
+            idx->ent = NULL;
+            errno    = EINVAL;
+            return -1;
+        }
+        idx->ent[i].tpl = r.tpl;
+        rank += (size_t)r.left;
+    }
+    if (rank != r.n) {
+        natcmp_free(alloc, idx->ent, sizeof(*idx->ent) * idx->nent);
+        idx->ent = NULL;
+        errno    = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * natcmp_pack_index_free
+ *
+ * Releases the memory of a rank index.
+ */
+static inline void natcmp_pack_index_free(natcmp_pack_index_t *idx)
+{
+    natcmp_free(idx->alloc, idx->ent, sizeof(*idx->ent) * idx->nent);
+    idx->ent = NULL;
+}
+
+/**
+ * natcmp_pack_get
+ *
+ * Decodes the name of the given rank (0-based) into `buf`, finding its record
+ * by binary search.
+ *
+ * @return int  1 if a name was decoded, 0 if rank is out of range, -1 on
+ *              failure with errno set to ENOBUFS (`size` is not larger than
+ *              `*len`)
+ */
+static inline int natcmp_pack_get(const natcmp_pack_index_t *idx,
+                                  size_t rank, unsigned char *buf, size_t size,
+                                  size_t *len)
+{
+    natcmp_pack_reader_t r;
+
+    if (rank >= idx->n) {
+        return 0;
+    }
+    size_t lo = 0;
+    size_t hi = idx->nent - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (idx->ent[mid].rank <= rank) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    // load the template, then the record itself (the index was validated)
+    const natcmp_pack_entry_t *e = idx->ent + lo;
+    memset(&r, 0, sizeof(r));
+    r.buf  = idx->buf;
+    r.size = idx->size;
+    r.pos  = e->tpl;
+    natcmp_pack_record(&r);
+    r.pos = e->offset;
+    natcmp_pack_record(&r);
+    r.value += r.stride * (uint64_t)(rank - e->rank);
+    r.left -= (uint64_t)(rank - e->rank);
+    return natcmp_pack_next(&r, buf, size, len);
+}
+
+#endif /* natcmp_pack_h */
@@ -0,0 +1,225 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+
+#ifndef natcmp_part_h
+#define natcmp_part_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_key.h"
+#include "natcmp_sort.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Range partitioning
+ *
+ * natcmp_part_t splits strings into a given number of partitions that follow
+ * each other in natural order: every string of partition i is less than
+ * every string of partition i + 1, so sorting the partitions separately (on
+ * separate machines, say) and concatenating them gives the sorted input.
+ *
+ * The boundaries are chosen from a sample of the input, such as a few
+ * hundred random lines per partition, so that the partitions have roughly
+ * the same size; the input can then be routed in one streaming pass.
+ * Partition i holds the strings s with bounds[i - 1] <= s < bounds[i], and
+ * strings that natcmp() considers equal always land in the same partition
+ * (which can leave partitions empty when a value dominates the sample).
+ *
+ * Routing is a binary search over the boundaries, prepared once: with the
+ * default comparison, the first 8 bytes of the sort key of each boundary
+ * (natcmp_key_prefix()) are kept, a string is placed among them with integer
+ * comparisons, and natcmp() only decides among the boundaries whose key
+ * prefix is the same as the string's.
+ */
+
+/**
+ * natcmp_part_t
+ *
+ * Partition boundaries.
+ */
+typedef struct {
+    const unsigned char **bounds; // parts - 1 boundaries in natural order
+    uint64_t *prefix;             // key prefix of each boundary, or NULL
+    size_t n;                     // number of boundaries (parts - 1)
+    unsigned char *buf;           // copies of the boundaries
+    size_t size;                  // size of buf
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+} natcmp_part_t;
+
+/**
+ * natcmp_part_free
+ *
+ * Releases the boundaries.
+ */
+static inline void natcmp_part_free(natcmp_part_t *p)
+{
+    natcmp_free(p->alloc, (void *)p->bounds, sizeof(*p->bounds) * p->n);
+    natcmp_free(p->alloc, p->prefix, sizeof(*p->prefix) * p->n);
+    natcmp_free(p->alloc, p->buf, p->size);
+    p->bounds = NULL;
+    p->prefix = NULL;
+    p->buf    = NULL;
+    p->n      = 0;
+    p->size   = 0;
+}
+
+/**
+ * natcmp_part_init
+ *
+ * Chooses the boundaries of `parts` partitions of roughly equal size from a
+ * sample of the input. The sample is not modified and need not outlive the
+ * partitioning: the boundaries are copied.
+ *
+ * @param p        Partitioning to initialize
+ * @param sample   Sample strings, in any order
+ * @param nsample  Number of sample strings
+ * @param parts    Number of partitions (1 or more)
+ * @param compare  Comparison for non-digit parts, or NULL for the default
+ * @param alloc    Allocator or NULL
+ * @return int     0 on success, -1 with errno set to ENOMEM or EINVAL (if
+ *                 parts is 0, or greater than 1 without any sample)
+ */
+static inline int natcmp_part_init(natcmp_part_t *p,
+                                   const unsigned char *const *sample,
+                                   size_t nsample, size_t parts,
+                                   natcmp_nondigit_cmp_func_t compare,
+                                   const natcmp_allocator_t *alloc)
+{
+    const unsigned char **sorted = NULL;
+
+    memset(p, 0, sizeof(*p));
+    p->compare = compare;
+    p->alloc   = alloc;
+    if (parts == 0 || (parts > 1 && nsample == 0)) {
+        errno = EINVAL;
+        return -1;
+    } else if (parts == 1) {
+        return 0;
+    }
+
+    sorted = (const unsigned char **)natcmp_alloc_array(alloc, nsample,
+                                                        sizeof(*sorted));
+    if (!sorted) {
+        return -1;
+    }
+    memcpy((void *)sorted, sample, sizeof(*sorted) * nsample);
+    if (natcmp_sort_merge(sorted, nsample, compare, alloc) != 0) {
+        goto fail;
+    }
+
+    // boundary i is the sample at the i/parts quantile
+    size_t n = parts - 1;
+    for (size_t i = 1; i <= n; i++) {
+        p->size += strlen((const char *)sorted[i * nsample / parts]) + 1;
+    }
+    p->bounds = (const unsigned char **)natcmp_alloc_array(alloc, n,
+                                                          sizeof(*p->bounds));
+    if (!p->bounds) {
+        goto fail;
+    }
+    p->n   = n;
+    p->buf = (unsigned char *)natcmp_alloc(alloc, p->size);
+    if (!p->buf) {
+        goto fail;
+    }
+    for (size_t i = 0, off = 0; i < n; i++) {
+        const unsigned char *s = sorted[(i + 1) * nsample / parts];
+        size_t len             = strlen((const char *)s) + 1;
+        memcpy(p->buf + off, s, len);
+        p->bounds[i] = p->buf + off;
+        off += len;
+    }
+
+    // the key prefixes order like natcmp() only with the default comparison
+    if (!compare || compare == natcmp_nondigit_cmp_ascii) {
+        p->prefix = (uint64_t *)natcmp_alloc_array(alloc, n,
+                                                   sizeof(*p->prefix));
+        if (!p->prefix) {
+            goto fail;
+        }
+        for (size_t i = 0; i < n; i++) {
+            p->prefix[i] = natcmp_key_prefix(p->bounds[i]);
+        }
+    }
+    natcmp_free(alloc, (void *)sorted, sizeof(*sorted) * nsample);
+    return 0;
+
+fail:
+    natcmp_free(alloc, (void *)sorted, sizeof(*sorted) * nsample);
+    natcmp_part_free(p);
+    return -1;
+}
+
+/**
+ * natcmp_part_find
+ *
+ * Returns the partition of `s`: the number of boundaries that are less than
+ * or equal to it, from 0 to p->n.
+ *
+ * @param p  Partitioning
+ * @param s  String to route
+ * @return size_t  Partition index
+ */
+static inline size_t natcmp_part_find(const natcmp_part_t *p,
+                                      const unsigned char *s)
+{
+    size_t lo = 0;
+    size_t hi = p->n;
+
+    if (p->prefix && hi > 0) {
+        // boundaries with a smaller key prefix are less than s, and those
+        // with a greater one are greater: narrow to the equal prefixes
+        uint64_t k = natcmp_key_prefix(s);
+        size_t end = hi;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (p->prefix[mid] < k) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        for (size_t eq = lo; eq < end;) {
+            size_t mid = eq + (end - eq) / 2;
+            if (p->prefix[mid] <= k) {
+                eq = mid + 1;
+            } else {
+                end = mid;
+            }
+        }
+        hi = end;
+    }
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (natcmp(p->bounds[mid], s, p->compare) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+#endif /* natcmp_part_h */
@@ -0,0 +1,265 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_sci_h
+#define natcmp_sci_h
+
+#include "natcmp.h"
+#include <stdint.h>
+
+/**
+ * Scientific notation
+ *
+ * natcmp_sci() compares numbers written in scientific notation, such as
+ * "1e-3", "2.5e2" or "6.02E+23", by their value. A number in scientific
+ * notation is a run of digits, an optional fraction ("." and digits), "e" or
+ * "E", an optional sign and at least one exponent digit.
+ *
+ * Every digit run is read as a number, whether or not it has an exponent: a
+ * decimal number (digits and an optional fraction) is compared by value too,
+ * so "0.5" < "1e0" < "1.10" < "1.5" whichever pairs are compared. Numbers are
+ * compared exactly by their decimal digits and exponents; no floating point
+ * conversion is done. Numbers of equal value are ordered by the leading zeros
+ * of their integer digits, as natcmp() orders "01" after "1". An exponent
+ * with more than NATCMP_SCI_MAX_EXP_DIGITS significant digits is not part of
+ * the number, which then ends before its "e".
+ */
+#define NATCMP_SCI_MAX_EXP_DIGITS 9
+
+/**
+ * natcmp_sci_num_t
+ *
+ * A parsed number. Its value is 0.<significant digits> * 10^exp.
+ */
+typedef struct {
+    const unsigned char *ipart; // integer digits
+    size_t ilen;                // number of integer digits
+    const unsigned char *frac;  // fraction digits
+    size_t flen;                // number of fraction digits
+    size_t lz;                  // number of leading zeros of the digits
+    size_t pad;                 // leading zeros of the integer digits
+    size_t nsig;                // number of significant digits (0 if zero)
+    int64_t exp;                // decimal exponent of the first digit
+    const unsigned char *tail;  // end of the number
+} natcmp_sci_num_t;
+
+// returns the k-th digit of the integer and fraction digits of `num`
+static inline unsigned char natcmp_sci_raw(const natcmp_sci_num_t *num,
+                                           size_t k)
+{
+    return (k < num->ilen) ? num->ipart[k] : num->frac[k - num->ilen];
+}
+
+/**
+ * natcmp_sci_digit
+ *
+ * Returns the i-th significant digit of `num`, or '0' past the last one.
+ */
+static inline unsigned char natcmp_sci_digit(const natcmp_sci_num_t *num,
+                                             size_t i)
+{
+    return (i < num->nsig) ? natcmp_sci_raw(num, num->lz + i) : '0';
+}
+
+/**
+ * natcmp_sci_parse
+ *
+ * Parses the number at the head of `s` (which must start with a digit).
+ *
+ * @param s      String to parse
+ * @param num    Output parameter to store the parsed number
+ * @return int   1 if the number is in scientific notation, 0 if it is a
+ *               decimal number, -1 if its exponent is too large (the number
+ *               is then the decimal number before the exponent)
+ */
+static inline int natcmp_sci_parse(const unsigned char *s,
+                                   natcmp_sci_num_t *num)
+{
+    const unsigned char *p = s;
+    int64_t exp            = 0;
+    int rv                 = 0;
+
+    num->ipart = p;
+    while (isdigit(*p)) {
+        p++;
+    }
+    num->ilen = (size_t)(p - s);
+    num->frac = p;
+    num->flen = 0;
+    if (*p == '.' && isdigit(p[1])) {
+        num->frac = ++p;
+        while (isdigit(*p)) {
+            p++;
+        }
+        num->flen = (size_t)(p - num->frac);
+    }
+
+    num->tail = p;
+    if ((*p == 'e' || *p == 'E') &&
+        (isdigit(p[1]) || ((p[1] == '+' || p[1] == '-') && isdigit(p[2])))) {
+        int neg  = (p[1] == '-');
+        size_t n = 0;
+        p += isdigit(p[1]) ? 1 : 2;
+        while (*p == '0') {
+            p++;
+        }
+        for (; isdigit(*p); p++, n++) {
+            if (n < NATCMP_SCI_MAX_EXP_DIGITS) {
+                exp = exp * 10 + (*p - '0');
+            }
+        }
+        if (n > NATCMP_SCI_MAX_EXP_DIGITS) {
+            // leave the exponent to be compared as text and digits
+            rv  = -1;
+            exp = 0;
+        } else {
+            rv        = 1;
+            exp       = neg ? -exp : exp;
+            num->tail = p;
+        }
+    }
+
+    // natcmp() keeps the last digit of an all-zero run
+    num->pad = 0;
+    while (num->pad + 1 < num->ilen && num->ipart[num->pad] == '0') {
+        num->pad++;
+    }
+
+    // strip leading and trailing zeros of the digits
+    size_t len = num->ilen + num->flen;
+    num->lz    = 0;
+    while (num->lz < len && natcmp_sci_raw(num, num->lz) == '0') {
+        num->lz++;
+    }
+    while (len > num->lz && natcmp_sci_raw(num, len - 1) == '0') {
+        len--;
+    }
+    num->nsig = len - num->lz;
+    num->exp  = exp + (int64_t)num->ilen - (int64_t)num->lz;
+    return rv;
+}
+
+/**
+ * natcmp_sci_cmp
+ *
+ * Compares the values of two parsed numbers.
+ *
+ * @return int  Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
+ */
+static inline int natcmp_sci_cmp(const natcmp_sci_num_t *a,
+                                 const natcmp_sci_num_t *b)
+{
+    if (!a->nsig || !b->nsig) {
+        // zero is less than any other value
+        return (a->nsig == b->nsig) ? 0 : (a->nsig ? 1 : -1);
+    } else if (a->exp != b->exp) {
+        return (a->exp < b->exp) ? -1 : 1;
+    }
+
+    size_t n = (a->nsig > b->nsig) ? a->nsig : b->nsig;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char da = natcmp_sci_digit(a, i);
+        unsigned char db = natcmp_sci_digit(b, i);
+        if (da != db) {
+            return (da < db) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * natcmp_sci
+ *
+ * Compares two strings in natural order like natcmp(), but compares numbers
+ * in scientific notation and decimal numbers by their value.
+ * Example: "sigma_1e-3" < "sigma_0.5" < "sigma_2.5e2" < "sigma_1000"
+ *
+ * Algorithm:
+ * 1. Non-digit portions are compared using the provided callback function
+ * 2. At a digit run, both numbers are parsed on their own (with their
+ *    fractions and exponents) and compared by value
+ * 3. Numbers of equal value are ordered by the leading zeros of their
+ *    integer digits; "1e3" and "1000" are equal
+ *
+ * @param a         First string to compare
+ * @param b         Second string to compare
+ * @param compare   Callback function for comparing non-digit portions
+ * @return int      Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ */
+static inline int natcmp_sci(const unsigned char *a, const unsigned char *b,
+                             natcmp_nondigit_cmp_func_t compare)
+{
+    if (!compare) {
+        // default to ASCII comparison if no callback is provided
+        compare = natcmp_nondigit_cmp_ascii;
+    }
+
+    while (*a && *b) {
+        int isdigit_a = isdigit(*a);
+        int isdigit_b = isdigit(*b);
+        if (!isdigit_a && !isdigit_b) {
+            // compare non-digit part
+            unsigned char *end_a = NULL;
+            unsigned char *end_b = NULL;
+            int res              = compare(a, b, &end_a, &end_b);
+            if (res != 0) {
+                return (res < 0) ? -1 : 1;
+            }
+            a = end_a;
+            b = end_b;
+            if (!*a || !*b) {
+                break;
+            }
+
+            isdigit_a = isdigit(*a);
+            isdigit_b = isdigit(*b);
+        }
+
+        if (isdigit_a != isdigit_b) {
+            return isdigit_a ? -1 : 1;
+        }
+
+        // compare number part by value; how each side is parsed must not
+        // depend on the other side, or the order would not be transitive
+        natcmp_sci_num_t na;
+        natcmp_sci_num_t nb;
+        natcmp_sci_parse(a, &na);
+        natcmp_sci_parse(b, &nb);
+        int res = natcmp_sci_cmp(&na, &nb);
+        if (res != 0) {
+            return res;
+        } else if (na.pad != nb.pad) {
+            return (na.pad < nb.pad) ? -1 : 1;
+        }
+        a = na.tail;
+        b = nb.tail;
+    }
+
+    if (*b) {
+        return -1;
+    } else if (*a) {
+        return 1;
+    }
+    return 0;
+}
+
+#endif /* natcmp_sci_h */
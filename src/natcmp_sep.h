@@ -0,0 +1,441 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+
+#ifndef natcmp_sep_h
+#define natcmp_sep_h
+
+#include "natcmp.h"
+#include "natcmp_key.h"
+#include <ctype.h>
+#include <string.h>
+
+/**
+ * Separators
+ *
+ * Index blocks only need a key that separates the last key of a block from
+ * the first key of the next one, not the keys themselves.
+ * natcmp_separator() returns the shortest string s with a <= s < b in the
+ * order of natcmp(a, b, NULL), and natcmp_successor() a short string that is
+ * greater than every string starting with a. natcmp_key_separator() and
+ * natcmp_key_successor() do the same for sort keys under natcmp_keycmp().
+ *
+ * natcmp() orders a string as a sequence of tokens: single text bytes
+ * (compared case-insensitively), whole digit runs (compared by their number
+ * of significant digits, then their digits, then their number of leading
+ * zeros) and the end of the string, with end < digit run < text byte. A
+ * string between a and b has the tokens a and b share, then either a token
+ * strictly between theirs, or the next token of b and nothing more, or the
+ * next token of a followed by something not less than the rest of a. The
+ * shortest of these is chosen, preferring a itself, then a token between,
+ * on ties. A separator is therefore never longer than a. Text bytes are
+ * chosen among the printable ones when possible, and are never upper-case
+ * letters or digits.
+ */
+
+// kinds of token
+#define NATCMP_SEP_END   0
+#define NATCMP_SEP_DIGIT 1
+#define NATCMP_SEP_TEXT  2
+
+// returns the kind of the token at s and sets *len to its length
+static inline int natcmp_sep_token(const unsigned char *s, size_t *len)
+{
+    size_t n = 0;
+    if (!*s) {
+        *len = 0;
+        return NATCMP_SEP_END;
+    } else if (!isdigit(*s)) {
+        *len = 1;
+        return NATCMP_SEP_TEXT;
+    }
+    while (isdigit(s[n])) {
+        n++;
+    }
+    *len = n;
+    return NATCMP_SEP_DIGIT;
+}
+
+// compares the tokens of kind ka at a and kb at b
+static inline int natcmp_sep_cmp(const unsigned char *a, int ka,
+                                 const unsigned char *b, int kb)
+{
+    unsigned char *end_a;
+    unsigned char *end_b;
+    if (ka != kb) {
+        return ka - kb;
+    } else if (ka == NATCMP_SEP_TEXT) {
+        return tolower(*a) - tolower(*b);
+    } else if (ka == NATCMP_SEP_DIGIT) {
+        return natcmp_digit_cmp(a, b, &end_a, &end_b);
+    }
+    return 0;
+}
+
+/**
+ * natcmp_sep_text
+ *
+ * Returns a text byte c with lo < tolower(c) < hi (lo = -1 for any text
+ * byte, which is greater than any digit run), or 0 if there is none.
+ */
+static inline unsigned char natcmp_sep_text(int lo, int hi)
+{
+    // printable bytes first, then any byte
+    for (int pass = 0; pass < 2; pass++) {
+        int c = (pass == 0 && lo < '!' - 1) ? '!' : lo + 1;
+        for (; c < hi && c <= (pass ? 0xff : '~'); c++) {
+            if (c > 0 && !isdigit(c) && tolower(c) == c) {
+                return (unsigned char)c;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * natcmp_sep_run_t
+ *
+ * Digit run split into leading zeros and significant digits like
+ * natcmp_digit_cmp() does (the last zero of a run of zeros is significant).
+ */
+typedef struct {
+    const unsigned char *digits; // significant digits
+    size_t n;                    // number of significant digits
+    size_t zeros;                // number of leading zeros
+} natcmp_sep_run_t;
+
+static inline natcmp_sep_run_t natcmp_sep_run(const unsigned char *s,
+                                              size_t len)
+{
+    natcmp_sep_run_t r;
+    r.zeros = 0;
+    while (r.zeros + 1 < len && s[r.zeros] == '0') {
+        r.zeros++;
+    }
+    r.digits = s + r.zeros;
+    r.n      = len - r.zeros;
+    return r;
+}
+
+// returns 1 if the n digits of a plus one are the n digits of b
+static inline int natcmp_sep_adjacent(const unsigned char *a,
+                                      const unsigned char *b, size_t n)
+{
+    size_t i = natcmp_mismatch(a, b, n);
+    if (i == n || b[i] != a[i] + 1) {
+        return 0;
+    }
+    for (i++; i < n; i++) {
+        if (a[i] != '9' || b[i] != '0') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// digit runs chosen by natcmp_sep_digits()
+#define NATCMP_SEP_RUN_NONE  0 // none
+#define NATCMP_SEP_RUN_INC   1 // the digits of a plus one
+#define NATCMP_SEP_RUN_POW   2 // 1 followed by as many zeros as a has digits
+#define NATCMP_SEP_RUN_ZEROS 3 // a with one more leading zero
+
+/**
+ * natcmp_sep_digits
+ *
+ * Chooses the shortest digit run greater than the run a and, if b is not
+ * NULL, less than the run b. Sets *len to its length.
+ */
+static inline int natcmp_sep_digits(const natcmp_sep_run_t *a,
+                                     const natcmp_sep_run_t *b, size_t *len)
+{
+    size_t nines = 0;
+    while (nines < a->n && a->digits[nines] == '9') {
+        nines++;
+    }
+    if (nines < a->n) {
+        // the digits of a plus one, without leading zeros
+        if (!b || a->n < b->n ||
+            (memcmp(a->digits, b->digits, a->n) < 0 &&
+             (!natcmp_sep_adjacent(a->digits, b->digits, a->n) ||
+              b->zeros))) {
+            *len = a->n;
+            return NATCMP_SEP_RUN_INC;
+        }
+    } else if (!b || a->n + 1 < b->n ||
+               (a->n + 1 == b->n &&
+                (b->zeros || b->digits[0] != '1' ||
+                 strspn((const char *)b->digits + 1, "0") < a->n))) {
+        // the smallest number with one more digit
+        *len = a->n + 1;
+        return NATCMP_SEP_RUN_POW;
+    }
+    if (a->n < b->n || memcmp(a->digits, b->digits, a->n) < 0 ||
+        a->zeros + 1 < b->zeros) {
+        *len = a->zeros + 1 + a->n;
+        return NATCMP_SEP_RUN_ZEROS;
+    }
+    return NATCMP_SEP_RUN_NONE;
+}
+
+static inline void natcmp_sep_put_digits(unsigned char *out, int kind,
+                                         const natcmp_sep_run_t *a)
+{
+    if (kind == NATCMP_SEP_RUN_INC) {
+        size_t i = a->n;
+        memcpy(out, a->digits, a->n);
+        while (out[--i] == '9') {
+            out[i] = '0';
+        }
+        out[i]++;
+    } else if (kind == NATCMP_SEP_RUN_POW) {
+        out[0] = '1';
+        memset(out + 1, '0', a->n);
+    } else {
+        memset(out, '0', a->zeros + 1);
+        memcpy(out + a->zeros + 1, a->digits, a->n);
+    }
+}
+
+/**
+ * natcmp_sep_succ
+ *
+ * Looks for the first token of s (from offset `from`) that has a greater
+ * one-byte token, the byte being stored in *c. Returns the offset of that
+ * token, or the length of s if there is none.
+ */
+static inline size_t natcmp_sep_succ(const unsigned char *s, size_t from,
+                                     unsigned char *c)
+{
+    size_t len;
+    int kind;
+    while ((kind = natcmp_sep_token(s + from, &len)) != NATCMP_SEP_END) {
+        *c = natcmp_sep_text(kind == NATCMP_SEP_TEXT ? tolower(s[from]) : -1,
+                             0x100);
+        if (*c) {
+            break;
+        }
+        from += len;
+    }
+    return from;
+}
+
+/**
+ * natcmp_separator
+ *
+ * Computes the shortest string s with a <= s < b in the order of
+ * natcmp(a, b, NULL). Index blocks can store s instead of b (or a) as the
+ * boundary between the keys up to a and the keys from b.
+ *
+ * @param a    Greatest key of the left side
+ * @param b    Least key of the right side, with natcmp(a, b, NULL) < 0
+ * @param out  Buffer of at least strlen(a) + 1 bytes receiving s
+ * @return size_t  Length of s; if a is not less than b, s is a copy of a
+ */
+static inline size_t natcmp_separator(const unsigned char *a,
+                                      const unsigned char *b,
+                                      unsigned char *out)
+{
+    size_t alen = strlen((const char *)a);
+    size_t i    = 0; // offset of the first different token in a
+    size_t j    = 0; // offset of the first different token in b
+    size_t la;
+    size_t lb;
+    int ka;
+    int kb;
+
+    for (;;) {
+        ka      = natcmp_sep_token(a + i, &la);
+        kb      = natcmp_sep_token(b + j, &lb);
+        int cmp = natcmp_sep_cmp(a + i, ka, b + j, kb);
+        if (cmp > 0 || ka == NATCMP_SEP_END) {
+            // a is not less than b, or a is a prefix of b
+            memcpy(out, a, alen + 1);
+            return alen;
+        } else if (cmp < 0) {
+            break;
+        }
+        i += la;
+        j += lb;
+    }
+
+    // a token between the tokens of a and b
+    size_t best       = alen;
+    int choice        = 0;
+    unsigned char mid = 0;
+    natcmp_sep_run_t ra;
+    natcmp_sep_run_t rb;
+    int run = NATCMP_SEP_RUN_NONE;
+    size_t rlen;
+    if (kb == NATCMP_SEP_TEXT) {
+        mid = natcmp_sep_text(ka == NATCMP_SEP_TEXT ? tolower(a[i]) : -1,
+                              tolower(b[j]));
+    }
+    if (mid && i + 1 < best) {
+        best   = i + 1;
+        choice = 1;
+    } else if (!mid && ka == NATCMP_SEP_DIGIT) {
+        ra  = natcmp_sep_run(a + i, la);
+        rb  = natcmp_sep_run(b + j, lb);
+        run = natcmp_sep_digits(&ra, kb == NATCMP_SEP_DIGIT ? &rb : NULL,
+                                &rlen);
+        if (run != NATCMP_SEP_RUN_NONE && i + rlen < best) {
+            best   = i + rlen;
+            choice = 2;
+        }
+    }
+
+    // the next token of b alone, if b goes on
+    if (b[j + lb] && i + lb < best) {
+        best   = i + lb;
+        choice = 3;
+    }
+
+    // the next token of a, then a greater one-byte token
+    unsigned char c = 0;
+    size_t at       = natcmp_sep_succ(a, i + la, &c);
+    if (at < alen && at + 1 < best) {
+        best   = at + 1;
+        choice = 4;
+    }
+
+    switch (choice) {
+    case 0:
+        memcpy(out, a, alen);
+        break;
+    case 1:
+        memcpy(out, a, i);
+        out[i] = mid;
+        break;
+    case 2:
+        memcpy(out, a, i);
+        natcmp_sep_put_digits(out + i, run, &ra);
+        break;
+    case 3:
+        memcpy(out, a, i);
+        memcpy(out + i, b + j, lb);
+        break;
+    case 4:
+        memcpy(out, a, at);
+        out[at] = c;
+        break;
+    }
+    out[best] = '\0';
+    return best;
+}
+
+/**
+ * natcmp_successor
+ *
+ * Computes a short string s that is greater than every string starting with
+ * a in the order of natcmp(a, b, NULL): a is cut after its first token that
+ * has a greater one-byte token, which replaces it. Usually s is one byte
+ * long.
+ *
+ * @param a    Greatest key, or common prefix of the greatest keys
+ * @param out  Buffer of at least strlen(a) + 1 bytes receiving s
+ * @return size_t  Length of s; if no token of a has a greater one-byte token
+ *                 (a is made of 0xff bytes), s is a copy of a
+ */
+static inline size_t natcmp_successor(const unsigned char *a,
+                                      unsigned char *out)
+{
+    unsigned char c = 0;
+    size_t at       = natcmp_sep_succ(a, 0, &c);
+    memcpy(out, a, at);
+    if (a[at]) {
+        out[at++] = c;
+    }
+    out[at] = '\0';
+    return at;
+}
+
+/**
+ * natcmp_key_separator
+ *
+ * Computes the shortest byte string s with a <= s < b under
+ * natcmp_keycmp(), for sort keys generated by natcmp_key(). s need not be a
+ * valid key; it is only meant to be compared with keys.
+ *
+ * @param a     Greatest key of the left side
+ * @param alen  Length of a
+ * @param b     Least key of the right side, greater than a
+ * @param blen  Length of b
+ * @param out   Buffer of at least alen bytes receiving s
+ * @return size_t  Length of s; if a is not less than b, s is a copy of a
+ */
+static inline size_t natcmp_key_separator(const unsigned char *a, size_t alen,
+                                          const unsigned char *b, size_t blen,
+                                          unsigned char *out)
+{
+    size_t i = natcmp_mismatch(a, b, (alen < blen) ? alen : blen);
+    size_t k;
+
+    if (i + 1 >= alen || i == blen || a[i] > b[i]) {
+        // a is a prefix of b, a is not longer than the separator, or a is
+        // not less than b
+        memcpy(out, a, alen);
+        return alen;
+    }
+    memcpy(out, a, i + 1);
+    if (a[i] + 1 < b[i] || i + 1 < blen) {
+        // a byte between a[i] and b[i], or b[i] alone
+        out[i] = (a[i] + 1 < b[i]) ? (unsigned char)(a[i] + 1) : b[i];
+        return i + 1;
+    }
+    // a[i] then the first byte of a that can be increased
+    for (k = i + 1; k < alen && a[k] == 0xff; k++) {
+        out[k] = 0xff;
+    }
+    if (k + 1 >= alen) {
+        memcpy(out + i + 1, a + i + 1, alen - i - 1);
+        return alen;
+    }
+    out[k] = (unsigned char)(a[k] + 1);
+    return k + 1;
+}
+
+/**
+ * natcmp_key_successor
+ *
+ * Computes the shortest byte string s that is greater than every key
+ * starting with a under natcmp_keycmp(): the first byte of a that is not
+ * 0xff, plus one, and the bytes before it.
+ *
+ * @param a     Key, or common prefix of keys
+ * @param alen  Length of a
+ * @param out   Buffer of at least alen bytes receiving s
+ * @return size_t  Length of s; if a is made of 0xff bytes, s is a copy of a
+ */
+static inline size_t natcmp_key_successor(const unsigned char *a, size_t alen,
+                                          unsigned char *out)
+{
+    for (size_t i = 0; i < alen; i++) {
+        out[i] = a[i];
+        if (a[i] != 0xff) {
+            out[i]++;
+            return i + 1;
+        }
+    }
+    return alen;
+}
+
+#endif /* natcmp_sep_h */
@@ -0,0 +1,626 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_sketch_h
+#define natcmp_sketch_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_key.h"
+#include "natcmp_sort.h"
+#include <stdint.h>
+
+/**
+ * Quantile sketch
+ *
+ * natcmp_sketch_t is a KLL quantile sketch of a stream of strings ordered by
+ * natcmp(). It keeps a few hundred samples in a stack of compactors: level h
+ * holds samples of weight 2^h, and when the sketch is full the lowest level
+ * that reached its capacity is sorted and every other sample of it, starting
+ * at a random offset, is promoted to the next level while the others are
+ * dropped. Capacities shrink by 2/3 per level below the top, so about 3k
+ * samples are kept whatever the stream length and the rank error is
+ * O(n / k).
+ *
+ * Samples are copies of the stream strings; the exact minimum and maximum
+ * are kept as well. Sketches built with the same k and callback can be
+ * merged, so that each thread can fill its own sketch.
+ */
+#define NATCMP_SKETCH_MAX_LEVELS 60
+#define NATCMP_SKETCH_DEFAULT_K  200
+#define NATCMP_SKETCH_MAGIC      "NCSK"
+#define NATCMP_SKETCH_VERSION    1
+
+typedef struct {
+    unsigned char **items; // samples (copies of strings)
+    size_t n;              // number of samples
+    size_t cap;            // number of allocated slots of items
+} natcmp_sketch_level_t;
+
+typedef struct {
+    const unsigned char *str; // sample
+    uint64_t rank;            // total weight of the samples up to this one
+} natcmp_sketch_entry_t;
+
+/**
+ * natcmp_sketch_t
+ *
+ * Quantile sketch. Initialize it with natcmp_sketch_init() and release it
+ * with natcmp_sketch_free().
+ */
+typedef struct {
+    size_t k;       // capacity of the top level
+    uint64_t n;     // number of strings seen
+    uint64_t rng;   // state of the random number generator
+    size_t nlevels; // number of levels in use
+    natcmp_sketch_level_t levels[NATCMP_SKETCH_MAX_LEVELS];
+    unsigned char *min; // smallest string seen
+    unsigned char *max; // largest string seen
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+    natcmp_sketch_entry_t *view; // sorted samples for quantile queries
+    size_t nview;                // number of entries of view (0 if stale)
+} natcmp_sketch_t;
+
+/**
+ * natcmp_sketch_init
+ *
+ * Initializes an empty sketch.
+ *
+ * @param sk       Sketch to initialize
+ * @param k        Accuracy parameter (0 selects NATCMP_SKETCH_DEFAULT_K)
+ * @param seed     Seed of the random offsets of compactions
+ * @param compare  Callback function for comparing non-digit portions
+ * @param alloc    Allocator or NULL
+ */
+static inline void natcmp_sketch_init(natcmp_sketch_t *sk, size_t k,
+                                      uint64_t seed,
+                                      natcmp_nondigit_cmp_func_t compare,
+                                      const natcmp_allocator_t *alloc)
+{
+    memset(sk, 0, sizeof(*sk));
+    sk->k       = (k < 8) ? (k ? 8 : NATCMP_SKETCH_DEFAULT_K) : k;
+    sk->rng     = seed ? seed : 0x9e3779b97f4a7c15ULL;
+    sk->nlevels = 1;
+    sk->compare = compare;
+    sk->alloc   = alloc;
+}
+
+// frees a copy of a string made by natcmp_sketch_dup()
+static inline void natcmp_sketch_release(const natcmp_sketch_t *sk,
+                                         unsigned char *s)
+{
+    if (s) {
+        natcmp_free(sk->alloc, s, strlen((const char *)s) + 1);
+    }
+}
+
+static inline unsigned char *natcmp_sketch_dup(const natcmp_sketch_t *sk,
+                                               const unsigned char *s,
+                                               size_t len)
+{
+    unsigned char *p = (unsigned char *)natcmp_alloc(sk->alloc, len + 1);
+    if (p) {
+        memcpy(p, s, len);
+        p[len] = 0;
+    }
+    return p;
+}
+
+static inline void natcmp_sketch_drop_view(natcmp_sketch_t *sk)
+{
+    if (sk->view) {
+        natcmp_free(sk->alloc, sk->view, sizeof(*sk->view) * sk->nview);
+    }
+    sk->view  = NULL;
+    sk->nview = 0;
+}
+
+/**
+ * natcmp_sketch_free
+ *
+ * Releases the samples of a sketch and leaves it empty.
+ */
+static inline void natcmp_sketch_free(natcmp_sketch_t *sk)
+{
+    for (size_t h = 0; h < sk->nlevels; h++) {
+        natcmp_sketch_level_t *lv = sk->levels + h;
+        for (size_t i = 0; i < lv->n; i++) {
+            natcmp_sketch_release(sk, lv->items[i]);
+        }
+        natcmp_free(sk->alloc, lv->items, sizeof(*lv->items) * lv->cap);
+    }
+    natcmp_sketch_release(sk, sk->min);
+    natcmp_sketch_release(sk, sk->max);
+    natcmp_sketch_drop_view(sk);
+    natcmp_sketch_init(sk, sk->k, sk->rng, sk->compare, sk->alloc);
+}
+
+// makes room for `extra` more samples in level h
+static inline int natcmp_sketch_reserve(natcmp_sketch_t *sk, size_t h,
+                                        size_t extra)
+{
+    natcmp_sketch_level_t *lv = sk->levels + h;
+    if (lv->cap - lv->n >= extra) {
+        return 0;
+    }
+
+    size_t cap = lv->cap ? lv->cap : 8;
+    while (cap - lv->n < extra) {
+        cap *= 2;
+    }
+    unsigned char **items =
+        (unsigned char **)natcmp_alloc_array(sk->alloc, cap, sizeof(*items));
+    if (!items) {
+        return -1;
+    }
+    if (lv->n) {
+        memcpy(items, lv->items, sizeof(*items) * lv->n);
+    }
+    natcmp_free(sk->alloc, lv->items, sizeof(*lv->items) * lv->cap);
+    lv->items = items;
+    lv->cap   = cap;
+    return 0;
+}
+
+// appends a sample to level h, taking ownership of it
+static inline int natcmp_sketch_push(natcmp_sketch_t *sk, size_t h,
+                                     unsigned char *s)
+{
+    if (natcmp_sketch_reserve(sk, h, 1) != 0) {
+        return -1;
+    }
+    sk->levels[h].items[sk->levels[h].n++] = s;
+    if (h >= sk->nlevels) {
+        sk->nlevels = h + 1;
+    }
+    return 0;
+}
+
+// capacity of level h
+static inline size_t natcmp_sketch_capacity(const natcmp_sketch_t *sk,
+                                            size_t h)
+{
+    size_t cap = sk->k;
+    for (size_t i = h + 1; i < sk->nlevels && cap > 2; i++) {
+        cap = cap * 2 / 3;
+    }
+    return (cap < 2) ? 2 : cap;
+}
+
+/**
+ * natcmp_sketch_compress
+ *
+ * Compacts levels until the number of samples fits in the total capacity.
+ */
+static inline int natcmp_sketch_compress(natcmp_sketch_t *sk)
+{
+    for (;;) {
+        size_t total = 0;
+        size_t size  = 0;
+        for (size_t h = 0; h < sk->nlevels; h++) {
+            total += natcmp_sketch_capacity(sk, h);
+            size += sk->levels[h].n;
+        }
+        if (size <= total) {
+            return 0;
+        }
+
+        size_t h = 0;
+        while (sk->levels[h].n < natcmp_sketch_capacity(sk, h)) {
+            h++;
+        }
+        if (h + 1 >= NATCMP_SKETCH_MAX_LEVELS) {
+            errno = ENOBUFS;
+            return -1;
+        }
+        // make room in the next level before touching this one
+        natcmp_sketch_level_t *lv = sk->levels + h;
+        if (natcmp_sketch_reserve(sk, h + 1, lv->n / 2) != 0) {
+            return -1;
+        }
+
+        // keep the first sample if the count is odd, promote every other one
+        // of the rest starting at a random offset
+        natcmp_sort_inplace((const unsigned char **)lv->items, lv->n,
+                            sk->compare, NULL, 0);
+        sk->rng ^= sk->rng << 13;
+        sk->rng ^= sk->rng >> 7;
+        sk->rng ^= sk->rng << 17;
+        size_t odd    = lv->n & 1;
+        size_t offset = (size_t)(sk->rng >> 63);
+        for (size_t i = odd; i < lv->n; i += 2) {
+            natcmp_sketch_level_t *up = sk->levels + h + 1;
+            up->items[up->n++]        = lv->items[i + offset];
+            natcmp_sketch_release(sk, lv->items[i + 1 - offset]);
+        }
+        lv->n = odd;
+        if (h + 1 >= sk->nlevels) {
+            sk->nlevels = h + 2;
+        }
+    }
+}
+
+// updates the exact minimum and maximum with a string of `len` bytes
+static inline int natcmp_sketch_minmax(natcmp_sketch_t *sk,
+                                       const unsigned char *s, size_t len)
+{
+    if (!sk->min || natcmp(s, sk->min, sk->compare) < 0) {
+        unsigned char *p = natcmp_sketch_dup(sk, s, len);
+        if (!p) {
+            return -1;
+        }
+        natcmp_sketch_release(sk, sk->min);
+        sk->min = p;
+    }
+    if (!sk->max || natcmp(s, sk->max, sk->compare) > 0) {
+        unsigned char *p = natcmp_sketch_dup(sk, s, len);
+        if (!p) {
+            return -1;
+        }
+        natcmp_sketch_release(sk, sk->max);
+        sk->max = p;
+    }
+    return 0;
+}
+
+/**
+ * natcmp_sketch_update
+ *
+ * Adds a string of the stream to the sketch.
+ *
+ * @param sk    Sketch
+ * @param s     String to add (it is copied if it is kept as a sample)
+ * @return int  0 on success, -1 on failure with errno set to ENOMEM
+ */
+static inline int natcmp_sketch_update(natcmp_sketch_t *sk,
+                                       const unsigned char *s)
+{
+    size_t len       = strlen((const char *)s);
+    unsigned char *p = natcmp_sketch_dup(sk, s, len);
+    if (!p || natcmp_sketch_minmax(sk, s, len) != 0) {
+        natcmp_sketch_release(sk, p);
+        return -1;
+    } else if (natcmp_sketch_push(sk, 0, p) != 0) {
+        natcmp_sketch_release(sk, p);
+        return -1;
+    }
+    sk->n++;
+    natcmp_sketch_drop_view(sk);
+    return natcmp_sketch_compress(sk);
+}
+
+/**
+ * natcmp_sketch_merge
+ *
+ * Adds the samples of `src` to `dst`. Both sketches must use the same
+ * callback; `src` is not modified.
+ *
+ * @return int  0 on success, -1 on failure with errno set to ENOMEM
+ */
+static inline int natcmp_sketch_merge(natcmp_sketch_t *dst,
+                                      const natcmp_sketch_t *src)
+{
+    if (!src->n) {
+        return 0;
+    }
+    for (size_t h = 0; h < src->nlevels; h++) {
+        const natcmp_sketch_level_t *lv = src->levels + h;
+        for (size_t i = 0; i < lv->n; i++) {
+            const unsigned char *s = lv->items[i];
+            unsigned char *p =
+                natcmp_sketch_dup(dst, s, strlen((const char *)s));
+            if (!p || natcmp_sketch_push(dst, h, p) != 0) {
+                natcmp_sketch_release(dst, p);
+                return -1;
+            }
+        }
+    }
+    if (natcmp_sketch_minmax(dst, src->min, strlen((const char *)src->min)) !=
+            0 ||
+        natcmp_sketch_minmax(dst, src->max, strlen((const char *)src->max)) !=
+            0) {
+        return -1;
+    }
+    dst->n += src->n;
+    natcmp_sketch_drop_view(dst);
+    return natcmp_sketch_compress(dst);
+}
+
+/**
+ * natcmp_sketch_rank
+ *
+ * Returns the estimated number of strings of the stream that are less than
+ * `s`.
+ */
+static inline uint64_t natcmp_sketch_rank(const natcmp_sketch_t *sk,
+                                          const unsigned char *s)
+{
+    uint64_t rank = 0;
+    for (size_t h = 0; h < sk->nlevels; h++) {
+        const natcmp_sketch_level_t *lv = sk->levels + h;
+        for (size_t i = 0; i < lv->n; i++) {
+            if (natcmp(lv->items[i], s, sk->compare) < 0) {
+                rank += (uint64_t)1 << h;
+            }
+        }
+    }
+    return rank;
+}
+
+// builds the sorted view of the samples with their cumulative weights
+static inline int natcmp_sketch_build_view(natcmp_sketch_t *sk)
+{
+    size_t total = 0;
+    size_t pos[NATCMP_SKETCH_MAX_LEVELS];
+
+    for (size_t h = 0; h < sk->nlevels; h++) {
+        natcmp_sketch_level_t *lv = sk->levels + h;
+        natcmp_sort_inplace((const unsigned char **)lv->items, lv->n,
+                            sk->compare, NULL, 0);
+        total += lv->n;
+        pos[h] = 0;
+    }
+    sk->view = (natcmp_sketch_entry_t *)natcmp_alloc_array(
+        sk->alloc, total, sizeof(*sk->view));
+    if (!sk->view) {
+        return -1;
+    }
+
+    // merge the sorted levels
+    uint64_t rank = 0;
+    for (size_t i = 0; i < total; i++) {
+        size_t best = NATCMP_SKETCH_MAX_LEVELS;
+        for (size_t h = 0; h < sk->nlevels; h++) {
+            if (pos[h] < sk->levels[h].n &&
+                (best == NATCMP_SKETCH_MAX_LEVELS ||
+                 natcmp(sk->levels[h].items[pos[h]],
+                        sk->levels[best].items[pos[best]], sk->compare) < 0)) {
+                best = h;
+            }
+        }
+        rank += (uint64_t)1 << best;
+        sk->view[i].str  = sk->levels[best].items[pos[best]++];
+        sk->view[i].rank = rank;
+    }
+    sk->nview = total;
+    return 0;
+}
+
+/**
+ * natcmp_sketch_quantile
+ *
+ * Returns a string whose estimated normalized rank is `q`: the minimum for
+ * q <= 0, the maximum for q >= 1, and the median for 0.5. The string is owned
+ * by the sketch and valid until it is next modified.
+ *
+ * @param sk   Sketch
+ * @param q    Normalized rank in [0, 1]
+ * @return const unsigned char*  String, or NULL if the sketch is empty or
+ *                               on failure (errno set to ENOMEM)
+ */
+static inline const unsigned char *natcmp_sketch_quantile(natcmp_sketch_t *sk,
+                                                          double q)
+{
+    if (!sk->n) {
+        return NULL;
+    } else if (q <= 0) {
+        return sk->min;
+    } else if (q >= 1) {
+        return sk->max;
+    } else if (!sk->nview && natcmp_sketch_build_view(sk) != 0) {
+        return NULL;
+    }
+
+    // total weight of the samples may differ from n by the compaction error
+    uint64_t target = (uint64_t)(q * (double)sk->view[sk->nview - 1].rank);
+    size_t lo       = 0;
+    size_t hi       = sk->nview - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (sk->view[mid].rank <= target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return sk->view[lo].str;
+}
+
+static inline void natcmp_sketch_put_u64(natcmp_key_writer_t *w, uint64_t v)
+{
+    for (int i = 56; i >= 0; i -= 8) {
+        natcmp_key_put_byte(w, (unsigned char)(v >> i));
+    }
+}
+
+static inline void natcmp_sketch_put_str(natcmp_key_writer_t *w,
+                                         const unsigned char *s)
+{
+    size_t len = strlen((const char *)s);
+    natcmp_key_put_size(w, len);
+    for (size_t i = 0; i < len; i++) {
+        natcmp_key_put_byte(w, s[i]);
+    }
+}
+
+/**
+ * natcmp_sketch_serialize
+ *
+ * Writes the sketch to `buf` in a portable binary format:
+ *
+ *   "NCSK", version, <k>, n (8 bytes), rng (8 bytes), <nlevels>,
+ *   then if n > 0: min, max, and for each level <count> and its samples
+ *
+ * where <x> is a size encoded like the lengths of sort keys (a byte count
+ * followed by big-endian bytes) and each string is its <length> followed by
+ * its bytes.
+ *
+ * @param sk       Sketch
+ * @param buf      Output buffer
+ * @param size     Size of the output buffer
+ * @return size_t  Length of the serialized sketch. Like snprintf(), the full
+ *                 length is returned even if `size` is too small.
+ */
+static inline size_t natcmp_sketch_serialize(const natcmp_sketch_t *sk,
+                                             unsigned char *buf, size_t size)
+{
+    natcmp_key_writer_t w = {buf, size, 0};
+    for (size_t i = 0; i < 4; i++) {
+        natcmp_key_put_byte(&w, (unsigned char)NATCMP_SKETCH_MAGIC[i]);
+    }
+    natcmp_key_put_byte(&w, NATCMP_SKETCH_VERSION);
+    natcmp_key_put_size(&w, sk->k);
+    natcmp_sketch_put_u64(&w, sk->n);
+    natcmp_sketch_put_u64(&w, sk->rng);
+    natcmp_key_put_size(&w, sk->nlevels);
+    if (sk->n) {
+        natcmp_sketch_put_str(&w, sk->min);
+        natcmp_sketch_put_str(&w, sk->max);
+        for (size_t h = 0; h < sk->nlevels; h++) {
+            natcmp_key_put_size(&w, sk->levels[h].n);
+            for (size_t i = 0; i < sk->levels[h].n; i++) {
+                natcmp_sketch_put_str(&w, sk->levels[h].items[i]);
+            }
+        }
+    }
+    return w.len;
+}
+
+/**
+ * natcmp_sketch_reader_t
+ *
+ * Bounded input buffer used while deserializing a sketch.
+ */
+typedef struct {
+    const unsigned char *buf; // input buffer
+    size_t size;              // size of input buffer
+    size_t pos;               // number of bytes consumed so far
+} natcmp_sketch_reader_t;
+
+static inline int natcmp_sketch_get_u64(natcmp_sketch_reader_t *r,
+                                        size_t nbyte, uint64_t *v)
+{
+    if (r->size - r->pos < nbyte) {
+        return -1;
+    }
+    *v = 0;
+    while (nbyte--) {
+        *v = (*v << 8) | r->buf[r->pos++];
+    }
+    return 0;
+}
+
+static inline int natcmp_sketch_get_size(natcmp_sketch_reader_t *r,
+                                         size_t *n)
+{
+    uint64_t v = 0;
+    if (r->pos >= r->size || r->buf[r->pos] > sizeof(size_t) ||
+        natcmp_sketch_get_u64(r, r->buf[r->pos++], &v) != 0) {
+        return -1;
+    }
+    *n = (size_t)v;
+    return 0;
+}
+
+static inline unsigned char *natcmp_sketch_get_str(natcmp_sketch_reader_t *r,
+                                                   const natcmp_sketch_t *sk)
+{
+    size_t len = 0;
+    if (natcmp_sketch_get_size(r, &len) != 0 || r->size - r->pos < len ||
+        memchr(r->buf + r->pos, 0, len)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    unsigned char *p = natcmp_sketch_dup(sk, r->buf + r->pos, len);
+    r->pos += len;
+    return p;
+}
+
+/**
+ * natcmp_sketch_deserialize
+ *
+ * Initializes `sk` from the output of natcmp_sketch_serialize().
+ *
+ * @param sk       Sketch to initialize
+ * @param buf      Serialized sketch
+ * @param size     Length of the serialized sketch
+ * @param compare  Callback function the sketch was built with
+ * @param alloc    Allocator or NULL
+ * @return int     0 on success, -1 on failure with errno set to EINVAL
+ *                 (malformed input) or ENOMEM
+ */
+static inline int natcmp_sketch_deserialize(natcmp_sketch_t *sk,
+                                            const unsigned char *buf,
+                                            size_t size,
+                                            natcmp_nondigit_cmp_func_t compare,
+                                            const natcmp_allocator_t *alloc)
+{
+    natcmp_sketch_reader_t r = {buf, size, 5};
+    size_t k                 = 0;
+    size_t nlevels           = 0;
+    uint64_t n               = 0;
+    uint64_t rng             = 0;
+
+    natcmp_sketch_init(sk, 0, 0, compare, alloc);
+    if (size < 5 || memcmp(buf, NATCMP_SKETCH_MAGIC, 4) != 0 ||
+        buf[4] != NATCMP_SKETCH_VERSION || natcmp_sketch_get_size(&r, &k) ||
+        natcmp_sketch_get_u64(&r, 8, &n) ||
+        natcmp_sketch_get_u64(&r, 8, &rng) ||
+        natcmp_sketch_get_size(&r, &nlevels) || !nlevels ||
+        nlevels > NATCMP_SKETCH_MAX_LEVELS) {
+        errno = EINVAL;
+        return -1;
+    }
+    natcmp_sketch_init(sk, k, rng, compare, alloc);
+    if (!n) {
+        return 0;
+    }
+
+    sk->min = natcmp_sketch_get_str(&r, sk);
+    sk->max = sk->min ? natcmp_sketch_get_str(&r, sk) : NULL;
+    if (!sk->max) {
+        natcmp_sketch_free(sk);
+        return -1;
+    }
+    for (size_t h = 0; h < nlevels; h++) {
+        size_t count = 0;
+        if (natcmp_sketch_get_size(&r, &count) != 0) {
+            natcmp_sketch_free(sk);
+            errno = EINVAL;
+            return -1;
+        }
+        for (size_t i = 0; i < count; i++) {
+            unsigned char *p = natcmp_sketch_get_str(&r, sk);
+            if (!p || natcmp_sketch_push(sk, h, p) != 0) {
+                natcmp_sketch_release(sk, p);
+                natcmp_sketch_free(sk);
+                return -1;
+            }
+        }
+    }
+    sk->nlevels = nlevels;
+    sk->n       = n;
+    return 0;
+}
+
+#endif /* natcmp_sketch_h */
@@ -0,0 +1,487 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_sort_h
+#define natcmp_sort_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_key.h"
+
+// partitions of up to this many elements are sorted by insertion sort
+#define NATCMP_SORT_INSERTION 16
+
+// partitions of up to this many elements are sorted by natcmp_sort_network()
+// when the default comparison is used (a power of two up to 64, or 0 to use
+// insertion sort instead)
+#ifndef NATCMP_SORT_NETWORK
+#define NATCMP_SORT_NETWORK 32
+#endif
+
+/**
+ * natcmp_sort_insertion
+ *
+ * Sorts strs[0..n) in natural order with a stable insertion sort.
+ * Intended for small arrays and as the base case of the other sorts.
+ *
+ * @param strs     Array of strings to sort in place
+ * @param n        Number of strings
+ * @param compare  Callback function for comparing non-digit portions
+ */
+static inline void natcmp_sort_insertion(const unsigned char **strs, size_t n,
+                                         natcmp_nondigit_cmp_func_t compare)
+{
+    for (size_t i = 1; i < n; i++) {
+        const unsigned char *s = strs[i];
+        size_t j               = i;
+        while (j > 0 && natcmp(strs[j - 1], s, compare) > 0) {
+            strs[j] = strs[j - 1];
+            j--;
+        }
+        strs[j] = s;
+    }
+}
+
+static inline void natcmp_sort_network_cx(uint64_t *v, size_t i, size_t j)
+{
+    uint64_t a = v[i];
+    uint64_t b = v[j];
+    v[i]       = (a < b) ? a : b;
+    v[j]       = (a < b) ? b : a;
+}
+
+/**
+ * natcmp_sort_network_run
+ *
+ * Sorts v[0..size), size being a power of two, with a bitonic sorting
+ * network in which every comparator points the same way: each stage is a
+ * loop of independent branch-free compare-exchanges that the compiler can
+ * turn into vector instructions.
+ */
+static inline void natcmp_sort_network_run(uint64_t *v, size_t size)
+{
+    for (size_t k = 2; k <= size; k <<= 1) {
+        // merge the sorted halves of each block of k, the second reversed
+        for (size_t b = 0; b < size; b += k) {
+            for (size_t t = 0; t < k / 2; t++) {
+                natcmp_sort_network_cx(v, b + t, b + k - 1 - t);
+            }
+        }
+        for (size_t j = k / 4; j > 0; j >>= 1) {
+            for (size_t b = 0; b < size; b += j * 2) {
+                for (size_t t = 0; t < j; t++) {
+                    natcmp_sort_network_cx(v, b + t, b + t + j);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * natcmp_sort_network
+ *
+ * Sorts strs[0..n), n <= 64, in the order of natcmp(a, b, NULL) with a
+ * stable sort. The bytes all the strings share are skipped (back to the
+ * start of a digit run), and the rest of each string is reduced to a 64-bit
+ * key prefix (natcmp_key_prefix()) whose low 6 bits are replaced by the
+ * index of the string. The keys are sorted by a sorting network, so the
+ * comparisons are integer comparisons without branches, and only the
+ * strings whose key prefixes are equal are then compared with natcmp(), by
+ * insertion sort.
+ *
+ * @param strs  Array of strings to sort in place
+ * @param n     Number of strings (at most 64)
+ */
+static inline void natcmp_sort_network(const unsigned char **strs, size_t n)
+{
+    const uint64_t mask = 63;
+    uint64_t v[64];
+    const unsigned char *tmp[64];
+    size_t size = 2;
+    size_t skip = (size_t)-1;
+
+    if (n < 2) {
+        return;
+    }
+    while (size < n) {
+        size <<= 1;
+    }
+    for (size_t i = 1; i < n; i++) {
+        size_t l = 0;
+        while (l < skip && strs[0][l] && strs[i][l] == strs[0][l]) {
+            l++;
+        }
+        skip = l;
+    }
+    while (skip && isdigit(strs[0][skip - 1])) {
+        skip--;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        v[i] = (natcmp_key_prefix(strs[i] + skip) & ~mask) | i;
+    }
+    for (size_t i = n; i < size; i++) {
+        v[i] = UINT64_MAX;
+    }
+    natcmp_sort_network_run(v, size);
+
+    for (size_t i = 0; i < n; i++) {
+        tmp[i] = strs[v[i] & mask];
+    }
+    for (size_t i = 0, j; i < n; i = j) {
+        for (j = i + 1; j < n && (v[j] | mask) == (v[i] | mask); j++) {
+        }
+        natcmp_sort_insertion(tmp + i, j - i, NULL);
+    }
+    memcpy(strs, tmp, sizeof(*strs) * n);
+}
+
+/**
+ * natcmp_sort_leaf
+ *
+ * Returns the size of the partitions sorted by natcmp_sort_small().
+ */
+static inline size_t natcmp_sort_leaf(natcmp_nondigit_cmp_func_t compare)
+{
+    if (NATCMP_SORT_NETWORK &&
+        (!compare || compare == natcmp_nondigit_cmp_ascii)) {
+        return NATCMP_SORT_NETWORK;
+    }
+    return NATCMP_SORT_INSERTION;
+}
+
+/**
+ * natcmp_sort_small
+ *
+ * Sorts a partition of at most natcmp_sort_leaf(compare) strings: with
+ * natcmp_sort_network() for the default comparison, and by insertion sort
+ * otherwise.
+ */
+static inline void natcmp_sort_small(const unsigned char **strs, size_t n,
+                                     natcmp_nondigit_cmp_func_t compare)
+{
+    if (NATCMP_SORT_NETWORK && n > 2 &&
+        (!compare || compare == natcmp_nondigit_cmp_ascii)) {
+        natcmp_sort_network(strs, n);
+    } else {
+        natcmp_sort_insertion(strs, n, compare);
+    }
+}
+
+static inline void natcmp_sort_merge_rec(const unsigned char **strs, size_t n,
+                                         const unsigned char **buf,
+                                         natcmp_nondigit_cmp_func_t compare)
+{
+    if (n <= natcmp_sort_leaf(compare)) {
+        natcmp_sort_small(strs, n, compare);
+        return;
+    }
+
+    size_t mid = n / 2;
+    natcmp_sort_merge_rec(strs, mid, buf, compare);
+    natcmp_sort_merge_rec(strs + mid, n - mid, buf, compare);
+    if (natcmp(strs[mid - 1], strs[mid], compare) <= 0) {
+        // already in order
+        return;
+    }
+
+    // merge the left half (moved to buf) and the right half into strs
+    size_t i = 0;
+    size_t j = mid;
+    size_t k = 0;
+    memcpy(buf, strs, sizeof(*strs) * mid);
+    while (i < mid && j < n) {
+        // take from the left on ties to keep the sort stable
+        strs[k++] = (natcmp(buf[i], strs[j], compare) <= 0) ? buf[i++] :
+                                                             strs[j++];
+    }
+    while (i < mid) {
+        strs[k++] = buf[i++];
+    }
+}
+
+/**
+ * natcmp_sort_merge
+ *
+ * Sorts strs[0..n) in natural order with a stable merge sort.
+ * Uses a scratch buffer of n / 2 pointers.
+ *
+ * @param strs     Array of strings to sort in place
+ * @param n        Number of strings
+ * @param compare  Callback function for comparing non-digit portions
+ *                 (NULL selects natcmp_nondigit_cmp_ascii)
+ * @param alloc    Allocator for the scratch buffer (NULL selects malloc)
+ * @return int     0 on success, -1 with errno set to ENOMEM on failure
+ */
+static inline int natcmp_sort_merge(const unsigned char **strs, size_t n,
+                                    natcmp_nondigit_cmp_func_t compare,
+                                    const natcmp_allocator_t *alloc)
+{
+    if (n <= natcmp_sort_leaf(compare)) {
+        natcmp_sort_small(strs, n, compare);
+        return 0;
+    }
+
+    size_t size               = sizeof(*strs) * (n / 2);
+    const unsigned char **buf = natcmp_alloc(alloc, size);
+    if (!buf) {
+        return -1;
+    }
+    natcmp_sort_merge_rec(strs, n, buf, compare);
+    natcmp_free(alloc, (void *)buf, size);
+    return 0;
+}
+
+/**
+ * natcmp_sort_rotate
+ *
+ * Rotates strs[0..n) left by m elements with three reversals.
+ */
+static inline void natcmp_sort_rotate(const unsigned char **strs, size_t m,
+                                      size_t n)
+{
+#define natcmp_sort_reverse(lo, hi)                                            \
+    do {                                                                       \
+        size_t l_ = (lo);                                                      \
+        size_t h_ = (hi);                                                      \
+        while (l_ + 1 < h_) {                                                  \
+            const unsigned char *t_ = strs[l_];                                \
+            strs[l_++]              = strs[--h_];                              \
+            strs[h_]                = t_;                                      \
+        }                                                                      \
+    } while (0)
+
+    natcmp_sort_reverse(0, m);
+    natcmp_sort_reverse(m, n);
+    natcmp_sort_reverse(0, n);
+#undef natcmp_sort_reverse
+}
+
+/**
+ * natcmp_sort_inplace_merge
+ *
+ * Stably merges the sorted runs strs[0..m) and strs[m..n).
+ * If the shorter run fits in buf, it is merged through buf in linear time.
+ * Otherwise the runs are split with a binary search and the middle parts are
+ * swapped by a rotation (SymMerge, Kim and Kutzner), which needs no extra
+ * memory and recurses to a depth of O(log n).
+ */
+static inline void natcmp_sort_inplace_merge(const unsigned char **strs,
+                                             size_t m, size_t n,
+                                             const unsigned char **buf,
+                                             size_t bufsize,
+                                             natcmp_nondigit_cmp_func_t compare)
+{
+    if (m == 0 || m == n || natcmp(strs[m - 1], strs[m], compare) <= 0) {
+        // nothing to merge
+        return;
+    }
+
+    if (m <= bufsize) {
+        // merge forward with the left run in buf
+        size_t i = 0;
+        size_t j = m;
+        size_t k = 0;
+        memcpy(buf, strs, sizeof(*strs) * m);
+        while (i < m && j < n) {
+            strs[k++] = (natcmp(buf[i], strs[j], compare) <= 0) ? buf[i++] :
+                                                                 strs[j++];
+        }
+        while (i < m) {
+            strs[k++] = buf[i++];
+        }
+        return;
+    } else if (n - m <= bufsize) {
+        // merge backward with the right run in buf
+        size_t i = m;
+        size_t j = n - m;
+        size_t k = n;
+        memcpy(buf, strs + m, sizeof(*strs) * (n - m));
+        while (i > 0 && j > 0) {
+            // take from the right on ties to keep the sort stable
+            strs[--k] = (natcmp(strs[i - 1], buf[j - 1], compare) > 0) ?
+                            strs[--i] :
+                            buf[--j];
+        }
+        while (j > 0) {
+            strs[--k] = buf[--j];
+        }
+        return;
+    }
+
+    // find the split point `start` so that strs[start..m) and
+    // strs[m..end) are swapped by the rotation
+    size_t mid   = n / 2;
+    size_t sum   = mid + m;
+    size_t start = (m > mid) ? sum - n : 0;
+    size_t r     = (m > mid) ? mid : m;
+    while (start < r) {
+        size_t c = start + (r - start) / 2;
+        if (natcmp(strs[c], strs[sum - 1 - c], compare) <= 0) {
+            start = c + 1;
+        } else {
+            r = c;
+        }
+    }
+    size_t end = sum - start;
+    if (start < m && m < end) {
+        natcmp_sort_rotate(strs + start, m - start, end - start);
+    }
+    natcmp_sort_inplace_merge(strs, start, mid, buf, bufsize, compare);
+    natcmp_sort_inplace_merge(strs + mid, end - mid, n - mid, buf, bufsize,
+                              compare);
+}
+
+/**
+ * natcmp_sort_inplace
+ *
+ * Sorts strs[0..n) in natural order with a stable in-place merge sort.
+ * Blocks of natcmp_sort_leaf() elements are sorted by natcmp_sort_small()
+ * and then merged bottom-up without allocating any memory. An optional fixed
+ * buffer `buf` of `bufsize` pointers (e.g. a few hundred on the stack) is used
+ * to merge short runs in linear time; pass NULL and 0 to sort with O(1)
+ * extra memory.
+ *
+ * @param strs     Array of strings to sort in place
+ * @param n        Number of strings
+ * @param compare  Callback function for comparing non-digit portions
+ *                 (NULL selects natcmp_nondigit_cmp_ascii)
+ * @param buf      Optional scratch buffer, or NULL
+ * @param bufsize  Number of pointers in buf
+ */
+static inline void natcmp_sort_inplace(const unsigned char **strs, size_t n,
+                                       natcmp_nondigit_cmp_func_t compare,
+                                       const unsigned char **buf,
+                                       size_t bufsize)
+{
+    if (!buf) {
+        bufsize = 0;
+    }
+    size_t leaf = natcmp_sort_leaf(compare);
+    for (size_t i = 0; i < n; i += leaf) {
+        natcmp_sort_small(strs + i, (n - i < leaf) ? n - i : leaf, compare);
+    }
+    for (size_t width = leaf; width < n; width *= 2) {
+        for (size_t i = 0; i + width < n; i += width * 2) {
+            size_t len = (n - i < width * 2) ? n - i : width * 2;
+            natcmp_sort_inplace_merge(strs + i, width, len, buf, bufsize,
+                                      compare);
+        }
+    }
+}
+
+/**
+ * natcmp_sort_entry_t
+ *
+ * Sort key and string pair used by natcmp_sort_keys().
+ */
+typedef struct {
+    const unsigned char *key;
+    size_t len;
+    const unsigned char *str;
+} natcmp_sort_entry_t;
+
+static inline void natcmp_sort_keys_rec(natcmp_sort_entry_t *ent, size_t n,
+                                        natcmp_sort_entry_t *buf)
+{
+#define natcmp_sort_entry_cmp(x, y)                                            \
+    natcmp_keycmp((x).key, (x).len, (y).key, (y).len)
+
+    if (n <= NATCMP_SORT_INSERTION) {
+        for (size_t i = 1; i < n; i++) {
+            natcmp_sort_entry_t e = ent[i];
+            size_t j              = i;
+            while (j > 0 && natcmp_sort_entry_cmp(ent[j - 1], e) > 0) {
+                ent[j] = ent[j - 1];
+                j--;
+            }
+            ent[j] = e;
+        }
+        return;
+    }
+
+    size_t mid = n / 2;
+    natcmp_sort_keys_rec(ent, mid, buf);
+    natcmp_sort_keys_rec(ent + mid, n - mid, buf);
+    if (natcmp_sort_entry_cmp(ent[mid - 1], ent[mid]) <= 0) {
+        return;
+    }
+
+    size_t i = 0;
+    size_t j = mid;
+    size_t k = 0;
+    memcpy(buf, ent, sizeof(*ent) * mid);
+    while (i < mid && j < n) {
+        ent[k++] = (natcmp_sort_entry_cmp(buf[i], ent[j]) <= 0) ? buf[i++] :
+                                                                  ent[j++];
+    }
+    while (i < mid) {
+        ent[k++] = buf[i++];
+    }
+#undef natcmp_sort_entry_cmp
+}
+
+/**
+ * natcmp_sort_keys
+ *
+ * Sorts strs[0..n) in the order of natcmp(a, b, NULL) with a stable merge
+ * sort over sort keys generated by natcmp_keys_bulk(). Trades memory for
+ * speed: the keys, one entry per string and a scratch buffer of n / 2 entries
+ * are allocated, but every comparison is a memcmp().
+ *
+ * @param strs   Array of strings to sort in place
+ * @param n      Number of strings
+ * @param alloc  Allocator for the scratch memory (NULL selects malloc)
+ * @return int   0 on success, -1 with errno set to ENOMEM on failure
+ */
+static inline int natcmp_sort_keys(const unsigned char **strs, size_t n,
+                                   const natcmp_allocator_t *alloc)
+{
+    const unsigned char *const *src = (const unsigned char *const *)strs;
+    size_t keys_size                = natcmp_keys_size(src, n);
+    size_t ent_size                 = sizeof(natcmp_sort_entry_t) * (n + n / 2);
+    size_t off_size                 = sizeof(size_t) * (n + 1);
+    unsigned char *keys             = natcmp_alloc(alloc, keys_size);
+    natcmp_sort_entry_t *ent        = natcmp_alloc(alloc, ent_size);
+    size_t *off                     = natcmp_alloc(alloc, off_size);
+    natcmp_arena_t arena            = {keys, keys_size, 0};
+    int rv                          = -1;
+
+    if (keys && ent && off && natcmp_keys_bulk(src, n, &arena, off) == 0) {
+        for (size_t i = 0; i < n; i++) {
+            ent[i].key = keys + off[i];
+            ent[i].len = off[i + 1] - off[i];
+            ent[i].str = strs[i];
+        }
+        natcmp_sort_keys_rec(ent, n, ent + n);
+        for (size_t i = 0; i < n; i++) {
+            strs[i] = ent[i].str;
+        }
+        rv = 0;
+    }
+    natcmp_free(alloc, off, off_size);
+    natcmp_free(alloc, ent, ent_size);
+    natcmp_free(alloc, keys, keys_size);
+    return rv;
+}
+
+#endif /* natcmp_sort_h */
@@ -0,0 +1,440 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_units_h
+#define natcmp_units_h
+
+#include "natcmp.h"
+#include <stdint.h>
+
+/**
+ * Unit-suffixed numbers
+ *
+ * natcmp_units() compares numbers followed by a unit suffix, such as "512K",
+ * "1.5M", "90s" or "2h", by their scaled magnitude instead of by their digits.
+ * A unit number is a run of digits, an optional fraction ("." and digits) and
+ * a suffix from a unit table that is not followed by an ASCII letter. A digit
+ * run without a suffix is a plain number whose unit is 1 (its fraction, if
+ * any, is not consumed and is compared as text and digits as usual).
+ *
+ * Magnitudes are compared exactly with fixed-size integer arithmetic; no
+ * floating point and no allocation is used. A unit number with more than
+ * NATCMP_UNIT_MAX_DIGITS significant digits is read as a plain number and its
+ * suffix as text. Plain numbers may be of any length: one with more than
+ * NATCMP_UNIT_PLAIN_DIGITS significant digits is larger than any unit number
+ * (2^64 < 10^20) and is compared with other plain numbers by its digits.
+ */
+#define NATCMP_UNIT_MAX_DIGITS   36
+#define NATCMP_UNIT_PLAIN_DIGITS (NATCMP_UNIT_MAX_DIGITS + 20)
+#define NATCMP_UNIT_BIG_LIMBS    12
+
+/**
+ * natcmp_unit_t
+ *
+ * Entry of a unit table. A table is terminated by an entry with a NULL
+ * suffix.
+ */
+typedef struct {
+    const char *suffix; // unit suffix (e.g. "K", "KiB", "ms")
+    uint64_t scale;     // number of base units in one unit
+} natcmp_unit_t;
+
+/**
+ * natcmp_units_si
+ *
+ * Returns the SI size table: k/K, M, G, T, P and E are powers of 1000, with
+ * or without a trailing "B".
+ */
+static inline const natcmp_unit_t *natcmp_units_si(void)
+{
+    static const natcmp_unit_t units[] = {
+        {"B",  1ULL                  },
+        {"k",  1000ULL               },
+        {"kB", 1000ULL               },
+        {"K",  1000ULL               },
+        {"KB", 1000ULL               },
+        {"M",  1000000ULL            },
+        {"MB", 1000000ULL            },
+        {"G",  1000000000ULL         },
+        {"GB", 1000000000ULL         },
+        {"T",  1000000000000ULL      },
+        {"TB", 1000000000000ULL      },
+        {"P",  1000000000000000ULL   },
+        {"PB", 1000000000000000ULL   },
+        {"E",  1000000000000000000ULL},
+        {"EB", 1000000000000000000ULL},
+        {NULL, 0                     },
+    };
+    return units;
+}
+
+/**
+ * natcmp_units_iec
+ *
+ * Returns the IEC size table: K/k/Ki, M/Mi, G/Gi, T/Ti, P/Pi and E/Ei are
+ * powers of 1024, with or without a trailing "B" (as printed by `ls -h` or
+ * `du -h`).
+ */
+static inline const natcmp_unit_t *natcmp_units_iec(void)
+{
+    static const natcmp_unit_t units[] = {
+        {"B",   1ULL      },
+        {"k",   1ULL << 10},
+        {"kB",  1ULL << 10},
+        {"K",   1ULL << 10},
+        {"KB",  1ULL << 10},
+        {"Ki",  1ULL << 10},
+        {"KiB", 1ULL << 10},
+        {"M",   1ULL << 20},
+        {"MB",  1ULL << 20},
+        {"Mi",  1ULL << 20},
+        {"MiB", 1ULL << 20},
+        {"G",   1ULL << 30},
+        {"GB",  1ULL << 30},
+        {"Gi",  1ULL << 30},
+        {"GiB", 1ULL << 30},
+        {"T",   1ULL << 40},
+        {"TB",  1ULL << 40},
+        {"Ti",  1ULL << 40},
+        {"TiB", 1ULL << 40},
+        {"P",   1ULL << 50},
+        {"PB",  1ULL << 50},
+        {"Pi",  1ULL << 50},
+        {"PiB", 1ULL << 50},
+        {"E",   1ULL << 60},
+        {"EB",  1ULL << 60},
+        {"Ei",  1ULL << 60},
+        {"EiB", 1ULL << 60},
+        {NULL,  0         },
+    };
+    return units;
+}
+
+/**
+ * natcmp_units_time
+ *
+ * Returns the duration table in microseconds: us, ms, s, m/min, h, d and w.
+ */
+static inline const natcmp_unit_t *natcmp_units_time(void)
+{
+    static const natcmp_unit_t units[] = {
+        {"us",  1ULL           },
+        {"ms",  1000ULL        },
+        {"s",   1000000ULL     },
+        {"m",   60000000ULL    },
+        {"min", 60000000ULL    },
+        {"h",   3600000000ULL  },
+        {"d",   86400000000ULL },
+        {"w",   604800000000ULL},
+        {NULL,  0              },
+    };
+    return units;
+}
+
+/**
+ * natcmp_unit_num_t
+ *
+ * A parsed number. Its value is (integer digits . fraction digits) * scale.
+ */
+typedef struct {
+    const unsigned char *digits; // first significant integer digit
+    size_t ilen;                 // number of significant integer digits
+    const unsigned char *frac;   // first fraction digit
+    size_t flen;                 // number of fraction digits (trimmed)
+    uint64_t scale;              // scale of the unit (1 for plain numbers)
+    size_t pad;                  // leading zeros, as counted by natcmp()
+    const unsigned char *tail;   // end of the number (after the suffix)
+} natcmp_unit_num_t;
+
+/**
+ * natcmp_unit_suffix
+ *
+ * Returns the scale of the longest suffix of `units` at `s` that is not
+ * followed by an ASCII letter, or 0 if there is none.
+ */
+static inline uint64_t natcmp_unit_suffix(const unsigned char *s,
+                                          const natcmp_unit_t *units,
+                                          const unsigned char **end)
+{
+    uint64_t scale = 0;
+    size_t len     = 0;
+
+    for (; units->suffix; units++) {
+        size_t n = strlen(units->suffix);
+        if (n > len && strncmp((const char *)s, units->suffix, n) == 0 &&
+            !isalpha(s[n])) {
+            scale = units->scale;
+            len   = n;
+        }
+    }
+    *end = s + len;
+    return scale;
+}
+
+/**
+ * natcmp_unit_parse
+ *
+ * Parses the number at the head of `s` (which must start with a digit). The
+ * result depends on `s` alone, so that the order of natcmp_units() is
+ * transitive.
+ *
+ * @param s      String to parse
+ * @param units  Unit table
+ * @param num    Output parameter to store the parsed number
+ * @return int   1 if the number has a unit suffix, 0 if it is a plain number
+ */
+static inline int natcmp_unit_parse(const unsigned char *s,
+                                    const natcmp_unit_t *units,
+                                    natcmp_unit_num_t *num)
+{
+    num->pad = 0;
+    while (*s == '0') {
+        num->pad++;
+        s++;
+    }
+    num->digits = s;
+    while (isdigit(*s)) {
+        s++;
+    }
+    num->ilen = (size_t)(s - num->digits);
+    if (!num->ilen) {
+        // natcmp() keeps the last zero of an all-zero run
+        num->pad--;
+    }
+    num->frac  = s;
+    num->flen  = 0;
+    num->scale = 1;
+    num->tail  = s;
+
+    const unsigned char *p = s;
+    if (*p == '.' && isdigit(p[1])) {
+        num->frac = ++p;
+        while (isdigit(*p)) {
+            p++;
+        }
+        num->flen = (size_t)(p - num->frac);
+    }
+
+    const unsigned char *end = NULL;
+    uint64_t scale           = natcmp_unit_suffix(p, units, &end);
+
+    // trim trailing zeros of the fraction
+    while (num->flen && num->frac[num->flen - 1] == '0') {
+        num->flen--;
+    }
+    if (!scale || num->ilen + num->flen > NATCMP_UNIT_MAX_DIGITS) {
+        // plain number; the fraction and suffix are not part of it
+        num->flen = 0;
+        return 0;
+    }
+    num->scale = scale;
+    num->tail  = end;
+    return 1;
+}
+
+/**
+ * natcmp_unit_big_t
+ *
+ * Fixed-size unsigned integer in base 2^32, least significant limb first.
+ * Large enough for NATCMP_UNIT_PLAIN_DIGITS digits times
+ * 10^NATCMP_UNIT_MAX_DIGITS times a 64-bit scale.
+ */
+typedef struct {
+    uint32_t v[NATCMP_UNIT_BIG_LIMBS];
+} natcmp_unit_big_t;
+
+// x = x * m + add
+static inline void natcmp_unit_big_muladd(natcmp_unit_big_t *x, uint32_t m,
+                                          uint32_t add)
+{
+    uint64_t carry = add;
+    for (size_t i = 0; i < NATCMP_UNIT_BIG_LIMBS; i++) {
+        uint64_t t = (uint64_t)x->v[i] * m + carry;
+        x->v[i]    = (uint32_t)t;
+        carry      = t >> 32;
+    }
+}
+
+// x = x * m
+static inline void natcmp_unit_big_mul64(natcmp_unit_big_t *x, uint64_t m)
+{
+    natcmp_unit_big_t hi = *x;
+    uint64_t carry       = 0;
+
+    natcmp_unit_big_muladd(x, (uint32_t)m, 0);
+    natcmp_unit_big_muladd(&hi, (uint32_t)(m >> 32), 0);
+    // x += hi << 32
+    for (size_t i = 1; i < NATCMP_UNIT_BIG_LIMBS; i++) {
+        uint64_t t = (uint64_t)x->v[i] + hi.v[i - 1] + carry;
+        x->v[i]    = (uint32_t)t;
+        carry      = t >> 32;
+    }
+}
+
+/**
+ * natcmp_unit_magnitude
+ *
+ * Computes digits * 10^(flen_max - flen) * scale of `num`, i.e. its value in
+ * base units scaled by 10^flen_max.
+ */
+static inline void natcmp_unit_magnitude(const natcmp_unit_num_t *num,
+                                         size_t flen_max, natcmp_unit_big_t *x)
+{
+    memset(x, 0, sizeof(*x));
+    for (size_t i = 0; i < num->ilen; i++) {
+        natcmp_unit_big_muladd(x, 10, (uint32_t)(num->digits[i] - '0'));
+    }
+    for (size_t i = 0; i < num->flen; i++) {
+        natcmp_unit_big_muladd(x, 10, (uint32_t)(num->frac[i] - '0'));
+    }
+    for (size_t i = num->flen; i < flen_max; i++) {
+        natcmp_unit_big_muladd(x, 10, 0);
+    }
+    natcmp_unit_big_mul64(x, num->scale);
+}
+
+/**
+ * natcmp_unit_cmp
+ *
+ * Compares the magnitudes of two parsed numbers.
+ *
+ * @return int  Comparison result (-1 if a < b, 1 if a > b, 0 if equal)
+ */
+static inline int natcmp_unit_cmp(const natcmp_unit_num_t *a,
+                                  const natcmp_unit_num_t *b)
+{
+    if (a->ilen > NATCMP_UNIT_PLAIN_DIGITS ||
+        b->ilen > NATCMP_UNIT_PLAIN_DIGITS) {
+        // at least one long plain number, larger than any unit number
+        if (a->ilen != b->ilen) {
+            return (a->ilen < b->ilen) ? -1 : 1;
+        }
+        int res = memcmp(a->digits, b->digits, a->ilen);
+        return (res > 0) - (res < 0);
+    }
+
+    size_t flen = (a->flen > b->flen) ? a->flen : b->flen;
+    natcmp_unit_big_t x;
+    natcmp_unit_big_t y;
+
+    natcmp_unit_magnitude(a, flen, &x);
+    natcmp_unit_magnitude(b, flen, &y);
+    for (size_t i = NATCMP_UNIT_BIG_LIMBS; i-- > 0;) {
+        if (x.v[i] != y.v[i]) {
+            return (x.v[i] < y.v[i]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * natcmp_units
+ *
+ * Compares two strings in natural order like natcmp(), but compares numbers
+ * with a unit suffix from `units` by their scaled magnitude.
+ * Example: "512K" < "1.5M" < "2G" with natcmp_units_si(), and
+ * "90s" < "2m" < "1h" with natcmp_units_time()
+ *
+ * Algorithm:
+ * 1. Non-digit portions are compared using the provided callback function
+ * 2. At a digit run, each number is parsed on its own (a plain number has
+ *    unit 1) and the two are compared by magnitude, so that numbers of
+ *    equal magnitude (e.g. "1000K" and "1M") are equal
+ * 3. Numbers of equal magnitude are ordered by their leading zeros, as in
+ *    natcmp(), and the scan continues after them
+ *
+ * @param a         First string to compare
+ * @param b         Second string to compare
+ * @param compare   Callback function for comparing non-digit portions
+ * @param units     Unit table (NULL compares like natcmp())
+ * @return int      Comparison result (-1=a is less, 0=equal, 1=a is greater)
+ */
+static inline int natcmp_units(const unsigned char *a, const unsigned char *b,
+                               natcmp_nondigit_cmp_func_t compare,
+                               const natcmp_unit_t *units)
+{
+    if (!compare) {
+        // default to ASCII comparison if no callback is provided
+        compare = natcmp_nondigit_cmp_ascii;
+    }
+
+    while (*a && *b) {
+        int isdigit_a = isdigit(*a);
+        int isdigit_b = isdigit(*b);
+        if (!isdigit_a && !isdigit_b) {
+            // compare non-digit part
+            unsigned char *end_a = NULL;
+            unsigned char *end_b = NULL;
+            int res              = compare(a, b, &end_a, &end_b);
+            if (res != 0) {
+                return (res < 0) ? -1 : 1;
+            }
+            a = end_a;
+            b = end_b;
+            if (!*a || !*b) {
+                break;
+            }
+
+            isdigit_a = isdigit(*a);
+            isdigit_b = isdigit(*b);
+        }
+
+        if (isdigit_a != isdigit_b) {
+            return isdigit_a ? -1 : 1;
+        }
+
+        if (units) {
+            natcmp_unit_num_t na;
+            natcmp_unit_num_t nb;
+            natcmp_unit_parse(a, units, &na);
+            natcmp_unit_parse(b, units, &nb);
+            int res = natcmp_unit_cmp(&na, &nb);
+            if (res != 0) {
+                return res;
+            } else if (na.pad != nb.pad) {
+                return (na.pad < nb.pad) ? -1 : 1;
+            }
+            a = na.tail;
+            b = nb.tail;
+            continue;
+        }
+
+        // compare number part
+        unsigned char *end_a = NULL;
+        unsigned char *end_b = NULL;
+        int res              = natcmp_digit_cmp(a, b, &end_a, &end_b);
+        if (res != 0) {
+            return res;
+        }
+        a = end_a;
+        b = end_b;
+    }
+
+    if (*b) {
+        return -1;
+    } else if (*a) {
+        return 1;
+    }
+    return 0;
+}
+
+#endif /* natcmp_units_h */
@@ -0,0 +1,800 @@
+/**
+ *  Copyright (C) 2025 Masatoshi Fukunaga
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ */
+
+#ifndef natcmp_walk_h
+#define natcmp_walk_h
+
+#include "natcmp.h"
+#include "natcmp_alloc.h"
+#include "natcmp_sort.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) &&                                                      \
+    (defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE)) &&                      \
+    !defined(NATCMP_WALK_DISABLE_GETDENTS)
+#define NATCMP_WALK_HAVE_GETDENTS 1
+#include <fcntl.h>
+#include <sys/syscall.h>
+#endif
+
+#ifndef NATCMP_WALK_THREADS
+#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0
+#define NATCMP_WALK_THREADS 1
+#else
+#define NATCMP_WALK_THREADS 0
+#endif
+#endif
+#if NATCMP_WALK_THREADS
+#include <pthread.h>
+#endif
+
+/**
+ * Directory walking
+ *
+ * natcmp_dir_read() reads a directory in one pass and sorts its names with
+ * natcmp(); natcmp_walk_t walks a tree depth-first, emitting every directory
+ * before its contents and the entries of each directory in natural order.
+ *
+ * By default the walk reads one directory at a time. With the
+ * NATCMP_WALK_PARALLEL flag, NATCMP_WALK_WORKERS threads read directories
+ * ahead of it while natcmp_walk_next() returns the entries that are already
+ * sorted. When the walk enters a directory, its subdirectories are queued in
+ * natural order. An idle worker takes the first queued subdirectory of the
+ * deepest open directory, which is the one the walk reaches first, and the
+ * walk reads a queued directory itself if it gets there before any worker.
+ * At most NATCMP_WALK_AHEAD directories are read ahead. The output is the
+ * same as without the flag. Without POSIX threads, or with
+ * NATCMP_WALK_THREADS defined to 0, the flag is ignored. In parallel mode the
+ * allocator and the callback must be safe to use from several threads, and
+ * the walk must not be moved in memory while it is open.
+ *
+ * On Linux, when the header is compiled with _GNU_SOURCE or _DEFAULT_SOURCE,
+ * natcmp_dir_read() fetches the entries with the getdents64 system call in
+ * batches of NATCMP_WALK_GETDENTS_SIZE bytes instead of through readdir().
+ * Defining NATCMP_WALK_DISABLE_GETDENTS selects readdir() at compile time.
+ *
+ * These functions use POSIX directory and file status functions; define
+ * _POSIX_C_SOURCE to 200809L or later before including any header when
+ * compiling with a strict C standard.
+ */
+#ifndef NATCMP_WALK_WORKERS
+#define NATCMP_WALK_WORKERS 4 // threads of a parallel walk
+#endif
+#ifndef NATCMP_WALK_AHEAD
+#define NATCMP_WALK_AHEAD 64 // directories read ahead of a parallel walk
+#endif
+#ifndef NATCMP_WALK_GETDENTS_SIZE
+#define NATCMP_WALK_GETDENTS_SIZE ((size_t)64 << 10) // bytes per getdents64
+#endif
+
+/**
+ * natcmp_dir_t
+ *
+ * Names of a directory in natural order.
+ */
+typedef struct {
+    char *buf;                   // type bytes and names, each NUL-terminated
+    size_t size;                 // size of buf
+    const unsigned char **names; // sorted names (point into buf)
+    size_t n;                    // number of names
+    const natcmp_allocator_t *alloc;
+} natcmp_dir_t;
+
+/**
+ * Entry types of natcmp_dir_type()
+ */
+#define NATCMP_DIR_OTHER   0 // not a directory
+#define NATCMP_DIR_DIR     1 // directory
+#define NATCMP_DIR_UNKNOWN 2 // not reported by readdir()
+
+/**
+ * natcmp_dir_type
+ *
+ * Returns the type of the i-th name of a listing as reported by readdir()
+ * (NATCMP_DIR_UNKNOWN on systems without d_type).
+ */
+static inline int natcmp_dir_type(const natcmp_dir_t *d, size_t i)
+{
+    return d->names[i][-1];
+}
+
+/**
+ * natcmp_dir_free
+ *
+ * Releases the memory of a directory listing.
+ */
+static inline void natcmp_dir_free(natcmp_dir_t *d)
+{
+    natcmp_free(d->alloc, d->buf, d->size);
+    natcmp_free(d->alloc, (void *)d->names, sizeof(*d->names) * d->n);
+    d->buf   = NULL;
+    d->names = NULL;
+    d->size  = 0;
+    d->n     = 0;
+}
+
+#if defined(DT_DIR) && defined(DT_UNKNOWN)
+// returns the NATCMP_DIR_* type of a d_type value
+static inline unsigned char natcmp_dir_dtype(unsigned char dtype)
+{
+    if (dtype == DT_UNKNOWN) {
+        return NATCMP_DIR_UNKNOWN;
+    }
+    return (dtype == DT_DIR) ? NATCMP_DIR_DIR : NATCMP_DIR_OTHER;
+}
+#endif
+
+// appends a type byte and `name` to the block of `d`, which holds `*len`
+// bytes, unless the name is "." or ".."
+static inline int natcmp_dir_add(natcmp_dir_t *d, size_t *len,
+                                 const char *name, unsigned char type)
+{
+    if (name[0] == '.' &&
+        (name[1] == 0 || (name[1] == '.' && name[2] == 0))) {
+        return 0;
+    }
+
+    size_t n = strlen(name) + 2;
+    if (d->size - *len < n) {
+        size_t size = d->size ? d->size : 4096;
+        while (size - *len < n) {
+            size *= 2;
+        }
+        char *buf = (char *)natcmp_alloc(d->alloc, size);
+        if (!buf) {
+            return -1;
+        }
+        if (*len) {
+            memcpy(buf, d->buf, *len);
+        }
+        natcmp_free(d->alloc, d->buf, d->size);
+        d->buf  = buf;
+        d->size = size;
+    }
+    d->buf[*len] = (char)type;
+    memcpy(d->buf + *len + 1, name, n - 1);
+    *len += n;
+    d->n++;
+    return 0;
+}
+
+#ifdef NATCMP_WALK_HAVE_GETDENTS
+// copies the names of the directory `path` into `d` with getdents64
+static inline int natcmp_dir_fetch(natcmp_dir_t *d, size_t *len,
+                                   const char *path)
+{
+    int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    char *batch = (char *)natcmp_alloc(d->alloc, NATCMP_WALK_GETDENTS_SIZE);
+    long got    = batch ? 1 : -1;
+    while (got > 0) {
+        got = syscall(SYS_getdents64, fd, batch, NATCMP_WALK_GETDENTS_SIZE);
+        // records of struct linux_dirent64: 64-bit inode number and offset,
+        // 16-bit record length, type byte and NUL-terminated name
+        for (long off = 0; off < got;) {
+            unsigned short reclen;
+            memcpy(&reclen, batch + off + 16, sizeof(reclen));
+            unsigned char type = (unsigned char)batch[off + 18];
+            if (natcmp_dir_add(d, len, batch + off + 19,
+                               natcmp_dir_dtype(type)) != 0) {
+                got = -1;
+                break;
+            }
+            off += reclen;
+        }
+    }
+
+    int err = errno;
+    natcmp_free(d->alloc, batch, NATCMP_WALK_GETDENTS_SIZE);
+    close(fd);
+    errno = err;
+    return (got < 0) ? -1 : 0;
+}
+#else
+// copies the names of the directory `path` into `d` with readdir()
+static inline int natcmp_dir_fetch(natcmp_dir_t *d, size_t *len,
+                                   const char *path)
+{
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return -1;
+    }
+
+    for (;;) {
+        errno            = 0;
+        struct dirent *e = readdir(dir);
+        if (!e) {
+            if (errno) {
+                break;
+            }
+            closedir(dir);
+            return 0;
+        }
+
+        unsigned char type = NATCMP_DIR_UNKNOWN;
+#if defined(DT_DIR) && defined(DT_UNKNOWN)
+        type = natcmp_dir_dtype(e->d_type);
+#endif
+        if (natcmp_dir_add(d, len, e->d_name, type) != 0) {
+            break;
+        }
+    }
+
+    int err = errno;
+    closedir(dir);
+    errno = err;
+    return -1;
+}
+#endif
+
+/**
+ * natcmp_dir_read
+ *
+ * Reads the names of the directory `path` (without "." and "..") and sorts
+ * them in natural order.
+ *
+ * @param d        Listing to initialize
+ * @param path     Path of the directory
+ * @param compare  Callback function for comparing non-digit portions
+ * @param alloc    Allocator or NULL
+ * @return int     0 on success, -1 on failure with errno set by opendir(),
+ *                 readdir() (or open() and getdents64) or to ENOMEM
+ */
+static inline int natcmp_dir_read(natcmp_dir_t *d, const char *path,
+                                  natcmp_nondigit_cmp_func_t compare,
+                                  const natcmp_allocator_t *alloc)
+{
+    size_t len = 0;
+
+    memset(d, 0, sizeof(*d));
+    d->alloc = alloc;
+
+    // copy the names into one growing block
+    if (natcmp_dir_fetch(d, &len, path) != 0) {
+        goto fail;
+    }
+
+    d->names = (const unsigned char **)natcmp_alloc_array(alloc, d->n,
+                                                         sizeof(*d->names));
+    if (!d->names) {
+        goto fail;
+    }
+    for (size_t i = 0, off = 1; i < d->n; i++) {
+        d->names[i] = (const unsigned char *)d->buf + off;
+        off += strlen(d->buf + off) + 2;
+    }
+    if (natcmp_sort_merge(d->names, d->n, compare, alloc) != 0) {
+        goto fail;
+    }
+    return 0;
+
+fail:
+    natcmp_dir_free(d);
+    return -1;
+}
+
+/**
+ * Flags of natcmp_walk_open()
+ *
+ * NATCMP_WALK_STAT      Fill the `st` field of every entry with lstat()
+ * NATCMP_WALK_PARALLEL  Read directories ahead on worker threads
+ */
+#define NATCMP_WALK_STAT     0x01
+#define NATCMP_WALK_PARALLEL 0x02
+
+/**
+ * natcmp_walk_entry_t
+ *
+ * Entry returned by natcmp_walk_next(). `path` and `name` are valid until the
+ * next call.
+ */
+typedef struct {
+    const char *path; // path of the entry (the root path, "/" and the names)
+    const char *name; // name of the entry (the last component of path)
+    size_t depth;     // 1 for the entries of the root directory
+    int isdir;        // the entry is a directory (symbolic links are not)
+    struct stat st;   // status of the entry with NATCMP_WALK_STAT
+} natcmp_walk_entry_t;
+
+/**
+ * States of a directory queued for reading ahead
+ */
+#define NATCMP_WALK_QUEUED  0 // not taken yet
+#define NATCMP_WALK_READING 1 // being read by a worker
+#define NATCMP_WALK_READ    2 // read by a worker, not entered yet
+#define NATCMP_WALK_TAKEN   3 // entered, or read by the walk itself
+
+typedef struct {
+    size_t idx;       // index of the directory in the listing of its parent
+    int state;        // NATCMP_WALK_QUEUED, ...
+    int err;          // errno value if the directory could not be read
+    natcmp_dir_t dir; // listing read by a worker
+} natcmp_walk_task_t;
+
+typedef struct {
+    natcmp_dir_t dir;          // sorted names of the directory
+    size_t next;               // index of the next name
+    size_t pathlen;            // length of the path of the directory
+    char *path;                // copy of the path for the workers
+    natcmp_walk_task_t *tasks; // subdirectories queued for the workers
+    size_t ntask;              // number of tasks
+    size_t claimed;            // tasks before this one are not queued
+    size_t entered;            // tasks before this one are passed by the walk
+} natcmp_walk_frame_t;
+
+/**
+ * natcmp_walk_t
+ *
+ * Depth-first walk in natural order. Initialize it with natcmp_walk_open()
+ * and release it with natcmp_walk_close().
+ */
+typedef struct {
+    natcmp_walk_frame_t *stack; // one frame per open directory
+    size_t depth;               // number of frames in use
+    size_t cap;                 // number of allocated frames
+    char *path;                 // path of the current entry
+    size_t pathcap;             // size of path
+    int descend;                // the last entry is a directory to enter
+    int flags;                  // NATCMP_WALK_* flags
+    natcmp_nondigit_cmp_func_t compare;
+    const natcmp_allocator_t *alloc;
+    size_t nworker; // number of running workers
+#if NATCMP_WALK_THREADS
+    pthread_t workers[NATCMP_WALK_WORKERS];
+    pthread_mutex_t lock;
+    pthread_cond_t work; // a directory was queued or entered
+    pthread_cond_t done; // a worker has read a directory
+    size_t ahead;        // directories being read or read by the workers
+    int stop;            // the workers must exit
+#endif
+} natcmp_walk_t;
+
+static inline void natcmp_walk_lock(natcmp_walk_t *w)
+{
+#if NATCMP_WALK_THREADS
+    if (w->nworker) {
+        pthread_mutex_lock(&w->lock);
+    }
+#endif
+    (void)w;
+}
+
+static inline void natcmp_walk_unlock(natcmp_walk_t *w)
+{
+#if NATCMP_WALK_THREADS
+    if (w->nworker) {
+        pthread_mutex_unlock(&w->lock);
+    }
+#endif
+    (void)w;
+}
+
+// wakes the workers up after directories were queued or taken
+static inline void natcmp_walk_wake(natcmp_walk_t *w)
+{
+#if NATCMP_WALK_THREADS
+    if (w->nworker) {
+        pthread_cond_broadcast(&w->work);
+    }
+#endif
+    (void)w;
+}
+
+// returns a new block holding dir + "/" + name
+static inline char *natcmp_walk_join(const natcmp_allocator_t *alloc,
+                                     const char *dir, const char *name,
+                                     size_t *size)
+{
+    size_t len = strlen(dir);
+    size_t n   = strlen(name);
+    char *path = (char *)natcmp_alloc(alloc, len + n + 2);
+    if (path) {
+        memcpy(path, dir, len);
+        if (len && path[len - 1] != '/') {
+            path[len++] = '/';
+        }
+        memcpy(path + len, name, n + 1);
+    }
+    *size = len + n + 2;
+    return path;
+}
+
+#if NATCMP_WALK_THREADS
+// takes the first queued directory of the deepest frame that has one
+static inline natcmp_walk_task_t *natcmp_walk_claim(natcmp_walk_t *w,
+                                                    const char **dir,
+                                                    const char **name)
+{
+    if (w->ahead >= NATCMP_WALK_AHEAD) {
+        return NULL;
+    }
+    for (size_t d = w->depth; d-- > 0;) {
+        natcmp_walk_frame_t *f = w->stack + d;
+        while (f->claimed < f->ntask &&
+               f->tasks[f->claimed].state != NATCMP_WALK_QUEUED) {
+            f->claimed++;
+        }
+        if (f->claimed < f->ntask) {
+            natcmp_walk_task_t *t = f->tasks + f->claimed++;
+            *dir                  = f->path;
+            *name                 = (const char *)f->dir.names[t->idx];
+            return t;
+        }
+    }
+    return NULL;
+}
+
+static inline void *natcmp_walk_worker(void *arg)
+{
+    natcmp_walk_t *w = (natcmp_walk_t *)arg;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        natcmp_walk_task_t *t = NULL;
+        const char *dir       = NULL;
+        const char *name      = NULL;
+        while (!w->stop && !(t = natcmp_walk_claim(w, &dir, &name))) {
+            pthread_cond_wait(&w->work, &w->lock);
+        }
+        if (w->stop) {
+            break;
+        }
+        t->state = NATCMP_WALK_READING;
+        w->ahead++;
+        pthread_mutex_unlock(&w->lock);
+
+        // the parent frame stays open while the directory is being read
+        size_t size;
+        char *path = natcmp_walk_join(w->alloc, dir, name, &size);
+        int err    = 0;
+        if (!path ||
+            natcmp_dir_read(&t->dir, path, w->compare, w->alloc) != 0) {
+            err = errno;
+        }
+        natcmp_free(w->alloc, path, size);
+
+        pthread_mutex_lock(&w->lock);
+        t->state = NATCMP_WALK_READ;
+        t->err   = err;
+        pthread_cond_broadcast(&w->done);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+#endif
+
+// queues the subdirectories of the frame `f` for the workers; the walk reads
+// them itself if this fails
+static inline void natcmp_walk_queue(natcmp_walk_t *w, natcmp_walk_frame_t *f)
+{
+    size_t ntask = 0;
+    for (size_t i = 0; i < f->dir.n; i++) {
+        ntask += (natcmp_dir_type(&f->dir, i) == NATCMP_DIR_DIR);
+    }
+    if (!w->nworker || !ntask) {
+        return;
+    }
+
+    f->path  = (char *)natcmp_alloc(w->alloc, f->pathlen + 1);
+    f->tasks = (natcmp_walk_task_t *)natcmp_alloc_array(w->alloc, ntask,
+                                                        sizeof(*f->tasks));
+    if (!f->path || !f->tasks) {
+        natcmp_free(w->alloc, f->path, f->pathlen + 1);
+        natcmp_free(w->alloc, f->tasks, sizeof(*f->tasks) * ntask);
+        f->path  = NULL;
+        f->tasks = NULL;
+        return;
+    }
+    memcpy(f->path, w->path, f->pathlen + 1);
+    memset(f->tasks, 0, sizeof(*f->tasks) * ntask);
+    for (size_t i = 0; i < f->dir.n; i++) {
+        if (natcmp_dir_type(&f->dir, i) == NATCMP_DIR_DIR) {
+            f->tasks[f->ntask++].idx = i;
+        }
+    }
+}
+
+// reads the directory at w->path into `d`, or takes it from the workers if it
+// was queued for them
+static inline int natcmp_walk_fetch(natcmp_walk_t *w, natcmp_dir_t *d)
+{
+    natcmp_walk_task_t *t = NULL;
+    if (w->depth) {
+        // the directory is the last entry returned from the top frame
+        natcmp_walk_frame_t *p = w->stack + w->depth - 1;
+        size_t idx             = p->next - 1;
+        while (p->entered < p->ntask && p->tasks[p->entered].idx < idx) {
+            p->entered++;
+        }
+        if (p->entered < p->ntask && p->tasks[p->entered].idx == idx) {
+            t = p->tasks + p->entered++;
+        }
+    }
+    if (!t) {
+        return natcmp_dir_read(d, w->path, w->compare, w->alloc);
+    }
+
+    natcmp_walk_lock(w);
+    if (t->state == NATCMP_WALK_QUEUED) {
+        // no worker got to it yet
+        t->state = NATCMP_WALK_TAKEN;
+        natcmp_walk_unlock(w);
+        return natcmp_dir_read(d, w->path, w->compare, w->alloc);
+    }
+#if NATCMP_WALK_THREADS
+    while (t->state != NATCMP_WALK_READ) {
+        pthread_cond_wait(&w->done, &w->lock);
+    }
+    w->ahead--;
+#endif
+    t->state = NATCMP_WALK_TAKEN;
+    *d       = t->dir;
+    memset(&t->dir, 0, sizeof(t->dir));
+    natcmp_walk_wake(w);
+    natcmp_walk_unlock(w);
+    if (t->err) {
+        errno = t->err;
+        return -1;
+    }
+    return 0;
+}
+
+// reads the directory at w->path and pushes its frame
+static inline int natcmp_walk_push(natcmp_walk_t *w)
+{
+    if (w->depth == w->cap) {
+        size_t cap                 = w->cap ? w->cap * 2 : 16;
+        natcmp_walk_frame_t *stack = (natcmp_walk_frame_t *)
+            natcmp_alloc_array(w->alloc, cap, sizeof(*stack));
+        if (!stack) {
+            return -1;
+        }
+        natcmp_walk_lock(w);
+        if (w->depth) {
+            memcpy(stack, w->stack, sizeof(*stack) * w->depth);
+        }
+        natcmp_free(w->alloc, w->stack, sizeof(*w->stack) * w->cap);
+        w->stack = stack;
+        w->cap   = cap;
+        natcmp_walk_unlock(w);
+    }
+
+    natcmp_walk_frame_t *f = w->stack + w->depth;
+    memset(f, 0, sizeof(*f));
+    if (natcmp_walk_fetch(w, &f->dir) != 0) {
+        return -1;
+    }
+    f->next    = 0;
+    f->pathlen = strlen(w->path);
+    natcmp_walk_queue(w, f);
+
+    natcmp_walk_lock(w);
+    w->depth++;
+    natcmp_walk_wake(w);
+    natcmp_walk_unlock(w);
+    return 0;
+}
+
+// pops the top frame, once no worker reads any of its subdirectories
+static inline void natcmp_walk_pop(natcmp_walk_t *w)
+{
+    natcmp_walk_lock(w);
+    natcmp_walk_frame_t *f = w->stack + --w->depth;
+    for (size_t i = 0; i < f->ntask; i++) {
+        natcmp_walk_task_t *t = f->tasks + i;
+#if NATCMP_WALK_THREADS
+        while (t->state == NATCMP_WALK_READING) {
+            pthread_cond_wait(&w->done, &w->lock);
+        }
+        if (t->state == NATCMP_WALK_READ) {
+            // read ahead but never entered
+            w->ahead--;
+        }
+#endif
+        natcmp_dir_free(&t->dir);
+    }
+    natcmp_walk_wake(w);
+    natcmp_walk_unlock(w);
+
+    natcmp_free(w->alloc, f->tasks, sizeof(*f->tasks) * f->ntask);
+    natcmp_free(w->alloc, f->path, f->pathlen + 1);
+    natcmp_dir_free(&f->dir);
+}
+
+/**
+ * natcmp_walk_close
+ *
+ * Releases the memory of a walk and stops its workers.
+ */
+static inline void natcmp_walk_close(natcmp_walk_t *w)
+{
+#if NATCMP_WALK_THREADS
+    if (w->nworker) {
+        pthread_mutex_lock(&w->lock);
+        w->stop = 1;
+        pthread_cond_broadcast(&w->work);
+        pthread_mutex_unlock(&w->lock);
+        for (size_t i = 0; i < w->nworker; i++) {
+            pthread_join(w->workers[i], NULL);
+        }
+        pthread_cond_destroy(&w->done);
+        pthread_cond_destroy(&w->work);
+        pthread_mutex_destroy(&w->lock);
+        w->nworker = 0;
+    }
+#endif
+    while (w->depth) {
+        natcmp_walk_pop(w);
+    }
+    natcmp_free(w->alloc, w->stack, sizeof(*w->stack) * w->cap);
+    natcmp_free(w->alloc, w->path, w->pathcap);
+    w->stack   = NULL;
+    w->path    = NULL;
+    w->cap     = 0;
+    w->pathcap = 0;
+}
+
+// sets the path of the walk to path[0..len) + "/" + name
+static inline int natcmp_walk_set_path(natcmp_walk_t *w, size_t len,
+                                       const char *name)
+{
+    size_t n = strlen(name);
+    if (w->pathcap < len + n + 2) {
+        size_t cap = w->pathcap ? w->pathcap : 256;
+        while (cap < len + n + 2) {
+            cap *= 2;
+        }
+        char *path = (char *)natcmp_alloc(w->alloc, cap);
+        if (!path) {
+            return -1;
+        }
+        if (len) {
+            memcpy(path, w->path, len);
+        }
+        natcmp_free(w->alloc, w->path, w->pathcap);
+        w->path    = path;
+        w->pathcap = cap;
+    }
+    if (len && w->path[len - 1] != '/') {
+        w->path[len++] = '/';
+    }
+    memcpy(w->path + len, name, n + 1);
+    return 0;
+}
+
+// starts the workers of a parallel walk
+static inline void natcmp_walk_start(natcmp_walk_t *w)
+{
+#if NATCMP_WALK_THREADS
+    if (pthread_mutex_init(&w->lock, NULL) != 0) {
+        return;
+    }
+    if (pthread_cond_init(&w->work, NULL) == 0) {
+        if (pthread_cond_init(&w->done, NULL) == 0) {
+            // the root is read before the workers have anything to do
+            while (w->nworker < NATCMP_WALK_WORKERS &&
+                   pthread_create(&w->workers[w->nworker], NULL,
+                                  natcmp_walk_worker, w) == 0) {
+                w->nworker++;
+            }
+            if (w->nworker) {
+                return;
+            }
+            pthread_cond_destroy(&w->done);
+        }
+        pthread_cond_destroy(&w->work);
+    }
+    pthread_mutex_destroy(&w->lock);
+#else
+    (void)w;
+#endif
+}
+
+/**
+ * natcmp_walk_open
+ *
+ * Starts a walk of the directory `root`. The root itself is not emitted.
+ *
+ * @param w        Walk to initialize
+ * @param root     Path of the root directory
+ * @param flags    NATCMP_WALK_* flags
+ * @param compare  Callback function for comparing non-digit portions
+ * @param alloc    Allocator or NULL
+ * @return int     0 on success, -1 on failure with errno set
+ */
+static inline int natcmp_walk_open(natcmp_walk_t *w, const char *root,
+                                   int flags,
+                                   natcmp_nondigit_cmp_func_t compare,
+                                   const natcmp_allocator_t *alloc)
+{
+    memset(w, 0, sizeof(*w));
+    w->flags   = flags;
+    w->compare = compare;
+    w->alloc   = alloc;
+    if (flags & NATCMP_WALK_PARALLEL) {
+        natcmp_walk_start(w);
+    }
+    if (natcmp_walk_set_path(w, 0, root) != 0 || natcmp_walk_push(w) != 0) {
+        int err = errno;
+        natcmp_walk_close(w);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * natcmp_walk_next
+ *
+ * Returns the next entry of the walk.
+ *
+ * @param w     Walk
+ * @param e     Output parameter to store the entry
+ * @return int  1 if an entry was returned, 0 at the end of the walk, -1 if a
+ *              directory could not be read (errno is set and w->path holds
+ *              its path); the walk goes on past it on the next call
+ */
+static inline int natcmp_walk_next(natcmp_walk_t *w, natcmp_walk_entry_t *e)
+{
+    if (w->descend) {
+        // enter the directory returned by the previous call
+        w->descend = 0;
+        if (natcmp_walk_push(w) != 0) {
+            return -1;
+        }
+    }
+
+    while (w->depth) {
+        natcmp_walk_frame_t *f = w->stack + w->depth - 1;
+        if (f->next == f->dir.n) {
+            natcmp_walk_pop(w);
+            continue;
+        }
+
+        int type         = natcmp_dir_type(&f->dir, f->next);
+        const char *name = (const char *)f->dir.names[f->next++];
+        if (natcmp_walk_set_path(w, f->pathlen, name) != 0) {
+            return -1;
+        }
+        memset(e, 0, sizeof(*e));
+        e->path  = w->path;
+        e->name  = w->path + strlen(w->path) - strlen(name);
+        e->depth = w->depth;
+        e->isdir = (type == NATCMP_DIR_DIR);
+        if ((w->flags & NATCMP_WALK_STAT) || type == NATCMP_DIR_UNKNOWN) {
+            // stat only when asked to or when readdir() did not tell
+            if (lstat(w->path, &e->st) == 0) {
+                e->isdir = S_ISDIR(e->st.st_mode);
+            }
+        }
+        w->descend = e->isdir;
+        return 1;
+    }
+    return 0;
+}
+
+#endif /* natcmp_walk_h */
@@ -62,6 +62,10 @@ static int strcmp_cb(const unsigned char *a, const unsigned char *b,
 #define assert_natcmp_null(a, b, op, expected)                                 \
     assert_natcmp_ex(NULL, a, b, op, expected)
 
+// 大文字小文字を区別する組み込み関数用のマクロ
+#define assert_natcmp_bytes(a, b, op, expected)                                \
+    assert_natcmp_ex(natcmp_nondigit_cmp_bytes, a, b, op, expected)
+
 // 便宜的なマクロ（カスタムコールバック用）
 #define assert_natcmp_eq(a, b) assert_natcmp(a, b, ==, 0)
 #define assert_natcmp_lt(a, b) assert_natcmp(a, b, <, 0)
@@ -77,6 +81,40 @@ static int strcmp_cb(const unsigned char *a, const unsigned char *b,
 #define assert_natcmp_null_lt(a, b) assert_natcmp_null(a, b, <, 0)
 #define assert_natcmp_null_gt(a, b) assert_natcmp_null(a, b, >, 0)
 
+// natcmp_total用のマクロ
+#define assert_natcmp_total(a, b, op, expected)                                \
+    do {                                                                       \
+        total_tests++;                                                         \
+        int actual = natcmp_total((const unsigned char *)(a),                  \
+                                  (const unsigned char *)(b), NULL);           \
+        if (actual op expected) {                                              \
+            passed_tests++;                                                    \
+            printf("    PASS: natcmp_total(\"%s\", \"%s\") %s %d\n", a, b,     \
+                   #op, expected);                                             \
+        } else {                                                               \
+            printf("    FAIL: natcmp_total(\"%s\", \"%s\") = %d %s %d\n", a,  \
+                   b, actual, #op, expected);                                  \
+            assert(actual op expected);                                        \
+        }                                                                      \
+    } while (0)
+
+// natcmp_ex用のマクロ（数字列のコールバックを指定）
+#define assert_natcmp_digit(dcmpfn, a, b, op, expected)                        \
+    do {                                                                       \
+        total_tests++;                                                         \
+        int actual = natcmp_ex((const unsigned char *)(a),                     \
+                               (const unsigned char *)(b), NULL, dcmpfn);      \
+        if (actual op expected) {                                              \
+            passed_tests++;                                                    \
+            printf("    PASS: natcmp_ex(\"%s\", \"%s\", %s) %s %d\n", a, b,    \
+                   #dcmpfn, #op, expected);                                    \
+        } else {                                                               \
+            printf("    FAIL: natcmp_ex(\"%s\", \"%s\", %s) = %d %s %d\n", a, \
+                   b, #dcmpfn, actual, #op, expected);                         \
+            assert(actual op expected);                                        \
+        }                                                                      \
+    } while (0)
+
 // Test basic comparisons with custom callback
 static void test_basic_comparison(void)
 {
@@ -266,6 +304,269 @@ static void test_null_callback(void)
     assert_natcmp_null_gt("file002.txt", "file02.txt");
 }
 
+// Test natcmp_total (natural order with byte order tie-break)
+static void test_total_order(void)
+{
+    TEST_SECTION("Total Order (natcmp_total)");
+
+    printf("  Natural order is kept:\n");
+    assert_natcmp_total("file2.txt", "file10.txt", <, 0);
+    assert_natcmp_total("File10.txt", "file2.txt", >, 0);
+    assert_natcmp_total("file02.txt", "file002.txt", <, 0);
+
+    printf("\n  Case differences are ordered by bytes:\n");
+    assert_natcmp_total("File2", "file2", <, 0);
+    assert_natcmp_total("file2", "File2", >, 0);
+    assert_natcmp_total("fILE2", "File2", >, 0);
+
+    printf("\n  Only identical strings are equal:\n");
+    assert_natcmp_total("file2", "file2", ==, 0);
+    assert_natcmp_total("", "", ==, 0);
+}
+
+// numbers in descending order, through the digit-run hook
+static int digit_cmp_desc(const unsigned char *a, const unsigned char *b,
+                          unsigned char **end_a, unsigned char **end_b)
+{
+    return -natcmp_digit_cmp(a, b, end_a, end_b);
+}
+
+// a hook that returns any negative or positive value, not only -1 and 1
+static int digit_cmp_by_seven(const unsigned char *a, const unsigned char *b,
+                              unsigned char **end_a, unsigned char **end_b)
+{
+    return 7 * natcmp_digit_cmp(a, b, end_a, end_b);
+}
+
+// Test the digit-run callbacks of natcmp_ex
+static void test_digit_callbacks(void)
+{
+    TEST_SECTION("Digit-Run Callbacks (natcmp_ex)");
+
+    printf("  natcmp_ex with the defaults matches natcmp:\n");
+    static const char *list[] = {"",      "0",    "00",    "007", "7",
+                                 "a",     "A1",   "a01",   "a1b", "a10",
+                                 "v1.02", "v1.2", "x9y10", "x09y9"};
+    size_t n                  = sizeof(list) / sizeof(list[0]);
+    int same                  = 1;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            const unsigned char *a = (const unsigned char *)list[i];
+            const unsigned char *b = (const unsigned char *)list[j];
+            int expected           = natcmp(a, b, NULL);
+            if (natcmp_ex(a, b, NULL, NULL) != expected ||
+                natcmp_ex(a, b, natcmp_nondigit_cmp_ascii, natcmp_digit_cmp) !=
+                    expected) {
+                same = 0;
+            }
+        }
+    }
+    total_tests++;
+    passed_tests += same;
+    printf("    %s: %zu x %zu pairs\n", same ? "PASS" : "FAIL", n, n);
+    assert(same);
+
+    printf("\n  Value only (natcmp_digit_cmp_value):\n");
+    assert_natcmp_digit(natcmp_digit_cmp_value, "file007", "file7", ==, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_value, "a07b", "a7c", <, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_value, "x000", "x0", ==, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_value, "x10", "x9", >, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_value, "x010", "x9", >, 0);
+
+    printf("\n  Leading zeros first (natcmp_digit_cmp_zeros_first):\n");
+    assert_natcmp_digit(natcmp_digit_cmp_zeros_first, "v007", "v07", <, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_zeros_first, "v07", "v7", <, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_zeros_first, "v08", "v7", >, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_zeros_first, "v7a", "v07b", >, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_zeros_first, "v7", "v7", ==, 0);
+
+    printf("\n  Hexadecimal runs (natcmp_digit_cmp_hex):\n");
+    assert_natcmp_digit(natcmp_digit_cmp_hex, "id1f", "id9", >, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_hex, "id0a", "id9", >, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_hex, "obj_1F", "obj_1f", ==, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_hex, "0x1f", "0x20", <, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_hex, "3a.log", "3b.log", <, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_hex, "0ff", "ff", <, 0);
+    assert_natcmp_digit(natcmp_digit_cmp_hex, "00ff", "0ff", >, 0);
+
+    printf("\n  Custom callback:\n");
+    assert_natcmp_digit(digit_cmp_desc, "file2", "file10", >, 0);
+    assert_natcmp_digit(digit_cmp_desc, "file10", "file10", ==, 0);
+    assert_natcmp_digit(digit_cmp_desc, "a1", "b2", <, 0);
+
+    printf("\n  Callback results are normalized to -1 and 1:\n");
+    assert_natcmp_digit(digit_cmp_by_seven, "file2", "file10", ==, -1);
+    assert_natcmp_digit(digit_cmp_by_seven, "file10", "file2", ==, 1);
+    assert_natcmp_digit(digit_cmp_by_seven, "file01", "file1", ==, 1);
+    assert_natcmp_digit(digit_cmp_by_seven, "file7", "file7", ==, 0);
+}
+
+// Test the case-sensitive built-in callback and natcmp_bytes
+static void test_bytes_function(void)
+{
+    TEST_SECTION("Using natcmp_nondigit_cmp_bytes and natcmp_bytes");
+
+    printf("  Case-sensitive comparison:\n");
+    assert_natcmp_bytes("abc", "abc", ==, 0);
+    assert_natcmp_bytes("ABC", "abc", <, 0);
+    assert_natcmp_bytes("abc", "abd", <, 0);
+    assert_natcmp_bytes("abc", "abcd", <, 0);
+    assert_natcmp_bytes("abc1", "abcd", <, 0);
+
+    printf("\n  Numbers:\n");
+    assert_natcmp_bytes("file2.txt", "file10.txt", <, 0);
+    assert_natcmp_bytes("File10.txt", "file2.txt", <, 0);
+    assert_natcmp_bytes("file02.txt", "file002.txt", <, 0);
+    assert_natcmp_bytes("1abc", "abc", <, 0);
+    assert_natcmp_bytes("abc", "abc123", <, 0);
+
+    printf("\n  natcmp_bytes matches natcmp with natcmp_nondigit_cmp_bytes:\n");
+    static const char *list[] = {
+        "",
+        "a",
+        "A",
+        "abc",
+        "abc1",
+        "abc12",
+        "abc012",
+        "abc0012",
+        "abc13",
+        "abc123xyz",
+        "abc123xyZ",
+        "abcd",
+        "1abc",
+        "10",
+        "9",
+        "file2.txt",
+        "File2.txt",
+        "file10.txt",
+        "a long shared prefix 123456789 and more text",
+        "a long shared prefix 123456790 and more text",
+        "a long shared prefix 0123456789 and more text",
+        "a long shared prefix 123456789 and more texts",
+    };
+    size_t n        = sizeof(list) / sizeof(list[0]);
+    size_t mismatch = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            const unsigned char *a = (const unsigned char *)list[i];
+            const unsigned char *b = (const unsigned char *)list[j];
+            int expected           = natcmp(a, b, natcmp_nondigit_cmp_bytes);
+            int actual             = natcmp_bytes(a, b);
+            if (expected != actual) {
+                printf("    MISMATCH: natcmp_bytes(\"%s\", \"%s\") = %d, "
+                       "expected %d\n",
+                       list[i], list[j], actual, expected);
+                mismatch++;
+            }
+        }
+    }
+    total_tests++;
+    if (mismatch == 0) {
+        passed_tests++;
+        printf("    PASS: %zu pairs\n", n * n);
+    } else {
+        printf("    FAIL: %zu mismatches\n", mismatch);
+        assert(mismatch == 0);
+    }
+}
+
+// Test that natcmp_dfa gives the same results as natcmp with NULL callback
+static void test_dfa_function(void)
+{
+    TEST_SECTION("Using natcmp_dfa");
+
+    static const char *list[] = {
+        "",
+        "a",
+        "A",
+        "abc",
+        "ABC",
+        "abd",
+        "abcd",
+        "abc1",
+        "abc123",
+        "abc123xyz",
+        "1abc",
+        "0",
+        "00",
+        "000",
+        "01",
+        "1",
+        "2",
+        "10",
+        "010",
+        "0010",
+        "file",
+        "file1",
+        "file2.txt",
+        "File2.txt",
+        "file02.txt",
+        "file002.txt",
+        "file10.txt",
+        "file123.txt",
+        "file456.txt",
+        "file12",
+        "x0y",
+        "x00y",
+        "x0",
+        "1.2.10",
+        "1.2.9",
+        "[a]",
+        "_a",
+        "Zebra",
+        "apple",
+        "\x80\xff",
+    };
+    size_t n        = sizeof(list) / sizeof(list[0]);
+    size_t mismatch = 0;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            const unsigned char *a = (const unsigned char *)list[i];
+            const unsigned char *b = (const unsigned char *)list[j];
+            if (natcmp_dfa(a, b) != natcmp(a, b, NULL)) {
+                printf("    MISMATCH: natcmp_dfa(\"%s\", \"%s\") = %d, "
+                       "expected %d\n",
+                       list[i], list[j], natcmp_dfa(a, b), natcmp(a, b, NULL));
+                mismatch++;
+            }
+        }
+    }
+
+    // random strings over a small alphabet to hit every transition
+    static const char alphabet[] = "0019aAbB.";
+    unsigned int seed            = 12345;
+    for (int k = 0; k < 100000; k++) {
+        char sa[12];
+        char sb[12];
+        for (int m = 0; m < 2; m++) {
+            char *p    = m ? sb : sa;
+            seed       = seed * 1103515245u + 12345u;
+            size_t len = (seed >> 16) % 11;
+            for (size_t l = 0; l < len; l++) {
+                seed = seed * 1103515245u + 12345u;
+                p[l] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+            }
+            p[len] = 0;
+        }
+        if (natcmp_dfa((const unsigned char *)sa, (const unsigned char *)sb) !=
+            natcmp((const unsigned char *)sa, (const unsigned char *)sb,
+                   NULL)) {
+            printf("    MISMATCH: natcmp_dfa(\"%s\", \"%s\")\n", sa, sb);
+            mismatch++;
+        }
+    }
+
+    total_tests++;
+    if (mismatch == 0) {
+        passed_tests++;
+        printf("    PASS: %zu pairs and 100000 random pairs\n", n * n);
+    } else {
+        printf("    FAIL: %zu mismatches\n", mismatch);
+        assert(mismatch == 0);
+    }
+}
+
 int main(void)
 {
     printf("=== NATCMP TEST SUITE ===\n");
@@ -278,6 +579,10 @@ int main(void)
     test_common_cases();
     test_string_length_edge_cases();
     test_null_callback(); // 追加
+    test_total_order();
+    test_digit_callbacks();
+    test_bytes_function();
+    test_dfa_function();
 
     // Summary
     printf("\n=== TEST SUMMARY ===\n");
@@ -0,0 +1,128 @@
+#include "../src/natcmp_alloc.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+// Test the default allocator
+static void test_default_allocator(void)
+{
+    TEST_SECTION("Default Allocator");
+
+    void *ptr = natcmp_alloc(NULL, 64);
+    assert_true(ptr != NULL);
+    natcmp_free(NULL, ptr, 64);
+
+    printf("\n  Zero-sized and NULL blocks:\n");
+    ptr = natcmp_alloc(NULL, 0);
+    assert_true(ptr != NULL);
+    natcmp_free(NULL, ptr, 0);
+    natcmp_free(NULL, NULL, 0);
+    assert_true(1);
+
+    printf("\n  Array size overflow:\n");
+    errno = 0;
+    assert_true(natcmp_alloc_array(NULL, (size_t)-1, 2) == NULL);
+    assert_true(errno == ENOMEM);
+}
+
+// Test the accounting allocator
+static void test_stats_allocator(void)
+{
+    TEST_SECTION("Accounting Allocator");
+
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a = natcmp_allocator_stats(&st, NULL);
+
+    void *p1 = natcmp_alloc(&a, 100);
+    void *p2 = natcmp_alloc_array(&a, 10, 30);
+    assert_true(p1 != NULL && p2 != NULL);
+    assert_true(st.nalloc == 2);
+    assert_true(st.allocated == 400);
+    assert_true(st.current == 400);
+
+    natcmp_free(&a, p1, 100);
+    assert_true(st.nfree == 1);
+    assert_true(st.current == 300);
+
+    void *p3 = natcmp_alloc(&a, 50);
+    assert_true(st.allocated == 450);
+    assert_true(st.peak == 400);
+
+    natcmp_free(&a, p2, 300);
+    natcmp_free(&a, p3, 50);
+    assert_true(st.current == 0);
+    assert_true(st.nfree == 3);
+
+    printf("\n  Forwarding to a failing allocator:\n");
+    natcmp_alloc_fail_t failing;
+    natcmp_allocator_t fail = natcmp_allocator_failing(&failing, 0, NULL);
+    a                       = natcmp_allocator_stats(&st, &fail);
+    errno                   = 0;
+    assert_true(natcmp_alloc(&a, 10) == NULL);
+    assert_true(errno == ENOMEM);
+    assert_true(st.nalloc == 0 && st.allocated == 0);
+}
+
+// Test the failing allocator
+static void test_failing_allocator(void)
+{
+    TEST_SECTION("Failing Allocator");
+
+    natcmp_alloc_stats_t st;
+    natcmp_alloc_fail_t failing;
+    natcmp_allocator_t parent = natcmp_allocator_stats(&st, NULL);
+    natcmp_allocator_t a      = natcmp_allocator_failing(&failing, 2, &parent);
+
+    void *p1 = natcmp_alloc(&a, 100);
+    void *p2 = natcmp_alloc(&a, 200);
+    assert_true(p1 != NULL && p2 != NULL);
+    errno = 0;
+    assert_true(natcmp_alloc(&a, 300) == NULL);
+    assert_true(errno == ENOMEM);
+    assert_true(failing.left == 0 && st.nalloc == 2);
+
+    natcmp_free(&a, p1, 100);
+    natcmp_free(&a, p2, 200);
+    assert_true(st.current == 0 && st.nfree == 2);
+}
+
+int main(void)
+{
+    printf("=== NATCMP ALLOC TEST SUITE ===\n");
+
+    test_default_allocator();
+    test_stats_allocator();
+    test_failing_allocator();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,296 @@
+#include "../src/natcmp_anon.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define NNAME 2000
+
+static char names[NNAME][48];
+static unsigned char outs[NNAME][48];
+
+static size_t lcp(const void *a, const void *b)
+{
+    const unsigned char *p = (const unsigned char *)a;
+    const unsigned char *q = (const unsigned char *)b;
+    size_t n               = 0;
+    while (p[n] && tolower(p[n]) == tolower(q[n])) {
+        n++;
+    }
+    return n;
+}
+
+// returns 1 if a and b only differ in their numbers
+static int same_text(const char *a, const char *b)
+{
+    for (;;) {
+        while (isdigit((unsigned char)*a) && isdigit((unsigned char)*b)) {
+            while (isdigit((unsigned char)*a)) {
+                a++;
+            }
+            while (isdigit((unsigned char)*b)) {
+                b++;
+            }
+        }
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b) ||
+            isdigit((unsigned char)*a)) {
+            return 0;
+        } else if (!*a) {
+            return 1;
+        }
+        a++;
+        b++;
+    }
+}
+
+static int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+// generates names mixing words, numbers of many lengths and leading zeros
+static void gen_names(void)
+{
+    static const char *words[] = {"report", "Report", "rep", "img_", "IMG_",
+                                  "data.", "v",      "x-y", "frame"};
+    uint64_t st = 5;
+    for (size_t i = 0; i < NNAME; i++) {
+        uint64_t r = natcmp_anon_rand(&st);
+        snprintf(names[i], sizeof(names[i]), "%s%0*llu.%s%llu",
+                 words[r % 9], (int)(r >> 8) % 6,
+                 (unsigned long long)((r >> 16) % 100000),
+                 words[(r >> 40) % 9],
+                 (unsigned long long)(natcmp_anon_rand(&st) >>
+                                      (r >> 58)));
+    }
+}
+
+static natcmp_anon_t anon(uint64_t seed, const natcmp_allocator_t *alloc)
+{
+    natcmp_anon_t an;
+    natcmp_anon_init(&an, seed, alloc);
+    for (size_t i = 0; i < NNAME; i++) {
+        assert(natcmp_anon_add(&an, (const unsigned char *)names[i]) == 0);
+    }
+    assert(natcmp_anon_build(&an) == 0);
+    return an;
+}
+
+// Test that the shape of every name is kept
+static void test_shape(void)
+{
+    TEST_SECTION("Shape");
+
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a = natcmp_allocator_stats(&st, NULL);
+    natcmp_anon_t an     = anon(42, &a);
+    int ok               = 1;
+    int changed          = 0;
+
+    for (size_t i = 0; i < NNAME; i++) {
+        const unsigned char *in = (const unsigned char *)names[i];
+        ok &= natcmp_anon_apply(&an, in, outs[i]) == 0;
+        ok &= strlen((const char *)outs[i]) == strlen(names[i]);
+        for (size_t k = 0; in[k]; k++) {
+            unsigned char c = in[k];
+            unsigned char d = outs[i][k];
+            if (isupper(c)) {
+                ok &= isupper(d) != 0;
+            } else if (islower(c)) {
+                ok &= islower(d) != 0;
+            } else if (isdigit(c)) {
+                ok &= isdigit(d) != 0;
+            } else {
+                ok &= c == d;
+            }
+            changed += c != d;
+        }
+    }
+    assert_true(ok);
+    assert_true(changed > NNAME * 5);
+
+    // digit runs keep their length and leading zeros
+    ok = 1;
+    for (size_t i = 0; i < NNAME; i++) {
+        const unsigned char *p = (const unsigned char *)names[i];
+        const unsigned char *q = outs[i];
+        for (size_t k = 0; p[k];) {
+            size_t nz1, nz2;
+            if (!isdigit(p[k])) {
+                k++;
+                continue;
+            }
+            size_t l1 = natcmp_anon_run(p + k, &nz1);
+            size_t l2 = natcmp_anon_run(q + k, &nz2);
+            ok &= l1 == l2 && nz1 == nz2;
+            k += l1;
+        }
+    }
+    assert_true(ok);
+    printf("  e.g. \"%s\" -> \"%s\"\n", names[0], outs[0]);
+    printf("  e.g. \"%s\" -> \"%s\"\n", names[1], outs[1]);
+
+    printf("\n  Leading zeros and zero runs:\n");
+    natcmp_anon_t b;
+    unsigned char out[32];
+    natcmp_anon_init(&b, 1, NULL);
+    assert_true(natcmp_anon_add(&b, (const unsigned char *)"a007b000c") == 0);
+    assert_true(natcmp_anon_build(&b) == 0);
+    assert_true(natcmp_anon_apply(&b, (const unsigned char *)"a007b000c",
+                                  out) == 0);
+    assert_true(memcmp(out + 1, "00", 2) == 0 && out[3] != '0');
+    assert_true(memcmp(out + 5, "000", 3) == 0);
+    assert_true(natcmp_anon_apply(&b, (const unsigned char *)"a8", out) ==
+                    -1 &&
+                errno == EINVAL);
+    natcmp_anon_free(&b);
+
+    natcmp_anon_free(&an);
+    assert_true(st.current == 0);
+}
+
+// Test that comparisons walk as far and end the same way
+static void test_order(void)
+{
+    TEST_SECTION("Order");
+
+    natcmp_anon_t an = anon(7, NULL);
+    int same_lcp     = 1;
+    int same_sign    = 1;
+    int same_equal   = 1;
+    size_t tested    = 0;
+
+    for (size_t i = 0; i < NNAME; i++) {
+        natcmp_anon_apply(&an, (const unsigned char *)names[i], outs[i]);
+    }
+    for (size_t i = 0; i < NNAME; i++) {
+        for (size_t j = i + 1; j < NNAME; j++) {
+            size_t l = lcp(names[i], names[j]);
+            int ci   = natcmp((const unsigned char *)names[i],
+                              (const unsigned char *)names[j], NULL);
+            int co   = natcmp(outs[i], outs[j], NULL);
+            // the prefix is kept up to a first difference outside numbers
+            if (!isdigit((unsigned char)names[i][l]) &&
+                !isdigit((unsigned char)names[j][l])) {
+                same_lcp &= lcp(outs[i], outs[j]) == l;
+            }
+            same_equal &= (ci == 0) == (co == 0);
+            // names differing in numbers only keep their order
+            if (same_text(names[i], names[j])) {
+                same_sign &= sign(ci) == sign(co);
+                tested++;
+            }
+        }
+    }
+    printf("  %zu pairs differing in numbers only\n", tested);
+    assert_true(same_lcp);
+    assert_true(same_equal);
+    assert_true(same_sign && tested > 0);
+
+    printf("\n  Numbers of every length keep their order:\n");
+    static const char *nums[] = {
+        "1",        "2",        "9",
+        "10",       "11",       "99",
+        "100",      "12345678", "12345679",
+        "99999999999999999999", "100000000000000000000",
+    };
+    const size_t n = sizeof(nums) / sizeof(nums[0]);
+    natcmp_anon_t b;
+    unsigned char o[sizeof(nums) / sizeof(nums[0])][32];
+    int ordered = 1;
+    natcmp_anon_init(&b, 3, NULL);
+    for (size_t i = 0; i < n; i++) {
+        natcmp_anon_add(&b, (const unsigned char *)nums[i]);
+    }
+    assert_true(natcmp_anon_build(&b) == 0);
+    for (size_t i = 0; i < n; i++) {
+        natcmp_anon_apply(&b, (const unsigned char *)nums[i], o[i]);
+        ordered &= !i || natcmp(o[i - 1], o[i], NULL) < 0;
+        ordered &= strlen((const char *)o[i]) == strlen(nums[i]);
+    }
+    assert_true(ordered);
+    natcmp_anon_free(&b);
+    natcmp_anon_free(&an);
+}
+
+// Test case-insensitive equality and determinism
+static void test_consistency(void)
+{
+    TEST_SECTION("Consistency");
+
+    static const char *pair[] = {"File10.TXT", "file10.txt"};
+    unsigned char a1[16], a2[16], b1[16];
+    natcmp_anon_t a, b;
+
+    natcmp_anon_init(&a, 9, NULL);
+    natcmp_anon_init(&b, 10, NULL);
+    for (size_t i = 0; i < 2; i++) {
+        natcmp_anon_add(&a, (const unsigned char *)pair[i]);
+        natcmp_anon_add(&b, (const unsigned char *)pair[i]);
+    }
+    assert_true(natcmp_anon_build(&a) == 0 && natcmp_anon_build(&b) == 0);
+    natcmp_anon_apply(&a, (const unsigned char *)pair[0], a1);
+    natcmp_anon_apply(&a, (const unsigned char *)pair[1], a2);
+    natcmp_anon_apply(&b, (const unsigned char *)pair[0], b1);
+    assert_true(strcasecmp((const char *)a1, (const char *)a2) == 0);
+    assert_true(natcmp(a1, a2, NULL) == 0);
+    assert_true(isupper(a1[0]) && islower(a2[0]));
+    assert_true(strcmp((const char *)a1, (const char *)b1) != 0);
+
+    // the result only depends on the seed and the names
+    natcmp_anon_t c = anon(42, NULL);
+    natcmp_anon_t d = anon(42, NULL);
+    int same        = 1;
+    for (size_t i = 0; i < NNAME; i++) {
+        unsigned char o1[48], o2[48];
+        natcmp_anon_apply(&c, (const unsigned char *)names[i], o1);
+        natcmp_anon_apply(&d, (const unsigned char *)names[i], o2);
+        same &= strcmp((const char *)o1, (const char *)o2) == 0;
+    }
+    assert_true(same);
+    natcmp_anon_free(&a);
+    natcmp_anon_free(&b);
+    natcmp_anon_free(&c);
+    natcmp_anon_free(&d);
+}
+
+int main(void)
+{
+    printf("=== NATCMP ANON TEST SUITE ===\n");
+
+    gen_names();
+    test_shape();
+    test_order();
+    test_consistency();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
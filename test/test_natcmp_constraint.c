@@ -0,0 +1,240 @@
+#include "../src/natcmp_constraint.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define V(s) ((const unsigned char *)(s))
+
+static int match(const char *constraint, const char *version)
+{
+    natcmp_constraint_t c;
+    if (natcmp_constraint_compile(&c, constraint, NULL, NULL) != 0) {
+        return -1;
+    }
+    int rv = natcmp_constraint_match(&c, V(version));
+    natcmp_constraint_free(&c);
+    return rv;
+}
+
+// Test parsing of constraints
+static void test_compile(void)
+{
+    TEST_SECTION("Compile");
+
+    natcmp_constraint_t c;
+    assert_true(natcmp_constraint_compile(&c, ">=1.2.10,<2.0", NULL, NULL) ==
+                0);
+    assert_true(strcmp((const char *)c.lo, "1.2.10") == 0 && c.lo_incl);
+    assert_true(strcmp((const char *)c.hi, "2.0") == 0 && !c.hi_incl);
+    natcmp_constraint_free(&c);
+
+    printf("\n  Tightest bounds are kept:\n");
+    assert_true(natcmp_constraint_compile(
+                    &c, " > 1.0 , >=1.5, <= 3 ,<3, <4, != 2, !=1.9", NULL,
+                    NULL) == 0);
+    assert_true(strcmp((const char *)c.lo, "1.5") == 0 && c.lo_incl);
+    assert_true(strcmp((const char *)c.hi, "3") == 0 && !c.hi_incl);
+    assert_true(c.nexcl == 2);
+    assert_true(strcmp((const char *)c.excl[0], "1.9") == 0);
+    natcmp_constraint_free(&c);
+
+    printf("\n  Syntax errors:\n");
+    errno = 0;
+    assert_true(natcmp_constraint_compile(&c, "", NULL, NULL) == -1);
+    assert_true(errno == EINVAL);
+    assert_true(natcmp_constraint_compile(&c, ">=1.0,", NULL, NULL) == -1);
+    assert_true(natcmp_constraint_compile(&c, ">=1.0 2.0", NULL, NULL) == -1);
+    assert_true(natcmp_constraint_compile(&c, ">>1.0", NULL, NULL) == -1);
+}
+
+// Test matching of single versions
+static void test_match(void)
+{
+    TEST_SECTION("Match");
+
+    assert_true(match(">=1.2.10,<2.0", "1.2.10") == 1);
+    assert_true(match(">=1.2.10,<2.0", "1.2.9") == 0);
+    assert_true(match(">=1.2.10,<2.0", "1.10.0") == 1);
+    assert_true(match(">=1.2.10,<2.0", "2.0") == 0);
+    assert_true(match(">=1.2.10,<2.0", "2.0.1") == 0);
+    assert_true(match(">1.0", "1.0") == 0);
+    assert_true(match(">1.0", "1.0.1") == 1);
+    assert_true(match("<=1.0", "1.0") == 1);
+    assert_true(match("1.0", "1.0") == 1);
+    assert_true(match("==1.0", "1.1") == 0);
+    assert_true(match("!=1.0", "1.0") == 0);
+    assert_true(match("!=1.0", "1.1") == 1);
+    assert_true(match(">=1.0,!=1.5,!=1.2", "1.2") == 0);
+    assert_true(match(">=1.0,!=1.5,!=1.2", "1.3") == 1);
+
+    printf("\n  Empty constraints:\n");
+    assert_true(match(">2,<1", "1.5") == 0);
+    assert_true(match(">1,<1", "1") == 0);
+    assert_true(match(">=1,<=1", "1") == 1);
+}
+
+// Test filtering of a sorted array
+static void test_filter(void)
+{
+    TEST_SECTION("Filter");
+
+    static const char *versions[] = {"0.9",   "1.0",   "1.2.9", "1.2.10",
+                                     "1.5",   "1.5",   "1.9",   "1.10",
+                                     "2.0",   "2.0.1", "10.0"};
+    const unsigned char *strs[11];
+    size_t n = sizeof(versions) / sizeof(versions[0]);
+    natcmp_range_t r[4];
+    natcmp_constraint_t c;
+
+    for (size_t i = 0; i < n; i++) {
+        strs[i] = V(versions[i]);
+    }
+
+    natcmp_constraint_compile(&c, ">=1.2.10,<2.0", NULL, NULL);
+    assert_true(natcmp_constraint_filter(&c, strs, n, r, 4) == 1);
+    assert_true(r[0].begin == 3 && r[0].end == 8);
+    natcmp_constraint_free(&c);
+
+    printf("\n  Exclusions split ranges:\n");
+    natcmp_constraint_compile(&c, ">1.0,<=2.0,!=1.5,!=1.10,!=3", NULL, NULL);
+    assert_true(natcmp_constraint_filter(&c, strs, n, r, 4) == 3);
+    assert_true(r[0].begin == 2 && r[0].end == 4);
+    assert_true(r[1].begin == 6 && r[1].end == 7);
+    assert_true(r[2].begin == 8 && r[2].end == 9);
+    assert_true(natcmp_constraint_filter(&c, strs, n, r, 1) == 3);
+    natcmp_constraint_free(&c);
+
+    printf("\n  Unbounded and empty results:\n");
+    natcmp_constraint_compile(&c, "!=0.9", NULL, NULL);
+    assert_true(natcmp_constraint_filter(&c, strs, n, r, 4) == 1);
+    assert_true(r[0].begin == 1 && r[0].end == n);
+    natcmp_constraint_free(&c);
+    natcmp_constraint_compile(&c, ">10.0", NULL, NULL);
+    assert_true(natcmp_constraint_filter(&c, strs, n, r, 4) == 0);
+    natcmp_constraint_free(&c);
+
+    printf("\n  Filter agrees with match:\n");
+    natcmp_constraint_compile(&c, ">=1.0,<10,!=1.5", NULL, NULL);
+    size_t nr = natcmp_constraint_filter(&c, strs, n, r, 4);
+    int ok    = 1;
+    for (size_t i = 0, k = 0; i < n; i++) {
+        while (k < nr && r[k].end <= i) {
+            k++;
+        }
+        int in = k < nr && r[k].begin <= i;
+        ok     = ok && (in == natcmp_constraint_match(&c, strs[i]));
+    }
+    assert_true(ok);
+    natcmp_constraint_free(&c);
+}
+
+// ASCII callback through another pointer, so the bounds are not prepared
+static int ascii_cmp(const unsigned char *a, const unsigned char *b,
+                     unsigned char **end_a, unsigned char **end_b)
+{
+    return natcmp_nondigit_cmp_ascii(a, b, end_a, end_b);
+}
+
+// Test the single-pass comparison with prepared bounds
+static void test_prepared(void)
+{
+    TEST_SECTION("Prepared Bounds");
+
+    static const char *versions[] = {
+        "",        "0",       "00",      "000.1",   "1",       "01",
+        "1.0",     "1.00",    "1.0.0",   "1.2",     "1.2.9",   "1.2.10",
+        "1.10",    "1.10rc1", "1.10RC",  "1.10-b",  "1.10.0a", "2",
+        "2.0",     "2.0.1",   "2.0a",    "10",      "v1",      "V1.2",
+        "a",       "1a",      "1a1",     "1.2.3.4", "1.2.010",
+        "99999999999999999999"};
+    static const char *constraints[] = {
+        ">=1.2.10,<2.0", ">1.0,<=2.0", ">=1,<1.10rc1", ">00,<=1.10.0a",
+        ">=v1,<V1.2.3",  "<2",         ">1.2.9",       "1.0",
+        ">=a,<1a1",      ">=1.2,<=1.2.010"};
+    size_t nv = sizeof(versions) / sizeof(versions[0]);
+    size_t nc = sizeof(constraints) / sizeof(constraints[0]);
+
+    int same     = 1;
+    int cmp_same = 1;
+    int prepared = 1;
+    for (size_t i = 0; i < nc; i++) {
+        natcmp_constraint_t c;
+        natcmp_constraint_t ref;
+        natcmp_constraint_compile(&c, constraints[i], NULL, NULL);
+        natcmp_constraint_compile(&ref, constraints[i], ascii_cmp, NULL);
+        prepared = prepared && c.runs && !ref.runs;
+        for (size_t j = 0; j < nv; j++) {
+            const unsigned char *v = V(versions[j]);
+            int res[2];
+            natcmp_constraint_cmp_bounds(&c, v, res);
+            cmp_same = cmp_same && (!c.lo || res[0] == natcmp(v, c.lo, NULL)) &&
+                       (!c.hi || res[1] == natcmp(v, c.hi, NULL));
+            same = same && natcmp_constraint_match(&c, v) ==
+                               natcmp_constraint_match(&ref, v);
+        }
+        natcmp_constraint_free(&ref);
+        natcmp_constraint_free(&c);
+    }
+    assert_true(prepared);
+    assert_true(cmp_same);
+    assert_true(same);
+}
+
+// Test allocation failures
+static void test_alloc(void)
+{
+    TEST_SECTION("Allocation failure");
+
+    natcmp_constraint_t c;
+    natcmp_alloc_fail_t failing;
+    for (size_t n = 0; n < 2; n++) {
+        natcmp_allocator_t alloc = natcmp_allocator_failing(&failing, n, NULL);
+        errno                    = 0;
+        assert_true(natcmp_constraint_compile(&c, ">=1.2.10,<2.0", NULL,
+                                              &alloc) == -1);
+        assert_true(errno == ENOMEM);
+    }
+}
+
+int main(void)
+{
+    printf("=== NATCMP CONSTRAINT TEST SUITE ===\n");
+
+    test_compile();
+    test_match();
+    test_filter();
+    test_prepared();
+    test_alloc();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,342 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/natcmp_diff.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+
+
+// writes `s` to an unlinked temporary file and returns it rewound
+static int temp_input(const char *s, size_t len)
+{
+    char path[] = "/tmp/natcmp_diff_XXXXXX";
+    int fd      = mkstemp(path);
+    if (fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    while (len > 0) {
+        ssize_t w = write(fd, s, len);
+        if (w <= 0) {
+            close(fd);
+            return -1;
+        }
+        s += w;
+        len -= (size_t)w;
+    }
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+// diffs the inputs and writes one "mask:line" per line to out
+static int run_diff(const char *const *inputs, size_t n, char *out,
+                    size_t size, natcmp_diff_t *d)
+{
+    int fds[8];
+    natcmp_diff_chunk_t c;
+    size_t len = 0;
+    int rv;
+
+    for (size_t i = 0; i < n; i++) {
+        fds[i] = temp_input(inputs[i], strlen(inputs[i]));
+    }
+    if (natcmp_diff_init(d, fds, n, NULL, NULL) != 0) {
+        return -1;
+    }
+    out[0] = 0;
+    while ((rv = natcmp_diff_next(d, &c)) == 1) {
+        const unsigned char *p = c.ptr;
+        for (size_t k = 0; k < c.count; k++) {
+            const unsigned char *nl =
+                (const unsigned char *)memchr(p, '\n', c.len);
+            len += (size_t)snprintf(out + len, size - len, "%u:%.*s\n",
+                                    (unsigned)c.mask, (int)(nl - p), p);
+            p = nl + 1;
+        }
+        if (p != c.ptr + c.len) {
+            rv = -1;
+            break;
+        }
+    }
+    natcmp_diff_free(d);
+    for (size_t i = 0; i < n; i++) {
+        close(fds[i]);
+    }
+    return rv;
+}
+
+static void test_diff(void)
+{
+    TEST_SECTION("Diff");
+    natcmp_diff_t d;
+    char out[1024];
+
+    static const char *two[] = {"a1\na2\na10\nb\n", "a2\na3\na10\nc\n"};
+    assert_true(run_diff(two, 2, out, sizeof(out), &d) == 0);
+    assert_true(strcmp(out, "1:a1\n3:a2\n2:a3\n3:a10\n1:b\n2:c\n") == 0);
+
+    printf("\n  Identical inputs:\n");
+    static const char *same[] = {"x1\nx2\nx10\n", "x1\nx2\nx10\n"};
+    assert_true(run_diff(same, 2, out, sizeof(out), &d) == 0);
+    assert_true(strcmp(out, "3:x1\n3:x2\n3:x10\n") == 0);
+    assert_true(d.ffwd == 3 && d.merged == 0);
+
+    printf("\n  Three inputs, missing newlines and an empty input:\n");
+    static const char *three[] = {"f1\nf9\nf10", "", "f9\nf10\n"};
+    assert_true(run_diff(three, 3, out, sizeof(out), &d) == 0);
+    assert_true(strcmp(out, "1:f1\n5:f9\n5:f10\n") == 0);
+
+    printf("\n  Lines that differ in case or leading zeros:\n");
+    static const char *ties[] = {"File2\nfile2\nv01\n", "file2\nv1\nv01\n"};
+    assert_true(run_diff(ties, 2, out, sizeof(out), &d) == 0);
+    assert_true(strcmp(out, "1:File2\n3:file2\n2:v1\n3:v01\n") == 0);
+
+    printf("\n  Case variants in a different order:\n");
+    static const char *order[] = {"File1\nfile1\nx\n", "file1\nFile1\nx\n"};
+    assert_true(run_diff(order, 2, out, sizeof(out), &d) == 0);
+    assert_true(strcmp(out, "3:File1\n3:file1\n3:x\n") == 0);
+    static const char *variants[] = {"File1\nfile1\nz\n", "file1\nFILE1\n",
+                                     "FILE1\nFile1\nz\n"};
+    assert_true(run_diff(variants, 3, out, sizeof(out), &d) == 0);
+    assert_true(strcmp(out, "6:FILE1\n5:File1\n3:file1\n5:z\n") == 0);
+
+    printf("\n  One input:\n");
+    static const char *one[] = {"a\nb\n"};
+    assert_true(run_diff(one, 1, out, sizeof(out), &d) == 0);
+    assert_true(strcmp(out, "1:a\n1:b\n") == 0 && d.merged == 0);
+
+    printf("\n  Invalid arguments:\n");
+    int fds[NATCMP_DIFF_MAX + 1] = {0};
+    errno                        = 0;
+    assert_true(natcmp_diff_init(&d, fds, 0, NULL, NULL) == -1 &&
+                errno == EINVAL);
+    errno = 0;
+    assert_true(natcmp_diff_init(&d, fds, NATCMP_DIFF_MAX + 1, NULL, NULL) ==
+                    -1 &&
+                errno == EINVAL);
+}
+
+static void test_long_lines(void)
+{
+    TEST_SECTION("Lines longer than a block");
+    size_t n  = NATCMP_DIFF_BLOCK * 3;
+    char *a   = malloc(n + 16);
+    char *b   = malloc(n + 16);
+    char *out = malloc(n * 2 + 64);
+    natcmp_diff_t d;
+
+    // a shared line, then long lines that differ near their end
+    memcpy(a, "0\n", 2);
+    memset(a + 2, 'x', n);
+    memcpy(a + 2 + n, "\n", 2);
+    memcpy(b, a, n + 4);
+    a[2 + n - 8]         = 'y';
+    const char *inputs[] = {a, b};
+    assert_true(run_diff(inputs, 2, out, n * 2 + 64, &d) == 0);
+    assert_true(strlen(out) == 4 + (n + 3) * 2);
+    assert_true(strncmp(out, "3:0\n2:xxx", 9) == 0);
+    assert_true(out[4 + n + 3 + 2 + n - 8] == 'y');
+
+    free(a);
+    free(b);
+    free(out);
+}
+
+static int cmp_bytes(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+#define NVARIANTS 1024
+#define VARIANT   100
+
+static void test_long_group(void)
+{
+    TEST_SECTION("Case variants longer than a block");
+    static char pool[NVARIANTS][VARIANT + 1];
+    static const char *lines[NVARIANTS];
+    size_t size = NVARIANTS * (VARIANT + 3) + 1;
+    char *a     = malloc(size);
+    char *b     = malloc(size);
+    char *want  = malloc(size);
+    char *out   = malloc(size);
+    size_t alen = 0;
+    size_t blen = 0;
+    size_t wlen = 0;
+    natcmp_diff_t d;
+
+    // lines that natcmp() finds equal, sorted by bytes in the first input,
+    // with neighbours swapped and every fifth line missing in the second
+    for (size_t i = 0; i < NVARIANTS; i++) {
+        memset(pool[i], 'x', VARIANT);
+        for (size_t j = 0; j < 10; j++) {
+            pool[i][j] = (char)((i >> j & 1) ? 'A' + j : 'a' + j);
+        }
+        pool[i][VARIANT] = 0;
+        lines[i]         = pool[i];
+    }
+    qsort(lines, NVARIANTS, sizeof(lines[0]), cmp_bytes);
+    for (size_t i = 0; i < NVARIANTS; i++) {
+        size_t k = i ^ 1;
+        alen += (size_t)sprintf(a + alen, "%s\n", lines[i]);
+        if (k % 5) {
+            blen += (size_t)sprintf(b + blen, "%s\n", lines[k]);
+        }
+        wlen += (size_t)sprintf(want + wlen, "%d:%s\n", (i % 5) ? 3 : 1,
+                                lines[i]);
+    }
+
+    const char *inputs[] = {a, b};
+    assert_true(run_diff(inputs, 2, out, size, &d) == 0);
+    assert_true(strcmp(out, want) == 0);
+
+    free(a);
+    free(b);
+    free(want);
+    free(out);
+}
+
+static int cmp_ref(const void *a, const void *b)
+{
+    return natcmp_total(*(const unsigned char *const *)a,
+                        *(const unsigned char *const *)b, NULL);
+}
+
+#define NUNIV 60000
+
+static void test_random(void)
+{
+    TEST_SECTION("Random");
+    static const unsigned char *univ[NUNIV];
+    static char pool[NUNIV * 24];
+    static uint64_t member[NUNIV];
+    static const char *prefixes[] = {"src/a", "src/A", "lib", "img_", "v"};
+    unsigned long st = 5;
+    size_t cap       = NUNIV * 24;
+    char *inputs[3];
+    size_t lens[3] = {0};
+    int fds[3];
+    int ok = 1;
+
+    for (size_t i = 0; i < NUNIV; i++) {
+        char *s = pool + i * 24;
+        st      = st * 6364136223846793005UL + 1442695040888963407UL;
+        sprintf(s, "%s%0*lu.%s", prefixes[(st >> 33) % 5],
+                (int)((st >> 61) % 3), (st >> 36) % 100000,
+                (st >> 50) % 2 ? "c" : "h");
+        univ[i] = (const unsigned char *)s;
+    }
+    qsort(univ, NUNIV, sizeof(univ[0]), cmp_ref);
+
+    // mostly shared lines, with runs of changes
+    for (size_t k = 0; k < 3; k++) {
+        inputs[k] = malloc(cap);
+    }
+    for (size_t i = 0; i < NUNIV; i++) {
+        if (i > 0 && natcmp_total(univ[i - 1], univ[i], NULL) == 0) {
+            continue;
+        }
+        st = st * 6364136223846793005UL + 1442695040888963407UL;
+        member[i] = ((st >> 40) % 50 < 45) ? 7 : (st >> 20) % 8;
+        for (size_t k = 0; k < 3; k++) {
+            if (member[i] & ((uint64_t)1 << k)) {
+                lens[k] += (size_t)sprintf(inputs[k] + lens[k], "%s\n",
+                                           (const char *)univ[i]);
+            }
+        }
+    }
+
+    natcmp_diff_t d;
+    natcmp_diff_chunk_t c;
+    size_t i = 0;
+    for (size_t k = 0; k < 3; k++) {
+        fds[k] = temp_input(inputs[k], lens[k]);
+    }
+    assert_true(natcmp_diff_init(&d, fds, 3, NULL, NULL) == 0);
+    while (ok && natcmp_diff_next(&d, &c) == 1) {
+        const unsigned char *p = c.ptr;
+        for (size_t k = 0; k < c.count && ok; k++) {
+            const unsigned char *nl =
+                (const unsigned char *)memchr(p, '\n', c.len);
+            while (i < NUNIV && member[i] == 0) {
+                i++;
+            }
+            size_t len = strlen((const char *)univ[i]);
+            if (i == NUNIV || c.mask != member[i] || (size_t)(nl - p) != len ||
+                memcmp(p, univ[i], len) != 0) {
+                printf("    mismatch at %zu: %.*s\n", i, (int)(nl - p), p);
+                ok = 0;
+            }
+            i++;
+            p = nl + 1;
+        }
+    }
+    while (i < NUNIV && member[i] == 0) {
+        i++;
+    }
+    printf("    %zu lines merged, %zu fast-forwarded\n", d.merged, d.ffwd);
+    assert_true(ok && i == NUNIV);
+    assert_true(d.ffwd > 0);
+    natcmp_diff_free(&d);
+    for (size_t k = 0; k < 3; k++) {
+        close(fds[k]);
+        free(inputs[k]);
+    }
+}
+
+static void test_alloc(void)
+{
+    TEST_SECTION("Allocation failure");
+    natcmp_alloc_fail_t failing;
+    natcmp_allocator_t fail = natcmp_allocator_failing(&failing, 0, NULL);
+    natcmp_diff_t d;
+    int fds[2] = {0, 0};
+
+    errno = 0;
+    assert_true(natcmp_diff_init(&d, fds, 2, NULL, &fail) == -1 &&
+                errno == ENOMEM);
+    assert_true(d.n == 0);
+}
+
+int main(void)
+{
+    printf("=== NATCMP DIFF TEST SUITE ===\n");
+
+    test_diff();
+    test_long_lines();
+    test_long_group();
+    test_random();
+    test_alloc();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
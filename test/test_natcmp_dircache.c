@@ -0,0 +1,248 @@
+#define _GNU_SOURCE
+#include "../src/natcmp_dircache.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+static char root[] = "/tmp/natcmp_dircache_XXXXXX";
+
+static const char *files[] = {"file10", "file2", "File1", "file1", "a"};
+#define NFILES (sizeof(files) / sizeof(files[0]))
+
+static void touch(const char *name)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    FILE *fp = fopen(path, "w");
+    assert(fp != NULL);
+    fclose(fp);
+}
+
+static void unlink_name(const char *name)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    unlink(path);
+}
+
+// returns 1 if the names of the cache are in natcmp_total() order
+static int is_sorted(const natcmp_dircache_t *c)
+{
+    for (size_t i = 1; i < c->n; i++) {
+        if (natcmp_total(c->names[i - 1], c->names[i], c->compare) >= 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int name_is(const natcmp_dircache_t *c, size_t i, const char *name)
+{
+    return i < c->n && strcmp((const char *)c->names[i], name) == 0;
+}
+
+// Test reading of the directory
+static void test_open(void)
+{
+    TEST_SECTION("Open");
+
+    natcmp_dircache_t c;
+    assert_true(natcmp_dircache_open(&c, root, NULL, NULL) == 0);
+    assert_true(c.n == NFILES);
+    assert_true(is_sorted(&c));
+    assert_true(name_is(&c, 0, "a"));
+    assert_true(name_is(&c, 1, "File1"));
+    assert_true(name_is(&c, 2, "file1"));
+    assert_true(name_is(&c, 3, "file2"));
+    assert_true(name_is(&c, 4, "file10"));
+    natcmp_dircache_close(&c);
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/missing", root);
+    assert_true(natcmp_dircache_open(&c, path, NULL, NULL) == -1);
+}
+
+// Test incremental insertion and removal
+static void test_update(void)
+{
+    TEST_SECTION("Insert / Remove");
+
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a = natcmp_allocator_stats(&st, NULL);
+    natcmp_dircache_t c;
+    assert_true(natcmp_dircache_open(&c, root, NULL, &a) == 0);
+
+    const unsigned char *name = (const unsigned char *)"file3";
+    size_t i                  = natcmp_dircache_search(&c, name);
+    assert_true(natcmp_dircache_insert(&c, name) == 1);
+    assert_true(name_is(&c, i, "file3"));
+    assert_true(natcmp_dircache_insert(&c, name) == 0);
+    assert_true(c.n == NFILES + 1);
+    assert_true(natcmp_dircache_remove(&c, (const unsigned char *)"file4") ==
+                0);
+    assert_true(natcmp_dircache_remove(&c, (const unsigned char *)"File1") ==
+                1);
+    assert_true(natcmp_dircache_remove(&c, (const unsigned char *)"File1") ==
+                0);
+    assert_true(c.n == NFILES);
+    assert_true(is_sorted(&c));
+
+    // many insertions in random order stay sorted
+    char buf[32];
+    uint32_t x = 7;
+    int ok     = 1;
+    for (int k = 0; k < 500; k++) {
+        x = x * 1103515245u + 12345u;
+        snprintf(buf, sizeof(buf), "x%u", (unsigned)(x >> 16) % 300);
+        ok &= natcmp_dircache_insert(&c, (const unsigned char *)buf) >= 0;
+    }
+    assert_true(ok && is_sorted(&c));
+
+    natcmp_dircache_close(&c);
+    assert_true(st.current == 0);
+}
+
+// Test snapshots while the cache changes
+static void test_snapshot(void)
+{
+    TEST_SECTION("Snapshot");
+
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a = natcmp_allocator_stats(&st, NULL);
+    natcmp_dircache_t c;
+    natcmp_dircache_snapshot_t s;
+    assert_true(natcmp_dircache_open(&c, root, NULL, &a) == 0);
+    assert_true(natcmp_dircache_snapshot(&c, &s) == 0);
+    assert_true(s.n == NFILES);
+
+    for (size_t i = 0; i < NFILES; i++) {
+        natcmp_dircache_remove(&c, (const unsigned char *)files[i]);
+    }
+    natcmp_dircache_insert(&c, (const unsigned char *)"new");
+    assert_true(c.n == 1 && c.ngrave == NFILES);
+    assert_true(s.n == NFILES);
+    assert_true(strcmp((const char *)s.names[0], "a") == 0);
+    assert_true(strcmp((const char *)s.names[NFILES - 1], "file10") == 0);
+
+    natcmp_dircache_release(&c, &s);
+    assert_true(c.ngrave == 0 && c.nsnap == 0);
+
+    // reload puts back the names of the directory
+    assert_true(natcmp_dircache_reload(&c) == 0);
+    assert_true(c.n == NFILES && is_sorted(&c));
+    natcmp_dircache_close(&c);
+    assert_true(st.current == 0);
+
+    // a reload that cannot allocate leaves the cache unchanged
+    natcmp_alloc_fail_t failing;
+    natcmp_allocator_t fail = natcmp_allocator_failing(&failing, 0, &a);
+    const unsigned char **names;
+    int rv = -1;
+    int ok = 1;
+    assert_true(natcmp_dircache_open(&c, root, NULL, &fail) == -1);
+    failing.left = (size_t)-1;
+    assert_true(natcmp_dircache_open(&c, root, NULL, &fail) == 0);
+    assert_true(natcmp_dircache_snapshot(&c, &s) == 0);
+    for (size_t n = 0; rv != 0; n++) {
+        names        = c.names;
+        failing.left = n;
+        errno        = 0;
+        rv           = natcmp_dircache_reload(&c);
+        ok &= rv == 0 || (errno == ENOMEM && c.names == names &&
+                          c.n == NFILES && c.ngrave == 0);
+    }
+    assert_true(ok && c.ngrave == NFILES && is_sorted(&c));
+    natcmp_dircache_release(&c, &s);
+    natcmp_dircache_close(&c);
+    assert_true(st.current == 0);
+}
+
+#ifdef __linux__
+// Test updates from inotify
+static void test_watch(void)
+{
+    TEST_SECTION("Watch");
+
+    natcmp_dircache_t c;
+    char from[256];
+    char to[256];
+    assert_true(natcmp_dircache_open(&c, root, NULL, NULL) == 0);
+    assert_true(natcmp_dircache_update(&c) == -1 && errno == EINVAL);
+    int fd = natcmp_dircache_watch(&c);
+    assert_true(fd >= 0);
+    assert_true(natcmp_dircache_watch(&c) == fd);
+    assert_true(natcmp_dircache_update(&c) == 0);
+
+    touch("file3");
+    touch("b20");
+    assert_true(natcmp_dircache_update(&c) == 2);
+    assert_true(c.n == NFILES + 2 && is_sorted(&c));
+    assert_true(name_is(&c, 1, "b20"));
+
+    snprintf(from, sizeof(from), "%s/b20", root);
+    snprintf(to, sizeof(to), "%s/b3", root);
+    assert_true(rename(from, to) == 0);
+    unlink_name("file3");
+    assert_true(natcmp_dircache_update(&c) == 3);
+    assert_true(c.n == NFILES + 1 && is_sorted(&c));
+    assert_true(name_is(&c, 1, "b3"));
+
+    unlink_name("b3");
+    assert_true(natcmp_dircache_update(&c) == 1);
+    assert_true(c.n == NFILES);
+    natcmp_dircache_close(&c);
+    assert_true(c.fd == -1);
+}
+#endif
+
+int main(void)
+{
+    printf("=== NATCMP DIRCACHE TEST SUITE ===\n");
+
+    assert(mkdtemp(root) != NULL);
+    for (size_t i = 0; i < NFILES; i++) {
+        touch(files[i]);
+    }
+    test_open();
+    test_update();
+    test_snapshot();
+#ifdef __linux__
+    test_watch();
+#endif
+    for (size_t i = 0; i < NFILES; i++) {
+        unlink_name(files[i]);
+    }
+    rmdir(root);
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
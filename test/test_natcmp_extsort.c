@@ -0,0 +1,280 @@
+#define _GNU_SOURCE
+#include "../src/natcmp_extsort.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+static int temp_file(void)
+{
+    char path[] = "/tmp/natcmp_extsort_XXXXXX";
+    int fd      = mkstemp(path);
+    assert(fd >= 0);
+    unlink(path);
+    return fd;
+}
+
+static int file_of(const char *data, size_t len)
+{
+    int fd = temp_file();
+    assert(write(fd, data, len) == (ssize_t)len);
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+static char *contents(int fd, size_t *len)
+{
+    off_t size = lseek(fd, 0, SEEK_END);
+    char *buf  = malloc((size_t)size + 1);
+    assert(buf && pread(fd, buf, (size_t)size, 0) == size);
+    buf[size] = '\0';
+    *len      = (size_t)size;
+    return buf;
+}
+
+// generates `n` lines whose names often tie under natcmp()
+static char *gen_lines(size_t n, uint32_t seed, size_t *len)
+{
+    static const char *stems[] = {"file", "File", "img_", "v", "a.b", ""};
+    size_t cap = n * 32;
+    char *buf  = malloc(cap);
+    size_t o   = 0;
+    assert(buf);
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned r = seed >> 8;
+        o += (size_t)snprintf(buf + o, cap - o, "%s%u.%u\n", stems[r % 6],
+                              (r >> 3) % 500, (r >> 12) % 3);
+    }
+    *len = o;
+    return buf;
+}
+
+// sorts the lines of data in memory with natcmp_sort_merge()
+static char *expected_sort(const char *data, size_t len, size_t *outlen)
+{
+    char *copy                 = malloc(len + 1);
+    const unsigned char **strs = malloc(sizeof(*strs) * (len + 1));
+    char *out                  = malloc(len + 2);
+    size_t n                   = 0;
+    assert(copy && strs && out);
+    memcpy(copy, data, len);
+    copy[len] = '\0';
+    for (char *p = copy; *p;) {
+        char *nl  = strchr(p, '\n');
+        strs[n++] = (const unsigned char *)p;
+        if (!nl) {
+            break;
+        }
+        *nl = '\0';
+        p   = nl + 1;
+    }
+    natcmp_sort_merge(strs, n, NULL, NULL);
+    size_t o = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t l = strlen((const char *)strs[i]);
+        memcpy(out + o, strs[i], l);
+        out[o + l] = '\n';
+        o += l + 1;
+    }
+    free(copy);
+    free(strs);
+    *outlen = o;
+    return out;
+}
+
+// sorts data with natcmp_extsort() and compares with expected_sort()
+static int sort_matches(const char *data, size_t len, size_t memory,
+                        int ioflags, int stream)
+{
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a       = natcmp_allocator_stats(&st, NULL);
+    // the accounting allocator is not safe to share with the worker thread
+    natcmp_extsort_opts_t opts = {memory,        NULL, ioflags, NULL,
+                                  stream ? NULL : &a, stream};
+    int in                     = file_of(data, len);
+    int out                    = temp_file();
+    size_t elen, olen;
+
+    int rv       = natcmp_extsort(in, out, &opts);
+    char *expect = expected_sort(data, len, &elen);
+    char *got    = contents(out, &olen);
+    int ok = rv == 0 && elen == olen && memcmp(expect, got, elen) == 0 &&
+             st.current == 0;
+    free(expect);
+    free(got);
+    close(in);
+    close(out);
+    return ok;
+}
+
+// Test sorting in one chunk and in many runs
+static void test_sort(int ioflags)
+{
+    size_t len;
+    char *data = gen_lines(20000, 1, &len);
+
+    printf("  input: %zu bytes\n", len);
+    assert_true(sort_matches(data, len, 0, ioflags, 0));
+    assert_true(sort_matches(data, len, 64 * 1024, ioflags, 0));
+    assert_true(sort_matches(data, len, 16 * 1024, ioflags, 0));
+    assert_true(sort_matches(data, len, 1, ioflags, 0));
+    free(data);
+
+    printf("\n  Small inputs:\n");
+    assert_true(sort_matches("", 0, 0, ioflags, 0));
+    assert_true(sort_matches("\n", 1, 0, ioflags, 0));
+    assert_true(sort_matches("b10\nb9\na", 8, 0, ioflags, 0));
+    assert_true(sort_matches("x2\n\nx10\n\n", 9, 0, ioflags, 0));
+}
+
+// Test the line that is longest in a run and spans blocks when merged
+static void test_long_lines(int ioflags)
+{
+    size_t cap = 64 * 1024;
+    char *data = malloc(cap);
+    size_t o   = 0;
+    assert(data);
+    for (int i = 0; i < 40; i++) {
+        o += (size_t)snprintf(data + o, cap - o, "line%d-", 40 - i);
+        size_t l = (size_t)(i * 97) % 1500;
+        memset(data + o, 'a' + i % 26, l);
+        o += l;
+        data[o++] = '\n';
+    }
+    assert_true(sort_matches(data, o, 16 * 1024, ioflags, 0));
+
+    // a line longer than a chunk
+    natcmp_extsort_opts_t opts = {16 * 1024, NULL, ioflags, NULL, NULL, 0};
+    memset(data, 'x', 8000);
+    data[8000] = '\n';
+    int in     = file_of(data, 8001);
+    int out    = temp_file();
+    assert_true(natcmp_extsort(in, out, &opts) == -1 && errno == ENOBUFS);
+    close(in);
+    close(out);
+
+    // a NUL byte
+    in  = file_of("a\nb\0c\n", 6);
+    out = temp_file();
+    assert_true(natcmp_extsort(in, out, NULL) == -1 && errno == EINVAL);
+    close(in);
+    close(out);
+    free(data);
+}
+
+// Test sorting as a stream, in memory and through runs
+static void test_stream(int ioflags)
+{
+    size_t len;
+    char *data = gen_lines(20000, 2, &len);
+
+    assert_true(sort_matches(data, len, 0, ioflags, 1));
+    assert_true(sort_matches(data, len, 1024 * 1024, ioflags, 1));
+    assert_true(sort_matches(data, len, 64 * 1024, ioflags, 1));
+    assert_true(sort_matches(data, len, 1, ioflags, 1));
+    assert_true(sort_matches("", 0, 0, ioflags, 1));
+    assert_true(sort_matches("b10\nb9\na", 8, 0, ioflags, 1));
+
+    // lines longer than a chunk are kept whole
+    memset(data, 'y', 10000);
+    data[5000] = '\n';
+    assert_true(sort_matches(data, 10000, 1, ioflags, 1));
+    free(data);
+}
+
+// Test sorting from a pipe
+static void test_pipe(int ioflags)
+{
+    static const char data[] = "z1\nz10\nz2\nA2\na1\n";
+    natcmp_extsort_opts_t opts = {1, NULL, ioflags, NULL, NULL, 0};
+    int fds[2];
+    int out = temp_file();
+    size_t len;
+
+    assert(pipe(fds) == 0);
+    assert(write(fds[1], data, sizeof(data) - 1) == sizeof(data) - 1);
+    close(fds[1]);
+    assert_true(natcmp_extsort(fds[0], out, &opts) == 0);
+    char *got = contents(out, &len);
+    assert_true(strcmp(got, "a1\nA2\nz1\nz2\nz10\n") == 0);
+    free(got);
+    char *data2;
+    close(fds[0]);
+    close(out);
+
+    // more than the pipe holds, written by a child process
+    size_t elen;
+    data2 = gen_lines(50000, 3, &len);
+    assert(pipe(fds) == 0);
+    out       = temp_file();
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        close(fds[0]);
+        _exit(write(fds[1], data2, len) == (ssize_t)len ? 0 : 1);
+    }
+    close(fds[1]);
+    opts.memory = 256 * 1024;
+    assert_true(natcmp_extsort(fds[0], out, &opts) == 0);
+    assert_true(waitpid(pid, NULL, 0) == pid);
+    got          = contents(out, &len);
+    char *expect = expected_sort(data2, strlen(data2), &elen);
+    assert_true(len == elen && memcmp(got, expect, len) == 0);
+    free(expect);
+    free(got);
+    free(data2);
+    close(fds[0]);
+    close(out);
+}
+
+int main(void)
+{
+    static const int flags[] = {0, NATCMP_IO_NOURING};
+
+    printf("=== NATCMP EXTSORT TEST SUITE ===\n");
+
+    for (int i = 0; i < 2; i++) {
+        TEST_SECTION(i ? "Sort (sync backend)" : "Sort (default backend)");
+        test_sort(flags[i]);
+        TEST_SECTION(i ? "Long Lines (sync backend)"
+                       : "Long Lines (default backend)");
+        test_long_lines(flags[i]);
+        TEST_SECTION(i ? "Stream (sync backend)" : "Stream (default backend)");
+        test_stream(flags[i]);
+        TEST_SECTION(i ? "Pipe (sync backend)" : "Pipe (default backend)");
+        test_pipe(flags[i]);
+    }
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "../src/natcmp_filter.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define NSTR   10000
+#define NQUERY 4000
+#define V(s)   ((const unsigned char *)(s))
+
+static char names[NSTR][16];
+static const unsigned char *strs[NSTR];
+
+// "file<3i>.dat": sorted in natural order
+static void make_input(void)
+{
+    for (size_t i = 0; i < NSTR; i++) {
+        snprintf(names[i], sizeof(names[i]), "file%zu.dat", i * 3);
+        strs[i] = V(names[i]);
+    }
+}
+
+// exact answer: is a string of the input in [lo, hi]?
+static int exists(const unsigned char *lo, const unsigned char *hi)
+{
+    size_t l = 0;
+    size_t h = NSTR;
+    while (l < h) {
+        size_t mid = l + (h - l) / 2;
+        if (natcmp(strs[mid], lo, NULL) < 0) {
+            l = mid + 1;
+        } else {
+            h = mid;
+        }
+    }
+    return l < NSTR && natcmp(strs[l], hi, NULL) <= 0;
+}
+
+// runs random range queries, returns the number of false positives or -1
+// on a false negative
+static long run_queries(const natcmp_filter_t *f)
+{
+    uint32_t seed = 1;
+    long fp       = 0;
+    char lo[32];
+    char hi[32];
+
+    for (size_t i = 0; i < NQUERY; i++) {
+        seed       = seed * 1103515245u + 12345u;
+        unsigned a = (seed >> 8) % (NSTR * 3);
+        seed       = seed * 1103515245u + 12345u;
+        unsigned w = (seed >> 8) % 3;
+        if (i % 3 == 0) {
+            snprintf(lo, sizeof(lo), "file%u.dat", a);
+            snprintf(hi, sizeof(hi), "file%u.dat", a + w);
+        } else {
+            // absent names that share a long prefix with present ones
+            a -= a % 3;
+            snprintf(lo, sizeof(lo), (i % 3 == 1) ? "file%u" : "file%u.da", a);
+            memcpy(hi, lo, sizeof(hi));
+        }
+
+        int want = exists(V(lo), V(hi));
+        int got  = natcmp_filter_may_contain(f, V(lo), V(hi));
+        if (want && !got) {
+            printf("    false negative: [%s, %s]\n", lo, hi);
+            return -1;
+        }
+        fp += !want && got;
+    }
+    return fp;
+}
+
+// Test that no key is ever missed
+static void test_no_false_negatives(void)
+{
+    TEST_SECTION("No False Negatives");
+
+    natcmp_filter_t f;
+    assert_true(natcmp_filter_build(&f, strs, NSTR, 0, NULL) == 0);
+    printf("    %zu prefixes, %zu bytes (%.2f bytes/key)\n", f.n, f.len,
+           (double)f.len / NSTR);
+
+    int ok = 1;
+    for (size_t i = 0; i < NSTR; i++) {
+        ok = ok && natcmp_filter_may_contain(&f, strs[i], strs[i]);
+    }
+    assert_true(ok);
+    assert_true(run_queries(&f) >= 0);
+
+    printf("\n  Unbounded and out of range queries:\n");
+    assert_true(natcmp_filter_may_contain(&f, NULL, NULL) == 1);
+    assert_true(natcmp_filter_may_contain(&f, V("file29997.dat"), NULL) == 1);
+    assert_true(natcmp_filter_may_contain(&f, NULL, V("file0.dat")) == 1);
+    assert_true(natcmp_filter_may_contain(&f, V("file29998"), NULL) == 0);
+    assert_true(natcmp_filter_may_contain(&f, V("a"), V("b")) == 0);
+    assert_true(natcmp_filter_may_contain(&f, V("g"), NULL) == 0);
+    assert_true(natcmp_filter_may_contain(&f, V("file5.dat"), V("file1.dat")) ==
+                0);
+    natcmp_filter_free(&f);
+}
+
+// Test that extra bytes reduce false positives
+static void test_false_positive_rate(void)
+{
+    TEST_SECTION("False Positive Rate");
+
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t alloc = natcmp_allocator_stats(&st, NULL);
+    static const size_t extra[3] = {0, 3, 8};
+    long fps[3];
+    for (size_t i = 0; i < 3; i++) {
+        natcmp_filter_t f;
+        natcmp_filter_build(&f, strs, NSTR, extra[i], &alloc);
+        fps[i] = run_queries(&f);
+        printf("    extra=%zu: %zu bytes, %ld/%d false positives\n", extra[i],
+               f.len, fps[i], NQUERY);
+        natcmp_filter_free(&f);
+    }
+    assert_true(fps[0] >= 0 && fps[1] >= 0 && fps[2] >= 0);
+    assert_true(fps[2] <= fps[1] && fps[1] <= fps[0]);
+    assert_true(fps[2] < fps[0]);
+    assert_true(st.current == 0);
+}
+
+// Test duplicates, prefixes and empty input
+static void test_edge_cases(void)
+{
+    TEST_SECTION("Edge Cases");
+
+    static const char *input[] = {"", "a", "a", "A", "ab", "abc", "abc1",
+                                  "abc01", "b2", "b10"};
+    const unsigned char *s[10];
+    natcmp_filter_t f;
+
+    for (size_t i = 0; i < 10; i++) {
+        s[i] = V(input[i]);
+    }
+    assert_true(natcmp_filter_build(&f, s, 10, 0, NULL) == 0);
+    int ok = 1;
+    for (size_t i = 0; i < 10; i++) {
+        ok = ok && natcmp_filter_may_contain(&f, s[i], s[i]);
+    }
+    assert_true(ok);
+    assert_true(natcmp_filter_may_contain(&f, V("b3"), V("b9")) == 1);
+    assert_true(natcmp_filter_may_contain(&f, V("c"), NULL) == 0);
+    natcmp_filter_free(&f);
+
+    printf("\n  Empty filter:\n");
+    assert_true(natcmp_filter_build(&f, s, 0, 0, NULL) == 0);
+    assert_true(natcmp_filter_may_contain(&f, NULL, NULL) == 0);
+    natcmp_filter_free(&f);
+}
+
+int main(void)
+{
+    printf("=== NATCMP FILTER TEST SUITE ===\n");
+
+    make_input();
+    test_no_false_negatives();
+    test_false_positive_rate();
+    test_edge_cases();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+#include "../src/natcmp_io.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+static int temp_file(void)
+{
+    char path[] = "/tmp/natcmp_io_XXXXXX";
+    int fd      = mkstemp(path);
+    assert(fd >= 0);
+    unlink(path);
+    return fd;
+}
+
+// Test reads and writes at offsets with several operations in flight
+static void test_file(int flags)
+{
+    natcmp_io_t io;
+    natcmp_io_op_t w1, w2, r1, r2, r3;
+    char a[16] = {0};
+    char b[16] = {0};
+    char c[16] = {0};
+    int fd     = temp_file();
+
+    int backend = natcmp_io_init(&io, 4, flags);
+    printf("  backend: %s\n", backend == NATCMP_IO_URING ? "io_uring" : "sync");
+    if (flags & NATCMP_IO_NOURING) {
+        assert_true(backend == NATCMP_IO_SYNC);
+    }
+
+    assert_true(natcmp_io_write(&io, &w1, fd, "hello", 5, 0) == 0);
+    assert_true(natcmp_io_write(&io, &w2, fd, "world", 5, 100) == 0);
+    assert_true(natcmp_io_wait(&io, &w2) == 5);
+    assert_true(natcmp_io_write_all(&io, &w1) == 0);
+
+    assert_true(natcmp_io_read(&io, &r1, fd, a, 5, 0) == 0);
+    assert_true(natcmp_io_read(&io, &r2, fd, b, 10, 100) == 0);
+    assert_true(natcmp_io_read(&io, &r3, fd, c, 10, 200) == 0);
+    assert_true(natcmp_io_wait(&io, &r3) == 0);
+    assert_true(natcmp_io_wait(&io, &r2) == 5);
+    assert_true(natcmp_io_wait(&io, &r1) == 5);
+    assert_true(memcmp(a, "hello", 5) == 0);
+    assert_true(memcmp(b, "world", 5) == 0);
+
+    // the gap between the writes reads as zeros
+    assert_true(natcmp_io_read(&io, &r1, fd, a, 10, 50) == 0);
+    assert_true(natcmp_io_wait(&io, &r1) == 10 && a[0] == 0 && a[9] == 0);
+
+    printf("\n  Errors:\n");
+    assert_true(natcmp_io_read(&io, &r1, -1, a, 5, 0) == 0 ||
+                errno == EBADF);
+    assert_true(natcmp_io_wait(&io, &r1) == -1 && errno == EBADF);
+    natcmp_io_close(&io);
+    close(fd);
+}
+
+// Test reads and writes at the current position of a pipe
+static void test_pipe(int flags)
+{
+    natcmp_io_t io;
+    natcmp_io_op_t w, r;
+    char buf[16] = {0};
+    int fds[2];
+
+    assert(pipe(fds) == 0);
+    natcmp_io_init(&io, 4, flags);
+    assert_true(natcmp_io_write(&io, &w, fds[1], "piped", 5, -1) == 0);
+    assert_true(natcmp_io_write_all(&io, &w) == 0);
+    close(fds[1]);
+    assert_true(natcmp_io_read(&io, &r, fds[0], buf, sizeof(buf), -1) == 0);
+    assert_true(natcmp_io_wait(&io, &r) == 5);
+    assert_true(memcmp(buf, "piped", 5) == 0);
+    assert_true(natcmp_io_read(&io, &r, fds[0], buf, sizeof(buf), -1) == 0);
+    assert_true(natcmp_io_wait(&io, &r) == 0);
+    natcmp_io_close(&io);
+    close(fds[0]);
+}
+
+// Test more operations than the queue holds
+static void test_depth(int flags)
+{
+    natcmp_io_t io;
+    natcmp_io_op_t ops[32];
+    char bufs[32][4];
+    int fd = temp_file();
+    int ok = 1;
+
+    natcmp_io_init(&io, 2, flags);
+    for (int i = 0; i < 32; i++) {
+        snprintf(bufs[i], sizeof(bufs[i]), "%03d", i);
+        ok &= natcmp_io_write(&io, &ops[i], fd, bufs[i], 3, i * 3) == 0;
+    }
+    for (int i = 0; i < 32; i++) {
+        ok &= natcmp_io_write_all(&io, &ops[i]) == 0;
+    }
+    assert_true(ok);
+    for (int i = 0; i < 32; i++) {
+        memset(bufs[i], 0, sizeof(bufs[i]));
+        ok &= natcmp_io_read(&io, &ops[i], fd, bufs[i], 3, i * 3) == 0;
+    }
+    natcmp_io_drain(&io);
+    for (int i = 0; i < 32; i++) {
+        char expect[4];
+        snprintf(expect, sizeof(expect), "%03d", i);
+        ok &= ops[i].done && natcmp_io_wait(&io, &ops[i]) == 3 &&
+              memcmp(bufs[i], expect, 3) == 0;
+    }
+    assert_true(ok);
+    assert_true(io.inflight == 0);
+    natcmp_io_close(&io);
+    close(fd);
+}
+
+int main(void)
+{
+    static const int flags[] = {0, NATCMP_IO_NOURING};
+    static const char *names[] = {"default backend", "sync backend"};
+
+    printf("=== NATCMP IO TEST SUITE ===\n");
+
+    for (int i = 0; i < 2; i++) {
+        printf("\n[File I/O (%s)]\n", names[i]);
+        test_file(flags[i]);
+        printf("\n[Pipe I/O (%s)]\n", names[i]);
+        test_pipe(flags[i]);
+        printf("\n[Queue Depth (%s)]\n", names[i]);
+        test_depth(flags[i]);
+    }
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include "../src/natcmp_jsonl.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+
+#define NREC 3000
+
+// finds the path in a NUL-terminated record and copies the key to buf
+static int find(const char *rec, const char *path, char *buf)
+{
+    natcmp_jsonl_path_t p;
+    natcmp_jsonl_span_t span;
+    int rv;
+
+    if (natcmp_jsonl_path_compile(&p, path) != 0) {
+        return -2;
+    }
+    rv = natcmp_jsonl_find((const unsigned char *)rec, strlen(rec), &p, &span);
+    if (rv == 1) {
+        size_t n = span.len;
+        if (span.type == NATCMP_JSONL_STRING) {
+            n = natcmp_jsonl_unescape(span.ptr, span.len, (unsigned char *)buf);
+        } else {
+            memcpy(buf, span.ptr, n);
+        }
+        buf[n] = '\0';
+    }
+    return rv;
+}
+
+static void test_path(void)
+{
+    natcmp_jsonl_path_t p;
+
+    TEST_SECTION("Key paths");
+    assert_true(natcmp_jsonl_path_compile(&p, ".") == 0 && p.n == 0);
+    assert_true(natcmp_jsonl_path_compile(&p, ".object.name") == 0 &&
+                p.n == 2 && p.seg[0].len == 6 && p.seg[1].len == 4 &&
+                memcmp(p.seg[1].name, "name", 4) == 0);
+    assert_true(natcmp_jsonl_path_compile(&p, ".a[12][\"b.c\"].\"d[e\"") ==
+                    0 &&
+                p.n == 4 && p.seg[1].name == NULL && p.seg[1].len == 12 &&
+                p.seg[2].len == 3 && memcmp(p.seg[2].name, "b.c", 3) == 0 &&
+                p.seg[3].len == 3 && memcmp(p.seg[3].name, "d[e", 3) == 0);
+    assert_true(natcmp_jsonl_path_compile(&p, "[0]") == 0 && p.n == 1);
+
+    errno = 0;
+    assert_true(natcmp_jsonl_path_compile(&p, "name") == -1 &&
+                errno == EINVAL);
+    assert_true(natcmp_jsonl_path_compile(&p, ".a.") == -1);
+    assert_true(natcmp_jsonl_path_compile(&p, ".a[]") == -1);
+    assert_true(natcmp_jsonl_path_compile(&p, ".a[1") == -1);
+    assert_true(natcmp_jsonl_path_compile(&p, ".\"a") == -1);
+    assert_true(natcmp_jsonl_path_compile(&p, "[\"a\"") == -1);
+    assert_true(natcmp_jsonl_path_compile(
+                    &p, ".a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a.a"
+                        ".a.a.a.a.a.a.a.a") == -1);
+}
+
+static void test_find(void)
+{
+    char buf[256];
+    char rec[512];
+
+    TEST_SECTION("Finding keys");
+    assert_true(find("{\"object\":{\"name\":\"file10\"}}", ".object.name",
+                     buf) == 1 &&
+                strcmp(buf, "file10") == 0);
+    assert_true(find(" { \"a\" : 1 , \"b\" : [ 10 , \"x\" , { \"c\" : "
+                     "\"y\" } ] } ",
+                     ".b[2].c", buf) == 1 &&
+                strcmp(buf, "y") == 0);
+    assert_true(find("{\"a\":1,\"b\":[10,\"x\"]}", ".b[0]", buf) == 1 &&
+                strcmp(buf, "10") == 0);
+    assert_true(find("{\"a\":{\"b\":[1,2]},\"c\":true}", ".a", buf) == 1 &&
+                strcmp(buf, "{\"b\":[1,2]}") == 0);
+    assert_true(find("{\"a\":\"x\"}", ".", buf) == 1 &&
+                strcmp(buf, "{\"a\":\"x\"}") == 0);
+
+    // members and elements before the key are skipped, including strings
+    // holding brackets, quotes and backslashes, and long strings
+    assert_true(find("{\"skip\":{\"s\":\"}]{[\\\"\\\\\",\"t\":[[],{}]},"
+                     "\"name\":\"x2\"}",
+                     ".name", buf) == 1 &&
+                strcmp(buf, "x2") == 0);
+    memset(rec, 0, sizeof(rec));
+    strcpy(rec, "{\"long\":\"");
+    memset(rec + strlen(rec), 'a', 300);
+    strcat(rec, "\\\"}\",\"deep\":[[[[\"]]]]\"]]]],\"name\":\"z\"}");
+    assert_true(find(rec, ".name", buf) == 1 && strcmp(buf, "z") == 0);
+
+    // member names are compared unescaped
+    assert_true(find("{\"na\\u006de\":\"v\"}", ".name", buf) == 1 &&
+                strcmp(buf, "v") == 0);
+    assert_true(find("{\"na\\\"me\":\"v\"}", ".\"na\"", buf) == 0);
+
+    // missing keys
+    assert_true(find("{\"a\":1}", ".b", buf) == 0);
+    assert_true(find("{}", ".b", buf) == 0);
+    assert_true(find("{\"a\":[1,2]}", ".a[2]", buf) == 0);
+    assert_true(find("{\"a\":[]}", ".a[0]", buf) == 0);
+    assert_true(find("{\"a\":\"str\"}", ".a.b", buf) == 0);
+    assert_true(find("{\"a\":[1]}", ".a.b", buf) == 0);
+    assert_true(find("[1]", ".a", buf) == 0);
+
+    // malformed records
+    errno = 0;
+    assert_true(find("{\"a\":1", ".b", buf) == -1 && errno == EINVAL);
+    assert_true(find("{\"a\" 1}", ".a", buf) == -1);
+    assert_true(find("{\"a\":\"x}", ".a", buf) == -1);
+    assert_true(find("{\"a\":{\"b\":1}", ".c", buf) == -1);
+    assert_true(find("{a:1}", ".a", buf) == -1);
+    assert_true(find("", ".", buf) == -1);
+    assert_true(find("{\"a\":}", ".a", buf) == -1);
+}
+
+static void test_unescape(void)
+{
+    char buf[256];
+
+    TEST_SECTION("Unescaping");
+    assert_true(find("{\"a\":\"x\\n\\t\\\"\\\\\\/y\"}", ".a", buf) == 1 &&
+                strcmp(buf, "x\n\t\"\\/y") == 0);
+    assert_true(find("{\"a\":\"caf\\u00e9\"}", ".a", buf) == 1 &&
+                strcmp(buf, "caf\xc3\xa9") == 0);
+    assert_true(find("{\"a\":\"\\u20AC\"}", ".a", buf) == 1 &&
+                strcmp(buf, "\xe2\x82\xac") == 0);
+    assert_true(find("{\"a\":\"\\ud83d\\ude00\"}", ".a", buf) == 1 &&
+                strcmp(buf, "\xf0\x9f\x98\x80") == 0);
+    // lone surrogates and malformed escapes
+    assert_true(find("{\"a\":\"\\ud83dx\"}", ".a", buf) == 1 &&
+                strcmp(buf, "\xef\xbf\xbdx") == 0);
+    assert_true(find("{\"a\":\"\\u12g4\\q\"}", ".a", buf) == 1 &&
+                strcmp(buf, "\\u12g4\\q") == 0);
+}
+
+static int cmp_ref(const void *a, const void *b)
+{
+    const unsigned char *const *x = (const unsigned char *const *)a;
+    const unsigned char *const *y = (const unsigned char *const *)b;
+    int c                         = natcmp(x[0], y[0], NULL);
+    // stable: ties keep the order of the records
+    return c ? c : (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+static void test_sort(void)
+{
+    static const char *recs[] = {
+        "{\"id\":1,\"object\":{\"name\":\"file10.txt\"}}",
+        "{\"id\":2,\"object\":{\"name\":\"file9.txt\"}}",
+        "{\"id\":3,\"object\":{}}",
+        "{\"id\":4,\"object\":{\"name\":\"File9.txt\"}}",
+        "{\"id\":5,\"object\":{\"name\":\"file\\u0031.txt\"}}",
+        "{\"id\":6,\"object\":{\"name\":null}}",
+        "{\"id\":7,\"object\":{\"name\":100}}",
+        "{\"id\":8,\"object\":{\"name\":\"file09.txt\"}}",
+    };
+    static const int order[] = {3, 6, 7, 5, 2, 4, 8, 1};
+    const size_t n           = sizeof(recs) / sizeof(recs[0]);
+    unsigned char lines[8][64];
+    natcmp_jsonl_t s;
+    int ok = 1;
+
+    TEST_SECTION("Sorting records");
+    for (size_t i = 0; i < n; i++) {
+        strcpy((char *)lines[i], recs[i]);
+    }
+    assert_true(natcmp_jsonl_init(&s, ".object.name", NULL, NULL) == 0);
+    for (size_t i = 0; i < n; i++) {
+        ok &= natcmp_jsonl_add(&s, lines[i], strlen(recs[i])) == 0;
+    }
+    assert_true(ok && s.n == n);
+    // the key of record 1 is terminated in place until the sort
+    assert_true(lines[0][strlen(recs[0]) - 3] == '\0');
+    assert_true(natcmp_jsonl_sort(&s) == 0);
+    for (size_t i = 0; i < n; i++) {
+        ok &= s.recs[i].line == lines[order[i] - 1];
+        ok &= s.recs[i].len == strlen(recs[order[i] - 1]);
+        ok &= strcmp((const char *)lines[i], recs[i]) == 0;
+    }
+    assert_true(ok);
+    natcmp_jsonl_free(&s);
+
+    errno = 0;
+    assert_true(natcmp_jsonl_init(&s, "bad", NULL, NULL) == -1 &&
+                errno == EINVAL);
+    assert_true(natcmp_jsonl_init(&s, ".a", NULL, NULL) == 0);
+    strcpy((char *)lines[0], "{\"b\" 1,\"a\":\"x\"}");
+    errno = 0;
+    assert_true(natcmp_jsonl_add(&s, lines[0], 15) == -1 && errno == EINVAL &&
+                s.n == 0);
+    // only the part of the record up to the key is checked
+    strcpy((char *)lines[0], "{\"a\":\"x\",");
+    assert_true(natcmp_jsonl_add(&s, lines[0], 9) == 0 && s.n == 1);
+    natcmp_jsonl_free(&s);
+}
+
+static void test_random(void)
+{
+    static char lines[NREC][160];
+    static char keys[NREC][48];
+    static const unsigned char *ref[NREC][2];
+    static const char *words[] = {"img", "IMG", "file", "a\\\"b", "x\\u0041",
+                                  "{", "]"};
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a = natcmp_allocator_stats(&st, NULL);
+    natcmp_jsonl_t s;
+    uint64_t r = 7;
+    int ok     = 1;
+
+    TEST_SECTION("Random records against a reference sort");
+    for (size_t i = 0; i < NREC; i++) {
+        char esc[48];
+        r = r * 6364136223846793005ULL + 1442695040888963407ULL;
+        snprintf(esc, sizeof(esc), "%s%u_%u", words[(r >> 33) % 7],
+                 (unsigned)(r >> 40) % 300, (unsigned)(r >> 20) % 20);
+        // the expected key is the unescaped string
+        size_t n = natcmp_jsonl_unescape((const unsigned char *)esc,
+                                         strlen(esc), (unsigned char *)keys[i]);
+        keys[i][n] = '\0';
+        if ((r >> 13) % 3 == 0) {
+            snprintf(lines[i], sizeof(lines[i]),
+                     "{\"meta\":{\"tags\":[\"a\",{\"b\":\"]\"}]},"
+                     "\"object\":{\"size\":%u,\"name\":\"%s\"}}",
+                     (unsigned)i, esc);
+        } else {
+            snprintf(lines[i], sizeof(lines[i]),
+                     "{ \"object\" : { \"name\" : \"%s\" } , \"n\" : %u }",
+                     esc, (unsigned)i);
+        }
+        ref[i][0] = (const unsigned char *)keys[i];
+        ref[i][1] = (const unsigned char *)lines[i];
+    }
+    qsort(ref, NREC, sizeof(ref[0]), cmp_ref);
+
+    assert_true(natcmp_jsonl_init(&s, ".object.name", NULL, &a) == 0);
+    for (size_t i = 0; i < NREC; i++) {
+        ok &= natcmp_jsonl_add(&s, (unsigned char *)lines[i],
+                               strlen(lines[i])) == 0;
+    }
+    assert_true(ok && s.n == NREC);
+    assert_true(natcmp_jsonl_sort(&s) == 0);
+    for (size_t i = 0; i < NREC; i++) {
+        ok &= s.recs[i].line == ref[i][1];
+    }
+    assert_true(ok);
+    natcmp_jsonl_free(&s);
+    assert_true(st.current == 0);
+}
+
+int main(void)
+{
+    printf("=== NATCMP JSONL TEST SUITE ===\n");
+
+    test_path();
+    test_find();
+    test_unescape();
+    test_sort();
+    test_random();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
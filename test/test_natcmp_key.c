@@ -0,0 +1,321 @@
+#include "../src/natcmp_key.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+static const char *corpus[] = {
+    "",
+    "a",
+    "A",
+    "abc",
+    "ABC",
+    "abcd",
+    "abc1",
+    "abc123",
+    "abc123xyz",
+    "1abc",
+    "0",
+    "00",
+    "000",
+    "1",
+    "01",
+    "2",
+    "10",
+    "010",
+    "file",
+    "file1",
+    "file2.txt",
+    "File2.txt",
+    "file02.txt",
+    "file002.txt",
+    "file10.txt",
+    "file123.txt",
+    "file456.txt",
+    "file12",
+    "a very long text run that spans many words",
+    "A Very Long Text Run That Spans Many Words2",
+    "12345678901234567890123",
+    "12345678901234567890124",
+    "0000000000000000012345678901234567890123",
+    "x99999999999999999999y",
+    "x100000000000000000000y",
+    "\x7f\x80\xff",
+    "[bracket]",
+    "_underscore",
+    "Zebra",
+    "apple",
+};
+#define CORPUS_LEN (sizeof(corpus) / sizeof(corpus[0]))
+
+static int keycmp_str(const char *a, const char *b)
+{
+    unsigned char ka[256];
+    unsigned char kb[256];
+    size_t la = natcmp_key((const unsigned char *)a, ka, sizeof(ka));
+    size_t lb = natcmp_key((const unsigned char *)b, kb, sizeof(kb));
+    assert(la <= sizeof(ka) && lb <= sizeof(kb));
+    return natcmp_keycmp(ka, la, kb, lb);
+}
+
+// Test that key order matches natcmp() order for every pair of the corpus
+static void test_key_order(void)
+{
+    TEST_SECTION("Key Order Matches natcmp()");
+
+    size_t mismatch = 0;
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        for (size_t j = 0; j < CORPUS_LEN; j++) {
+            int expected = natcmp((const unsigned char *)corpus[i],
+                                  (const unsigned char *)corpus[j], NULL);
+            int actual   = keycmp_str(corpus[i], corpus[j]);
+            if (expected != actual) {
+                printf("    MISMATCH: \"%s\" vs \"%s\": natcmp=%d key=%d\n",
+                       corpus[i], corpus[j], expected, actual);
+                mismatch++;
+            }
+        }
+    }
+    assert_true(mismatch == 0);
+
+    printf("\n  Specific cases:\n");
+    assert_true(keycmp_str("file2.txt", "file10.txt") < 0);
+    assert_true(keycmp_str("File2.txt", "file2.TXT") == 0);
+    assert_true(keycmp_str("file02.txt", "file002.txt") < 0);
+    assert_true(keycmp_str("1abc", "abc") < 0);
+    assert_true(keycmp_str("abc", "abc123") < 0);
+}
+
+static int keycmp_total_str(const char *a, const char *b)
+{
+    unsigned char ka[256];
+    unsigned char kb[256];
+    size_t la = natcmp_key_total((const unsigned char *)a, ka, sizeof(ka));
+    size_t lb = natcmp_key_total((const unsigned char *)b, kb, sizeof(kb));
+    assert(la <= sizeof(ka) && lb <= sizeof(kb));
+    return natcmp_keycmp(ka, la, kb, lb);
+}
+
+// Test that total-order key order matches natcmp_total() order
+static void test_key_total_order(void)
+{
+    TEST_SECTION("Total-Order Key Matches natcmp_total()");
+
+    size_t mismatch = 0;
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        for (size_t j = 0; j < CORPUS_LEN; j++) {
+            int expected = natcmp_total((const unsigned char *)corpus[i],
+                                        (const unsigned char *)corpus[j], NULL);
+            int actual   = keycmp_total_str(corpus[i], corpus[j]);
+            if (expected != actual) {
+                printf("    MISMATCH: \"%s\" vs \"%s\": natcmp_total=%d "
+                       "key=%d\n",
+                       corpus[i], corpus[j], expected, actual);
+                mismatch++;
+            }
+        }
+    }
+    assert_true(mismatch == 0);
+
+    printf("\n  Specific cases:\n");
+    assert_true(keycmp_total_str("File2.txt", "file2.txt") < 0);
+    assert_true(keycmp_total_str("file2.txt", "File10.txt") < 0);
+    assert_true(keycmp_total_str("abc", "abc1") < 0);
+    assert_true(keycmp_total_str("ABC", "abc") < 0);
+}
+
+// Test the snprintf()-like length semantics
+static void test_key_truncation(void)
+{
+    TEST_SECTION("Key Length and Truncation");
+
+    unsigned char full[64];
+    unsigned char part[64];
+    size_t len = natcmp_key((const unsigned char *)"file10.txt", full,
+                            sizeof(full));
+
+    printf("  Length query with NULL buffer:\n");
+    assert_true(natcmp_key((const unsigned char *)"file10.txt", NULL, 0) ==
+                len);
+
+    printf("\n  Truncated key is a prefix of the full key:\n");
+    memset(part, 0xAA, sizeof(part));
+    assert_true(natcmp_key((const unsigned char *)"file10.txt", part, 5) ==
+                len);
+    assert_true(memcmp(full, part, 5) == 0);
+    assert_true(part[5] == 0xAA);
+}
+
+// Test that key prefixes are the first 8 bytes of the keys
+static void test_key_prefix(void)
+{
+    TEST_SECTION("Key Prefixes");
+
+    int ok = 1;
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        unsigned char key[8] = {0};
+        uint64_t v           = 0;
+        natcmp_key((const unsigned char *)corpus[i], key, sizeof(key));
+        for (size_t k = 0; k < sizeof(key); k++) {
+            v = (v << 8) | key[k];
+        }
+        ok &= natcmp_key_prefix((const unsigned char *)corpus[i]) == v;
+    }
+    assert_true(ok);
+    assert_true(natcmp_key_prefix((const unsigned char *)"") == 0);
+    assert_true(natcmp_key_prefix((const unsigned char *)"a9") <
+                natcmp_key_prefix((const unsigned char *)"a10"));
+    assert_true(natcmp_key_prefix((const unsigned char *)"file9") ==
+                natcmp_key_prefix((const unsigned char *)"file10"));
+    assert_true(natcmp_key_prefix((const unsigned char *)"abcdefgh1") ==
+                natcmp_key_prefix((const unsigned char *)"ABCDEFGH2"));
+}
+
+// Test bulk key generation into an arena
+static void test_keys_bulk(void)
+{
+    TEST_SECTION("Bulk Key Generation");
+
+    const unsigned char *strs[CORPUS_LEN];
+    size_t offsets[CORPUS_LEN + 1];
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        strs[i] = (const unsigned char *)corpus[i];
+    }
+
+    size_t total       = natcmp_keys_size(strs, CORPUS_LEN);
+    unsigned char *buf = malloc(total);
+    natcmp_arena_t arena = {buf, total, 0};
+
+    printf("  Keys fill the arena exactly:\n");
+    assert_true(natcmp_keys_bulk(strs, CORPUS_LEN, &arena, offsets) == 0);
+    assert_true(arena.used == total);
+    assert_true(offsets[0] == 0 && offsets[CORPUS_LEN] == total);
+
+    printf("\n  Keys match natcmp_key():\n");
+    size_t mismatch = 0;
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        unsigned char key[256];
+        size_t len = natcmp_key(strs[i], key, sizeof(key));
+        if (len != offsets[i + 1] - offsets[i] ||
+            memcmp(key, buf + offsets[i], len) != 0) {
+            mismatch++;
+        }
+    }
+    assert_true(mismatch == 0);
+
+    printf("\n  Split into two slices of one arena:\n");
+    size_t half          = CORPUS_LEN / 2;
+    size_t first         = natcmp_keys_size(strs, half);
+    unsigned char *split = malloc(total);
+    size_t split_off[CORPUS_LEN + 1];
+    natcmp_arena_t lo = {split, first, 0};
+    natcmp_arena_t hi = {split, total, first};
+    assert_true(natcmp_keys_bulk(strs, half, &lo, split_off) == 0);
+    assert_true(natcmp_keys_bulk(strs + half, CORPUS_LEN - half, &hi,
+                                 split_off + half) == 0);
+    assert_true(memcmp(buf, split, total) == 0);
+    assert_true(memcmp(offsets, split_off, sizeof(offsets)) == 0);
+
+    printf("\n  On several threads:\n");
+    size_t par_off[CORPUS_LEN + 1];
+    unsigned char *par = malloc(total + 1);
+    for (size_t nthread = 2; nthread <= 5; nthread += 3) {
+        natcmp_arena_t pa = {par, total + 1, 1};
+        assert_true(natcmp_keys_size_par(strs, CORPUS_LEN, natcmp_key_encode,
+                                         nthread) == total);
+        assert_true(natcmp_keys_bulk_par(strs, CORPUS_LEN, &pa, par_off,
+                                         natcmp_key_encode, nthread) == 0);
+        assert_true(pa.used == total + 1);
+        assert_true(memcmp(buf, par + 1, total) == 0);
+        size_t shifted = 0;
+        for (size_t i = 0; i <= CORPUS_LEN; i++) {
+            shifted += (par_off[i] == offsets[i] + 1);
+        }
+        assert_true(shifted == CORPUS_LEN + 1);
+    }
+
+    printf("\n  Arena too small on several threads:\n");
+    natcmp_arena_t par_small = {par, total - 1, 0};
+    memset(par, 0xA5, total + 1);
+    errno = 0;
+    assert_true(natcmp_keys_bulk_par(strs, CORPUS_LEN, &par_small, par_off,
+                                     natcmp_key_encode, 3) == -1);
+    assert_true(errno == ENOBUFS);
+    assert_true(par_small.used == 0);
+#if NATCMP_KEY_THREADS
+    // the slices are sized before any key is written
+    assert_true(par[0] == 0xA5 && par[total / 2] == 0xA5);
+#endif
+    free(par);
+
+    printf("\n  Arena too small:\n");
+    natcmp_arena_t small = {buf, total - 1, 0};
+    errno                = 0;
+    assert_true(natcmp_keys_bulk(strs, CORPUS_LEN, &small, offsets) == -1);
+    assert_true(errno == ENOBUFS);
+    assert_true(small.used == 0);
+
+    printf("\n  Total-order keys:\n");
+    size_t total2       = natcmp_keys_size_total(strs, CORPUS_LEN);
+    unsigned char *buf2 = malloc(total2);
+    natcmp_arena_t arena2 = {buf2, total2, 0};
+    assert_true(natcmp_keys_bulk_total(strs, CORPUS_LEN, &arena2, offsets) ==
+                0);
+    assert_true(arena2.used == total2);
+    mismatch = 0;
+    for (size_t i = 0; i < CORPUS_LEN; i++) {
+        unsigned char key[256];
+        size_t len = natcmp_key_total(strs[i], key, sizeof(key));
+        if (len != offsets[i + 1] - offsets[i] ||
+            memcmp(key, buf2 + offsets[i], len) != 0) {
+            mismatch++;
+        }
+    }
+    assert_true(mismatch == 0);
+
+    free(buf2);
+    free(split);
+    free(buf);
+}
+
+int main(void)
+{
+    printf("=== NATCMP KEY TEST SUITE ===\n");
+
+    test_key_order();
+    test_key_total_order();
+    test_key_truncation();
+    test_key_prefix();
+    test_keys_bulk();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+#define _POSIX_C_SOURCE 200809L
+#include "../src/natcmp_look.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+
+
+static const char sorted[] = "a1\n"
+                             "a2\n"
+                             "A2\n"
+                             "a02\n"
+                             "a10\n"
+                             "b\n"
+                             "b1.5\n"
+                             "file9.txt\n"
+                             "file10.txt\n";
+
+// offset of the n-th line of `sorted`
+static size_t line_off(size_t n)
+{
+    size_t off = 0;
+    while (n--) {
+        off += strcspn(sorted + off, "\n") + 1;
+    }
+    return off;
+}
+
+// 1 if the range [first, last] of `map` is the lines [from, to)
+static int range_is(natcmp_look_t *lk, const char *first, const char *last,
+                    size_t from, size_t to)
+{
+    size_t start = 99;
+    size_t end   = 99;
+    return natcmp_look_range(lk, (const unsigned char *)first,
+                             (const unsigned char *)last, &start,
+                             &end) == 0 &&
+           start == line_off(from) && end == line_off(to);
+}
+
+static void test_search(void)
+{
+    TEST_SECTION("Search");
+    natcmp_look_t lk;
+    size_t off = 99;
+
+    natcmp_look_init(&lk, sorted, sizeof(sorted) - 1, NULL, NULL);
+    assert_true(natcmp_look_lower(&lk, (const unsigned char *)"a2", &off) ==
+                    0 &&
+                off == line_off(1));
+    assert_true(natcmp_look_upper(&lk, (const unsigned char *)"a2", &off) ==
+                    0 &&
+                off == line_off(3));
+    assert_true(natcmp_look_lower(&lk, (const unsigned char *)"a0", &off) ==
+                    0 &&
+                off == 0);
+    assert_true(natcmp_look_lower(&lk, (const unsigned char *)"zzz", &off) ==
+                    0 &&
+                off == sizeof(sorted) - 1);
+
+    printf("\n  Ranges:\n");
+    assert_true(range_is(&lk, "a2", "a2", 1, 3));
+    assert_true(range_is(&lk, "a02", "a02", 3, 4));
+    assert_true(range_is(&lk, "a3", "b", 4, 6));
+    assert_true(range_is(&lk, "B1", "FILE9.TXT", 6, 8));
+    assert_true(range_is(&lk, "file9.txt", "file99", 7, 9));
+    assert_true(range_is(&lk, "a5", "a6", 4, 4));
+    assert_true(range_is(&lk, "b", "a", 5, 5));
+    assert_true(range_is(&lk, "", "z", 0, 9));
+    natcmp_look_close(&lk);
+
+    printf("\n  Case-sensitive comparison:\n");
+    static const char cs[] = "A2\na2\n";
+    natcmp_look_init(&lk, cs, sizeof(cs) - 1, natcmp_nondigit_cmp_bytes, NULL);
+    assert_true(natcmp_look_lower(&lk, (const unsigned char *)"a2", &off) ==
+                    0 &&
+                off == 3);
+    natcmp_look_close(&lk);
+
+    printf("\n  Last line without a newline:\n");
+    static const char nonl[] = "x1\nx2\nx3";
+    natcmp_look_init(&lk, nonl, sizeof(nonl) - 1, NULL, NULL);
+    assert_true(natcmp_look_lower(&lk, (const unsigned char *)"x3", &off) ==
+                    0 &&
+                off == 6);
+    assert_true(natcmp_look_upper(&lk, (const unsigned char *)"x3", &off) ==
+                    0 &&
+                off == 8);
+    natcmp_look_close(&lk);
+
+    printf("\n  Empty lines and empty map:\n");
+    static const char blank[] = "\n\nx\n";
+    natcmp_look_init(&lk, blank, sizeof(blank) - 1, NULL, NULL);
+    assert_true(natcmp_look_upper(&lk, (const unsigned char *)"", &off) == 0 &&
+                off == 2);
+    natcmp_look_close(&lk);
+    natcmp_look_init(&lk, NULL, 0, NULL, NULL);
+    assert_true(natcmp_look_lower(&lk, (const unsigned char *)"x", &off) == 0 &&
+                off == 0);
+    assert_true(lk.nprobe == 0);
+    natcmp_look_close(&lk);
+}
+
+static void test_alloc(void)
+{
+    TEST_SECTION("Allocation failure");
+    natcmp_alloc_fail_t failing;
+    natcmp_allocator_t fail = natcmp_allocator_failing(&failing, 0, NULL);
+    natcmp_look_t lk;
+    size_t off;
+
+    natcmp_look_init(&lk, sorted, sizeof(sorted) - 1, NULL, &fail);
+    errno = 0;
+    assert_true(natcmp_look_lower(&lk, (const unsigned char *)"b", &off) ==
+                    -1 &&
+                errno == ENOMEM);
+    natcmp_look_close(&lk);
+}
+
+static int cmp_ref(const void *a, const void *b)
+{
+    return natcmp(*(const unsigned char *const *)a,
+                  *(const unsigned char *const *)b, NULL);
+}
+
+#define NLINE 5000
+
+static void test_random(void)
+{
+    TEST_SECTION("Random");
+    static const char *words[] = {"a", "B", "img", "v", "-", ".", "x"};
+    static const unsigned char *lines[NLINE];
+    static char pool[NLINE * 16];
+    static char map[NLINE * 16];
+    unsigned long st = 7;
+    size_t len       = 0;
+    int ok           = 1;
+    size_t maxprobe  = 0;
+
+    // random words and numbers, with duplicates
+    for (size_t i = 0; i < NLINE; i++) {
+        char *s = pool + i * 16;
+        st      = st * 6364136223846793005UL + 1442695040888963407UL;
+        sprintf(s, "%s%lu%s", words[(st >> 33) % 7], (st >> 40) % 300,
+                words[(st >> 50) % 7]);
+        lines[i] = (const unsigned char *)s;
+    }
+    qsort(lines, NLINE, sizeof(lines[0]), cmp_ref);
+    for (size_t i = 0; i < NLINE; i++) {
+        size_t n = strlen((const char *)lines[i]);
+        memcpy(map + len, lines[i], n);
+        map[len + n] = '\n';
+        len += n + 1;
+    }
+
+    natcmp_look_t lk;
+    natcmp_look_init(&lk, map, len, NULL, NULL);
+    for (size_t k = 0; k < 2000 && ok; k++) {
+        char key[32];
+        size_t start;
+        size_t end;
+        st = st * 6364136223846793005UL + 1442695040888963407UL;
+        if (k % 2) {
+            strcpy(key, (const char *)lines[(st >> 33) % NLINE]);
+        } else {
+            sprintf(key, "%s%lu", words[(st >> 33) % 7], (st >> 40) % 320);
+        }
+
+        // expected range by linear scan
+        size_t lo = 0;
+        size_t hi = 0;
+        size_t n  = 0;
+        for (size_t i = 0; i < NLINE; i++) {
+            int res  = natcmp(lines[i], (const unsigned char *)key, NULL);
+            size_t l = strlen((const char *)lines[i]) + 1;
+            lo += (res < 0) ? l : 0;
+            hi += (res <= 0) ? l : 0;
+            n += l;
+        }
+        lk.nprobe = 0;
+        if (natcmp_look_range(&lk, (const unsigned char *)key,
+                              (const unsigned char *)key, &start, &end) != 0 ||
+            start != lo || end != hi || n != len) {
+            printf("    mismatch for %s\n", key);
+            ok = 0;
+        }
+        maxprobe = (lk.nprobe > maxprobe) ? lk.nprobe : maxprobe;
+    }
+    natcmp_look_close(&lk);
+    assert_true(ok);
+
+    // each search halves the byte range per probe
+    size_t bits = 0;
+    while (((size_t)1 << bits) < len) {
+        bits++;
+    }
+    printf("    %zu bytes, at most %zu probes per range\n", len, maxprobe);
+    assert_true(maxprobe <= 2 * (bits + 1));
+}
+
+static void test_open(void)
+{
+    TEST_SECTION("Files");
+    char path[] = "/tmp/natcmp_look_XXXXXX";
+    int fd      = mkstemp(path);
+    natcmp_look_t lk;
+    size_t start;
+    size_t end;
+
+    assert_true(fd >= 0);
+    assert_true(natcmp_look_open(&lk, path, NULL, NULL) == 0 && lk.len == 0 &&
+                !lk.mapped);
+    assert_true(natcmp_look_range(&lk, (const unsigned char *)"a",
+                                  (const unsigned char *)"z", &start,
+                                  &end) == 0 &&
+                start == 0 && end == 0);
+    natcmp_look_close(&lk);
+
+    assert_true(write(fd, sorted, sizeof(sorted) - 1) ==
+                (ssize_t)sizeof(sorted) - 1);
+    close(fd);
+    assert_true(natcmp_look_open(&lk, path, NULL, NULL) == 0 &&
+                lk.len == sizeof(sorted) - 1 && lk.mapped);
+    assert_true(range_is(&lk, "a3", "b", 4, 6));
+    assert_true(memcmp(lk.map + line_off(4), "a10\nb\n", 6) == 0);
+    natcmp_look_close(&lk);
+    assert_true(lk.map == NULL && lk.buf == NULL);
+    unlink(path);
+
+    errno = 0;
+    assert_true(natcmp_look_open(&lk, path, NULL, NULL) == -1 &&
+                errno == ENOENT);
+}
+
+int main(void)
+{
+    printf("=== NATCMP LOOK TEST SUITE ===\n");
+
+    test_search();
+    test_alloc();
+    test_random();
+    test_open();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
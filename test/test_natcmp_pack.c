@@ -0,0 +1,185 @@
+#include "../src/natcmp_pack.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define NFRAME 250000
+
+// packs the list, checks that streaming and random access decoding restore
+// it, and returns the packed length (0 on mismatch)
+static size_t roundtrip(const unsigned char *const *strs, size_t n)
+{
+    size_t len         = natcmp_pack(strs, n, NULL, 0);
+    unsigned char *buf = malloc(len);
+    natcmp_pack_reader_t r;
+    natcmp_pack_index_t idx;
+    unsigned char name[64];
+    size_t namelen = 0;
+    size_t i       = 0;
+    int ok         = 1;
+
+    ok = ok && natcmp_pack(strs, n, buf, len) == len;
+    ok = ok && natcmp_pack_open(&r, buf, len) == 0 && r.n == n;
+    while (ok && natcmp_pack_next(&r, name, sizeof(name), &namelen) == 1) {
+        ok = i < n && strcmp((const char *)name, (const char *)strs[i]) == 0 &&
+             namelen == strlen((const char *)strs[i]);
+        i++;
+    }
+    ok = ok && i == n;
+
+    ok = ok && natcmp_pack_index(&idx, buf, len, NULL) == 0;
+    for (size_t k = 0; ok && k < n; k += 1 + k / 7) {
+        ok = natcmp_pack_get(&idx, k, name, sizeof(name), &namelen) == 1 &&
+             strcmp((const char *)name, (const char *)strs[k]) == 0;
+    }
+    ok = ok && natcmp_pack_get(&idx, n, name, sizeof(name), &namelen) == 0;
+    if (n) {
+        ok = ok && natcmp_pack_get(&idx, n - 1, name, sizeof(name),
+                                   &namelen) == 1 &&
+             strcmp((const char *)name, (const char *)strs[n - 1]) == 0;
+    }
+    natcmp_pack_index_free(&idx);
+    free(buf);
+    return ok ? len : 0;
+}
+
+// Test a long frame sequence with gaps
+static void test_frames(void)
+{
+    TEST_SECTION("Frame Sequence");
+
+    static char names[NFRAME][20];
+    static const unsigned char *strs[NFRAME];
+    size_t n   = 0;
+    size_t raw = 0;
+
+    for (int i = 1; i <= NFRAME; i++) {
+        if (i % 1000 >= 500 && i % 1000 < 510) {
+            continue;
+        }
+        snprintf(names[n], sizeof(names[n]), "frame_%06d.exr", i);
+        strs[n] = (const unsigned char *)names[n];
+        raw += strlen(names[n]) + 1;
+        n++;
+    }
+    size_t len = roundtrip(strs, n);
+    printf("    %zu names, %zu bytes -> %zu bytes\n", n, raw, len);
+    assert_true(len > 0);
+    assert_true(len * 100 < raw);
+}
+
+// Test strides, widths and names without numbers
+static void test_patterns(void)
+{
+    TEST_SECTION("Patterns");
+
+    static const char *strided[] = {"shot10.png", "shot20.png", "shot30.png",
+                                    "shot40.png", "shot50.png", "shot60.png",
+                                    "shot70.png", "shot80.png", "shot90.png",
+                                    "shot100.png"};
+    static const char *widths[]  = {"f_0998", "f_0999", "f_1000", "f_1001",
+                                    "v8",     "v9",     "v10",    "v11"};
+    static const char *mixed[]   = {"",       "README", "README", "a1b",
+                                    "a1b",    "a2b",    "a2c",    "x007y3",
+                                    "x007y4", "z123456789012345678901"};
+    const unsigned char *strs[10];
+    natcmp_pack_reader_t r;
+    natcmp_pack_index_t idx;
+    unsigned char buf[256];
+
+#define set_strs(list)                                                         \
+    for (size_t i = 0; i < sizeof(list) / sizeof(list[0]); i++) {              \
+        strs[i] = (const unsigned char *)list[i];                              \
+    }
+
+    printf("\n  Strided run:\n");
+    set_strs(strided);
+    assert_true(roundtrip(strs, 10) > 0);
+    natcmp_pack(strs, 10, buf, sizeof(buf));
+    natcmp_pack_open(&r, buf, sizeof(buf));
+    assert_true(r.nrec == 1);
+
+    printf("\n  Padded and unpadded runs:\n");
+    set_strs(widths);
+    assert_true(roundtrip(strs, 8) > 0);
+    natcmp_pack(strs, 8, buf, sizeof(buf));
+    natcmp_pack_open(&r, buf, sizeof(buf));
+    assert_true(r.nrec == 2);
+
+    printf("\n  Literal names and duplicates:\n");
+    set_strs(mixed);
+    assert_true(roundtrip(strs, 10) > 0);
+
+
+    printf("\n  Empty list:\n");
+    assert_true(roundtrip(strs, 0) > 0);
+
+    printf("\n  Malformed input and small buffers:\n");
+    size_t len = natcmp_pack(strs, 10, buf, sizeof(buf));
+    errno      = 0;
+    assert_true(natcmp_pack_index(&idx, buf, len - 1, NULL) == -1);
+    assert_true(errno == EINVAL);
+    buf[0] = 'X';
+    assert_true(natcmp_pack_open(&r, buf, len) == -1);
+    buf[0] = 'N';
+    natcmp_pack_open(&r, buf, len);
+    size_t namelen = 0;
+    assert_true(natcmp_pack_next(&r, buf + len, 1, &namelen) == 1);
+    assert_true(natcmp_pack_next(&r, buf + len, 6, &namelen) == -1);
+    assert_true(errno == ENOBUFS && namelen == 6);
+    assert_true(natcmp_pack_next(&r, buf + len, 7, &namelen) == 1);
+
+    printf("\n  Zero-padded runs wider than a record allows:\n");
+    static const char *wide[] = {"f0000000000000000000000001",
+                                 "f0000000000000000000000002",
+                                 "f00000000000000000000000000000000000000001",
+                                 "f00000000000000000000000000000000000000002"};
+    set_strs(wide);
+    assert_true(roundtrip(strs, 2) > 0);
+    assert_true(roundtrip(strs + 2, 2) > 0);
+    assert_true(roundtrip(strs, 4) > 0);
+    natcmp_pack(strs, 4, buf, sizeof(buf));
+    natcmp_pack_open(&r, buf, sizeof(buf));
+    assert_true(r.nrec == 4);
+#undef set_strs
+}
+
+int main(void)
+{
+    printf("=== NATCMP PACK TEST SUITE ===\n");
+
+    test_frames();
+    test_patterns();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
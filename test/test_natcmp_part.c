@@ -0,0 +1,209 @@
+#include "../src/natcmp_part.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+
+
+// partition of s by a linear scan of the boundaries
+static size_t find_ref(const natcmp_part_t *p, const unsigned char *s)
+{
+    size_t i = 0;
+    while (i < p->n && natcmp(p->bounds[i], s, p->compare) <= 0) {
+        i++;
+    }
+    return i;
+}
+
+static int bounds_sorted(const natcmp_part_t *p)
+{
+    for (size_t i = 1; i < p->n; i++) {
+        if (natcmp(p->bounds[i - 1], p->bounds[i], p->compare) > 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#define U(s) ((const unsigned char *)(s))
+
+static void test_bounds(void)
+{
+    TEST_SECTION("Boundaries");
+    static const char *sample[] = {"f7", "f1", "f10", "f3", "f9", "f5",
+                                   "f2", "f8", "f4",  "f6", "f12", "f11"};
+    natcmp_part_t p;
+
+    assert_true(natcmp_part_init(&p, (const unsigned char *const *)sample, 12,
+                                 4, NULL, NULL) == 0);
+    assert_true(p.n == 3 && p.prefix != NULL);
+    assert_true(strcmp((const char *)p.bounds[0], "f4") == 0);
+    assert_true(strcmp((const char *)p.bounds[1], "f7") == 0);
+    assert_true(strcmp((const char *)p.bounds[2], "f10") == 0);
+    assert_true(natcmp_part_find(&p, U("f1")) == 0);
+    assert_true(natcmp_part_find(&p, U("f3.9")) == 0);
+    assert_true(natcmp_part_find(&p, U("f4")) == 1);
+    assert_true(natcmp_part_find(&p, U("F04")) == 1);
+    assert_true(natcmp_part_find(&p, U("f9")) == 2);
+    assert_true(natcmp_part_find(&p, U("f10")) == 3);
+    assert_true(natcmp_part_find(&p, U("")) == 0);
+    assert_true(natcmp_part_find(&p, U("zz")) == 3);
+    natcmp_part_free(&p);
+
+    printf("\n  One partition and invalid arguments:\n");
+    assert_true(natcmp_part_init(&p, NULL, 0, 1, NULL, NULL) == 0 && p.n == 0);
+    assert_true(natcmp_part_find(&p, U("x")) == 0);
+    natcmp_part_free(&p);
+    errno = 0;
+    assert_true(natcmp_part_init(&p, NULL, 0, 2, NULL, NULL) == -1 &&
+                errno == EINVAL);
+    errno = 0;
+    assert_true(natcmp_part_init(&p, (const unsigned char *const *)sample, 12,
+                                 0, NULL, NULL) == -1 &&
+                errno == EINVAL);
+
+    printf("\n  More partitions than samples:\n");
+    assert_true(natcmp_part_init(&p, (const unsigned char *const *)sample, 2,
+                                 5, NULL, NULL) == 0);
+    assert_true(p.n == 4 && bounds_sorted(&p));
+    assert_true(natcmp_part_find(&p, U("f7")) == find_ref(&p, U("f7")));
+    natcmp_part_free(&p);
+
+    printf("\n  Case-sensitive comparison:\n");
+    static const char *cs[] = {"b", "B", "a", "A"};
+    assert_true(natcmp_part_init(&p, (const unsigned char *const *)cs, 4, 2,
+                                 natcmp_nondigit_cmp_bytes, NULL) == 0);
+    assert_true(p.prefix == NULL && p.n == 1);
+    assert_true(strcmp((const char *)p.bounds[0], "a") == 0);
+    assert_true(natcmp_part_find(&p, U("B")) == 0);
+    assert_true(natcmp_part_find(&p, U("b")) == 1);
+    natcmp_part_free(&p);
+}
+
+static void test_alloc(void)
+{
+    TEST_SECTION("Allocation failure");
+    natcmp_alloc_fail_t failing;
+    static const char *sample[] = {"a", "b", "c"};
+    natcmp_allocator_t fail     = natcmp_allocator_failing(&failing, 0, NULL);
+    natcmp_part_t p;
+
+    errno = 0;
+    assert_true(natcmp_part_init(&p, (const unsigned char *const *)sample, 3,
+                                 2, NULL, &fail) == -1 &&
+                errno == ENOMEM);
+    assert_true(p.bounds == NULL && p.n == 0);
+}
+
+static int cmp_ref(const void *a, const void *b)
+{
+    return natcmp(*(const unsigned char *const *)a,
+                  *(const unsigned char *const *)b, NULL);
+}
+
+#define NSTR 20000
+
+static void test_random(void)
+{
+    TEST_SECTION("Random");
+    // long shared prefixes, so that key prefixes tie and natcmp() decides
+    static const char *dirs[] = {"/data/logs/", "/data/Logs/", "/data/",
+                                 "img", "IMG_", "v1.", ""};
+    static const unsigned char *strs[NSTR];
+    static char pool[NSTR * 32];
+    unsigned long st = 11;
+    int ok           = 1;
+
+    for (size_t i = 0; i < NSTR; i++) {
+        char *s = pool + i * 32;
+        st      = st * 6364136223846793005UL + 1442695040888963407UL;
+        sprintf(s, "%s%0*lu%s", dirs[(st >> 33) % 7], (int)((st >> 60) % 3),
+                (st >> 36) % 5000, (st >> 50) % 2 ? ".txt" : "");
+        strs[i] = (const unsigned char *)s;
+    }
+
+    for (size_t parts = 1; parts <= 64 && ok; parts = parts * 3 + 1) {
+        natcmp_part_t p;
+        size_t count[100] = {0};
+
+        // boundaries from every tenth string
+        static const unsigned char *sample[NSTR / 10];
+        for (size_t i = 0; i < NSTR / 10; i++) {
+            sample[i] = strs[i * 10];
+        }
+        if (natcmp_part_init(&p, sample, NSTR / 10, parts, NULL, NULL) != 0 ||
+            !bounds_sorted(&p)) {
+            ok = 0;
+            break;
+        }
+        for (size_t i = 0; i < NSTR; i++) {
+            size_t k = natcmp_part_find(&p, strs[i]);
+            if (k != find_ref(&p, strs[i])) {
+                printf("    %s: partition %zu, expected %zu\n", strs[i], k,
+                       find_ref(&p, strs[i]));
+                ok = 0;
+            }
+            count[k]++;
+        }
+
+        // the sorted partitions follow each other, and are near NSTR/parts
+        qsort(strs, NSTR, sizeof(strs[0]), cmp_ref);
+        for (size_t i = 0, k = 0; i < NSTR; i++) {
+            size_t j = natcmp_part_find(&p, strs[i]);
+            if (j < k) {
+                ok = 0;
+            }
+            k = j;
+        }
+        size_t max = 0;
+        for (size_t k = 0; k < parts; k++) {
+            max = (count[k] > max) ? count[k] : max;
+        }
+        printf("    %zu partitions: largest %zu of %d\n", parts, max, NSTR);
+        if (max > 2 * NSTR / parts) {
+            ok = 0;
+        }
+        natcmp_part_free(&p);
+    }
+    assert_true(ok);
+}
+
+int main(void)
+{
+    printf("=== NATCMP PART TEST SUITE ===\n");
+
+    test_bounds();
+    test_alloc();
+    test_random();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
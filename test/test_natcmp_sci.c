@@ -0,0 +1,175 @@
+#include "../src/natcmp_sci.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define assert_sci(a, b, expected)                                             \
+    do {                                                                       \
+        int result = natcmp_sci((const unsigned char *)(a),                    \
+                                (const unsigned char *)(b), NULL);             \
+        total_tests++;                                                         \
+        if (result == (expected)) {                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: natcmp_sci(\"%s\", \"%s\") = %d\n", (a), (b),    \
+                   result);                                                    \
+        } else {                                                               \
+            printf("    FAIL: natcmp_sci(\"%s\", \"%s\") = %d, expected %d\n", \
+                   (a), (b), result, (expected));                              \
+            assert(result == (expected));                                      \
+        }                                                                      \
+    } while (0)
+
+// Test comparison of numbers in scientific notation
+static void test_scientific(void)
+{
+    TEST_SECTION("Scientific Notation");
+
+    printf("\n  Ordering by value:\n");
+    assert_sci("sigma_1e-3", "sigma_2.5e2", -1);
+    assert_sci("sigma_1e-3", "sigma_1e-2", -1);
+    assert_sci("sigma_9e-3", "sigma_1e-2", -1);
+    assert_sci("sigma_2.5e2", "sigma_3e1", 1);
+    assert_sci("x1.5E+3", "x2e3", -1);
+    assert_sci("x6.02e23", "x6.1e23", -1);
+    assert_sci("x0e5", "x1e-300", -1);
+
+    printf("\n  Equal values:\n");
+    assert_sci("1e3", "1000", 0);
+    assert_sci("2.50e2", "25e1", 0);
+    assert_sci("0.1e1", "1e0", 0);
+    assert_sci("0e3", "0", 0);
+    assert_sci("1e3.dat", "1000.txt", -1);
+
+    printf("\n  Decimal numbers against scientific notation:\n");
+    assert_sci("sigma_0.5", "sigma_1e-3", 1);
+    assert_sci("sigma_0.0005", "sigma_1e-3", -1);
+    assert_sci("run_250", "run_2.5e2", 0);
+    assert_sci("run_251", "run_2.5e2", 1);
+    assert_sci("lr_0.001", "lr_1e-2", -1);
+    assert_sci("lr_1e-2", "lr_0.5", -1);
+}
+
+// Test fallbacks to plain natural order
+static void test_plain(void)
+{
+    TEST_SECTION("Plain Numbers");
+
+    printf("\n  No scientific notation on either side:\n");
+    assert_sci("file2", "file10", -1);
+    assert_sci("file01", "file1", 1);
+    assert_sci("1.5", "1.10", 1);
+    assert_sci("lr_0.001", "lr_0.01", -1);
+    assert_sci("v1.2.3", "v1.2.10", -1);
+
+    printf("\n  Equal values with different padding:\n");
+    assert_sci("x01e0", "x1.0", 1);
+    assert_sci("x1.50", "x1.5", 0);
+    assert_sci("00", "0e1", 1);
+
+    printf("\n  Not scientific notation:\n");
+    assert_sci("1e", "1f", -1);
+    assert_sci("1ex", "1e-", 1);
+    assert_sci("1e+", "2", -1);
+
+    printf("\n  Exponent too large:\n");
+    assert_sci("1e1234567890", "2e1", -1);
+    assert_sci("1e0000000001", "2", 1);
+
+    printf("\n  Parser:\n");
+    natcmp_sci_num_t num;
+    assert_true(natcmp_sci_parse((const unsigned char *)"0012.500e-3x",
+                                 &num) == 1);
+    assert_true(num.nsig == 3 && num.exp == -1);
+    assert_true(*num.tail == 'x');
+    assert_true(natcmp_sci_parse((const unsigned char *)"0.000", &num) == 0);
+    assert_true(num.nsig == 0);
+}
+
+// Test that the order is transitive whichever kinds of numbers are compared
+static void test_transitive(void)
+{
+    TEST_SECTION("Transitivity");
+
+    static const char *const strs[] = {
+        "x1.5",    "x1.2e0", "x1.10",         "x1",      "x1e0",
+        "x01",     "x0.5",   "x5e-1",         "x1.2",    "x1.2.3",
+        "x1.2.10", "x2",     "x10e-1",        "x1.0",    "x0",
+        "x00",     "x0e3",   "x1e",           "x1e-",    "x1.e1",
+        "x1e99",   "y",      "x1e1234567890", "x1.5E+0",
+    };
+    size_t n = sizeof(strs) / sizeof(strs[0]);
+    int r[sizeof(strs) / sizeof(strs[0])][sizeof(strs) / sizeof(strs[0])];
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            r[i][j] = natcmp_sci((const unsigned char *)strs[i],
+                                 (const unsigned char *)strs[j], NULL);
+        }
+    }
+
+    int antisymmetric = 1;
+    int transitive    = 1;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            if (r[i][j] != -r[j][i]) {
+                printf("    %s vs %s: %d, %d\n", strs[i], strs[j], r[i][j],
+                       r[j][i]);
+                antisymmetric = 0;
+            }
+            for (size_t k = 0; k < n; k++) {
+                // a <= b and b <= c imply a <= c, strictly if either is
+                int ab = r[i][j], bc = r[j][k], ac = r[i][k];
+                if (ab <= 0 && bc <= 0 && (ac > 0 || ((ab || bc) && !ac))) {
+                    printf("    %s, %s, %s: %d, %d, %d\n", strs[i], strs[j],
+                           strs[k], ab, bc, ac);
+                    transitive = 0;
+                }
+            }
+        }
+    }
+    assert_true(antisymmetric);
+    assert_true(transitive);
+
+    assert_sci("x1.5", "x1.2e0", 1);
+    assert_sci("x1.2e0", "x1.10", 1);
+    assert_sci("x1.5", "x1.10", 1);
+}
+
+int main(void)
+{
+    printf("=== NATCMP SCI TEST SUITE ===\n");
+
+    test_scientific();
+    test_plain();
+    test_transitive();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
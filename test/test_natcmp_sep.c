@@ -0,0 +1,261 @@
+#include "../src/natcmp_sep.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+
+
+static unsigned char out[64];
+
+static int sep_is(const char *a, const char *b, const char *expect)
+{
+    size_t n = natcmp_separator((const unsigned char *)a,
+                                (const unsigned char *)b, out);
+    return n == strlen(expect) && strcmp((const char *)out, expect) == 0;
+}
+
+static int succ_is(const char *a, const char *expect)
+{
+    size_t n = natcmp_successor((const unsigned char *)a, out);
+    return n == strlen(expect) && strcmp((const char *)out, expect) == 0;
+}
+
+static void test_examples(void)
+{
+    TEST_SECTION("Separator examples");
+    // a byte between the first different bytes
+    assert_true(sep_is("abcdef", "abz", "abd"));
+    assert_true(sep_is("ABCDEF", "abz", "ABd"));
+    // a is shortest
+    assert_true(sep_is("file9", "file10", "file9"));
+    assert_true(sep_is("a", "b", "a"));
+    assert_true(sep_is("file", "file1", "file"));
+    // digit runs between digit runs
+    assert_true(sep_is("x1zzzz", "x3", "x2"));
+    assert_true(sep_is("x1999zz", "x2001", "x2000"));
+    assert_true(sep_is("x99zz", "x1000", "x100"));
+    assert_true(sep_is("x99zz", "x0100", "x100"));
+    assert_true(sep_is("x99zz", "x100", "x099"));
+    assert_true(sep_is("x7zz", "x0008", "x8"));
+    // leading zeros: equal numbers with more zeros are greater
+    assert_true(sep_is("f7zzz", "f007", "f07"));
+    assert_true(sep_is("f07zz", "f7", "f07zz"));
+    // the first token of b alone
+    assert_true(sep_is("img12zz", "img13a", "img13"));
+    assert_true(sep_is("az9999999", "b1", "b"));
+    // text after a digit run and before a text byte
+    assert_true(sep_is("a5zzzz", "ab", "a!"));
+    // the next token of a, then a greater byte
+    assert_true(sep_is("x5zzzz", "y", "x!"));
+    assert_true(sep_is("f7zzz", "f07", "f7{"));
+    // ties go to a token between
+    assert_true(sep_is("file99.txt", "file100.txt", "file099"));
+    // a not less than b
+    assert_true(sep_is("b", "a", "b"));
+    assert_true(sep_is("File1", "file1", "File1"));
+    assert_true(sep_is("x10", "x9", "x10"));
+
+    TEST_SECTION("Successor examples");
+    assert_true(succ_is("file10", "g"));
+    assert_true(succ_is("File10", "g"));
+    assert_true(succ_is("10", "!"));
+    assert_true(succ_is("z", "{"));
+    assert_true(succ_is("\xff\xff" "a", "\xff\xff" "b"));
+    assert_true(succ_is("\xff", "\xff"));
+    assert_true(succ_is("", ""));
+}
+
+// strings over a small alphabet that covers the interesting cases
+static const char alpha[] = "019aBz.";
+
+static void gen(char *s, uint64_t *r, size_t maxlen)
+{
+    *r       = *r * 6364136223846793005ULL + 1442695040888963407ULL;
+    size_t n = (size_t)(*r >> 60) % (maxlen + 1);
+    for (size_t i = 0; i < n; i++) {
+        *r   = *r * 6364136223846793005ULL + 1442695040888963407ULL;
+        s[i] = alpha[(*r >> 40) % (sizeof(alpha) - 1)];
+    }
+    s[n] = '\0';
+}
+
+// checks that no string of the brute force alphabet shorter than len is a
+// separator of a and b
+static int none_shorter(const unsigned char *a, const unsigned char *b,
+                        size_t len)
+{
+    static const char brute[] = "0123456789 !./:@[abcyz{~";
+    const size_t nb           = sizeof(brute) - 1;
+    unsigned char s[8];
+    for (size_t l = 0; l < len; l++) {
+        size_t total = 1;
+        for (size_t k = 0; k < l; k++) {
+            total *= nb;
+        }
+        for (size_t x = 0; x < total; x++) {
+            size_t v = x;
+            for (size_t k = 0; k < l; k++) {
+                s[k] = (unsigned char)brute[v % nb];
+                v /= nb;
+            }
+            s[l] = '\0';
+            if (natcmp(a, s, NULL) <= 0 && natcmp(s, b, NULL) < 0) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void test_random(void)
+{
+    char a[8];
+    char b[8];
+    uint64_t r  = 1;
+    int valid   = 1;
+    int shorter = 1;
+    int optimal = 1;
+    int succ    = 1;
+
+    TEST_SECTION("Random separators");
+    for (int iter = 0; iter < 6000; iter++) {
+        gen(a, &r, 5);
+        gen(b, &r, 5);
+        if ((iter & 1) && *a) {
+            // b is a with one byte changed, to share a longer prefix
+            memcpy(b, a, sizeof(b));
+            b[(r >> 20) % strlen(a)] = alpha[(r >> 10) % (sizeof(alpha) - 1)];
+        }
+        if (natcmp((const unsigned char *)a, (const unsigned char *)b, NULL) >=
+            0) {
+            continue;
+        }
+        size_t n = natcmp_separator((const unsigned char *)a,
+                                    (const unsigned char *)b, out);
+        valid &= natcmp((const unsigned char *)a, out, NULL) <= 0 &&
+                 natcmp(out, (const unsigned char *)b, NULL) < 0 &&
+                 strlen((const char *)out) == n;
+        shorter &= n <= strlen(a);
+        if (n <= 4) {
+            optimal &= none_shorter((const unsigned char *)a,
+                                    (const unsigned char *)b, n);
+        }
+
+        // every string starting with a is less than the successor
+        n = natcmp_successor((const unsigned char *)a, out);
+        for (size_t k = 0; k < sizeof(alpha) - 1 && n; k++) {
+            char ext[16];
+            snprintf(ext, sizeof(ext), "%s%c%s", a, alpha[k], b);
+            succ &= natcmp((const unsigned char *)ext, out, NULL) < 0 &&
+                    natcmp((const unsigned char *)a, out, NULL) < 0;
+        }
+    }
+    assert_true(valid);
+    assert_true(shorter);
+    assert_true(optimal);
+    assert_true(succ);
+}
+
+static void test_keys(void)
+{
+    static const unsigned char bytes[] = {0x00, 0x01, 0x02, 0x80, 0xfe, 0xff};
+    unsigned char a[4];
+    unsigned char b[4];
+    unsigned char s[4];
+    uint64_t r  = 3;
+    int valid   = 1;
+    int optimal = 1;
+
+    TEST_SECTION("Key separators");
+    for (int iter = 0; iter < 400; iter++) {
+        size_t alen;
+        size_t blen;
+        r    = r * 6364136223846793005ULL + 1442695040888963407ULL;
+        alen = (size_t)(r >> 33) % 4;
+        blen = (size_t)(r >> 35) % 4;
+        for (size_t i = 0; i < 4; i++) {
+            r    = r * 6364136223846793005ULL + 1442695040888963407ULL;
+            a[i] = bytes[(r >> 40) % sizeof(bytes)];
+            b[i] = bytes[(r >> 50) % sizeof(bytes)];
+        }
+        if (natcmp_keycmp(a, alen, b, blen) >= 0) {
+            continue;
+        }
+        size_t n = natcmp_key_separator(a, alen, b, blen, out);
+        valid &= n <= alen && natcmp_keycmp(a, alen, out, n) <= 0 &&
+                 natcmp_keycmp(out, n, b, blen) < 0;
+        // no shorter byte string is a separator
+        for (size_t l = 0; l < n && l < 3; l++) {
+            for (size_t x = 0; x < ((size_t)1 << (8 * l)); x++) {
+                for (size_t k = 0; k < l; k++) {
+                    s[k] = (unsigned char)(x >> (8 * k));
+                }
+                optimal &= !(natcmp_keycmp(a, alen, s, l) <= 0 &&
+                             natcmp_keycmp(s, l, b, blen) < 0);
+            }
+        }
+    }
+    assert_true(valid);
+    assert_true(optimal);
+
+    // separators of natural keys separate the strings
+    unsigned char ka[64];
+    unsigned char kb[64];
+    size_t la = natcmp_key((const unsigned char *)"file9.txt", ka, sizeof(ka));
+    size_t lb = natcmp_key((const unsigned char *)"file10.txt", kb, sizeof(kb));
+    size_t n  = natcmp_key_separator(ka, la, kb, lb, out);
+    assert_true(n < la && natcmp_keycmp(ka, la, out, n) < 0 &&
+                natcmp_keycmp(out, n, kb, lb) < 0);
+
+    TEST_SECTION("Key successors");
+    assert_true(natcmp_key_successor((const unsigned char *)"\x02" "ab", 3,
+                                     out) == 1 &&
+                out[0] == 0x03);
+    assert_true(natcmp_key_successor((const unsigned char *)"\xff\x01", 2,
+                                     out) == 2 &&
+                out[0] == 0xff && out[1] == 0x02);
+    assert_true(natcmp_key_successor((const unsigned char *)"\xff", 1, out) ==
+                1);
+    assert_true(natcmp_key_successor(kb, lb, out) == 1 &&
+                natcmp_keycmp(kb, lb, out, 1) < 0);
+}
+
+int main(void)
+{
+    printf("=== NATCMP SEP TEST SUITE ===\n");
+
+    test_examples();
+    test_random();
+    test_keys();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
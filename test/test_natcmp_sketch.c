@@ -0,0 +1,198 @@
+#include "../src/natcmp_sketch.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define NITEM 100000
+#define V(s)  ((const unsigned char *)(s))
+
+// number of "item<i>" strings of the stream that are less than "item<r>"
+static long item_rank(const unsigned char *s)
+{
+    return strtol((const char *)s + 4, NULL, 10) - 1;
+}
+
+// feeds "item1" to "item<NITEM>" in a shuffled order, every `step`-th one
+// starting at `first`
+static void feed(natcmp_sketch_t *sk, size_t first, size_t step)
+{
+    static unsigned perm[NITEM];
+    uint32_t seed = 12345;
+    char buf[32];
+
+    for (size_t i = 0; i < NITEM; i++) {
+        perm[i] = (unsigned)i + 1;
+    }
+    for (size_t i = NITEM - 1; i > 0; i--) {
+        seed         = seed * 1103515245u + 12345u;
+        size_t j     = (seed >> 8) % (i + 1);
+        unsigned tmp = perm[i];
+        perm[i]      = perm[j];
+        perm[j]      = tmp;
+    }
+    for (size_t i = first; i < NITEM; i += step) {
+        snprintf(buf, sizeof(buf), "item%u", perm[i]);
+        natcmp_sketch_update(sk, V(buf));
+    }
+}
+
+static size_t nsamples(const natcmp_sketch_t *sk)
+{
+    size_t n = 0;
+    for (size_t h = 0; h < sk->nlevels; h++) {
+        n += sk->levels[h].n;
+    }
+    return n;
+}
+
+// checks that the quantiles are within 2% of their exact ranks
+static int quantiles_ok(natcmp_sketch_t *sk)
+{
+    static const double qs[] = {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99};
+    for (size_t i = 0; i < sizeof(qs) / sizeof(qs[0]); i++) {
+        const unsigned char *s = natcmp_sketch_quantile(sk, qs[i]);
+        long want              = (long)(qs[i] * NITEM);
+        if (!s || labs(item_rank(s) - want) > NITEM / 50) {
+            printf("    q=%.2f: %s\n", qs[i], s ? (const char *)s : "NULL");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Test queries on a single stream
+static void test_queries(void)
+{
+    TEST_SECTION("Queries");
+
+    natcmp_sketch_t sk;
+    natcmp_sketch_init(&sk, 0, 1, NULL, NULL);
+    assert_true(natcmp_sketch_quantile(&sk, 0.5) == NULL);
+    assert_true(natcmp_sketch_rank(&sk, V("item1")) == 0);
+
+    feed(&sk, 0, 1);
+    assert_true(sk.n == NITEM);
+    assert_true(nsamples(&sk) <= 3 * NATCMP_SKETCH_DEFAULT_K + sk.nlevels);
+    assert_true(strcmp((const char *)natcmp_sketch_quantile(&sk, 0), "item1") ==
+                0);
+    assert_true(strcmp((const char *)natcmp_sketch_quantile(&sk, 1),
+                       "item100000") == 0);
+    assert_true(quantiles_ok(&sk));
+
+    uint64_t r = natcmp_sketch_rank(&sk, V("item25001"));
+    assert_true(labs((long)r - 25000) <= NITEM / 50);
+    assert_true(natcmp_sketch_rank(&sk, V("item0")) == 0);
+    assert_true(natcmp_sketch_rank(&sk, V("item100001")) >= NITEM - NITEM / 50);
+    natcmp_sketch_free(&sk);
+}
+
+// Test merging of sketches
+static void test_merge(void)
+{
+    TEST_SECTION("Merge");
+
+    natcmp_sketch_t a;
+    natcmp_sketch_t b;
+    natcmp_sketch_init(&a, 0, 1, NULL, NULL);
+    natcmp_sketch_init(&b, 0, 2, NULL, NULL);
+    feed(&a, 0, 2);
+    feed(&b, 1, 2);
+
+    assert_true(natcmp_sketch_merge(&a, &b) == 0);
+    assert_true(a.n == NITEM);
+    assert_true(nsamples(&a) <= 3 * NATCMP_SKETCH_DEFAULT_K + a.nlevels);
+    assert_true(strcmp((const char *)natcmp_sketch_quantile(&a, 0), "item1") ==
+                0);
+    assert_true(strcmp((const char *)natcmp_sketch_quantile(&a, 1),
+                       "item100000") == 0);
+    assert_true(quantiles_ok(&a));
+
+    printf("\n  Merging an empty sketch:\n");
+    natcmp_sketch_free(&b);
+    assert_true(natcmp_sketch_merge(&a, &b) == 0 && a.n == NITEM);
+    natcmp_sketch_free(&a);
+}
+
+// Test serialization
+static void test_serialize(void)
+{
+    TEST_SECTION("Serialize");
+
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t alloc = natcmp_allocator_stats(&st, NULL);
+    natcmp_sketch_t sk;
+    natcmp_sketch_t copy;
+    natcmp_sketch_init(&sk, 0, 1, NULL, &alloc);
+    feed(&sk, 0, 1);
+    printf("    peak memory: %zu bytes\n", st.peak);
+
+    size_t len         = natcmp_sketch_serialize(&sk, NULL, 0);
+    unsigned char *buf = malloc(len);
+    assert_true(natcmp_sketch_serialize(&sk, buf, len) == len);
+    printf("    serialized size: %zu bytes\n", len);
+    assert_true(len < 8192);
+
+    assert_true(natcmp_sketch_deserialize(&copy, buf, len, NULL, &alloc) ==
+                0);
+    assert_true(copy.n == sk.n && copy.k == sk.k);
+    assert_true(nsamples(&copy) == nsamples(&sk));
+    assert_true(strcmp((const char *)natcmp_sketch_quantile(&copy, 0.5),
+                       (const char *)natcmp_sketch_quantile(&sk, 0.5)) == 0);
+    assert_true(natcmp_sketch_rank(&copy, V("item777")) ==
+                natcmp_sketch_rank(&sk, V("item777")));
+
+    printf("\n  Malformed input:\n");
+    natcmp_sketch_t bad;
+    errno = 0;
+    assert_true(natcmp_sketch_deserialize(&bad, buf, len / 2, NULL, &alloc) ==
+                -1);
+    assert_true(errno == EINVAL);
+    buf[0] = 'X';
+    assert_true(natcmp_sketch_deserialize(&bad, buf, len, NULL, &alloc) == -1);
+
+    free(buf);
+    natcmp_sketch_free(&copy);
+    natcmp_sketch_free(&sk);
+    assert_true(st.current == 0);
+}
+
+int main(void)
+{
+    printf("=== NATCMP SKETCH TEST SUITE ===\n");
+
+    test_queries();
+    test_merge();
+    test_serialize();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
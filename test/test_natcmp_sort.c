@@ -0,0 +1,204 @@
+#include "../src/natcmp_sort.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define NSTR 2000
+
+static char strbuf[NSTR][16];
+static const unsigned char *input[NSTR];
+
+// generates names such as "File07b" with many natcmp()-equal duplicates
+static void make_input(void)
+{
+    static const char *prefix[] = {"file", "File", "FILE", "img", "a", ""};
+    unsigned int seed           = 1;
+    for (size_t i = 0; i < NSTR; i++) {
+        seed = seed * 1103515245u + 12345u;
+        snprintf(strbuf[i], sizeof(strbuf[i]), "%s%0*u%s",
+                 prefix[(seed >> 8) % 6], (int)((seed >> 4) % 3),
+                 (seed >> 16) % 50, ((seed >> 12) & 1) ? "b" : "");
+        input[i] = (const unsigned char *)strbuf[i];
+    }
+}
+
+// returns 1 if strs is sorted and equal elements keep their input order
+static int is_stable_sorted(const unsigned char **strs, size_t n)
+{
+    for (size_t i = 1; i < n; i++) {
+        int cmp = natcmp(strs[i - 1], strs[i], NULL);
+        // input order of equal elements is the order of their addresses
+        if (cmp > 0 || (cmp == 0 && strs[i - 1] > strs[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Test the sort engines
+static void test_sort_engines(void)
+{
+    TEST_SECTION("Sort Engines");
+
+    const unsigned char *strs[NSTR];
+
+    printf("  Insertion sort:\n");
+    memcpy(strs, input, sizeof(strs));
+    natcmp_sort_insertion(strs, NSTR, NULL);
+    assert_true(is_stable_sorted(strs, NSTR));
+
+    printf("\n  Merge sort:\n");
+    memcpy(strs, input, sizeof(strs));
+    assert_true(natcmp_sort_merge(strs, NSTR, NULL, NULL) == 0);
+    assert_true(is_stable_sorted(strs, NSTR));
+
+    printf("\n  Key sort:\n");
+    memcpy(strs, input, sizeof(strs));
+    assert_true(natcmp_sort_keys(strs, NSTR, NULL) == 0);
+    assert_true(is_stable_sorted(strs, NSTR));
+
+    printf("\n  In-place merge sort without buffer:\n");
+    memcpy(strs, input, sizeof(strs));
+    natcmp_sort_inplace(strs, NSTR, NULL, NULL, 0);
+    assert_true(is_stable_sorted(strs, NSTR));
+
+    printf("\n  In-place merge sort with a fixed buffer:\n");
+    const unsigned char *buf[64];
+    memcpy(strs, input, sizeof(strs));
+    natcmp_sort_inplace(strs, NSTR, NULL, buf, 64);
+    assert_true(is_stable_sorted(strs, NSTR));
+    memcpy(strs, input, sizeof(strs));
+    natcmp_sort_inplace(strs, NSTR, NULL, buf, 3);
+    assert_true(is_stable_sorted(strs, NSTR));
+
+    printf("\n  In-place merge sort of every length up to 100:\n");
+    int ok = 1;
+    for (size_t n = 0; n <= 100 && ok; n++) {
+        memcpy(strs, input, sizeof(strs));
+        natcmp_sort_inplace(strs, n, NULL, NULL, 0);
+        ok = is_stable_sorted(strs, n);
+    }
+    assert_true(ok);
+
+    printf("\n  Small and empty arrays:\n");
+    memcpy(strs, input, sizeof(strs));
+    assert_true(natcmp_sort_merge(strs, 5, NULL, NULL) == 0);
+    assert_true(is_stable_sorted(strs, 5));
+    assert_true(natcmp_sort_keys(strs, 0, NULL) == 0);
+}
+
+// Test the sorting network base case
+static void test_sort_network(void)
+{
+    TEST_SECTION("Sorting Network");
+
+    static const char *shared[] = {
+        "/data/x/10", "/data/x/9",  "/data/x/09", "/data/x/1a", "/data/x/1",
+        "/data/x/",   "/data/x",    "/data/X/9",  "/data/x/1A", "/data/x/10",
+        "/data/x/z",  "/data/x/0",  "/data/x/00", "/data/x1",   "/data/x/90",
+    };
+    const size_t nshared = sizeof(shared) / sizeof(shared[0]);
+    const unsigned char *strs[64];
+    int ok = 1;
+
+    printf("  Every length up to 64:\n");
+    for (size_t n = 0; n <= 64 && ok; n++) {
+        for (size_t off = 0; off + n <= NSTR && ok; off += 397) {
+            memcpy(strs, input + off, sizeof(*strs) * n);
+            natcmp_sort_network(strs, n);
+            ok = is_stable_sorted(strs, n);
+        }
+    }
+    assert_true(ok);
+
+    printf("\n  Strings sharing a prefix that ends in a digit run:\n");
+    memcpy(strs, shared, sizeof(*strs) * nshared);
+    natcmp_sort_network(strs, nshared);
+    assert_true(is_stable_sorted(strs, nshared));
+    memcpy(strs, shared, sizeof(*strs) * 3);
+    natcmp_sort_network(strs, 3);
+    assert_true(is_stable_sorted(strs, 3));
+
+    printf("\n  Leaf size of the sort engines:\n");
+    assert_true(natcmp_sort_leaf(NULL) == NATCMP_SORT_NETWORK);
+    assert_true(natcmp_sort_leaf(natcmp_nondigit_cmp_bytes) ==
+                NATCMP_SORT_INSERTION);
+}
+
+// Test allocator hooks of the sort engines
+static void test_sort_allocator(void)
+{
+    TEST_SECTION("Sort Engine Allocations");
+
+    const unsigned char *strs[NSTR];
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t a = natcmp_allocator_stats(&st, NULL);
+
+    printf("  Merge sort uses n / 2 pointers of scratch:\n");
+    memcpy(strs, input, sizeof(strs));
+    assert_true(natcmp_sort_merge(strs, NSTR, NULL, &a) == 0);
+    assert_true(st.nalloc == 1 && st.nfree == 1);
+    assert_true(st.peak == sizeof(*strs) * (NSTR / 2));
+    assert_true(st.current == 0);
+
+    printf("\n  Key sort releases everything:\n");
+    a = natcmp_allocator_stats(&st, NULL);
+    memcpy(strs, input, sizeof(strs));
+    assert_true(natcmp_sort_keys(strs, NSTR, &a) == 0);
+    assert_true(st.nalloc == 3 && st.nfree == 3);
+    assert_true(st.current == 0);
+
+    printf("\n  Allocation failure:\n");
+    natcmp_alloc_fail_t failing;
+    natcmp_allocator_t fail = natcmp_allocator_failing(&failing, 0, NULL);
+    memcpy(strs, input, sizeof(strs));
+    errno = 0;
+    assert_true(natcmp_sort_merge(strs, NSTR, NULL, &fail) == -1);
+    assert_true(errno == ENOMEM);
+    assert_true(memcmp(strs, input, sizeof(strs)) == 0);
+    errno = 0;
+    assert_true(natcmp_sort_keys(strs, NSTR, &fail) == -1);
+    assert_true(errno == ENOMEM);
+}
+
+int main(void)
+{
+    printf("=== NATCMP SORT TEST SUITE ===\n");
+
+    make_input();
+    test_sort_engines();
+    test_sort_network();
+    test_sort_allocator();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "../src/natcmp_units.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+#define assert_units(a, b, units, expected)                                    \
+    do {                                                                       \
+        int result = natcmp_units((const unsigned char *)(a),                  \
+                                  (const unsigned char *)(b), NULL, (units));  \
+        total_tests++;                                                         \
+        if (result == (expected)) {                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: natcmp_units(\"%s\", \"%s\") = %d\n", (a), (b),  \
+                   result);                                                    \
+        } else {                                                               \
+            printf("    FAIL: natcmp_units(\"%s\", \"%s\") = %d, "             \
+                   "expected %d\n",                                            \
+                   (a), (b), result, (expected));                              \
+            assert(result == (expected));                                      \
+        }                                                                      \
+    } while (0)
+
+// Test sizes with SI and IEC units
+static void test_sizes(void)
+{
+    TEST_SECTION("Sizes");
+
+    const natcmp_unit_t *si  = natcmp_units_si();
+    const natcmp_unit_t *iec = natcmp_units_iec();
+
+    printf("\n  Ordering by magnitude:\n");
+    assert_units("512K", "1.5M", si, -1);
+    assert_units("1.5M", "2G", si, -1);
+    assert_units("2G", "512K", si, 1);
+    assert_units("900M", "1G", iec, -1);
+    assert_units("1023", "1K", iec, -1);
+    assert_units("1.5T", "1536G", iec, 0);
+
+    printf("\n  SI vs IEC scales:\n");
+    assert_units("1000K", "1M", si, 0);
+    assert_units("1000K", "1M", iec, -1);
+    assert_units("1024K", "1M", iec, 0);
+    assert_units("1.5M", "1500K", si, 0);
+    assert_units("1.5M", "1536K", iec, 0);
+    assert_units("1MiB", "1048576B", iec, 0);
+
+    printf("\n  Fractions:\n");
+    assert_units("1.05M", "1.5M", si, -1);
+    assert_units("1.50M", "1.5M", si, 0);
+    assert_units("0.5K", "499", si, 1);
+    assert_units("0.001G", "1M", si, 0);
+
+    printf("\n  Names with sizes:\n");
+    assert_units("img-512K.bin", "img-1M.bin", si, -1);
+    assert_units("img-1M.bin", "img-1M.txt", si, -1);
+    assert_units("disk 10G a", "disk 10GB b", si, -1);
+}
+
+// Test durations
+static void test_durations(void)
+{
+    TEST_SECTION("Durations");
+
+    const natcmp_unit_t *t = natcmp_units_time();
+
+    assert_units("90s", "2m", t, -1);
+    assert_units("2m", "1h", t, -1);
+    assert_units("1h", "1d", t, -1);
+    assert_units("25h", "1d", t, 1);
+    assert_units("500ms", "1s", t, -1);
+    assert_units("1500ms", "1.5s", t, 0);
+    assert_units("60min", "1h", t, 0);
+    assert_units("1w", "6d", t, 1);
+}
+
+// Test fallbacks to plain natural order
+static void test_plain(void)
+{
+    TEST_SECTION("Plain Numbers");
+
+    const natcmp_unit_t *si = natcmp_units_si();
+
+    printf("\n  No unit table:\n");
+    assert_units("1M", "2K", NULL, -1);
+    assert_units("file2", "file10", NULL, -1);
+
+    printf("\n  No suffix on either side:\n");
+    assert_units("file2", "file10", si, -1);
+    assert_units("file01", "file1", si, 1);
+    assert_units("1.5", "1.10", si, -1);
+
+    printf("\n  Suffix followed by a letter is not a unit:\n");
+    assert_units("1Kx", "2", si, -1);
+    assert_units("1Mbps", "999Kbps", si, -1);
+
+    printf("\n  Too many significant digits:\n");
+    assert_units("1234567890123456789012345678901234567K", "2K", si, 1);
+    assert_units("0.0000000000000000000000000000000000001K", "1", si, -1);
+
+    printf("\n  Parser:\n");
+    natcmp_unit_num_t num;
+    assert_true(natcmp_unit_parse((const unsigned char *)"0012.500Kx", si,
+                                  &num) == 0);
+    assert_true(num.ilen == 2 && num.flen == 0 && num.scale == 1);
+    assert_true(natcmp_unit_parse((const unsigned char *)"0012.500K", si,
+                                  &num) == 1);
+    assert_true(num.ilen == 2 && num.flen == 1 && num.scale == 1000);
+    assert_true(*num.tail == '\0' && num.pad == 2);
+    assert_true(natcmp_unit_parse((const unsigned char *)"00", si, &num) == 0);
+    assert_true(num.ilen == 0 && num.pad == 1);
+}
+
+static void test_transitive(void)
+{
+    TEST_SECTION("Transitivity");
+
+    const natcmp_unit_t *si = natcmp_units_si();
+    static const char *const strs[] = {
+        "1000",
+        "01000",
+        "1K",
+        "1.0K",
+        "0M1.K",
+        "0x5M",
+        "00",
+        "0",
+        "0K",
+        "1.5M",
+        "1500K",
+        "1500000",
+        "999K",
+        "1Kx",
+        "2",
+        "1E",
+        "1000000000000000000",
+        "1234567890123456789012345678901234567K",
+        "1234567890123456789012345678901234567",
+        "99999999999999999999999999999999999999999999999999999999999",
+        "100000000000000000000000000000000000000000000000000000000000",
+        "x",
+    };
+    size_t n = sizeof(strs) / sizeof(strs[0]);
+    int r[sizeof(strs) / sizeof(strs[0])][sizeof(strs) / sizeof(strs[0])];
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            r[i][j] = natcmp_units((const unsigned char *)strs[i],
+                                   (const unsigned char *)strs[j], NULL, si);
+        }
+    }
+
+    int antisymmetric = 1;
+    int transitive    = 1;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            if (r[i][j] != -r[j][i]) {
+                printf("    %s vs %s: %d, %d\n", strs[i], strs[j], r[i][j],
+                       r[j][i]);
+                antisymmetric = 0;
+            }
+            for (size_t k = 0; k < n; k++) {
+                // a <= b and b <= c imply a <= c, strictly if either is
+                int ab = r[i][j], bc = r[j][k], ac = r[i][k];
+                if (ab <= 0 && bc <= 0 && (ac > 0 || ((ab || bc) && !ac))) {
+                    printf("    %s, %s, %s: %d, %d, %d\n", strs[i], strs[j],
+                           strs[k], ab, bc, ac);
+                    transitive = 0;
+                }
+            }
+        }
+    }
+    assert_true(antisymmetric);
+    assert_true(transitive);
+
+    assert_units("1000", "1K", si, 0);
+    assert_units("01000", "1K", si, 1);
+    assert_units("1000", "01000", si, -1);
+    assert_units("0x5M", "00", si, -1);
+}
+
+int main(void)
+{
+    printf("=== NATCMP UNITS TEST SUITE ===\n");
+
+    test_sizes();
+    test_durations();
+    test_plain();
+    test_transitive();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
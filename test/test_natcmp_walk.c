@@ -0,0 +1,306 @@
+#define _GNU_SOURCE
+#include "../src/natcmp_walk.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int total_tests  = 0;
+static int passed_tests = 0;
+
+#define TEST_SECTION(name) printf("\n[%s]\n", name)
+
+#define assert_true(expr)                                                      \
+    do {                                                                       \
+        total_tests++;                                                         \
+        if (expr) {                                                            \
+            passed_tests++;                                                    \
+            printf("    PASS: %s\n", #expr);                                   \
+        } else {                                                               \
+            printf("    FAIL: %s\n", #expr);                                   \
+            assert(expr);                                                      \
+        }                                                                      \
+    } while (0)
+
+// tree relative to the root; directories end with "/"
+static const char *tree[] = {
+    "dir10/",     "dir10/x",    "dir2/",        "dir2/a1",
+    "dir2/a10",   "dir2/a2",    "dir2/sub01/",  "dir2/sub01/z",
+    "dir2/sub1/", "file1.txt",  "file10.txt",   "file2.txt",
+    "File3.txt",  "empty/",
+};
+#define NTREE (sizeof(tree) / sizeof(tree[0]))
+
+// natural depth-first order of the tree
+static const char *expected[] = {
+    "dir2",       "dir2/a1",   "dir2/a2",      "dir2/a10",
+    "dir2/sub1",  "dir2/sub01", "dir2/sub01/z", "dir10",
+    "dir10/x",    "empty",     "file1.txt",    "file2.txt",
+    "File3.txt",  "file10.txt",
+};
+
+static char root[] = "/tmp/natcmp_walk_XXXXXX";
+
+// returns 1 if the tree has a directory at `rel`
+static int is_tree_dir(const char *rel)
+{
+    size_t len = strlen(rel);
+    for (size_t i = 0; i < NTREE; i++) {
+        if (strncmp(tree[i], rel, len) == 0 &&
+            strcmp(tree[i] + len, "/") == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void make_tree(void)
+{
+    char path[256];
+    assert(mkdtemp(root) != NULL);
+    for (size_t i = 0; i < NTREE; i++) {
+        size_t len = strlen(tree[i]);
+        snprintf(path, sizeof(path), "%s/%s", root, tree[i]);
+        if (tree[i][len - 1] == '/') {
+            assert(mkdir(path, 0700) == 0);
+        } else {
+            FILE *fp = fopen(path, "w");
+            assert(fp != NULL);
+            fclose(fp);
+        }
+    }
+}
+
+static void remove_tree(void)
+{
+    char path[256];
+    // children are listed after their directory
+    for (size_t i = NTREE; i-- > 0;) {
+        size_t len = strlen(tree[i]);
+        snprintf(path, sizeof(path), "%s/%s", root, tree[i]);
+        if (tree[i][len - 1] == '/') {
+            rmdir(path);
+        } else {
+            unlink(path);
+        }
+    }
+    rmdir(root);
+}
+
+// Test listing of a single directory
+static void test_dir_read(void)
+{
+    TEST_SECTION("Directory Listing");
+
+    natcmp_dir_t d;
+    assert_true(natcmp_dir_read(&d, root, NULL, NULL) == 0);
+    assert_true(d.n == 7);
+    assert_true(strcmp((const char *)d.names[0], "dir2") == 0);
+    assert_true(strcmp((const char *)d.names[1], "dir10") == 0);
+    assert_true(strcmp((const char *)d.names[6], "file10.txt") == 0);
+    assert_true(natcmp_dir_type(&d, 0) != NATCMP_DIR_OTHER);
+    assert_true(natcmp_dir_type(&d, 6) != NATCMP_DIR_DIR);
+    natcmp_dir_free(&d);
+
+    printf("\n  Missing directory:\n");
+    char path[256];
+    snprintf(path, sizeof(path), "%s/missing", root);
+    errno = 0;
+    assert_true(natcmp_dir_read(&d, path, NULL, NULL) == -1);
+    assert_true(errno == ENOENT);
+}
+
+// Test the depth-first walk
+static void test_walk(void)
+{
+    TEST_SECTION("Walk");
+
+    natcmp_alloc_stats_t st;
+    natcmp_allocator_t alloc = natcmp_allocator_stats(&st, NULL);
+    natcmp_walk_t w;
+    natcmp_walk_entry_t e;
+    size_t rootlen = strlen(root);
+    size_t n       = 0;
+    int ok         = 1;
+    int rv;
+
+    assert_true(natcmp_walk_open(&w, root, 0, NULL, &alloc) == 0);
+    while ((rv = natcmp_walk_next(&w, &e)) == 1) {
+        const char *rel = e.path + rootlen + 1;
+        printf("    %zu %s%s\n", e.depth, rel, e.isdir ? "/" : "");
+        ok = ok && n < NTREE && strcmp(rel, expected[n]) == 0 &&
+             e.isdir == is_tree_dir(rel);
+        ok = ok && strcmp(e.name, strrchr(e.path, '/') + 1) == 0;
+        n++;
+    }
+    assert_true(rv == 0);
+    assert_true(ok);
+    assert_true(n == NTREE);
+    natcmp_walk_close(&w);
+    assert_true(st.current == 0);
+
+    printf("\n  Status of entries:\n");
+    assert_true(natcmp_walk_open(&w, root, NATCMP_WALK_STAT, NULL, NULL) ==
+                0);
+    ok = 1;
+    while (natcmp_walk_next(&w, &e) == 1) {
+        ok = ok && (S_ISDIR(e.st.st_mode) != 0) == e.isdir;
+    }
+    assert_true(ok);
+    natcmp_walk_close(&w);
+
+    printf("\n  Subtrees concatenate to the whole walk:\n");
+    natcmp_dir_t d;
+    char path[256];
+    n  = 0;
+    ok = 1;
+    natcmp_dir_read(&d, root, NULL, NULL);
+    for (size_t i = 0; i < d.n; i++) {
+        ok = ok && strcmp((const char *)d.names[i], expected[n++]) == 0;
+        snprintf(path, sizeof(path), "%s/%s", root, (const char *)d.names[i]);
+        if (natcmp_walk_open(&w, path, 0, NULL, NULL) != 0) {
+            continue; // not a directory
+        }
+        while (natcmp_walk_next(&w, &e) == 1) {
+            ok = ok && strcmp(e.path + rootlen + 1, expected[n++]) == 0;
+        }
+        natcmp_walk_close(&w);
+    }
+    natcmp_dir_free(&d);
+    assert_true(ok && n == NTREE);
+
+    printf("\n  Missing root:\n");
+    snprintf(path, sizeof(path), "%s/missing", root);
+    assert_true(natcmp_walk_open(&w, path, 0, NULL, NULL) == -1);
+}
+
+// appends the paths of a walk of `dir` to `out`, one per line, closing the
+// walk after `limit` entries; returns the number of entries
+static size_t walk_lines(const char *dir, int flags, size_t limit, char *out,
+                         size_t size)
+{
+    natcmp_walk_t w;
+    natcmp_walk_entry_t e;
+    size_t n   = 0;
+    size_t len = 0;
+
+    out[0] = 0;
+    if (natcmp_walk_open(&w, dir, flags, NULL, NULL) != 0) {
+        return 0;
+    }
+    while (n < limit && natcmp_walk_next(&w, &e) == 1) {
+        len += (size_t)snprintf(out + len, size - len, "%zu %s%s\n", e.depth,
+                                e.path, e.isdir ? "/" : "");
+        assert(len < size);
+        n++;
+    }
+    natcmp_walk_close(&w);
+    return n;
+}
+
+// Test the walk with directories read ahead on worker threads
+static void test_parallel(void)
+{
+    TEST_SECTION("Parallel Walk");
+
+    natcmp_walk_t w;
+    natcmp_walk_entry_t e;
+    size_t rootlen = strlen(root);
+    size_t n       = 0;
+    int ok         = 1;
+    int rv;
+
+    assert_true(natcmp_walk_open(&w, root, NATCMP_WALK_PARALLEL, NULL,
+                                 NULL) == 0);
+#if NATCMP_WALK_THREADS
+    assert_true(w.nworker > 0);
+#endif
+    while ((rv = natcmp_walk_next(&w, &e)) == 1) {
+        const char *rel = e.path + rootlen + 1;
+        ok = ok && n < NTREE && strcmp(rel, expected[n]) == 0 &&
+             e.isdir == is_tree_dir(rel);
+        n++;
+    }
+    assert_true(rv == 0);
+    assert_true(ok);
+    assert_true(n == NTREE);
+    natcmp_walk_close(&w);
+
+    printf("\n  Same output as the sequential walk on a wider tree:\n");
+    char wide[] = "/tmp/natcmp_pwalk_XXXXXX";
+    char path[256];
+    assert(mkdtemp(wide) != NULL);
+    for (int i = 0; i < 12; i++) {
+        snprintf(path, sizeof(path), "%s/d%d", wide, i);
+        assert(mkdir(path, 0700) == 0);
+        for (int j = 0; j < 12; j++) {
+            snprintf(path, sizeof(path), "%s/d%d/s%d", wide, i, j);
+            assert(mkdir(path, 0700) == 0);
+            for (int k = 0; k < 2; k++) {
+                snprintf(path, sizeof(path), "%s/d%d/s%d/f%d", wide, i, j, k);
+                FILE *fp = fopen(path, "w");
+                assert(fp != NULL);
+                fclose(fp);
+            }
+        }
+    }
+
+    static char seq[65536];
+    static char par[65536];
+    size_t nseq = walk_lines(wide, 0, SIZE_MAX, seq, sizeof(seq));
+    size_t npar = walk_lines(wide, NATCMP_WALK_PARALLEL, SIZE_MAX, par,
+                             sizeof(par));
+    assert_true(nseq == 12 + 12 * 12 * 3);
+    assert_true(npar == nseq && strcmp(seq, par) == 0);
+    npar = walk_lines(wide, NATCMP_WALK_PARALLEL | NATCMP_WALK_STAT, SIZE_MAX,
+                      par, sizeof(par));
+    assert_true(npar == nseq && strcmp(seq, par) == 0);
+
+    printf("\n  Closed while directories are read ahead:\n");
+    npar = walk_lines(wide, NATCMP_WALK_PARALLEL, 5, par, sizeof(par));
+    assert_true(npar == 5 && strncmp(seq, par, strlen(par)) == 0);
+
+    for (int i = 0; i < 12; i++) {
+        for (int j = 0; j < 12; j++) {
+            for (int k = 0; k < 2; k++) {
+                snprintf(path, sizeof(path), "%s/d%d/s%d/f%d", wide, i, j, k);
+                unlink(path);
+            }
+            snprintf(path, sizeof(path), "%s/d%d/s%d", wide, i, j);
+            rmdir(path);
+        }
+        snprintf(path, sizeof(path), "%s/d%d", wide, i);
+        rmdir(path);
+    }
+    rmdir(wide);
+}
+
+int main(void)
+{
+    printf("=== NATCMP WALK TEST SUITE ===\n");
+#ifdef NATCMP_WALK_HAVE_GETDENTS
+    printf("Directory reader: getdents64\n");
+#else
+    printf("Directory reader: readdir\n");
+#endif
+
+    make_tree();
+    test_dir_read();
+    test_walk();
+    test_parallel();
+    remove_tree();
+
+    // Summary
+    printf("\n=== TEST SUMMARY ===\n");
+    printf("Total tests: %d\n", total_tests);
+
+    if (passed_tests == total_tests) {
+        printf("All tests passed successfully! (%d/%d)\n", passed_tests,
+               total_tests);
+    } else {
+        printf("Passed: %d/%d\n", passed_tests, total_tests);
+    }
+
+    return 0;
+}
@@ -0,0 +1,3 @@
+// test_natcmp_walk.c with the portable readdir() reader instead of getdents64
+#define NATCMP_WALK_DISABLE_GETDENTS
+#include "test_natcmp_walk.c"
@@ -0,0 +1,135 @@
+/**
+ * natanon: rewrites a list of names, one per line, with natcmp_anon.h so
+ * that it can be shared as a benchmark corpus. Letters and numbers are
+ * replaced; lengths, case, leading zeros, shared prefixes and the order of
+ * the numbers are kept.
+ *
+ *   natanon [-s seed] [file]
+ *
+ *   -s seed  seed of the replacements (random by default); the same seed
+ *            and input give the same output
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_anon.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: natanon [-s seed] [file]\n");
+    exit(2);
+}
+
+static uint64_t random_seed(void)
+{
+    uint64_t seed = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32);
+    int fd        = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        if (read(fd, &seed, sizeof(seed)) != (ssize_t)sizeof(seed)) {
+            seed ^= (uint64_t)clock();
+        }
+        close(fd);
+    }
+    return seed;
+}
+
+// reads the whole input, NUL-terminated
+static char *read_all(int fd, size_t *len)
+{
+    size_t cap = 1 << 16;
+    size_t n   = 0;
+    char *buf  = malloc(cap);
+    while (buf) {
+        if (n + 1 == cap) {
+            char *p = realloc(buf, cap * 2);
+            if (!p) {
+                break;
+            }
+            buf = p;
+            cap *= 2;
+        }
+        ssize_t r = read(fd, buf + n, cap - 1 - n);
+        if (r < 0) {
+            break;
+        } else if (r == 0) {
+            buf[n] = '\0';
+            *len   = n;
+            return buf;
+        }
+        n += (size_t)r;
+    }
+    free(buf);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t seed = 0;
+    int seeded    = 0;
+    int in        = STDIN_FILENO;
+    int c;
+
+    while ((c = getopt(argc, argv, "s:")) != -1) {
+        if (c != 's') {
+            usage();
+        }
+        seed   = strtoull(optarg, NULL, 0);
+        seeded = 1;
+    }
+    if (argc - optind > 1) {
+        usage();
+    } else if (argc - optind == 1 && strcmp(argv[optind], "-") != 0) {
+        in = open(argv[optind], O_RDONLY);
+        if (in < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    size_t len;
+    char *buf = read_all(in, &len);
+    if (!buf) {
+        perror("natanon");
+        return 1;
+    }
+    // the lines are NUL-terminated in place
+    size_t maxlen = 0;
+    for (char *p = buf; p < buf + len;) {
+        char *nl = memchr(p, '\n', (size_t)(buf + len - p));
+        if (nl) {
+            *nl = '\0';
+        }
+        size_t l = strlen(p);
+        maxlen   = l > maxlen ? l : maxlen;
+        p += (nl ? (size_t)(nl - p) : l) + 1;
+    }
+
+    natcmp_anon_t an;
+    natcmp_anon_init(&an, seeded ? seed : random_seed(), NULL);
+    for (char *p = buf; p < buf + len; p += strlen(p) + 1) {
+        if (natcmp_anon_add(&an, (const unsigned char *)p) != 0) {
+            perror("natanon");
+            return 1;
+        }
+    }
+    unsigned char *out = malloc(maxlen + 1);
+    if (!out || natcmp_anon_build(&an) != 0) {
+        perror("natanon");
+        return 1;
+    }
+    for (char *p = buf; p < buf + len; p += strlen(p) + 1) {
+        natcmp_anon_apply(&an, (const unsigned char *)p, out);
+        fputs((const char *)out, stdout);
+        if (p + strlen(p) < buf + len) {
+            putchar('\n');
+        }
+    }
+
+    natcmp_anon_free(&an);
+    free(out);
+    free(buf);
+    return fflush(stdout) == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/**
+ * natdiff: compares files whose lines are sorted in natural order (such as
+ * the output of natsort) with natcmp_diff.h and prints the lines that are
+ * not in all of them, reading each file once with a fixed amount of memory.
+ * With two files, lines only in the first are printed as "-line" and lines
+ * only in the second as "+line"; with more, each line is preceded by one
+ * column per file, '+' if the line is in that file and '-' if not, and a
+ * space. Exits with 0 if the files have the same lines, 1 if not and 2 on
+ * error.
+ *
+ *   natdiff [-c] [-u] file1 file2 [file ...]
+ *
+ *   file  a file name, or - for the standard input
+ *   -u    also print the lines that are in every file (" line")
+ *   -c    compare the text case-sensitively (the files must be sorted so)
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_diff.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: natdiff [-c] [-u] file1 file2 [file ...]\n");
+    exit(2);
+}
+
+// prints the lines of a chunk, each preceded by its tag
+static void print_chunk(const natcmp_diff_chunk_t *c, size_t n, uint64_t all)
+{
+    char tag[NATCMP_DIFF_MAX + 2];
+    size_t len = 0;
+    if (c->mask == all) {
+        tag[len++] = ' ';
+    } else if (n == 2) {
+        tag[len++] = (c->mask == 1) ? '-' : '+';
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            tag[len++] = (c->mask & ((uint64_t)1 << i)) ? '+' : '-';
+        }
+        tag[len++] = ' ';
+    }
+
+    const unsigned char *p   = c->ptr;
+    const unsigned char *end = c->ptr + c->len;
+    while (p < end) {
+        const unsigned char *nl = memchr(p, '\n', (size_t)(end - p));
+        fwrite(tag, 1, len, stdout);
+        fwrite(p, 1, (size_t)(nl - p) + 1, stdout);
+        p = nl + 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    natcmp_nondigit_cmp_func_t compare = NULL;
+    int unchanged                      = 0;
+    int fds[NATCMP_DIFF_MAX];
+    natcmp_diff_t d;
+    natcmp_diff_chunk_t chunk;
+    int rv;
+    int c;
+
+    while ((c = getopt(argc, argv, "cu")) != -1) {
+        switch (c) {
+        case 'c':
+            compare = natcmp_nondigit_cmp_bytes;
+            break;
+        case 'u':
+            unchanged = 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    size_t n = (size_t)(argc - optind);
+    if (n < 2) {
+        usage();
+    } else if (n > NATCMP_DIFF_MAX) {
+        fprintf(stderr, "natdiff: at most %d files\n", NATCMP_DIFF_MAX);
+        return 2;
+    }
+    for (size_t i = 0; i < n; i++) {
+        const char *path = argv[optind + (int)i];
+        fds[i] = strcmp(path, "-") ? open(path, O_RDONLY) : STDIN_FILENO;
+        if (fds[i] < 0) {
+            perror(path);
+            return 2;
+        }
+    }
+    if (natcmp_diff_init(&d, fds, n, compare, NULL) != 0) {
+        perror("natdiff");
+        return 2;
+    }
+
+    int differ = 0;
+    while ((rv = natcmp_diff_next(&d, &chunk)) == 1) {
+        if (chunk.mask != d.all) {
+            differ = 1;
+            print_chunk(&chunk, n, d.all);
+        } else if (unchanged) {
+            print_chunk(&chunk, n, d.all);
+        }
+    }
+    if (rv < 0) {
+        perror("natdiff");
+        return 2;
+    }
+    natcmp_diff_free(&d);
+    for (size_t i = 0; i < n; i++) {
+        close(fds[i]);
+    }
+    if (fflush(stdout) != 0) {
+        return 2;
+    }
+    return differ;
+}
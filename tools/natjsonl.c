@@ -0,0 +1,111 @@
+/**
+ * natjsonl: sorts JSON Lines records by the value at a key path in natural
+ * order with natcmp_jsonl.h and writes them to the standard output. Records
+ * without the key, or with a null key, come first; blank lines are dropped.
+ *
+ *   natjsonl [-c] path [file]
+ *
+ *   path  key path such as .object.name, .tags[0] or ."odd.name"
+ *   -c    compare the text case-sensitively
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_jsonl.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: natjsonl [-c] path [file]\n");
+    exit(2);
+}
+
+// reads the whole input
+static unsigned char *read_all(int fd, size_t *len)
+{
+    size_t cap         = 1 << 16;
+    size_t n           = 0;
+    unsigned char *buf = malloc(cap);
+    while (buf) {
+        if (n == cap) {
+            unsigned char *p = realloc(buf, cap * 2);
+            if (!p) {
+                break;
+            }
+            buf = p;
+            cap *= 2;
+        }
+        ssize_t r = read(fd, buf + n, cap - n);
+        if (r < 0) {
+            break;
+        } else if (r == 0) {
+            *len = n;
+            return buf;
+        }
+        n += (size_t)r;
+    }
+    free(buf);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    natcmp_nondigit_cmp_func_t compare = NULL;
+    int in                             = STDIN_FILENO;
+    natcmp_jsonl_t s;
+    size_t len;
+    int c;
+
+    while ((c = getopt(argc, argv, "c")) != -1) {
+        if (c != 'c') {
+            usage();
+        }
+        compare = natcmp_nondigit_cmp_bytes;
+    }
+    if (argc - optind < 1 || argc - optind > 2) {
+        usage();
+    } else if (natcmp_jsonl_init(&s, argv[optind], compare, NULL) != 0) {
+        fprintf(stderr, "natjsonl: invalid key path: %s\n", argv[optind]);
+        return 2;
+    } else if (argc - optind == 2 && strcmp(argv[optind + 1], "-") != 0) {
+        in = open(argv[optind + 1], O_RDONLY);
+        if (in < 0) {
+            perror(argv[optind + 1]);
+            return 1;
+        }
+    }
+
+    unsigned char *buf = read_all(in, &len);
+    if (!buf) {
+        perror("natjsonl");
+        return 1;
+    }
+    size_t lineno = 0;
+    for (unsigned char *p = buf; p < buf + len;) {
+        unsigned char *nl = memchr(p, '\n', (size_t)(buf + len - p));
+        size_t n          = nl ? (size_t)(nl - p) : (size_t)(buf + len - p);
+        lineno++;
+        if (natcmp_jsonl_ws(p, n, 0) < n && natcmp_jsonl_add(&s, p, n) != 0) {
+            if (errno == EINVAL) {
+                fprintf(stderr, "natjsonl: line %zu: invalid JSON\n", lineno);
+            } else {
+                perror("natjsonl");
+            }
+            return 1;
+        }
+        p += n + 1;
+    }
+    if (natcmp_jsonl_sort(&s) != 0) {
+        perror("natjsonl");
+        return 1;
+    }
+    for (size_t i = 0; i < s.n; i++) {
+        fwrite(s.recs[i].line, 1, s.recs[i].len, stdout);
+        putchar('\n');
+    }
+
+    natcmp_jsonl_free(&s);
+    free(buf);
+    return fflush(stdout) == 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/**
+ * natlook: prints the lines of a file sorted in natural order (such as the
+ * output of natsort) that are equal to a key, or between two keys, with
+ * natcmp_look.h. Like look(1), it binary-searches the file instead of
+ * reading it, and exits with 0 if lines were found, 1 if none and 2 on
+ * error.
+ *
+ *   natlook [-c] key [last] file
+ *
+ *   key   prints the lines equal to key in natural order
+ *   last  prints the lines from key to last inclusive instead
+ *   -c    compare the text case-sensitively (the file must be sorted so)
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_look.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: natlook [-c] key [last] file\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    natcmp_nondigit_cmp_func_t compare = NULL;
+    natcmp_look_t lk;
+    size_t start;
+    size_t end;
+    int c;
+
+    while ((c = getopt(argc, argv, "c")) != -1) {
+        if (c != 'c') {
+            usage();
+        }
+        compare = natcmp_nondigit_cmp_bytes;
+    }
+    if (argc - optind < 2 || argc - optind > 3) {
+        usage();
+    }
+    const char *path  = argv[argc - 1];
+    const char *first = argv[optind];
+    const char *last  = (argc - optind == 3) ? argv[optind + 1] : first;
+
+    if (natcmp_look_open(&lk, path, compare, NULL) != 0) {
+        perror(path);
+        return 2;
+    } else if (natcmp_look_range(&lk, (const unsigned char *)first,
+                                 (const unsigned char *)last, &start,
+                                 &end) != 0) {
+        perror("natlook");
+        return 2;
+    }
+    fwrite(lk.map + start, 1, end - start, stdout);
+    if (end > start && lk.map[end - 1] != '\n') {
+        putchar('\n');
+    }
+    natcmp_look_close(&lk);
+    if (fflush(stdout) != 0) {
+        return 2;
+    }
+    return (end > start) ? 0 : 1;
+}
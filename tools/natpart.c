@@ -0,0 +1,219 @@
+/**
+ * natpart: splits a file of lines into partitions that follow each other in
+ * natural order, with natcmp_part.h, so that sorting each partition (with
+ * natsort) and concatenating them gives the sorted file. The boundaries are
+ * chosen from lines read at random offsets, then the file is read once and
+ * each line is appended to its partition's file, prefix0 ... prefixN-1
+ * (numbered with the same number of digits).
+ *
+ *   natpart [-c] [-n parts] [-s samples] [-o prefix] file
+ *
+ *   -n parts    number of partitions (default 2)
+ *   -s samples  lines sampled per partition (default 256)
+ *   -o prefix   prefix of the partition files (default "part")
+ *   -c          compare the text case-sensitively
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_part.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SAMPLE_READ 512       // bytes read per sampled line
+#define BLOCK_SIZE  (1 << 20) // bytes read per block of the streaming pass
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: natpart [-c] [-n parts] [-s samples] "
+                    "[-o prefix] file\n");
+    exit(2);
+}
+
+static size_t parse_count(const char *s)
+{
+    char *end;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (*s < '0' || *s > '9' || *end || v == 0 || v > 1000000) {
+        usage();
+    }
+    return (size_t)v;
+}
+
+static uint64_t next_rand(uint64_t *st)
+{
+    *st = *st * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *st >> 11;
+}
+
+// reads `n` lines starting after random offsets (the first line from 0);
+// lines longer than SAMPLE_READ are cut, which still gives valid boundaries
+static unsigned char *sample_lines(int fd, size_t size, size_t n,
+                                   const unsigned char **lines, size_t *nline)
+{
+    unsigned char *pool = malloc(n * (SAMPLE_READ + 1));
+    uint64_t st         = 0x9e3779b97f4a7c15ULL ^ size;
+    *nline              = 0;
+    for (size_t i = 0; pool && i < n; i++) {
+        unsigned char *buf = pool + i * (SAMPLE_READ + 1);
+        off_t off          = (off_t)(i ? next_rand(&st) % size : 0);
+        ssize_t r          = pread(fd, buf, SAMPLE_READ, off);
+        if (r < 0) {
+            free(pool);
+            return NULL;
+        }
+        unsigned char *s   = buf;
+        unsigned char *end = buf + r;
+        if (off > 0) {
+            // skip the rest of the line the offset fell in
+            s = memchr(buf, '\n', (size_t)r);
+            if (!s || ++s == end) {
+                continue;
+            }
+        }
+        unsigned char *nl = memchr(s, '\n', (size_t)(end - s));
+        *(nl ? nl : end)  = 0;
+        lines[(*nline)++] = s;
+    }
+    return pool;
+}
+
+int main(int argc, char **argv)
+{
+    natcmp_nondigit_cmp_func_t compare = NULL;
+    const char *prefix                 = "part";
+    size_t parts                       = 2;
+    size_t per                         = 256;
+    natcmp_part_t p;
+    struct stat st;
+    int c;
+
+    while ((c = getopt(argc, argv, "cn:s:o:")) != -1) {
+        switch (c) {
+        case 'c':
+            compare = natcmp_nondigit_cmp_bytes;
+            break;
+        case 'n':
+            parts = parse_count(optarg);
+            break;
+        case 's':
+            per = parse_count(optarg);
+            break;
+        case 'o':
+            prefix = optarg;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (argc - optind != 1) {
+        usage();
+    }
+    const char *path = argv[optind];
+    int in           = open(path, O_RDONLY);
+    if (in < 0 || fstat(in, &st) != 0) {
+        perror(path);
+        return 1;
+    } else if (!S_ISREG(st.st_mode)) {
+        fprintf(stderr, "natpart: %s: not a regular file\n", path);
+        return 1;
+    }
+
+    // choose the boundaries
+    size_t nsample = parts * per;
+    size_t nline   = 0;
+    const unsigned char **lines = malloc(sizeof(*lines) * nsample);
+    unsigned char *pool         = NULL;
+    if (lines && st.st_size > 0) {
+        pool = sample_lines(in, (size_t)st.st_size, nsample, lines, &nline);
+    }
+    if (!lines || (st.st_size > 0 && !pool) ||
+        natcmp_part_init(&p, lines, nline, nline ? parts : 1, compare, NULL)) {
+        perror("natpart");
+        return 1;
+    }
+    free(pool);
+    free(lines);
+
+    // open the partition files
+    FILE **out   = calloc(parts, sizeof(*out));
+    size_t width = 1;
+    for (size_t n = parts - 1; n >= 10; n /= 10) {
+        width++;
+    }
+    char *name = malloc(strlen(prefix) + width + 1);
+    if (!out || !name) {
+        perror("natpart");
+        return 1;
+    }
+    for (size_t i = 0; i < parts; i++) {
+        sprintf(name, "%s%0*zu", prefix, (int)width, i);
+        out[i] = fopen(name, "w");
+        if (!out[i]) {
+            perror(name);
+            return 1;
+        }
+    }
+
+    // route every line in one pass; a line is NUL-terminated in place
+    size_t cap         = BLOCK_SIZE;
+    size_t len         = 0;
+    unsigned char *buf = malloc(cap + 1);
+    for (int eof = 0; buf && !eof;) {
+        if (len == cap) {
+            // a line longer than the buffer
+            unsigned char *q = realloc(buf, cap * 2 + 1);
+            if (!q) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = q;
+            cap *= 2;
+        }
+        ssize_t r = read(in, buf + len, cap - len);
+        if (r < 0) {
+            perror(path);
+            return 1;
+        }
+        len += (size_t)r;
+        eof = (r == 0);
+
+        unsigned char *s   = buf;
+        unsigned char *end = buf + len;
+        while (s < end) {
+            unsigned char *nl = memchr(s, '\n', (size_t)(end - s));
+            if (!nl && !eof) {
+                break;
+            }
+            size_t n = (size_t)((nl ? nl : end) - s);
+            s[n]     = 0;
+            FILE *f  = out[natcmp_part_find(&p, s)];
+            fwrite(s, 1, n, f);
+            putc('\n', f);
+            s += n + 1;
+        }
+        len = (s < end) ? (size_t)(end - s) : 0;
+        memmove(buf, s, len);
+    }
+    if (!buf) {
+        perror("natpart");
+        return 1;
+    }
+
+    int rv = 0;
+    for (size_t i = 0; i < parts; i++) {
+        if (fclose(out[i]) != 0) {
+            sprintf(name, "%s%0*zu", prefix, (int)width, i);
+            perror(name);
+            rv = 1;
+        }
+    }
+    natcmp_part_free(&p);
+    free(buf);
+    free(name);
+    free(out);
+    close(in);
+    return rv;
+}
@@ -0,0 +1,86 @@
+/**
+ * natsort: sorts the lines of a file, or of the standard input, in natural
+ * order with natcmp_extsort() and writes them to the standard output.
+ *
+ *   natsort [-m size] [-T dir] [-S] [file]
+ *
+ *   -m size  memory budget in bytes, with an optional K, M or G suffix
+ *   -T dir   directory of the temporary file
+ *   -S       use synchronous I/O instead of io_uring
+ */
+#define _GNU_SOURCE
+#include "../src/natcmp_extsort.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: natsort [-m size] [-T dir] [-S] [file]\n");
+    exit(2);
+}
+
+// parses a size with an optional K, M or G suffix
+static size_t parse_size(const char *str)
+{
+    char *end;
+    unsigned long long v = strtoull(str, &end, 10);
+    switch (*end) {
+    case 'G':
+    case 'g':
+        v <<= 10;
+        /* fallthrough */
+    case 'M':
+    case 'm':
+        v <<= 10;
+        /* fallthrough */
+    case 'K':
+    case 'k':
+        v <<= 10;
+        end++;
+        break;
+    }
+    if (end == str || *end || !v) {
+        usage();
+    }
+    return (size_t)v;
+}
+
+int main(int argc, char **argv)
+{
+    natcmp_extsort_opts_t opts = {0};
+    int in                     = STDIN_FILENO;
+    int c;
+
+    while ((c = getopt(argc, argv, "m:T:S")) != -1) {
+        switch (c) {
+        case 'm':
+            opts.memory = parse_size(optarg);
+            break;
+        case 'T':
+            opts.tmpdir = optarg;
+            break;
+        case 'S':
+            opts.ioflags |= NATCMP_IO_NOURING;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (argc - optind > 1) {
+        usage();
+    } else if (argc - optind == 1 && strcmp(argv[optind], "-") != 0) {
+        in = open(argv[optind], O_RDONLY);
+        if (in < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    if (natcmp_extsort(in, STDOUT_FILENO, &opts) != 0) {
+        perror("natsort");
+        return 1;
+    }
+    return 0;
+}